@@ -47,6 +47,11 @@ namespace seal
 
         // Copy over inverse of coeff moduli products mod each coeff moduli
         inv_coeff_products_mod_coeff_array_ = base_converter_.get_inv_coeff_mod_coeff_array();
+        inv_coeff_products_mod_coeff_shoup_array_.resize(coeff_mod_count);
+        for (int i = 0; i < coeff_mod_count; i++)
+        {
+            inv_coeff_products_mod_coeff_shoup_array_[i] = shoup_precompute_uint_mod(inv_coeff_products_mod_coeff_array_[i], coeff_modulus_[i]);
+        }
 
         // Populate coeff products array for compose functions (used in noise budget)
         coeff_products_array_ = allocate_uint(coeff_mod_count * coeff_mod_count, pool_);
@@ -101,6 +106,14 @@ namespace seal
             temp_reduction[i] = modulo_uint(coeff_div_plain_modulus_.get(), coeff_mod_count, coeff_modulus_[i], pool_);
         }
         set_uint_uint(temp_reduction.get(), coeff_mod_count, coeff_div_plain_modulus_.get());
+
+        // Precompute coeff_div_plain_modulus for Shoup multiplication in add_plain and sub_plain
+        coeff_div_plain_modulus_shoup_array_.resize(coeff_mod_count);
+        for (int i = 0; i < coeff_mod_count; i++)
+        {
+            coeff_div_plain_modulus_shoup_array_[i] = shoup_precompute_uint_mod(coeff_div_plain_modulus_[i], coeff_modulus_[i]);
+        }
+
         for (int i = 0; i < coeff_mod_count; i++)
         {
             temp_reduction[i] = modulo_uint(upper_half_increment_.get(), coeff_mod_count, coeff_modulus_[i], pool_);
@@ -124,14 +137,16 @@ namespace seal
     }
 
     Evaluator::Evaluator(const Evaluator &copy) :
-        pool_(copy.pool_), parms_(copy.parms_), qualifiers_(copy.qualifiers_),
+        pool_(copy.pool_), thread_pool_(copy.thread_pool_), parms_(copy.parms_), qualifiers_(copy.qualifiers_),
         base_converter_(copy.base_converter_),
         coeff_small_ntt_tables_(copy.coeff_small_ntt_tables_),
         bsk_small_ntt_tables_(copy.bsk_small_ntt_tables_),
+        coeff_div_plain_modulus_shoup_array_(copy.coeff_div_plain_modulus_shoup_array_),
         plain_upper_half_threshold_(copy.plain_upper_half_threshold_),
         coeff_modulus_(copy.coeff_modulus_),
         bsk_mod_array_(copy.bsk_mod_array_),
         inv_coeff_products_mod_coeff_array_(copy.inv_coeff_products_mod_coeff_array_),
+        inv_coeff_products_mod_coeff_shoup_array_(copy.inv_coeff_products_mod_coeff_shoup_array_),
         bsk_base_mod_count_(copy.bsk_base_mod_count_),
         plain_upper_half_increment_array_(copy.plain_upper_half_increment_array_),
         Zmstar_to_generator_(copy.Zmstar_to_generator_)
@@ -205,7 +220,8 @@ namespace seal
         {
             for (int j = 0; j < coeff_mod_count; j++)
             {
-                uint64_t tmp = multiply_uint_uint_mod(coefficients_ptr[j], inv_coeff_products_mod_coeff_array_[j], coeff_modulus_[j]);
+                uint64_t tmp = multiply_uint_uint_mod(coefficients_ptr[j], inv_coeff_products_mod_coeff_array_[j], 
+                    inv_coeff_products_mod_coeff_shoup_array_[j], coeff_modulus_[j]);
                 multiply_uint_uint64(coeff_products_array_.get() + (j * coeff_mod_count), coeff_mod_count, tmp, coeff_mod_count, temp.get());
                 add_uint_uint_mod(temp.get(), value + (i * coeff_mod_count), mod_.get(), coeff_mod_count, value + (i * coeff_mod_count));
             }
@@ -214,6 +230,20 @@ namespace seal
         }
     }
 
+    void Evaluator::parallel_for(int count, const function<void(int)> &task, const MemoryPoolHandle &pool) const
+    {
+        // Tasks allocate from pool, which must then be thread-safe to be shared between the threads
+        if (!thread_pool_ || dynamic_cast<MemoryPoolST*>(&static_cast<MemoryPool&>(pool)))
+        {
+            for (int i = 0; i < count; i++)
+            {
+                task(i);
+            }
+            return;
+        }
+        static_cast<ThreadPool&>(thread_pool_).parallel_for(count, task);
+    }
+
     void Evaluator::populate_Zmstar_to_generator()
     {
         uint64_t n = parms_.poly_modulus().coeff_count() - 1;
@@ -401,23 +431,24 @@ namespace seal
 
         // Step 0: fast base convert from q to Bsk U {m_tilde}
         // Step 1: reduce q-overflows in Bsk
-        // Iterate over all the ciphertexts inside encrypted1
-        for (int i = 0; i < encrypted1_size; i++)
-        {
-            base_converter_.fastbconv_mtilde(encrypted1.pointer(i), 
-                tmp_encrypted1_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment), pool);
-            base_converter_.mont_rq(tmp_encrypted1_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment), 
-                tmp_encrypted1_bsk.get() + (i * encrypted_bsk_ptr_increment));
-        }
-        
-        // Iterate over all the ciphertexts inside encrypted2
-        for (int i = 0; i < encrypted2_size; i++)
-        {
-            base_converter_.fastbconv_mtilde(encrypted2.pointer(i), 
-                tmp_encrypted2_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment), pool);
-            base_converter_.mont_rq(tmp_encrypted2_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment), 
-                tmp_encrypted2_bsk.get() + (i * encrypted_bsk_ptr_increment));
-        }
+        // Iterate over all the ciphertexts inside encrypted1, then over the ones inside encrypted2
+        parallel_for(encrypted1_size + encrypted2_size, [&](int index) {
+            if (index < encrypted1_size)
+            {
+                base_converter_.fastbconv_mtilde(encrypted1.pointer(index), 
+                    tmp_encrypted1_bsk_mtilde.get() + (index * encrypted_bsk_mtilde_ptr_increment), pool);
+                base_converter_.mont_rq(tmp_encrypted1_bsk_mtilde.get() + (index * encrypted_bsk_mtilde_ptr_increment), 
+                    tmp_encrypted1_bsk.get() + (index * encrypted_bsk_ptr_increment));
+            }
+            else
+            {
+                int i = index - encrypted1_size;
+                base_converter_.fastbconv_mtilde(encrypted2.pointer(i), 
+                    tmp_encrypted2_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment), pool);
+                base_converter_.mont_rq(tmp_encrypted2_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment), 
+                    tmp_encrypted2_bsk.get() + (i * encrypted_bsk_ptr_increment));
+            }
+        }, pool);
         
         // Step 2: compute product and multiply plain modulus to the result
         // We need to multiply both in q and Bsk. Values in encrypted_safe are in base q and values in tmp_encrypted_bsk are in base Bsk
@@ -433,8 +464,6 @@ namespace seal
         Pointer tmp2_poly_coeff_base(allocate_poly(coeff_count, coeff_mod_count, pool));
         Pointer tmp2_poly_bsk_base(allocate_poly(coeff_count, bsk_base_mod_count_, pool));
 
-        int current_encrypted1_limit = 0;
-
         // First convert all the inputs into NTT form
         Pointer copy_encrypted1_ntt_coeff_mod(allocate_poly(coeff_count * encrypted1_size, coeff_mod_count, pool));
         set_poly_poly(encrypted1.pointer(), coeff_count * encrypted1_size, coeff_mod_count, copy_encrypted1_ntt_coeff_mod.get());
@@ -450,223 +479,133 @@ namespace seal
 
         for (int i = 0; i < encrypted1_size; i++)
         {
-            for (int j = 0; j < coeff_mod_count; j++)
-            {
-                // Lazy reduction
-                ntt_negacyclic_harvey_lazy(copy_encrypted1_ntt_coeff_mod.get() + (j * coeff_count) + (i * encrypted_ptr_increment), coeff_small_ntt_tables_[j]);
-            }
-            for (int j = 0; j < bsk_base_mod_count_; j++)
-            {
-                // Lazy reduction
-                ntt_negacyclic_harvey_lazy(copy_encrypted1_ntt_bsk_base_mod.get() + (j * coeff_count) + (i * encrypted_bsk_ptr_increment), bsk_small_ntt_tables_[j]);
-            }
+            // Lazy reduction
+            ntt_negacyclic_harvey_lazy(copy_encrypted1_ntt_coeff_mod.get() + (i * encrypted_ptr_increment), coeff_count, coeff_mod_count,
+                coeff_small_ntt_tables_.data(), ntt_thread_pool());
+            ntt_negacyclic_harvey_lazy(copy_encrypted1_ntt_bsk_base_mod.get() + (i * encrypted_bsk_ptr_increment), coeff_count, bsk_base_mod_count_,
+                bsk_small_ntt_tables_.data(), ntt_thread_pool());
         }
 
         for (int i = 0; i < encrypted2_size; i++)
         {
-            for (int j = 0; j < coeff_mod_count; j++)
-            {
-                // Lazy reduction
-                ntt_negacyclic_harvey_lazy(copy_encrypted2_ntt_coeff_mod.get() + (j * coeff_count) + (i * encrypted_ptr_increment), coeff_small_ntt_tables_[j]);
-            }
-            for (int j = 0; j < bsk_base_mod_count_; j++)
+            // Lazy reduction
+            ntt_negacyclic_harvey_lazy(copy_encrypted2_ntt_coeff_mod.get() + (i * encrypted_ptr_increment), coeff_count, coeff_mod_count,
+                coeff_small_ntt_tables_.data(), ntt_thread_pool());
+            ntt_negacyclic_harvey_lazy(copy_encrypted2_ntt_bsk_base_mod.get() + (i * encrypted_bsk_ptr_increment), coeff_count, bsk_base_mod_count_,
+                bsk_small_ntt_tables_.data(), ntt_thread_pool());
+        }
+
+        // The residues of base q and of base Bsk are independent: residue i of base q is task i, and residue i of 
+        // base Bsk is task coeff_mod_count + i
+        auto get_residue = [&](int task, const uint64_t *&encrypted1_ntt, const uint64_t *&encrypted2_ntt, uint64_t *&tmp1_poly, 
+            uint64_t *&tmp2_poly, uint64_t *&tmp_des, int &ptr_increment) -> const SmallModulus & {
+            if (task < coeff_mod_count)
             {
-                // Lazy reduction
-                ntt_negacyclic_harvey_lazy(copy_encrypted2_ntt_bsk_base_mod.get() + (j * coeff_count) + (i * encrypted_bsk_ptr_increment), bsk_small_ntt_tables_[j]);
+                encrypted1_ntt = copy_encrypted1_ntt_coeff_mod.get() + (task * coeff_count);
+                encrypted2_ntt = copy_encrypted2_ntt_coeff_mod.get() + (task * coeff_count);
+                tmp1_poly = tmp1_poly_coeff_base.get() + (task * coeff_count);
+                tmp2_poly = tmp2_poly_coeff_base.get() + (task * coeff_count);
+                tmp_des = tmp_des_coeff_base.get() + (task * coeff_count);
+                ptr_increment = encrypted_ptr_increment;
+                return coeff_modulus_[task];
             }
-        }
+            int i = task - coeff_mod_count;
+            encrypted1_ntt = copy_encrypted1_ntt_bsk_base_mod.get() + (i * coeff_count);
+            encrypted2_ntt = copy_encrypted2_ntt_bsk_base_mod.get() + (i * coeff_count);
+            tmp1_poly = tmp1_poly_bsk_base.get() + (i * coeff_count);
+            tmp2_poly = tmp2_poly_bsk_base.get() + (i * coeff_count);
+            tmp_des = tmp_des_bsk_base.get() + (i * coeff_count);
+            ptr_increment = encrypted_bsk_ptr_increment;
+            return bsk_mod_array_[i];
+        };
 
         // Perform Karatsuba multiplication on size 2 ciphertexts
         if (encrypted1_size == 2 && encrypted2_size == 2)
         {
-            Pointer tmp_first_mul_coeff_base(allocate_poly(coeff_count, coeff_mod_count, pool));
-
-            // Compute c0 + c1 and c0*d0 in base q
-            for (int i = 0; i < coeff_mod_count; i++)
-            {
-                //add_poly_poly_coeffmod(copy_encrypted1_ntt_coeff_mod.get() + (i * coeff_count), 
-                //    copy_encrypted1_ntt_coeff_mod.get() + (i * coeff_count) + encrypted_ptr_increment, 
-                //    coeff_count, coeff_modulus_[i], tmp1_poly_coeff_base.get() + (i * coeff_count));
+            parallel_for(coeff_mod_count + bsk_base_mod_count_, [&](int task) {
+                const uint64_t *encrypted1_ntt, *encrypted2_ntt;
+                uint64_t *tmp1_poly, *tmp2_poly, *tmp_des;
+                int ptr_increment;
+                const SmallModulus &modulus = get_residue(task, encrypted1_ntt, encrypted2_ntt, tmp1_poly, tmp2_poly, tmp_des, ptr_increment);
 
+                // Compute c0 + c1 and d0 + d1
                 // Lazy reduction
                 for (int j = 0; j < coeff_count; j++)
                 {
-                    tmp1_poly_coeff_base[j + (i * coeff_count)] = copy_encrypted1_ntt_coeff_mod[j + (i * coeff_count)]
-                        + copy_encrypted1_ntt_coeff_mod[j + (i * coeff_count) + encrypted_ptr_increment];
-                }
-                dyadic_product_coeffmod(copy_encrypted1_ntt_coeff_mod.get() + (i * coeff_count), 
-                    copy_encrypted2_ntt_coeff_mod.get() + (i * coeff_count), coeff_count, coeff_modulus_[i], 
-                    tmp_first_mul_coeff_base.get() + (i * coeff_count));
-            }
-
-            Pointer tmp_first_mul_bsk_base(allocate_poly(coeff_count, bsk_base_mod_count_, pool));
-
-            // Compute c0 + c1 and c0*d0 in base bsk
-            for (int i = 0; i < bsk_base_mod_count_; i++)
-            {
-                //add_poly_poly_coeffmod(copy_encrypted1_ntt_bsk_base_mod.get() + (i * coeff_count), 
-                //    copy_encrypted1_ntt_bsk_base_mod.get() + (i * coeff_count) + encrypted_bsk_ptr_increment, 
-                //    coeff_count, bsk_mod_array_[i], tmp1_poly_bsk_base.get() + (i * coeff_count));
-                for (int j = 0; j < coeff_count; j++)
-                {
-                    tmp1_poly_bsk_base[j + (i * coeff_count)] = copy_encrypted1_ntt_bsk_base_mod[j + (i * coeff_count)]
-                        + copy_encrypted1_ntt_bsk_base_mod[j + (i * coeff_count) + encrypted_bsk_ptr_increment];
+                    tmp1_poly[j] = encrypted1_ntt[j] + encrypted1_ntt[j + ptr_increment];
+                    tmp2_poly[j] = encrypted2_ntt[j] + encrypted2_ntt[j + ptr_increment];
                 }
-                dyadic_product_coeffmod(copy_encrypted1_ntt_bsk_base_mod.get() + (i * coeff_count), 
-                    copy_encrypted2_ntt_bsk_base_mod.get() + (i * coeff_count), coeff_count, bsk_mod_array_[i], 
-                    tmp_first_mul_bsk_base.get() + (i * coeff_count));
-            }
 
-            Pointer tmp_second_mul_coeff_base(allocate_poly(coeff_count, coeff_mod_count, pool));
+                // Des[0] = c0*d0
+                dyadic_product_coeffmod(encrypted1_ntt, encrypted2_ntt, coeff_count, modulus, tmp_des);
 
-            // Compute d0 + d1 and c1*d1 in base q
-            for (int i = 0; i < coeff_mod_count; i++)
-            {
-                //add_poly_poly_coeffmod(copy_encrypted2_ntt_coeff_mod.get() + (i * coeff_count), 
-                //    copy_encrypted2_ntt_coeff_mod.get() + (i * coeff_count) + encrypted_ptr_increment, 
-                //    coeff_count, coeff_modulus_[i], tmp2_poly_coeff_base.get() + (i * coeff_count));
-                for (int j = 0; j < coeff_count; j++)
-                {
-                    tmp2_poly_coeff_base[j + (i * coeff_count)] = copy_encrypted2_ntt_coeff_mod[j + (i * coeff_count)]
-                        + copy_encrypted2_ntt_coeff_mod[j + (i * coeff_count) + encrypted_ptr_increment];
-                }
-                dyadic_product_coeffmod(copy_encrypted1_ntt_coeff_mod.get() + (i * coeff_count) + encrypted_ptr_increment, 
-                    copy_encrypted2_ntt_coeff_mod.get() + (i * coeff_count) + encrypted_ptr_increment, 
-                    coeff_count, coeff_modulus_[i], tmp_second_mul_coeff_base.get() + (i * coeff_count));
-            }
-
-            Pointer tmp_second_mul_bsk_base(allocate_poly(coeff_count, bsk_base_mod_count_, pool));
+                // Des[2] = c1*d1
+                dyadic_product_coeffmod(encrypted1_ntt + ptr_increment, encrypted2_ntt + ptr_increment, coeff_count, modulus, 
+                    tmp_des + 2 * ptr_increment);
 
-            // Compute d0 + d1 and c1*d1 in base bsk
-            for (int i = 0; i < bsk_base_mod_count_; i++)
-            {
-                //add_poly_poly_coeffmod(copy_encrypted2_ntt_bsk_base_mod.get() + (i * coeff_count), 
-                //    copy_encrypted2_ntt_bsk_base_mod.get() + (i * coeff_count) + encrypted_bsk_ptr_increment, 
-                //    coeff_count, bsk_mod_array_[i], tmp2_poly_bsk_base.get() + (i * coeff_count));
-                for (int j = 0; j < coeff_count; j++)
-                {
-                    tmp2_poly_bsk_base[j + (i * coeff_count)] = copy_encrypted2_ntt_bsk_base_mod[j + (i * coeff_count)]
-                        + copy_encrypted2_ntt_bsk_base_mod[j + (i * coeff_count) + encrypted_bsk_ptr_increment];
-                }
-                dyadic_product_coeffmod(copy_encrypted1_ntt_bsk_base_mod.get() + (i * coeff_count) + encrypted_bsk_ptr_increment, 
-                    copy_encrypted2_ntt_bsk_base_mod.get() + (i * coeff_count) + encrypted_bsk_ptr_increment, 
-                    coeff_count, bsk_mod_array_[i], tmp_second_mul_bsk_base.get() + (i * coeff_count));
-            }
-
-            Pointer tmp_mul_poly_coeff_base(allocate_poly(coeff_count, coeff_mod_count, pool));
-            Pointer tmp_mul_poly_bsk_base(allocate_poly(coeff_count, bsk_base_mod_count_, pool));
-
-            // Set destination first and third polys in base q
-            // Des[0] in base q
-            set_poly_poly(tmp_first_mul_coeff_base.get(), coeff_count, coeff_mod_count, tmp_des_coeff_base.get());
-
-            // Des[2] in base q
-            set_poly_poly(tmp_second_mul_coeff_base.get(), coeff_count, coeff_mod_count, tmp_des_coeff_base.get() + 2 * encrypted_ptr_increment);
-            
-            // Compute (c0 + c1)*(d0 + d1) - c0*d0 - c1*d1 in base q
-            for (int i = 0; i < coeff_mod_count; i++)
-            {
-                dyadic_product_coeffmod(tmp1_poly_coeff_base.get() + (i * coeff_count), tmp2_poly_coeff_base.get() + (i * coeff_count), 
-                    coeff_count, coeff_modulus_[i], tmp_mul_poly_coeff_base.get() + (i * coeff_count));
-                sub_poly_poly_coeffmod(tmp_mul_poly_coeff_base.get() + (i * coeff_count), 
-                    tmp_first_mul_coeff_base.get() + (i * coeff_count), coeff_count, coeff_modulus_[i], 
-                    tmp_mul_poly_coeff_base.get() + (i * coeff_count));
-                
-                // Des[1] in base q
-                sub_poly_poly_coeffmod(tmp_mul_poly_coeff_base.get() + (i * coeff_count), 
-                    tmp_second_mul_coeff_base.get() + (i * coeff_count), coeff_count, coeff_modulus_[i], 
-                    tmp_des_coeff_base.get() + (i * coeff_count) + encrypted_ptr_increment);
-            }
-
-            // Set destination first and third polys in base bsk
-            // Des[0] in base bsk
-            set_poly_poly(tmp_first_mul_bsk_base.get(), coeff_count, bsk_base_mod_count_, tmp_des_bsk_base.get());
-
-            // Des[2] in base q
-            set_poly_poly(tmp_second_mul_bsk_base.get(), coeff_count, bsk_base_mod_count_, 
-                tmp_des_bsk_base.get() + 2 * encrypted_bsk_ptr_increment);
-
-            // Compute (c0 + c1)*(d0 + d1)  - c0d0 - c1d1 in base bsk
-            for (int i = 0; i < bsk_base_mod_count_; i++)
-            {
-                dyadic_product_coeffmod(tmp1_poly_bsk_base.get() + (i * coeff_count), 
-                    tmp2_poly_bsk_base.get() + (i * coeff_count), coeff_count, bsk_mod_array_[i], 
-                    tmp_mul_poly_bsk_base.get() + (i * coeff_count));
-                sub_poly_poly_coeffmod(tmp_mul_poly_bsk_base.get() + (i * coeff_count), 
-                    tmp_first_mul_bsk_base.get() + (i * coeff_count), coeff_count, bsk_mod_array_[i], 
-                    tmp_mul_poly_bsk_base.get() + (i * coeff_count));
-
-                // Des[1] in bsk
-                sub_poly_poly_coeffmod(tmp_mul_poly_bsk_base.get() + (i * coeff_count), 
-                    tmp_second_mul_bsk_base.get() + (i * coeff_count), coeff_count, bsk_mod_array_[i], 
-                    tmp_des_bsk_base.get() + (i * coeff_count) + encrypted_bsk_ptr_increment); 
-            }
+                // Des[1] = (c0 + c1)*(d0 + d1) - c0*d0 - c1*d1
+                dyadic_product_coeffmod(tmp1_poly, tmp2_poly, coeff_count, modulus, tmp_des + ptr_increment);
+                sub_poly_poly_coeffmod(tmp_des + ptr_increment, tmp_des, coeff_count, modulus, tmp_des + ptr_increment);
+                sub_poly_poly_coeffmod(tmp_des + ptr_increment, tmp_des + 2 * ptr_increment, coeff_count, modulus, 
+                    tmp_des + ptr_increment);
+            }, pool);
         }
         else
         {
             // Perform multiplication on arbitrary size ciphertexts
-            for (int secret_power_index = 0; secret_power_index < dest_count; secret_power_index++)
-            {
-                // Loop over encrypted1 components [i], seeing if a match exists with an encrypted2 
-                // component [j] such that [i+j]=[secret_power_index]
-                // Only need to check encrypted1 components up to and including [secret_power_index], 
-                // and strictly less than [encrypted_array.size()]
-                current_encrypted1_limit = min(encrypted1_size, secret_power_index + 1);
+            parallel_for(coeff_mod_count + bsk_base_mod_count_, [&](int task) {
+                const uint64_t *encrypted1_ntt, *encrypted2_ntt;
+                uint64_t *tmp1_poly, *tmp2_poly, *tmp_des;
+                int ptr_increment;
+                const SmallModulus &modulus = get_residue(task, encrypted1_ntt, encrypted2_ntt, tmp1_poly, tmp2_poly, tmp_des, ptr_increment);
 
-                for (int encrypted1_index = 0; encrypted1_index < current_encrypted1_limit; encrypted1_index++)
+                for (int secret_power_index = 0; secret_power_index < dest_count; secret_power_index++)
                 {
-                    // check if a corresponding component in encrypted2 exists
-                    if (encrypted2_size > secret_power_index - encrypted1_index)
-                    {
-                        int encrypted2_index = secret_power_index - encrypted1_index;
+                    // Loop over encrypted1 components [i], seeing if a match exists with an encrypted2 
+                    // component [j] such that [i+j]=[secret_power_index]
+                    // Only need to check encrypted1 components up to and including [secret_power_index], 
+                    // and strictly less than [encrypted_array.size()]
+                    int current_encrypted1_limit = min(encrypted1_size, secret_power_index + 1);
 
-                        // NTT Multiplication and addition for results in q
-                        for (int i = 0; i < coeff_mod_count; i++)
+                    for (int encrypted1_index = 0; encrypted1_index < current_encrypted1_limit; encrypted1_index++)
+                    {
+                        // check if a corresponding component in encrypted2 exists
+                        if (encrypted2_size > secret_power_index - encrypted1_index)
                         {
-                            dyadic_product_coeffmod(copy_encrypted1_ntt_coeff_mod.get() + (i * coeff_count) + (encrypted_ptr_increment * encrypted1_index), 
-                                copy_encrypted2_ntt_coeff_mod.get() + (i * coeff_count) + (encrypted_ptr_increment * encrypted2_index), 
-                                coeff_small_ntt_tables_[i].coeff_count(), coeff_modulus_[i], tmp1_poly_coeff_base.get() + (i * coeff_count));
-                            add_poly_poly_coeffmod(tmp1_poly_coeff_base.get() + (i * coeff_count), 
-                                tmp_des_coeff_base.get() + (i * coeff_count) + (secret_power_index * coeff_count * coeff_mod_count), coeff_count, 
-                                coeff_modulus_[i], tmp_des_coeff_base.get() + (i * coeff_count) + (secret_power_index * coeff_count * coeff_mod_count));
-                        }
+                            int encrypted2_index = secret_power_index - encrypted1_index;
 
-                        // NTT Multiplication and addition for results in Bsk
-                        for (int i = 0; i < bsk_base_mod_count_; i++)
-                        {
-                            dyadic_product_coeffmod(copy_encrypted1_ntt_bsk_base_mod.get() + (i * coeff_count) + (encrypted_bsk_ptr_increment * encrypted1_index), 
-                                copy_encrypted2_ntt_bsk_base_mod.get() + (i * coeff_count) + (encrypted_bsk_ptr_increment * encrypted2_index), 
-                                bsk_small_ntt_tables_[i].coeff_count(), bsk_mod_array_[i], tmp1_poly_bsk_base.get() + (i * coeff_count));
-                            add_poly_poly_coeffmod(tmp1_poly_bsk_base.get() + (i * coeff_count), 
-                                tmp_des_bsk_base.get() + (i * coeff_count) + (secret_power_index * coeff_count * bsk_base_mod_count_), 
-                                coeff_count, bsk_mod_array_[i], 
-                                tmp_des_bsk_base.get() + (i * coeff_count) + (secret_power_index * coeff_count * bsk_base_mod_count_));
+                            // NTT Multiplication and addition
+                            dyadic_product_coeffmod(encrypted1_ntt + (ptr_increment * encrypted1_index), 
+                                encrypted2_ntt + (ptr_increment * encrypted2_index), coeff_count - 1, modulus, tmp1_poly);
+                            add_poly_poly_coeffmod(tmp1_poly, tmp_des + (secret_power_index * ptr_increment), coeff_count, 
+                                modulus, tmp_des + (secret_power_index * ptr_increment));
                         }
                     }
                 }
-            }
+            }, pool);
         }
+
         // Convert back outputs from NTT form
         for (int i = 0; i < dest_count; i++)
         {
-            for (int j = 0; j < coeff_mod_count; j++)
-            {
-                inverse_ntt_negacyclic_harvey(tmp_des_coeff_base.get() + (i * (encrypted_ptr_increment)) + (j * coeff_count), coeff_small_ntt_tables_[j]);
-            }
-            for (int j = 0; j < bsk_base_mod_count_; j++)
-            {
-                inverse_ntt_negacyclic_harvey(tmp_des_bsk_base.get() + (i * (encrypted_bsk_ptr_increment)) + (j * coeff_count), bsk_small_ntt_tables_[j]);
-            }
+            inverse_ntt_negacyclic_harvey(tmp_des_coeff_base.get() + (i * encrypted_ptr_increment), coeff_count, coeff_mod_count,
+                coeff_small_ntt_tables_.data(), ntt_thread_pool());
+            inverse_ntt_negacyclic_harvey(tmp_des_bsk_base.get() + (i * encrypted_bsk_ptr_increment), coeff_count, bsk_base_mod_count_,
+                bsk_small_ntt_tables_.data(), ntt_thread_pool());
         }
 
         // Now we multiply plain modulus to both results in base q and Bsk and allocate them together in one 
         // container as (te0)q(te'0)Bsk | ... |te count)q (te' count)Bsk to make it ready for fast_floor 
         Pointer tmp_coeff_bsk_together(allocate_poly(coeff_count, dest_count * (coeff_mod_count + bsk_base_mod_count_), pool));
-        uint64_t *tmp_coeff_bsk_together_ptr = tmp_coeff_bsk_together.get();
 
-        // Base q 
-        for (int i = 0; i < dest_count; i++)
-        {
+        // Allocate a new poly for fast floor result in Bsk
+        Pointer tmp_result_bsk(allocate_poly(coeff_count, dest_count * bsk_base_mod_count_, pool));
+
+        // Each component of the destination is a task
+        parallel_for(dest_count, [&](int i) {
+            uint64_t *tmp_coeff_bsk_together_ptr = tmp_coeff_bsk_together.get() + (i * (encrypted_ptr_increment + encrypted_bsk_ptr_increment));
+
+            // Base q 
             for (int j = 0; j < coeff_mod_count; j++)
             {
                 multiply_poly_scalar_coeffmod(tmp_des_coeff_base.get() + (j * coeff_count) + (i * encrypted_ptr_increment), 
@@ -679,20 +618,14 @@ namespace seal
                 multiply_poly_scalar_coeffmod(tmp_des_bsk_base.get() + (k * coeff_count) + (i * encrypted_bsk_ptr_increment), 
                     coeff_count, parms_.plain_modulus().value(), bsk_mod_array_[k], tmp_coeff_bsk_together_ptr + (k * coeff_count));
             }
-            tmp_coeff_bsk_together_ptr += encrypted_bsk_ptr_increment;
-        }
 
-        // Allocate a new poly for fast floor result in Bsk
-        Pointer tmp_result_bsk(allocate_poly(coeff_count, dest_count * bsk_base_mod_count_, pool));
-        for (int i = 0; i < dest_count; i++)
-        {
             // Step 3: fast floor from q U {Bsk} to Bsk 
             base_converter_.fast_floor(tmp_coeff_bsk_together.get() + (i * (encrypted_ptr_increment + encrypted_bsk_ptr_increment)), 
                 tmp_result_bsk.get() + (i * encrypted_bsk_ptr_increment), pool);
 
             // Step 4: fast base convert from Bsk to q
             base_converter_.fastbconv_sk(tmp_result_bsk.get() + (i * encrypted_bsk_ptr_increment), encrypted1.mutable_pointer(i), pool);
-        }
+        }, pool);
     }
 
     void Evaluator::square(Ciphertext &encrypted, const MemoryPoolHandle &pool)
@@ -738,13 +671,12 @@ namespace seal
         // Step 0: fast base convert from q to Bsk U {m_tilde}
         // Step 1: reduce q-overflows in Bsk
         // Iterate over all the ciphertexts inside encrypted1
-        for (int i = 0; i < encrypted_size; i++)
-        {
+        parallel_for(encrypted_size, [&](int i) {
             base_converter_.fastbconv_mtilde(encrypted.pointer(i),
                 tmp_encrypted_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment), pool);
             base_converter_.mont_rq(tmp_encrypted_bsk_mtilde.get() + (i * encrypted_bsk_mtilde_ptr_increment),
                 tmp_encrypted_bsk.get() + (i * encrypted_bsk_ptr_increment));
-        }
+        }, pool);
 
         // Step 2: compute product and multiply plain modulus to the result
         // We need to multiply both in q and Bsk. Values in encrypted_safe are in base q and values in 
@@ -764,14 +696,11 @@ namespace seal
 
         for (int i = 0; i < encrypted_size; i++)
         {
-            for (int j = 0; j < coeff_mod_count; j++)
-            {
-                ntt_negacyclic_harvey_lazy(copy_encrypted_ntt_coeff_mod.get() + (j * coeff_count) + (i * encrypted_ptr_increment), coeff_small_ntt_tables_[j]);
-            }
-            for (int j = 0; j < bsk_base_mod_count_; j++)
-            {
-                ntt_negacyclic_harvey_lazy(copy_encrypted_ntt_bsk_base_mod.get() + (j * coeff_count) + (i * encrypted_bsk_ptr_increment), bsk_small_ntt_tables_[j]);
-            }
+            // Lazy reduction
+            ntt_negacyclic_harvey_lazy(copy_encrypted_ntt_coeff_mod.get() + (i * encrypted_ptr_increment), coeff_count, coeff_mod_count,
+                coeff_small_ntt_tables_.data(), ntt_thread_pool());
+            ntt_negacyclic_harvey_lazy(copy_encrypted_ntt_bsk_base_mod.get() + (i * encrypted_bsk_ptr_increment), coeff_count, bsk_base_mod_count_,
+                bsk_small_ntt_tables_.data(), ntt_thread_pool());
         }
 
         // Perform fast squaring
@@ -832,51 +761,44 @@ namespace seal
         // Convert back outputs from NTT form
         for (int i = 0; i < dest_count; i++)
         {
-            for (int j = 0; j < coeff_mod_count; j++)
-            {
-                inverse_ntt_negacyclic_harvey_lazy(tmp_des_coeff_base.get() + (i * (encrypted_ptr_increment)) + (j * coeff_count),
-                    coeff_small_ntt_tables_[j]);
-            }
-            for (int j = 0; j < bsk_base_mod_count_; j++)
-            {
-                inverse_ntt_negacyclic_harvey_lazy(tmp_des_bsk_base.get() + (i * (encrypted_bsk_ptr_increment)) + (j * coeff_count), bsk_small_ntt_tables_[j]);
-            }
+            inverse_ntt_negacyclic_harvey_lazy(tmp_des_coeff_base.get() + (i * encrypted_ptr_increment), coeff_count, coeff_mod_count,
+                coeff_small_ntt_tables_.data(), ntt_thread_pool());
+            inverse_ntt_negacyclic_harvey_lazy(tmp_des_bsk_base.get() + (i * encrypted_bsk_ptr_increment), coeff_count, bsk_base_mod_count_,
+                bsk_small_ntt_tables_.data(), ntt_thread_pool());
         }
 
         // Now we multiply plain modulus to both results in base q and Bsk and allocate them together in one 
         // container as (te0)q(te'0)Bsk | ... |te count)q (te' count)Bsk to make it ready for fast_floor 
         Pointer tmp_coeff_bsk_together(allocate_poly(coeff_count, dest_count * (coeff_mod_count + bsk_base_mod_count_), pool));
-        uint64_t *tmp_coeff_bsk_together_ptr = tmp_coeff_bsk_together.get();
 
-        // Base q 
-        for (int i = 0; i < dest_count; i++)
-        {
+        // Allocate a new poly for fast floor result in Bsk
+        Pointer tmp_result_bsk(allocate_poly(coeff_count, dest_count * bsk_base_mod_count_, pool));
+
+        // Each component of the destination is a task
+        parallel_for(dest_count, [&](int i) {
+            uint64_t *tmp_coeff_bsk_together_ptr = tmp_coeff_bsk_together.get() + (i * (encrypted_ptr_increment + encrypted_bsk_ptr_increment));
+
+            // Base q 
             for (int j = 0; j < coeff_mod_count; j++)
             {
-                multiply_poly_scalar_coeffmod(tmp_des_coeff_base.get() + (j * coeff_count) + (i * encrypted_ptr_increment),
+                multiply_poly_scalar_coeffmod(tmp_des_coeff_base.get() + (j * coeff_count) + (i * encrypted_ptr_increment), 
                     coeff_count, parms_.plain_modulus().value(), coeff_modulus_[j], tmp_coeff_bsk_together_ptr + (j * coeff_count));
             }
             tmp_coeff_bsk_together_ptr += encrypted_ptr_increment;
-
+            
             for (int k = 0; k < bsk_base_mod_count_; k++)
             {
-                multiply_poly_scalar_coeffmod(tmp_des_bsk_base.get() + (k * coeff_count) + (i * encrypted_bsk_ptr_increment),
+                multiply_poly_scalar_coeffmod(tmp_des_bsk_base.get() + (k * coeff_count) + (i * encrypted_bsk_ptr_increment), 
                     coeff_count, parms_.plain_modulus().value(), bsk_mod_array_[k], tmp_coeff_bsk_together_ptr + (k * coeff_count));
             }
-            tmp_coeff_bsk_together_ptr += encrypted_bsk_ptr_increment;
-        }
 
-        // Allocate a new poly for fast floor result in Bsk
-        Pointer tmp_result_bsk(allocate_poly(coeff_count, dest_count * bsk_base_mod_count_, pool));
-        for (int i = 0; i < dest_count; i++)
-        {
             // Step 3: fast floor from q U {Bsk} to Bsk 
-            base_converter_.fast_floor(tmp_coeff_bsk_together.get() + (i * (encrypted_ptr_increment + encrypted_bsk_ptr_increment)),
+            base_converter_.fast_floor(tmp_coeff_bsk_together.get() + (i * (encrypted_ptr_increment + encrypted_bsk_ptr_increment)), 
                 tmp_result_bsk.get() + (i * encrypted_bsk_ptr_increment), pool);
 
             // Step 4: fast base convert from Bsk to q
             base_converter_.fastbconv_sk(tmp_result_bsk.get() + (i * encrypted_bsk_ptr_increment), encrypted.mutable_pointer(i), pool);
-        }
+        }, pool);
     }
 
     void Evaluator::relinearize(Ciphertext &encrypted, const EvaluationKeys &evaluation_keys, int destination_size, const MemoryPoolHandle &pool)
@@ -969,7 +891,7 @@ namespace seal
         Pointer wide_innerresult0(allocate_zero_poly(coeff_count, 2 * coeff_mod_count, pool));
         Pointer wide_innerresult1(allocate_zero_poly(coeff_count, 2 * coeff_mod_count, pool));
         Pointer innerresult(allocate_poly(coeff_count, coeff_mod_count, pool));
-        Pointer temp_decomp_coeff(allocate_uint(coeff_count, pool));
+        Pointer temp_decomp_coeff(allocate_poly(coeff_count, coeff_mod_count, pool));
 
         /*
         For lazy reduction to work here, we need to ensure that the 128-bit accumulators (wide_innerresult0 and wide_innerresult1)
@@ -979,8 +901,8 @@ namespace seal
         */
         for (int i = 0; i < coeff_mod_count; i++)
         {
-            multiply_poly_scalar_coeffmod(encrypted_coeff + (i * coeff_count), coeff_count, 
-                inv_coeff_products_mod_coeff_array_[i], coeff_modulus_[i], encrypted_coeff_prod_inv_coeff.get());
+            multiply_poly_scalar_coeffmod(encrypted_coeff + (i * coeff_count), coeff_count, inv_coeff_products_mod_coeff_array_[i], 
+                inv_coeff_products_mod_coeff_shoup_array_[i], coeff_modulus_[i], encrypted_coeff_prod_inv_coeff.get());
 
             int shift = 0;
             for (int k = 0; k < evaluation_keys.data()[0][i].size(); k += 2)
@@ -994,53 +916,57 @@ namespace seal
 
                 for (int j = 0; j < coeff_mod_count; j++)
                 {
-                    set_uint_uint(decomp_encrypted_last.get(), coeff_count, temp_decomp_coeff.get());
+                    set_uint_uint(decomp_encrypted_last.get(), coeff_count, temp_decomp_coeff.get() + (j * coeff_count));
+                }
+
+                // We don't reduce here, so might get up to two extra bits. Thus 62 bits at most.
+                ntt_negacyclic_harvey_lazy(temp_decomp_coeff.get(), coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
 
-                    // We don't reduce here, so might get up to two extra bits. Thus 62 bits at most.
-                    ntt_negacyclic_harvey_lazy(temp_decomp_coeff.get(), coeff_small_ntt_tables_[j]);
+                // Each residue of the results is a task
+                parallel_for(coeff_mod_count, [&](int j) {
+                    const uint64_t *temp_decomp_coeff_ptr = temp_decomp_coeff.get() + (j * coeff_count);
+                    const uint64_t *key0_ptr = evaluation_keys.key(encrypted_size - 1)[i].pointer(k) + (j * coeff_count);
+                    const uint64_t *key1_ptr = evaluation_keys.key(encrypted_size - 1)[i].pointer(k + 1) + (j * coeff_count);
 
                     // Lazy reduction
                     uint64_t wide_innerproduct[2];
                     for (int m = 0; m < coeff_count; m++)
                     {
-                        multiply_uint64(temp_decomp_coeff[m], 
-                            *(evaluation_keys.key(encrypted_size - 1)[i].pointer(k) + (m + j * coeff_count)), wide_innerproduct);
+                        multiply_uint64(temp_decomp_coeff_ptr[m], key0_ptr[m], wide_innerproduct);
                         unsigned char carry = add_uint64(wide_innerresult0[2 * (m + j * coeff_count)], wide_innerproduct[0], 0, 
                             wide_innerresult0.get() + 2 * (m + j * coeff_count));
                         wide_innerresult0[2 * (m + j * coeff_count) + 1] += wide_innerproduct[1] + carry;
 
-                        multiply_uint64(temp_decomp_coeff[m],
-                            *(evaluation_keys.key(encrypted_size - 1)[i].pointer(k + 1) + (m + j * coeff_count)), wide_innerproduct);
+                        multiply_uint64(temp_decomp_coeff_ptr[m], key1_ptr[m], wide_innerproduct);
                         carry = add_uint64(wide_innerresult1[2 * (m + j * coeff_count)], wide_innerproduct[0], 0,
                             wide_innerresult1.get() + 2 * (m + j * coeff_count));
                         wide_innerresult1[2 * (m + j * coeff_count) + 1] += wide_innerproduct[1] + carry;
                     }
-                }
+                }, pool);
 
                 shift += evaluation_keys.decomposition_bit_count();
             }
         }
 
-        for (int i = 0; i < coeff_mod_count; i++)
-        {
+        // Each residue is a task
+        parallel_for(coeff_mod_count, [&](int i) {
+            uint64_t *innerresult_ptr = innerresult.get() + (i * coeff_count);
             for (int m = 0; m < coeff_count; m++)
             {
-                innerresult[m + (i * coeff_count)] = barrett_reduce_128(wide_innerresult0.get() + 2 * (m + i * coeff_count), 
-                    coeff_modulus_[i]);
+                innerresult_ptr[m] = barrett_reduce_128(wide_innerresult0.get() + 2 * (m + i * coeff_count), coeff_modulus_[i]);
             }
-            inverse_ntt_negacyclic_harvey(innerresult.get() + (i * coeff_count), coeff_small_ntt_tables_[i]);
-            add_poly_poly_coeffmod(encrypted + (i * coeff_count), innerresult.get() + (i * coeff_count), 
+            inverse_ntt_negacyclic_harvey(innerresult_ptr, coeff_small_ntt_tables_[i]);
+            add_poly_poly_coeffmod(encrypted + (i * coeff_count), innerresult_ptr, 
                 coeff_count, coeff_modulus_[i], encrypted + (i * coeff_count));
 
             for (int m = 0; m < coeff_count; m++)
             {
-                innerresult[m + (i * coeff_count)] = barrett_reduce_128(wide_innerresult1.get() + 2 * (m + i * coeff_count), 
-                    coeff_modulus_[i]);
+                innerresult_ptr[m] = barrett_reduce_128(wide_innerresult1.get() + 2 * (m + i * coeff_count), coeff_modulus_[i]);
             }
-            inverse_ntt_negacyclic_harvey(innerresult.get() + (i * coeff_count), coeff_small_ntt_tables_[i]);
-            add_poly_poly_coeffmod(encrypted + (i * coeff_count) + array_poly_uint64_count, innerresult.get() + (i * coeff_count), 
+            inverse_ntt_negacyclic_harvey(innerresult_ptr, coeff_small_ntt_tables_[i]);
+            add_poly_poly_coeffmod(encrypted + (i * coeff_count) + array_poly_uint64_count, innerresult_ptr, 
                 coeff_count, coeff_modulus_[i], encrypted + (i * coeff_count) + array_poly_uint64_count);
-        }
+        }, pool);
     }
 
     void Evaluator::multiply_many(vector<Ciphertext> &encrypteds, const EvaluationKeys &evaluation_keys, Ciphertext &destination, const MemoryPoolHandle &pool)
@@ -1148,10 +1074,8 @@ namespace seal
                 // Loop over primes
                 for (int j = 0; j < coeff_mod_count; j++)
                 {
-                    uint64_t temp[2]{ 0 };
-                    multiply_uint64(*(coeff_div_plain_modulus_.get() + j), plain[i], temp);
-                    temp[1] += add_uint64(temp[0], *(upper_half_increment_.get() + j), 0, temp);
-                    uint64_t scaled_plain_coeff = barrett_reduce_128(temp, coeff_modulus_[j]);
+                    uint64_t scaled_plain_coeff = multiply_add_uint_mod(plain[i], coeff_div_plain_modulus_[j], 
+                        coeff_div_plain_modulus_shoup_array_[j], upper_half_increment_[j], coeff_modulus_[j]);
                     *(encrypted.mutable_pointer() + i + (j * coeff_count)) = add_uint_uint_mod(encrypted[i + (j * coeff_count)], scaled_plain_coeff, coeff_modulus_[j]);
                 }
             }
@@ -1159,8 +1083,8 @@ namespace seal
             {
                 for (int j = 0; j < coeff_mod_count; j++)
                 {
-                    uint64_t scaled_plain_coeff = multiply_uint_uint_mod(coeff_div_plain_modulus_[j], plain[i], coeff_modulus_[j]);
-                    *(encrypted.mutable_pointer() + i + (j * coeff_count)) = add_uint_uint_mod(encrypted[i + (j * coeff_count)], scaled_plain_coeff, coeff_modulus_[j]);
+                    *(encrypted.mutable_pointer() + i + (j * coeff_count)) = multiply_add_uint_mod(plain[i], coeff_div_plain_modulus_[j], 
+                        coeff_div_plain_modulus_shoup_array_[j], encrypted[i + (j * coeff_count)], coeff_modulus_[j]);
                 }
             }
         }
@@ -1198,10 +1122,8 @@ namespace seal
                 // Loop over primes
                 for (int j = 0; j < coeff_mod_count; j++)
                 {
-                    uint64_t temp[2]{ 0 };
-                    multiply_uint64(*(coeff_div_plain_modulus_.get() + j), plain[i], temp);
-                    temp[1] += add_uint64(temp[0], *(upper_half_increment_.get() + j), 0, temp);
-                    uint64_t scaled_plain_coeff = barrett_reduce_128(temp, coeff_modulus_[j]);
+                    uint64_t scaled_plain_coeff = multiply_add_uint_mod(plain[i], coeff_div_plain_modulus_[j], 
+                        coeff_div_plain_modulus_shoup_array_[j], upper_half_increment_[j], coeff_modulus_[j]);
                     *(encrypted.mutable_pointer() + i + (j * coeff_count)) = sub_uint_uint_mod(encrypted[i + (j * coeff_count)], scaled_plain_coeff, coeff_modulus_[j]);
                 }
             }
@@ -1209,7 +1131,8 @@ namespace seal
             {
                 for (int j = 0; j < coeff_mod_count; j++)
                 {
-                    uint64_t scaled_plain_coeff = multiply_uint_uint_mod(coeff_div_plain_modulus_[j], plain[i], coeff_modulus_[j]);
+                    uint64_t scaled_plain_coeff = multiply_uint_uint_mod(plain[i], coeff_div_plain_modulus_[j], 
+                        coeff_div_plain_modulus_shoup_array_[j], coeff_modulus_[j]);
                     *(encrypted.mutable_pointer() + i + (j * coeff_count)) = sub_uint_uint_mod(encrypted[i + (j * coeff_count)], scaled_plain_coeff, coeff_modulus_[j]);
                 }
             }
@@ -1364,18 +1287,21 @@ namespace seal
 
         // Need to multiply each component in encrypted with decomposed_poly (plain poly)
         // Transform plain poly only once
-        for (int i = 0; i < coeff_mod_count; i++)
-        {
-            ntt_negacyclic_harvey(poly_to_transform + (i * coeff_count), coeff_small_ntt_tables_[i]);
-        }
+        ntt_negacyclic_harvey(poly_to_transform, coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
 
+        // Each component is transformed in place, all of its residues at once
         for (int i = 0; i < encrypted_size; i++)
         {
+            uint64_t *encrypted_ptr = encrypted.mutable_pointer(i);
+
+            // Lazy reduction
+            ntt_negacyclic_harvey_lazy(encrypted_ptr, coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
             for (int j = 0; j < coeff_mod_count; j++)
             {
-                ntt_multiply_poly_nttpoly(encrypted.pointer(i) + (j * coeff_count), poly_to_transform + (j * coeff_count),
-                    coeff_small_ntt_tables_[j], encrypted.mutable_pointer(i) + (j * coeff_count), pool);
+                dyadic_product_coeffmod(encrypted_ptr + (j * coeff_count), poly_to_transform + (j * coeff_count), coeff_count,
+                    coeff_modulus_[j], encrypted_ptr + (j * coeff_count));
             }
+            inverse_ntt_negacyclic_harvey(encrypted_ptr, coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
         }
     }
 
@@ -1451,10 +1377,7 @@ namespace seal
         }
 
         // Transform to NTT domain
-        for (int i = 0; i < coeff_mod_count; i++)
-        {
-            ntt_negacyclic_harvey(plain.pointer() + (i * coeff_count), coeff_small_ntt_tables_[i]);
-        }
+        ntt_negacyclic_harvey(plain.pointer(), coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
     }
 
     void Evaluator::transform_to_ntt(Ciphertext &encrypted)
@@ -1473,10 +1396,7 @@ namespace seal
         // Transform each polynomial to NTT domain
         for (int i = 0; i < encrypted_size; i++)
         {
-            for (int j = 0; j < coeff_mod_count; j++)
-            {
-                ntt_negacyclic_harvey(encrypted.mutable_pointer(i) + (j * coeff_count), coeff_small_ntt_tables_[j]);
-            }
+            ntt_negacyclic_harvey(encrypted.mutable_pointer(i), coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
         }
     }
 
@@ -1496,10 +1416,7 @@ namespace seal
         // Transform each polynomial from NTT domain
         for (int i = 0; i < encrypted_ntt_size; i++)
         {
-            for (int j = 0; j < coeff_mod_count; j++)
-            {
-                inverse_ntt_negacyclic_harvey(encrypted_ntt.mutable_pointer(i) + (j * coeff_count), coeff_small_ntt_tables_[j]);
-            }
+            inverse_ntt_negacyclic_harvey(encrypted_ntt.mutable_pointer(i), coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
         }
     }
 
@@ -1628,17 +1545,15 @@ namespace seal
 
         // Apply Galois for each ciphertext
         Pointer temp0(allocate_zero_uint(coeff_count * coeff_mod_count, pool));
-        for (int i = 0; i < coeff_mod_count; i++)
-        {
-            util::apply_galois(encrypted.pointer() + (i * coeff_count), n_power_of_two,
-                galois_elt, coeff_modulus_[i], temp0.get() + (i * coeff_count));
-        }
         Pointer temp1(allocate_zero_uint(coeff_count * coeff_mod_count, pool));
-        for (int i = 0; i < coeff_mod_count; i++)
-        {
-            util::apply_galois(encrypted.pointer(1) + (i * coeff_count), n_power_of_two,
-                galois_elt, coeff_modulus_[i], temp1.get() + (i * coeff_count));
-        }
+
+        // Each residue of each component is a task, the ones of the second component coming after the ones of the first
+        parallel_for(2 * coeff_mod_count, [&](int task) {
+            int component = task / coeff_mod_count;
+            int i = task % coeff_mod_count;
+            util::apply_galois(encrypted.pointer(component) + (i * coeff_count), n_power_of_two,
+                galois_elt, coeff_modulus_[i], (component ? temp1 : temp0).get() + (i * coeff_count));
+        }, pool);
 
         // Calculate (temp1 * galois_key.first, temp1 * galois_key.second) + (temp0, 0)
         const uint64_t *encrypted_coeff = temp1.get();
@@ -1653,7 +1568,7 @@ namespace seal
         Pointer wide_innerresult0(allocate_zero_poly(coeff_count, 2 * coeff_mod_count, pool));
         Pointer wide_innerresult1(allocate_zero_poly(coeff_count, 2 * coeff_mod_count, pool));
         Pointer innerresult(allocate_poly(coeff_count, coeff_mod_count, pool));
-        Pointer temp_decomp_coeff(allocate_uint(coeff_count, pool));
+        Pointer temp_decomp_coeff(allocate_poly(coeff_count, coeff_mod_count, pool));
 
         /*
         For lazy reduction to work here, we need to ensure that the 128-bit accumulators (wide_innerresult0 and wide_innerresult1)
@@ -1664,7 +1579,7 @@ namespace seal
         for (int i = 0; i < coeff_mod_count; i++)
         {
             multiply_poly_scalar_coeffmod(encrypted_coeff + (i * coeff_count), coeff_count, inv_coeff_products_mod_coeff_array_[i], 
-                coeff_modulus_[i], encrypted_coeff_prod_inv_coeff.get());
+                inv_coeff_products_mod_coeff_shoup_array_[i], coeff_modulus_[i], encrypted_coeff_prod_inv_coeff.get());
 
             int shift = 0;
             for (int k = 0; k < galois_keys.key(galois_elt)[i].size(); k += 2)
@@ -1678,51 +1593,52 @@ namespace seal
 
                 for (int j = 0; j < coeff_mod_count; j++)
                 {
-                    set_uint_uint(decomp_encrypted_last.get(), coeff_count, temp_decomp_coeff.get());
+                    set_uint_uint(decomp_encrypted_last.get(), coeff_count, temp_decomp_coeff.get() + (j * coeff_count));
+                }
+
+                // We don't reduce here, so might get up to two extra bits. Thus 62 bits at most.
+                ntt_negacyclic_harvey_lazy(temp_decomp_coeff.get(), coeff_count, coeff_mod_count, coeff_small_ntt_tables_.data(), ntt_thread_pool());
 
-                    // We don't reduce here, so might get up to two extra bits. Thus 62 bits at most.
-                    ntt_negacyclic_harvey_lazy(temp_decomp_coeff.get(), coeff_small_ntt_tables_[j]);
+                // Each residue of the results is a task
+                parallel_for(coeff_mod_count, [&](int j) {
+                    const uint64_t *temp_decomp_coeff_ptr = temp_decomp_coeff.get() + (j * coeff_count);
+                    const uint64_t *key0_ptr = galois_keys.key(galois_elt)[i].pointer(k) + (j * coeff_count);
+                    const uint64_t *key1_ptr = galois_keys.key(galois_elt)[i].pointer(k + 1) + (j * coeff_count);
 
                     // Lazy reduction
                     uint64_t wide_innerproduct[2];
                     for (int m = 0; m < coeff_count; m++)
                     {
-                        multiply_uint64(temp_decomp_coeff[m], *(galois_keys.key(galois_elt)[i].pointer(k) + (m + j * coeff_count)), 
-                            wide_innerproduct);
+                        multiply_uint64(temp_decomp_coeff_ptr[m], key0_ptr[m], wide_innerproduct);
                         unsigned char carry = add_uint64(wide_innerresult0[2 * (m + j * coeff_count)], wide_innerproduct[0], 0,
                             wide_innerresult0.get() + 2 * (m + j * coeff_count));
                         wide_innerresult0[2 * (m + j * coeff_count) + 1] += wide_innerproduct[1] + carry;
 
-                        multiply_uint64(temp_decomp_coeff[m], *(galois_keys.key(galois_elt)[i].pointer(k + 1) + (m + j * coeff_count)), 
-                            wide_innerproduct);
+                        multiply_uint64(temp_decomp_coeff_ptr[m], key1_ptr[m], wide_innerproduct);
                         carry = add_uint64(wide_innerresult1[2 * (m + j * coeff_count)], wide_innerproduct[0], 0,
                             wide_innerresult1.get() + 2 * (m + j * coeff_count));
                         wide_innerresult1[2 * (m + j * coeff_count) + 1] += wide_innerproduct[1] + carry;
                     }
-                }
+                }, pool);
 
                 shift += galois_keys.decomposition_bit_count();
             }
         }
 
-        for (int i = 0; i < coeff_mod_count; i++)
-        {
+        // Each residue is a task
+        parallel_for(coeff_mod_count, [&](int i) {
+            uint64_t *innerresult_ptr = innerresult.get() + (i * coeff_count);
+            uint64_t *encrypted1_ptr = encrypted.mutable_pointer(1) + (i * coeff_count);
             for (int m = 0; m < coeff_count; m++)
             {
-                innerresult[m + (i * coeff_count)] = barrett_reduce_128(wide_innerresult0.get() + 2 * (m + i * coeff_count), 
-                    coeff_modulus_[i]);
+                innerresult_ptr[m] = barrett_reduce_128(wide_innerresult0.get() + 2 * (m + i * coeff_count), coeff_modulus_[i]);
+                encrypted1_ptr[m] = barrett_reduce_128(wide_innerresult1.get() + 2 * (m + i * coeff_count), coeff_modulus_[i]);
             }
-            inverse_ntt_negacyclic_harvey(innerresult.get() + (i * coeff_count), coeff_small_ntt_tables_[i]);
-            add_poly_poly_coeffmod(temp0.get() + (i * coeff_count), innerresult.get() + (i * coeff_count), coeff_count, coeff_modulus_[i],
+            inverse_ntt_negacyclic_harvey(innerresult_ptr, coeff_small_ntt_tables_[i]);
+            inverse_ntt_negacyclic_harvey(encrypted1_ptr, coeff_small_ntt_tables_[i]);
+            add_poly_poly_coeffmod(temp0.get() + (i * coeff_count), innerresult_ptr, coeff_count, coeff_modulus_[i],
                 encrypted.mutable_pointer() + (i * coeff_count));
-
-            for (int m = 0; m < coeff_count; m++)
-            {
-                encrypted.mutable_pointer(1)[m + (i * coeff_count)] = barrett_reduce_128(wide_innerresult1.get() + 2 * (m + i * coeff_count), 
-                    coeff_modulus_[i]);
-            }
-            inverse_ntt_negacyclic_harvey(encrypted.mutable_pointer(1) + (i * coeff_count), coeff_small_ntt_tables_[i]);
-        }
+        }, pool);
     }
 
     void Evaluator::rotate_rows(Ciphertext &encrypted, int steps, const GaloisKeys &galois_keys, const MemoryPoolHandle &pool)
@@ -3,11 +3,13 @@
 #include <vector>
 #include <utility>
 #include <map>
+#include <functional>
 #include "seal/encryptionparams.h"
 #include "seal/context.h"
 #include "seal/evaluationkeys.h"
 #include "seal/smallmodulus.h"
 #include "seal/memorypoolhandle.h"
+#include "seal/threadpoolhandle.h"
 #include "seal/ciphertext.h"
 #include "seal/plaintext.h"
 #include "seal/galoiskeys.h"
@@ -82,6 +84,15 @@ namespace seal
     operations we provide up to four different overloads, and it is important for 
     a developer to understand how these work to avoid unnecessary performance bottlenecks.
 
+    @par Parallel Execution
+    By default every operation runs on the thread calling it. An Evaluator can instead be given
+    a thread pool with set_thread_pool, and then splits multiplication, squaring, relinearization
+    and rotations across the RNS moduli and the ciphertext components, between the threads of
+    the pool, as well as the NTTs of the other operations. The results are identical with and 
+    without a thread pool. Since the memory pool of the operation is then used by several 
+    threads, operations given a thread-unsafe memory pool only split their NTTs, which allocate
+    no memory.
+
     @see EncryptionParameters for more details on encryption parameters.
     @see PolyCRTBuilder for more details on batching
     @see EvaluationKeys for more details on evaluation keys.
@@ -117,6 +128,27 @@ namespace seal
         */
         Evaluator(Evaluator &&source) = default;
 
+        /**
+        Sets the thread pool the heaviest operations are split across. Operations given a 
+        thread-unsafe memory pool only split their NTTs. This function must not be called while 
+        other threads are using the Evaluator.
+
+        @param[in] thread_pool The ThreadPoolHandle pointing to the thread pool, or an 
+        uninitialized ThreadPoolHandle to run every operation on the calling thread
+        */
+        inline void set_thread_pool(const ThreadPoolHandle &thread_pool)
+        {
+            thread_pool_ = thread_pool;
+        }
+
+        /**
+        Returns the ThreadPoolHandle set with set_thread_pool, which is uninitialized by default.
+        */
+        inline const ThreadPoolHandle &thread_pool() const
+        {
+            return thread_pool_;
+        }
+
         /**
         Negates a ciphertext.
 
@@ -1101,6 +1133,15 @@ namespace seal
 
         Evaluator &operator =(Evaluator &&assign) = delete;
 
+        // Calls task(i) for every i in [0, count), between the threads of thread_pool_ unless pool is thread-unsafe
+        void parallel_for(int count, const std::function<void(int)> &task, const MemoryPoolHandle &pool) const;
+
+        // The thread pool the batched NTTs are split across, or nullptr if there is none
+        inline util::ThreadPool *ntt_thread_pool() const
+        {
+            return thread_pool_ ? &static_cast<util::ThreadPool&>(thread_pool_) : nullptr;
+        }
+
         void relinearize(Ciphertext &encrypted, const EvaluationKeys &evaluation_keys, int destination_size, 
             const MemoryPoolHandle &pool);
 
@@ -1237,6 +1278,8 @@ namespace seal
 
         MemoryPoolHandle pool_;
 
+        ThreadPoolHandle thread_pool_;
+
         EncryptionParameters parms_;
 
         EncryptionParameterQualifiers qualifiers_;
@@ -1251,6 +1294,8 @@ namespace seal
 
         util::Pointer coeff_div_plain_modulus_;
 
+        std::vector<std::uint64_t> coeff_div_plain_modulus_shoup_array_;
+
         std::uint64_t plain_upper_half_threshold_;
 
         util::Pointer plain_upper_half_increment_;
@@ -1273,6 +1318,8 @@ namespace seal
 
         std::vector<std::uint64_t> inv_coeff_products_mod_coeff_array_;
 
+        std::vector<std::uint64_t> inv_coeff_products_mod_coeff_shoup_array_;
+
         int bsk_base_mod_count_;
 
         std::map<std::uint64_t, std::pair<std::uint64_t, std::uint64_t> > Zmstar_to_generator_;
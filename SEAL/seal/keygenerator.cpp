@@ -90,12 +90,17 @@ namespace seal
         small_ntt_tables_ = context.small_ntt_tables_;
 
         // Initialize public and secret key.
-        public_key_.mutable_data().resize(2, coeff_count, coeff_mod_count);
-        secret_key_.mutable_data().resize(coeff_count, coeff_mod_count);
+        public_key_.mutable_data().resize(2, coeff_count, coeff_mod_count * bits_per_uint64);
+        secret_key_.mutable_data().resize(coeff_count, coeff_mod_count * bits_per_uint64);
 
         // Initialize moduli.
         polymod_ = PolyModulus(parms_.poly_modulus().pointer(), coeff_count, poly_coeff_uint64_count);
 
+        // Set the secret_key_array to have size 1 (first power of secret)
+        secret_key_array_ = allocate_poly(coeff_count, coeff_mod_count, pool_);
+        set_poly_poly(secret_key_.data().pointer(), coeff_count, coeff_mod_count, secret_key_array_.get());
+        secret_key_array_size_ = 1;
+
         // Secret key and public key are generated
         generated_ = true;
     }
@@ -288,6 +293,14 @@ namespace seal
     }
 
     void KeyGenerator::generate_galois_keys(int decomposition_bit_count, const vector<uint64_t> &galois_elts, GaloisKeys &galois_keys)
+    {
+        // Clear the current keys
+        galois_keys.mutable_data().clear();
+
+        add_galois_keys(decomposition_bit_count, galois_elts, galois_keys);
+    }
+
+    void KeyGenerator::add_galois_keys(int decomposition_bit_count, const vector<uint64_t> &galois_elts, GaloisKeys &galois_keys)
     {
         // Check to see if secret key and public key have been generated
         if (!generated_)
@@ -305,8 +318,12 @@ namespace seal
             throw invalid_argument("decomposition_bit_count is not on the valid range");
         }
 
-        // Clear the current keys
-        galois_keys.mutable_data().clear();
+        // Keys can only be added to keys generated for the same parameters and decomposition bit count
+        if (!galois_keys.data().empty() && (galois_keys.hash_block_ != parms_.hash_block() || 
+            galois_keys.decomposition_bit_count_ != decomposition_bit_count))
+        {
+            throw invalid_argument("galois_keys are not valid for encryption parameters");
+        }
 
         // Extract encryption parameters.
         int coeff_count = parms_.poly_modulus().coeff_count();
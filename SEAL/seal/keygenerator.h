@@ -108,6 +108,55 @@ namespace seal
         */        
         void generate_galois_keys(int decomposition_bit_count, GaloisKeys &galois_keys);
 
+        /**
+        Generates Galois keys for the given Galois elements only. A rotation whose Galois element 
+        has a key takes a single key switch, instead of one for each power of two of its steps.
+
+        @param[in] decomposition_bit_count The decomposition bit count
+        @param[in] galois_elts The Galois elements to generate keys for
+        @param[out] galois_keys The Galois keys instance to overwrite with the generated keys
+        @throws std::invalid_argument if decomposition_bit_count is not within [1, 60]
+        @throws std::invalid_argument if a Galois element is not valid
+        @throws std::logic_error if the encryption parameters do not support batching
+        */
+        void generate_galois_keys(int decomposition_bit_count, 
+            const std::vector<std::uint64_t> &galois_elts, GaloisKeys &galois_keys);
+
+        /**
+        Adds to galois_keys the keys for the given Galois elements that it does not hold yet, leaving 
+        the other keys unchanged. The keys held by galois_keys must have been generated from the secret 
+        key of this KeyGenerator, which cannot be checked: extending keys generated from another secret 
+        key gives a set of keys that rotates some ciphertexts incorrectly.
+
+        @param[in] decomposition_bit_count The decomposition bit count
+        @param[in] galois_elts The Galois elements to generate keys for
+        @param[in,out] galois_keys The Galois keys instance to extend
+        @throws std::invalid_argument if decomposition_bit_count is not within [1, 60]
+        @throws std::invalid_argument if a Galois element is not valid
+        @throws std::invalid_argument if galois_keys holds keys generated for other encryption parameters 
+        or another decomposition bit count
+        @throws std::logic_error if the encryption parameters do not support batching
+        */
+        void add_galois_keys(int decomposition_bit_count, 
+            const std::vector<std::uint64_t> &galois_elts, GaloisKeys &galois_keys);
+
+        /**
+        Generates and returns Galois keys for the given Galois elements only.
+
+        @param[in] decomposition_bit_count The decomposition bit count
+        @param[in] galois_elts The Galois elements to generate keys for
+        @throws std::invalid_argument if decomposition_bit_count is not within [1, 60]
+        @throws std::invalid_argument if a Galois element is not valid
+        @throws std::logic_error if the encryption parameters do not support batching
+        */
+        inline GaloisKeys generate_galois_keys(int decomposition_bit_count, 
+            const std::vector<std::uint64_t> &galois_elts)
+        {
+            GaloisKeys keys;
+            generate_galois_keys(decomposition_bit_count, galois_elts, keys);
+            return keys;
+        }
+
     private:
         KeyGenerator(const KeyGenerator &copy) = delete;
 
@@ -141,17 +190,6 @@ namespace seal
             return generated_;
         }
 
-        void generate_galois_keys(int decomposition_bit_count, 
-            const std::vector<std::uint64_t> &galois_elts, GaloisKeys &galois_keys);
-
-        inline GaloisKeys generate_galois_keys(int decomposition_bit_count, 
-            const std::vector<std::uint64_t> &galois_elts)
-        {
-            GaloisKeys keys;
-            generate_galois_keys(decomposition_bit_count, galois_elts, keys);
-            return keys;
-        }
-
         MemoryPoolHandle pool_;
 
         EncryptionParameters parms_;
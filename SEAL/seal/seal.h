@@ -30,5 +30,6 @@
 #include "seal/secretkey.h"
 #include "seal/simulator.h"
 #include "seal/smallmodulus.h"
+#include "seal/threadpoolhandle.h"
 #include "seal/utilities.h"
 
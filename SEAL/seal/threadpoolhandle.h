@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "seal/util/threadpool.h"
+
+namespace seal
+{
+    /**
+    Manages a shared pointer to a pool of threads. By default SEAL runs each operation on the thread
+    calling it, and multi-threaded applications run several operations at once. When a single operation
+    has to return as soon as possible (for example one multiplication with a large poly_modulus), an
+    Evaluator can instead be given a ThreadPoolHandle (see Evaluator::set_thread_pool), and then splits
+    its heaviest operations between the threads of the pool.
+
+    @par Sharing Thread Pools
+    A thread pool can be shared by any number of Evaluators, and used by several threads at once. The
+    thread starting an operation always takes part in it, so operations never wait for threads busy
+    elsewhere, but a pool with fewer threads than there are cores gives each operation less help.
+
+    @par Initialized and Uninitialized Handles
+    A ThreadPoolHandle created with the default constructor is uninitialized, and means that operations
+    run on the calling thread only. Initialization means assigning ThreadPoolHandle::New() to it.
+    */
+    class ThreadPoolHandle
+    {
+    public:
+        /**
+        Creates a new uninitialized ThreadPoolHandle.
+        */
+        ThreadPoolHandle() = default;
+
+        /**
+        Returns a ThreadPoolHandle pointing to a new thread pool. The threads of the pool are started
+        at once, and stopped when the last ThreadPoolHandle pointing to it is destroyed.
+
+        @param[in] thread_count The number of threads taking part in an operation, counting the thread
+        calling it, or 0 for the number of hardware threads of the processor
+        @throws std::invalid_argument if thread_count is negative
+        */
+        inline static ThreadPoolHandle New(int thread_count = 0)
+        {
+            if (thread_count < 0)
+            {
+                throw std::invalid_argument("thread_count cannot be negative");
+            }
+            if (thread_count == 0)
+            {
+                thread_count = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+            }
+            return ThreadPoolHandle(std::make_shared<util::ThreadPool>(thread_count));
+        }
+
+        /**
+        Returns the number of threads taking part in an operation, or 1 if the ThreadPoolHandle is
+        uninitialized.
+        */
+        inline int thread_count() const
+        {
+            return pool_ ? pool_->thread_count() : 1;
+        }
+
+        /**
+        Returns a reference to the internal SEAL thread pool that the ThreadPoolHandle points to.
+        This function is mainly for internal use.
+
+        @throws std::logic_error if the ThreadPoolHandle is uninitialized
+        */
+        inline operator util::ThreadPool &() const
+        {
+            if (!pool_)
+            {
+                throw std::logic_error("thread pool not initialized");
+            }
+            return *pool_.get();
+        }
+
+        /**
+        Returns whether the ThreadPoolHandle is initialized.
+        */
+        inline operator bool() const
+        {
+            return pool_.operator bool();
+        }
+
+    private:
+        ThreadPoolHandle(std::shared_ptr<util::ThreadPool> pool) : pool_(std::move(pool))
+        {
+        }
+
+        std::shared_ptr<util::ThreadPool> pool_;
+    };
+}
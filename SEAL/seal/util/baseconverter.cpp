@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <stdexcept>
 #include "seal/util/mempool.h"
 #include "seal/util/uintcore.h"
@@ -17,6 +18,92 @@ namespace seal
 {
     namespace util
     {
+        namespace
+        {
+            // Number of coefficients the base conversions work on at once, so that the residues of a block stay in the L1 cache
+            const int base_conversion_block_size = 256;
+
+            // Sets destination[k + (i * base_conversion_block_size)] to input[k + (i * coeff_count)] * factors[i] mod moduli[i], 
+            // for i in [0, count) and k in [0, block_count)
+            void multiply_block_scalar_mod(const uint64_t *input, int coeff_count, const uint64_t *factors, const SmallModulus *moduli, 
+                int count, int block_count, uint64_t *destination)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    const uint64_t *input_ptr = input + (i * coeff_count);
+                    uint64_t *destination_ptr = destination + (i * base_conversion_block_size);
+                    for (int k = 0; k < block_count; k++)
+                    {
+                        destination_ptr[k] = multiply_uint_uint_mod(input_ptr[k], factors[i], moduli[i]);
+                    }
+                }
+            }
+
+            inline void multiply_accumulate_uint64(uint64_t operand1, uint64_t operand2, uint64_t *accumulator)
+            {
+                uint64_t product[2];
+                multiply_uint64(operand1, operand2, product);
+                unsigned char carry = add_uint64(accumulator[0], product[0], 0, accumulator);
+                accumulator[1] += product[1] + carry;
+            }
+
+            // Sets wide[2 * k] and wide[2 * k + 1] to the 128-bit sum of input[k + (i * base_conversion_block_size)] * factors[i] 
+            // over i in [0, count), for k in [0, block_count). No reduction is done, so the caller bounds count.
+            void dot_product_block(const uint64_t *input, const uint64_t *factors, int count, int block_count, uint64_t *wide)
+            {
+                int k = 0;
+
+                // Four coefficients at a time, so that each factor is loaded once for four independent sums kept in registers
+                for (; k + 4 <= block_count; k += 4)
+                {
+                    uint64_t sum0[2]{ 0 }, sum1[2]{ 0 }, sum2[2]{ 0 }, sum3[2]{ 0 };
+                    for (int i = 0; i < count; i++)
+                    {
+                        const uint64_t *input_ptr = input + (k + (i * base_conversion_block_size));
+                        uint64_t factor = factors[i];
+                        multiply_accumulate_uint64(input_ptr[0], factor, sum0);
+                        multiply_accumulate_uint64(input_ptr[1], factor, sum1);
+                        multiply_accumulate_uint64(input_ptr[2], factor, sum2);
+                        multiply_accumulate_uint64(input_ptr[3], factor, sum3);
+                    }
+                    wide[2 * k] = sum0[0];
+                    wide[2 * k + 1] = sum0[1];
+                    wide[2 * k + 2] = sum1[0];
+                    wide[2 * k + 3] = sum1[1];
+                    wide[2 * k + 4] = sum2[0];
+                    wide[2 * k + 5] = sum2[1];
+                    wide[2 * k + 6] = sum3[0];
+                    wide[2 * k + 7] = sum3[1];
+                }
+                for (; k < block_count; k++)
+                {
+                    uint64_t sum[2]{ 0 };
+                    for (int i = 0; i < count; i++)
+                    {
+                        multiply_accumulate_uint64(input[k + (i * base_conversion_block_size)], factors[i], sum);
+                    }
+                    wide[2 * k] = sum[0];
+                    wide[2 * k + 1] = sum[1];
+                }
+            }
+
+            // Sets destination[k + (j * coeff_count)] to the sum of input[k + (i * base_conversion_block_size)] * factors[i + (j * count)] 
+            // over i in [0, count) mod moduli[j], for j in [0, destination_count) and k in [0, block_count)
+            void convert_block(const uint64_t *input, int count, const uint64_t *factors, const SmallModulus *moduli, int destination_count, 
+                int block_count, uint64_t *wide, uint64_t *destination, int coeff_count)
+            {
+                for (int j = 0; j < destination_count; j++)
+                {
+                    dot_product_block(input, factors + (j * count), count, block_count, wide);
+                    uint64_t *destination_ptr = destination + (j * coeff_count);
+                    for (int k = 0; k < block_count; k++)
+                    {
+                        destination_ptr[k] = barrett_reduce_128(wide + (2 * k), moduli[j]);
+                    }
+                }
+            }
+        }
+
         BaseConverter::BaseConverter(const BaseConverter &copy) : pool_(copy.pool_), generated_(copy.generated_),
             m_tilde_(copy.m_tilde_), m_sk_(copy.m_sk_), coeff_base_mod_count_(copy.coeff_base_mod_count_), aux_base_mod_count_(copy.aux_base_mod_count_),
             coeff_base_array_(copy.coeff_base_array_), aux_base_array_(copy.aux_base_array_), inv_aux_products_mod_msk_(copy.inv_aux_products_mod_msk_),
@@ -40,6 +127,10 @@ namespace seal
                 coeff_products_mod_plain_gamma_array_ = copy.coeff_products_mod_plain_gamma_array_;
                 neg_inv_coeff_products_all_mod_plain_gamma_array_ = copy.neg_inv_coeff_products_all_mod_plain_gamma_array_;
                 plain_gamma_product_mod_coeff_array_ = copy.plain_gamma_product_mod_coeff_array_;
+                coeff_base_products_mod_bsk_matrix_ = copy.coeff_base_products_mod_bsk_matrix_;
+                neg_inv_coeff_base_mod_bsk_matrix_ = copy.neg_inv_coeff_base_mod_bsk_matrix_;
+                aux_base_products_mod_coeff_matrix_ = copy.aux_base_products_mod_coeff_matrix_;
+                coeff_products_all_inv_mtilde_mod_bsk_array_ = copy.coeff_products_all_inv_mtilde_mod_bsk_array_;
             }
         }
 
@@ -103,10 +194,10 @@ namespace seal
                 coeff_base_products_mod_aux_bsk_array_[i].resize(bsk_base_mod_count_);
             }
 
-            aux_base_products_mod_coeff_array_.resize(aux_base_mod_count_);
-            for (int i = 0; i < aux_base_mod_count_; i++)
+            aux_base_products_mod_coeff_array_.resize(coeff_base_mod_count_);
+            for (int i = 0; i < coeff_base_mod_count_; i++)
             {
-                aux_base_products_mod_coeff_array_[i].resize(coeff_base_mod_count_);
+                aux_base_products_mod_coeff_array_[i].resize(aux_base_mod_count_);
             }
 
             coeff_products_mod_plain_gamma_array_.resize(coeff_base_mod_count_);
@@ -227,7 +318,7 @@ namespace seal
             }
 
             // Add qi mod msk at the end of the array
-            for (int i = 0; i < aux_base_mod_count_; i++)
+            for (int i = 0; i < coeff_base_mod_count_; i++)
             {
                 coeff_base_products_mod_aux_bsk_array_[i][aux_base_mod_count_] = modulo_uint(coeff_products_array.get() + (i * coeff_products_uint64_count), 
                     coeff_products_uint64_count, m_sk_, pool_);
@@ -371,6 +462,33 @@ namespace seal
                 plain_gamma_product_mod_coeff_array_[i] = multiply_uint_uint_mod(small_plain_mod_.value(), gamma_.value(), coeff_base_array_[i]);
             }
 
+            // Lay out the factors of the fast base conversions by output modulus, as the conversions read them
+            coeff_base_products_mod_bsk_matrix_.resize(bsk_base_mod_count_ * coeff_base_mod_count_);
+            neg_inv_coeff_base_mod_bsk_matrix_.resize(bsk_base_mod_count_ * coeff_base_mod_count_);
+            coeff_products_all_inv_mtilde_mod_bsk_array_.resize(bsk_base_mod_count_);
+            for (int j = 0; j < bsk_base_mod_count_; j++)
+            {
+                for (int i = 0; i < coeff_base_mod_count_; i++)
+                {
+                    // (q/qi) * q^(-1) = qi^(-1) mod mj
+                    uint64_t coeff_base_product = coeff_base_products_mod_aux_bsk_array_[i][j];
+                    coeff_base_products_mod_bsk_matrix_[i + (j * coeff_base_mod_count_)] = coeff_base_product;
+                    neg_inv_coeff_base_mod_bsk_matrix_[i + (j * coeff_base_mod_count_)] = negate_uint_mod(multiply_uint_uint_mod(
+                        coeff_base_product, inv_coeff_products_all_mod_aux_bsk_array_[j], bsk_base_array_[j]), bsk_base_array_[j]);
+                }
+                coeff_products_all_inv_mtilde_mod_bsk_array_[j] = multiply_uint_uint_mod(coeff_products_all_mod_bsk_array_[j], 
+                    inv_mtilde_mod_bsk_array_[j], bsk_base_array_[j]);
+            }
+
+            aux_base_products_mod_coeff_matrix_.resize(coeff_base_mod_count_ * aux_base_mod_count_);
+            for (int j = 0; j < coeff_base_mod_count_; j++)
+            {
+                for (int i = 0; i < aux_base_mod_count_; i++)
+                {
+                    aux_base_products_mod_coeff_matrix_[i + (j * aux_base_mod_count_)] = aux_base_products_mod_coeff_array_[j][i];
+                }
+            }
+
             // Everything went well
             generated_ = true;
         }
@@ -396,6 +514,10 @@ namespace seal
             coeff_products_mod_plain_gamma_array_.clear();
             neg_inv_coeff_products_all_mod_plain_gamma_array_.clear();
             plain_gamma_product_mod_coeff_array_.clear();
+            coeff_base_products_mod_bsk_matrix_.clear();
+            neg_inv_coeff_base_mod_bsk_matrix_.clear();
+            aux_base_products_mod_coeff_matrix_.clear();
+            coeff_products_all_inv_mtilde_mod_bsk_array_.clear();
             bsk_small_ntt_table_.clear();
             inv_coeff_products_mod_mtilde_ = 0;
             m_tilde_ = 0;
@@ -432,40 +554,19 @@ namespace seal
              Require: Input in q
              Ensure: Output in Bsk = {m1,...,ml} U {msk}
             */
-            Pointer temp_coeff_transition(allocate_uint(coeff_count_ * coeff_base_mod_count_, pool));
+            Pointer temp_coeff_transition(allocate_uint(base_conversion_block_size * coeff_base_mod_count_, pool));
+            Pointer wide_transition(allocate_uint(2 * base_conversion_block_size, pool));
 
-            for (int i = 0; i < coeff_base_mod_count_; i++)
+            for (int block_start = 0; block_start < coeff_count_; block_start += base_conversion_block_size)
             {
-                for (int k = 0; k < coeff_count_; k++)
-                {
-                    temp_coeff_transition[k + (i * coeff_count_)] = multiply_uint_uint_mod(input[k + (i * coeff_count_)], inv_coeff_base_products_mod_coeff_array_[i], coeff_base_array_[i]);
-                }
-            }
+                int block_count = min(base_conversion_block_size, coeff_count_ - block_start);
+                multiply_block_scalar_mod(input + block_start, coeff_count_, inv_coeff_base_products_mod_coeff_array_.data(), 
+                    coeff_base_array_.data(), coeff_base_mod_count_, block_count, temp_coeff_transition.get());
 
-            for (int j = 0; j < bsk_base_mod_count_; j++)
-            {
-                for (int k = 0; k < coeff_count_; k++)
-                {
-                    uint64_t aux_transition[2]{ 0 };
-                    for (int i = 0; i < coeff_base_mod_count_; i++)
-                    {
-                        {
-                            //uint64_t aux_transition;
-                            //multiply_uint64_mod(temp_coeff_transition.get() + k, &coeff_base_products_mod_aux_bsk_array_[i][j], bsk_base_array_[j], &aux_transition);
-                            //add_uint_uint_smallmod(&aux_transition, destination + (k + j * coeff_count_), bsk_base_array_[j], destination + (k + j * coeff_count_));
-
-                            // Lazy reduction
-                            uint64_t temp[2];
-
-                            // Product is 60 bit + 61 bit = 121 bit, so can sum up to 127 of them with no reduction
-                            // Thus need coeff_base_mod_count_ <= 127 to guarantee success
-                            multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], coeff_base_products_mod_aux_bsk_array_[i][j], temp);
-                            unsigned char carry = add_uint64(aux_transition[0], temp[0], 0, aux_transition);
-                            aux_transition[1] += temp[1] + carry;
-                        }
-                    }
-                    destination[k + (j * coeff_count_)] = barrett_reduce_128(aux_transition, bsk_base_array_[j]);
-                }
+                // Product is 60 bit + 61 bit = 121 bit, so can sum up to 127 of them with no reduction
+                // Thus need coeff_base_mod_count_ <= 127 to guarantee success
+                convert_block(temp_coeff_transition.get(), coeff_base_mod_count_, coeff_base_products_mod_bsk_matrix_.data(), 
+                    bsk_base_array_.data(), bsk_base_mod_count_, block_count, wide_transition.get(), destination + block_start, coeff_count_);
             }
         }
 
@@ -489,117 +590,55 @@ namespace seal
              Require: Input in base Bsk = M U {msk}
              Ensure: Output in base q
             */
+            Pointer temp_coeff_transition(allocate_uint(base_conversion_block_size * aux_base_mod_count_, pool));
+            Pointer wide_transition(allocate_uint(2 * base_conversion_block_size, pool));
+            Pointer alpha_sk(allocate_uint(base_conversion_block_size, pool));
 
-            // Fast convert B -> q
-            Pointer temp_coeff_transition(allocate_uint(coeff_count_ * coeff_base_mod_count_, pool));
-            for (int i = 0; i < coeff_base_mod_count_; i++)
-            {
-                for (int k = 0; k < coeff_count_; k++)
-                {
-                    temp_coeff_transition[k + (i * coeff_count_)] = multiply_uint_uint_mod(input[k + (i * coeff_count_)], inv_aux_base_products_mod_aux_array_[i], aux_base_array_[i]);
-                }
-            }
+            // x_sk is allocated in input[aux_base_mod_count_]
+            const uint64_t *input_sk = input + (aux_base_mod_count_ * coeff_count_);
+            uint64_t m_sk_div_2 = m_sk_.value() >> 1;
 
-            for (int j = 0; j < coeff_base_mod_count_; j++)
+            for (int block_start = 0; block_start < coeff_count_; block_start += base_conversion_block_size)
             {
-                for (int k = 0; k < coeff_count_; k++)
-                {
-                    uint64_t aux_transition[2]{ 0 };
-                    for (int i = 0; i < aux_base_mod_count_; i++)
-                    {
-                        //uint64_t aux_transition;
-                        //multiply_uint64_mod(temp_coeff_transition.get() + k + (i * coeff_count_), &aux_base_products_mod_coeff_array_[j][i], coeff_base_array_[j], &aux_transition);
-                        //add_uint_uint_smallmod(&aux_transition, destination + (k + j * coeff_count_), coeff_base_array_[j], destination + (k + j * coeff_count_));
-
-                        // Lazy reduction
-                        uint64_t temp[2];
+                int block_count = min(base_conversion_block_size, coeff_count_ - block_start);
+                multiply_block_scalar_mod(input + block_start, coeff_count_, inv_aux_base_products_mod_aux_array_.data(), 
+                    aux_base_array_.data(), aux_base_mod_count_, block_count, temp_coeff_transition.get());
 
-                        // Product is 61 bit + 60 bit = 121 bit, so can sum up to 127 of them with no reduction
-                        // Thus need aux_base_mod_count_ <= 127, so coeff_base_mod_count_ <= 126 to guarantee success
-                        multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], aux_base_products_mod_coeff_array_[j][i], temp);
-                        unsigned char carry = add_uint64(aux_transition[0], temp[0], 0, aux_transition);
-                        aux_transition[1] += temp[1] + carry;
-                    }
-                    destination[k + (j * coeff_count_)] = barrett_reduce_128(aux_transition, coeff_base_array_[j]);
-                }
-            }
-            
-            // Compute alpha_sk
-            // Require: Input is in Bsk 
-            // we only use coefficient in B 
-            // Fast convert B -> m_sk
-            Pointer tmp(allocate_uint(coeff_count_, pool));
-            for (int k = 0; k < coeff_count_; k++)
-            {
-                uint64_t msk_transition[2]{ 0 };
-                for (int i = 0; i < aux_base_mod_count_; i++)
+                // Compute alpha_sk
+                // Fast convert B -> m_sk
+                // Product is 61 bit + 61 bit = 122 bit, so can sum up to 63 of them with no reduction
+                // Thus need aux_base_mod_count_ <= 63, so coeff_base_mod_count_ <= 62 to guarantee success
+                // This gives the strongest restriction on the number of coeff modulus primes
+                dot_product_block(temp_coeff_transition.get(), aux_base_products_mod_msk_array_.data(), aux_base_mod_count_, 
+                    block_count, wide_transition.get());
+                for (int k = 0; k < block_count; k++)
                 {
-                    //multiply_uint64_mod(&coeff_transition, &aux_base_products_mod_msk_array_[i], m_sk_, &msk_transition);
-                    //add_uint_uint_smallmod(&msk_transition, tmp.get() + k, m_sk_, tmp.get() + k);
-
-                    // Lazy reduction
-                    uint64_t temp[2];
-
-                    // Product is 61 bit + 61 bit = 122 bit, so can sum up to 63 of them with no reduction
-                    // Thus need aux_base_mod_count_ <= 63, so coeff_base_mod_count_ <= 62 to guarantee success
-                    // This gives the strongest restriction on the number of coeff modulus primes
-                    multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], aux_base_products_mod_msk_array_[i], temp);
-                    unsigned char carry = add_uint64(msk_transition[0], temp[0], 0, msk_transition);
-                    msk_transition[1] += temp[1] + carry;
+                    // It is not necessary for the negation to be reduced modulo the small prime
+                    uint64_t negated_input = m_sk_.value() - input_sk[block_start + k];
+                    uint64_t msk_transition = barrett_reduce_128(wide_transition.get() + (2 * k), m_sk_) + negated_input;
+                    alpha_sk[k] = multiply_uint_uint_mod(msk_transition, inv_aux_products_mod_msk_, m_sk_);
                 }
-                tmp[k] = barrett_reduce_128(msk_transition, m_sk_);
-            }
 
-            Pointer alpha_sk(allocate_uint(coeff_count_, pool));
-            // x_sk is allocated in input[aux_base_mod_count_]
-            for (int i = 0; i < coeff_count_; i++)
-            {
-                //sub_uint_uint_smallmod(tmp.get() + i, input + i + (aux_base_mod_count_ * coeff_count_), m_sk_, tmp.get() + i);
-                //multiply_uint64_mod(tmp.get() + i, &inv_aux_products_mod_msk_, m_sk_, alpha_sk.get() + i);
-
-                // It is not necessary for the negation to be reduced modulo the small prime
-                //negate_uint_smallmod(input + i + (aux_base_mod_count_ * coeff_count_), m_sk_, &negated_input);
-                uint64_t negated_input = m_sk_.value() - input[i + (aux_base_mod_count_ * coeff_count_)];
-
-                tmp[i] += negated_input;
-                alpha_sk[i] = multiply_uint_uint_mod(tmp[i], inv_aux_products_mod_msk_, m_sk_);
-            }
-            
-            uint64_t m_sk_div_2 = m_sk_.value() >> 1;
-
-            for (int i = 0; i < coeff_base_mod_count_; i++)
-            {
-                for (int k = 0; k < coeff_count_; k++)
+                // Fast convert B -> q, correcting each sum with alpha_sk before its only reduction
+                for (int j = 0; j < coeff_base_mod_count_; j++)
                 {
-                    uint64_t m_alpha_sk[2];
-
-                    // Correcting alpha_sk since it is a centered modulo 
-                    if (alpha_sk[k] > m_sk_div_2)
-                    {
-                        uint64_t alpha_sk_corrected = m_sk_.value() - alpha_sk[k];
-
-                        //uint64_t m_alpha_sk;
-                        //multiply_uint64_mod(&aux_products_all_mod_coeff_array_[i], &alpha_sk_corrected, coeff_base_array_[i], &m_alpha_sk);
-                        //add_uint_uint_smallmod(destination + k + (i * coeff_count_), &m_alpha_sk, coeff_base_array_[i], destination + k + (i * coeff_count_));
+                    // Product is 61 bit + 60 bit = 121 bit, so can sum up to 127 of them with no reduction
+                    // Thus need aux_base_mod_count_ <= 126 to leave room for the correction
+                    dot_product_block(temp_coeff_transition.get(), aux_base_products_mod_coeff_matrix_.data() + (j * aux_base_mod_count_), 
+                        aux_base_mod_count_, block_count, wide_transition.get());
 
-                        // Lazy reduction
-                        multiply_uint64(aux_products_all_mod_coeff_array_[i], alpha_sk_corrected, m_alpha_sk);
-                        m_alpha_sk[1] += add_uint64(m_alpha_sk[0], destination[k + (i * coeff_count_)], 0, m_alpha_sk);
-                        destination[k + (i * coeff_count_)] = barrett_reduce_128(m_alpha_sk, coeff_base_array_[i]);
-                    }
-                    // No correction needed
-                    else
+                    // It is not necessary for the negation to be reduced modulo the small prime
+                    uint64_t aux_products_all = aux_products_all_mod_coeff_array_[j];
+                    uint64_t negated_aux_products_all = coeff_base_array_[j].value() - aux_products_all;
+                    uint64_t *destination_ptr = destination + (block_start + (j * coeff_count_));
+                    for (int k = 0; k < block_count; k++)
                     {
-                        //uint64_t m_alpha_sk;
-                        //multiply_uint64_mod(&aux_products_all_mod_coeff_array_[i], alpha_sk.get() + k, coeff_base_array_[i], &m_alpha_sk);
-                        //sub_uint_uint_smallmod(destination + k + (i * coeff_count_), &m_alpha_sk, coeff_base_array_[i], destination + k + (i * coeff_count_));
-
-                        // Lazy reduction
-                        // It is not necessary for the negation to be reduced modulo the small prime
-                        uint64_t negated_input = coeff_base_array_[i].value() - aux_products_all_mod_coeff_array_[i];
-                        multiply_uint64(negated_input, alpha_sk[k], m_alpha_sk);
-                        m_alpha_sk[1] += add_uint64(destination[k + (i * coeff_count_)], m_alpha_sk[0], 0, m_alpha_sk);
-                        destination[k + (i * coeff_count_)] = barrett_reduce_128(m_alpha_sk, coeff_base_array_[i]);
+                        // Correcting alpha_sk since it is a centered modulo
+                        bool alpha_sk_negative = alpha_sk[k] > m_sk_div_2;
+                        uint64_t alpha_sk_corrected = alpha_sk_negative ? m_sk_.value() - alpha_sk[k] : alpha_sk[k];
+                        uint64_t factor = alpha_sk_negative ? aux_products_all : negated_aux_products_all;
+                        multiply_accumulate_uint64(factor, alpha_sk_corrected, wide_transition.get() + (2 * k));
+                        destination_ptr[k] = barrett_reduce_128(wide_transition.get() + (2 * k), coeff_base_array_[j]);
                     }
                 }
             }
@@ -621,27 +660,36 @@ namespace seal
              Require: Input should in Bsk U {m_tilde}
              Ensure: Destination array in Bsk = m U {msk}
             */
-                        
-            for (int i = 0; i < coeff_count_; i++)
+
+            // (x + q * r_mtilde) * m_tilde^(-1) is computed as x * m_tilde^(-1) + r_mtilde * (q * m_tilde^(-1)), with a single reduction
+            uint64_t r_mtilde[base_conversion_block_size];
+            const uint64_t *input_mtilde = input + (coeff_count_ * bsk_base_mod_count_);
+
+            for (int block_start = 0; block_start < coeff_count_; block_start += base_conversion_block_size)
             {
+                int block_count = min(base_conversion_block_size, coeff_count_ - block_start);
+
                 // Compute r_mtilde
-                uint64_t r_mtilde = multiply_uint_uint_mod(input[i + (coeff_count_ * bsk_base_mod_count_)], inv_coeff_products_mod_mtilde_, m_tilde_);
-                r_mtilde = negate_uint_mod(r_mtilde, m_tilde_);
+                for (int k = 0; k < block_count; k++)
+                {
+                    r_mtilde[k] = negate_uint_mod(multiply_uint_uint_mod(input_mtilde[block_start + k], inv_coeff_products_mod_mtilde_, m_tilde_), 
+                        m_tilde_);
+                }
 
                 // Compute result for aux base
-                for (int k = 0; k < bsk_base_mod_count_; k++)
+                for (int j = 0; j < bsk_base_mod_count_; j++)
                 {
-                    //uint64_t tmp;
-                    //multiply_uint64_mod(&coeff_products_all_mod_bsk_array_[k], &r_mtilde, bsk_base_array_[k], &tmp);
-                    //add_uint_uint_smallmod(input + i + (k * coeff_count_), &tmp, bsk_base_array_[k], &tmp);
-                    //multiply_uint64_mod(&tmp, &inv_mtilde_mod_bsk_array_[k], bsk_base_array_[k], destination + i + (k * coeff_count_));
-
-                    // Lazy reduction
-                    uint64_t tmp[2];
-                    multiply_uint64(coeff_products_all_mod_bsk_array_[k], r_mtilde, tmp);
-                    tmp[1] += add_uint64(tmp[0], input[i + (k * coeff_count_)], 0, tmp);
-                    uint64_t tmp2 = barrett_reduce_128(tmp, bsk_base_array_[k]);
-                    destination[i + (k * coeff_count_)] = multiply_uint_uint_mod(tmp2, inv_mtilde_mod_bsk_array_[k], bsk_base_array_[k]);
+                    const uint64_t *input_ptr = input + (block_start + (j * coeff_count_));
+                    uint64_t *destination_ptr = destination + (block_start + (j * coeff_count_));
+                    for (int k = 0; k < block_count; k++)
+                    {
+                        // Lazy reduction
+                        // Products are 61 bit + 61 bit = 122 bit and 33 bit + 61 bit = 94 bit
+                        uint64_t tmp[2];
+                        multiply_uint64(input_ptr[k], inv_mtilde_mod_bsk_array_[j], tmp);
+                        multiply_accumulate_uint64(r_mtilde[k], coeff_products_all_inv_mtilde_mod_bsk_array_[j], tmp);
+                        destination_ptr[k] = barrett_reduce_128(tmp, bsk_base_array_[j]);
+                    }
                 }
             }
         }
@@ -666,26 +714,33 @@ namespace seal
              Require: Input in q U m U {msk}
              Ensure: Destination array in Bsk
             */
-            fastbconv(input, destination, pool); //q -> Bsk
-            
-            int index_msk = coeff_base_mod_count_ * coeff_count_;
-            
-            for (int i = 0; i < bsk_base_mod_count_; i++)
-            {
-                for (int k = 0; k < coeff_count_; k++)
-                {
-                    //uint64_t tmp;
-                    //sub_uint_uint_smallmod(input + index_msk + k + (i * coeff_count_), base_convert_Bsk.get() + k + (i * coeff_count_), bsk_base_array_[i], &tmp);
-                    //multiply_uint64_mod(&tmp, &inv_coeff_products_all_mod_aux_bsk_array_[i], bsk_base_array_[i], destination + k + (i * coeff_count_));
 
-                    uint64_t bsk_transition;
+            // (x - fastbconv(x_q)) * q^(-1) is computed in Bsk as x * q^(-1) plus the fast conversion of x_q with factors 
+            // premultiplied by -q^(-1), so that each result is reduced only once
+            Pointer temp_coeff_transition(allocate_uint(base_conversion_block_size * coeff_base_mod_count_, pool));
+            Pointer wide_transition(allocate_uint(2 * base_conversion_block_size, pool));
+            int index_msk = coeff_base_mod_count_ * coeff_count_;
 
-                    // It is not necessary for the negation to be reduced modulo the small prime
-                    //negate_uint_smallmod(base_convert_Bsk.get() + k + (i * coeff_count_), bsk_base_array_[i], &negated_base_convert_Bsk);
-                    uint64_t negated_base_convert_Bsk = bsk_base_array_[i].value() - destination[k + (i * coeff_count_)];
+            for (int block_start = 0; block_start < coeff_count_; block_start += base_conversion_block_size)
+            {
+                int block_count = min(base_conversion_block_size, coeff_count_ - block_start);
+                multiply_block_scalar_mod(input + block_start, coeff_count_, inv_coeff_base_products_mod_coeff_array_.data(), 
+                    coeff_base_array_.data(), coeff_base_mod_count_, block_count, temp_coeff_transition.get());
 
-                    bsk_transition = input[index_msk + k + (i * coeff_count_)] + negated_base_convert_Bsk;
-                    destination[k + (i * coeff_count_)] = multiply_uint_uint_mod(bsk_transition, inv_coeff_products_all_mod_aux_bsk_array_[i], bsk_base_array_[i]);
+                for (int j = 0; j < bsk_base_mod_count_; j++)
+                {
+                    // Product is 60 bit + 61 bit = 121 bit, so can sum up to 127 of them with no reduction
+                    // Thus need coeff_base_mod_count_ <= 126 to leave room for x * q^(-1)
+                    dot_product_block(temp_coeff_transition.get(), neg_inv_coeff_base_mod_bsk_matrix_.data() + (j * coeff_base_mod_count_), 
+                        coeff_base_mod_count_, block_count, wide_transition.get());
+
+                    const uint64_t *input_ptr = input + (index_msk + block_start + (j * coeff_count_));
+                    uint64_t *destination_ptr = destination + (block_start + (j * coeff_count_));
+                    for (int k = 0; k < block_count; k++)
+                    {
+                        multiply_accumulate_uint64(input_ptr[k], inv_coeff_products_all_mod_aux_bsk_array_[j], wide_transition.get() + (2 * k));
+                        destination_ptr[k] = barrett_reduce_128(wide_transition.get() + (2 * k), bsk_base_array_[j]);
+                    }
                 }
             }
         }
@@ -710,63 +765,27 @@ namespace seal
              Require: Input in q
              Ensure: Output in Bsk U {m_tilde}
             */
-            
-            // Compute in Bsk first; we compute |m_tilde*q^-1i| mod qi
-            Pointer temp_coeff_transition(allocate_uint(coeff_count_ * coeff_base_mod_count_, pool));
-            for (int i = 0; i < coeff_base_mod_count_; i++)
-            {
-                for (int k = 0; k < coeff_count_; k++)
-                {
-                    temp_coeff_transition[k + (i * coeff_count_)] = multiply_uint_uint_mod(input[k + (i * coeff_count_)], 
-                        mtilde_inv_coeff_base_products_mod_coeff_array_[i], coeff_base_array_[i]);
-                }
-            }
+            Pointer temp_coeff_transition(allocate_uint(base_conversion_block_size * coeff_base_mod_count_, pool));
+            Pointer wide_transition(allocate_uint(2 * base_conversion_block_size, pool));
+            int index_mtilde = bsk_base_mod_count_ * coeff_count_;
 
-            for (int j = 0; j < bsk_base_mod_count_; j++)
+            for (int block_start = 0; block_start < coeff_count_; block_start += base_conversion_block_size)
             {
-                for (int k = 0; k < coeff_count_; k++)
-                {
-                    uint64_t aux_transition[2]{ 0 };
-                    for (int i = 0; i < coeff_base_mod_count_; i++)
-                    {
-                        //uint64_t aux_transition;
-                        //multiply_uint64_mod(temp_coeff_transition.get() + k + (i * coeff_count_), 
-                        //  &coeff_base_products_mod_aux_bsk_array_[i][j], bsk_base_array_[j], &aux_transition);
-                        //add_uint_uint_smallmod(&aux_transition, destination + (k + j * coeff_count_), bsk_base_array_[j], 
-                        // destination + (k + j * coeff_count_));
+                int block_count = min(base_conversion_block_size, coeff_count_ - block_start);
 
-                        // Lazy reduction
-                        uint64_t temp[2];
+                // Compute in Bsk first; we compute |m_tilde*q^-1i| mod qi
+                multiply_block_scalar_mod(input + block_start, coeff_count_, mtilde_inv_coeff_base_products_mod_coeff_array_.data(), 
+                    coeff_base_array_.data(), coeff_base_mod_count_, block_count, temp_coeff_transition.get());
 
-                        // Product is 60 bit + 61 bit = 121 bit, so can sum up to 127 of them with no reduction
-                        // Thus need coeff_base_mod_count_ <= 127
-                        multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], 
-                            coeff_base_products_mod_aux_bsk_array_[i][j], temp);
-                        unsigned char carry = add_uint64(aux_transition[0], temp[0], 0, aux_transition);
-                        aux_transition[1] += temp[1] + carry;
-                    }
-                    destination[k + (j * coeff_count_)] = barrett_reduce_128(aux_transition, bsk_base_array_[j]);
-                }
-            }
+                // Product is 60 bit + 61 bit = 121 bit, so can sum up to 127 of them with no reduction
+                // Thus need coeff_base_mod_count_ <= 127
+                convert_block(temp_coeff_transition.get(), coeff_base_mod_count_, coeff_base_products_mod_bsk_matrix_.data(), 
+                    bsk_base_array_.data(), bsk_base_mod_count_, block_count, wide_transition.get(), destination + block_start, coeff_count_);
 
-            int index_mtilde = bsk_base_mod_count_ * coeff_count_;
-            
-            // Computing the last element (mod m_tilde) and add it at the end of destination array
-            for (int k = 0; k < coeff_count_; k++)
-            {
-                uint64_t wide_result[2]{ 0 };
-                for (int i = 0; i < coeff_base_mod_count_; i++)
-                {
-                    // Lazy reduction
-                    uint64_t aux_transition[2];
-
-                    // Product is 60 bit + 33 bit = 93 bit
-                    multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], 
-                        coeff_base_products_mod_mtilde_array_[i], aux_transition);
-                    unsigned char carry = add_uint64(aux_transition[0], wide_result[0], 0, wide_result);
-                    wide_result[1] += aux_transition[1] + carry;
-                }
-                destination[index_mtilde + k] = barrett_reduce_128(wide_result, m_tilde_);
+                // Computing the last element (mod m_tilde) and add it at the end of destination array
+                // Product is 60 bit + 33 bit = 93 bit
+                convert_block(temp_coeff_transition.get(), coeff_base_mod_count_, coeff_base_products_mod_mtilde_array_.data(), 
+                    &m_tilde_, 1, block_count, wide_transition.get(), destination + (index_mtilde + block_start), coeff_count_);
             }
         }
 
@@ -179,6 +179,18 @@ namespace seal
 
             // Array of plain_gamma_product mod coeff base moduli
             std::vector<std::uint64_t> plain_gamma_product_mod_coeff_array_;
+
+            // Matrix of coeff moduli products mod Bsk, row j holding (q/qi) mod mj for every i
+            std::vector<std::uint64_t> coeff_base_products_mod_bsk_matrix_;
+
+            // Matrix of negated inverse coeff moduli mod Bsk, row j holding -(qi^(-1)) mod mj for every i
+            std::vector<std::uint64_t> neg_inv_coeff_base_mod_bsk_matrix_;
+
+            // Matrix of auxiliary moduli products mod coeff moduli, row j holding (M/mi) mod qj for every i
+            std::vector<std::uint64_t> aux_base_products_mod_coeff_matrix_;
+
+            // Array of all coeff base products times m_tilde inverse mod Bsk
+            std::vector<std::uint64_t> coeff_products_all_inv_mtilde_mod_bsk_array_;
             
             // Array of small NTT tables for moduli in Bsk
             std::vector<SmallNTTTables> bsk_small_ntt_table_;
@@ -21,6 +21,12 @@
 // Use unrolled versions of polynomial operations for automatic vectorization
 #undef SEAL_VECTORIZATION_HINTS
 
+// Use AVX2 and AVX-512 versions of the negacyclic NTT when the processor supports them,
+// which is checked at runtime with CPUID (GCC and Clang on x86-64 only)
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SEAL_ENABLE_AVX_NTT
+#endif
+
 // Compile for big-endian system (not implemented)
 #undef SEAL_BIG_ENDIAN
 
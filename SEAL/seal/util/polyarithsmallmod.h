@@ -144,14 +144,61 @@ namespace seal
                 throw std::invalid_argument("modulus");
             }
 #endif
-#ifdef SEAL_VECTORIZATION_HINTS
-            multiply_uint_scalar_mod_vector(poly, coeff_count, scalar, modulus, result);
-#else
-            for (int i = 0; i < coeff_count; i++)
+            // The scalar is reduced and precomputed once so that every coefficient takes a Shoup multiplication
+            std::uint64_t wide_scalar[2]{ scalar, 0 };
+            scalar = barrett_reduce_128(wide_scalar, modulus);
+            multiply_uint_scalar_mod_vector(poly, coeff_count, scalar, shoup_precompute_uint_mod(scalar, modulus), modulus, result);
+        }
+
+        // Same as above for a scalar already reduced modulo modulus, with scalar_shoup = shoup_precompute_uint_mod(scalar, modulus)
+        inline void multiply_poly_scalar_coeffmod(const std::uint64_t *poly, int coeff_count, std::uint64_t scalar, std::uint64_t scalar_shoup, 
+            const SmallModulus &modulus, std::uint64_t *result)
+        {
+#ifdef SEAL_DEBUG
+            if (poly == nullptr && coeff_count > 0)
+            {
+                throw std::invalid_argument("poly");
+            }
+            if (coeff_count < 0)
+            {
+                throw std::invalid_argument("coeff_count");
+            }
+            if (result == nullptr && coeff_count > 0)
+            {
+                throw std::invalid_argument("result");
+            }
+            if (modulus.is_zero())
+            {
+                throw std::invalid_argument("modulus");
+            }
+#endif
+            multiply_uint_scalar_mod_vector(poly, coeff_count, scalar, scalar_shoup, modulus, result);
+        }
+
+        // Sets result to result + poly * scalar coefficient-wise, with scalar and scalar_shoup as above and the 
+        // coefficients of result reduced modulo modulus
+        inline void multiply_add_poly_scalar_coeffmod(const std::uint64_t *poly, int coeff_count, std::uint64_t scalar, std::uint64_t scalar_shoup, 
+            const SmallModulus &modulus, std::uint64_t *result)
+        {
+#ifdef SEAL_DEBUG
+            if (poly == nullptr && coeff_count > 0)
             {
-                result[i] = multiply_uint_uint_mod(poly[i], scalar, modulus);
+                throw std::invalid_argument("poly");
+            }
+            if (coeff_count < 0)
+            {
+                throw std::invalid_argument("coeff_count");
+            }
+            if (result == nullptr && coeff_count > 0)
+            {
+                throw std::invalid_argument("result");
+            }
+            if (modulus.is_zero())
+            {
+                throw std::invalid_argument("modulus");
             }
 #endif
+            multiply_add_uint_scalar_mod_vector(poly, coeff_count, scalar, scalar_shoup, modulus, result);
         }
 
         void multiply_poly_poly_coeffmod(const std::uint64_t *operand1, int operand1_coeff_count, const std::uint64_t *operand2, int operand2_coeff_count,
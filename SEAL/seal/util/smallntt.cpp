@@ -5,7 +5,14 @@
 #include "seal/smallmodulus.h"
 #include "seal/util/uintarithsmallmod.h"
 #include "seal/util/defines.h"
+#include "seal/util/threadpool.h"
 #include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#ifdef SEAL_ENABLE_AVX_NTT
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -188,100 +195,622 @@ namespace seal
             }
         }
 
-        /**
-        This function computes in-place the negacyclic NTT. The input is a polynomial a of degree n in R_q,
-        where n is assumed to be a power of 2 and q is a prime such that q = 1 (mod 2n).
-
-        The output is a vector A such that the following hold:
-        A[j] =  a(psi**(2*bit_reverse(j) + 1)), 0 <= j < n.
-
-        For details, see Michael Naehrig and Patrick Longa.
-        */
-        void ntt_negacyclic_harvey_lazy(uint64_t *operand, const SmallNTTTables &tables)
+        namespace
         {
-            uint64_t modulus = tables.modulus().value();
-            uint64_t two_times_modulus = modulus * 2;
+            // Harvey's butterflies on one coefficient at a time, used on processors without AVX2 and as the reference of the vectorized kernels
+            void ntt_negacyclic_harvey_lazy_scalar(uint64_t *operand, const SmallNTTTables &tables)
+            {
+                uint64_t modulus = tables.modulus().value();
+                uint64_t two_times_modulus = modulus * 2;
             
-            // Return the NTT in scrambled order
-            int n = 1 << tables.coeff_count_power();
-            int t = n;
-            for (int m = 1; m < n; m <<= 1)
+                // Return the NTT in scrambled order
+                int n = 1 << tables.coeff_count_power();
+                int t = n;
+                for (int m = 1; m < n; m <<= 1)
+                {
+                    t >>= 1;
+                    for (int i = 0; i < m; i++)
+                    {
+                        int j1 = 2 * i * t;
+                        int j2 = j1 + t - 1;
+                        const uint64_t W = tables.get_from_root_powers(m + i);
+                        const uint64_t Wprime = tables.get_from_scaled_root_powers(m + i);
+
+                        uint64_t *X = operand + j1;
+                        uint64_t *Y = X + t;
+                        for (int j = j1; j <= j2; j++)
+                        {
+                            uint64_t currX = *X, currY = *Y;
+                            // The Harvey butterfly: assume X, Y in [0, 2p), and return X', Y' in [0, 2p).
+                            // X', Y' = X + WY, X - WY (mod p).
+                            currX -= two_times_modulus & static_cast<uint64_t>(-static_cast<int64_t>(currX >= two_times_modulus));
+
+                            uint64_t Q;
+                            multiply_uint64_hw64(Wprime, currY, &Q);
+                            uint64_t T = W * currY - Q * modulus;
+                            *Y++ = currX + two_times_modulus - T;
+                            *X++ = currX + T;
+                        }
+                    }
+                }
+            }
+
+            void inverse_ntt_negacyclic_harvey_lazy_scalar(uint64_t *operand, const SmallNTTTables &tables)
+            {
+                uint64_t modulus = tables.modulus().value();
+                uint64_t two_times_modulus = modulus * 2;
+
+                // return the bit-reversed order of NTT. 
+                int n = 1 << tables.coeff_count_power();
+                int t = 1;
+                for (int m = n; m > 1; m >>= 1)
+                {
+                    int j1 = 0;
+                    int h = m >> 1;
+                    for (int i = 0; i < h; i++)
+                    {
+                        int j2 = j1 + t - 1;
+                        // Need the powers of  phi^{-1} in bit-reversed order
+                        const uint64_t W = tables.get_from_inv_root_powers_div_two(h + i);
+                        const uint64_t Wprime = tables.get_from_scaled_inv_root_powers_div_two(h + i);
+                        uint64_t *U = operand + j1;
+                        uint64_t *V = U + t;
+                        for (int j = j1; j <= j2; j++)
+                        {
+                            uint64_t currV = *V;
+                            uint64_t currU = *U;
+                            // U = x[i], V = x[i+m]
+
+                            // Compute U - V + 2q
+                            uint64_t T = two_times_modulus - currV + currU;
+
+                            // Cleverly check whether currU + currV >= two_times_modulus
+                            currU += currV - (two_times_modulus & static_cast<uint64_t>(-static_cast<int64_t>((currU << 1) >= T)));
+
+                            // Need to make it so that div2_uint_mod takes values that are > q. 
+                            //div2_uint_mod(U, modulusptr, coeff_uint64_count, U); 
+                            uint64_t masked_modulus = modulus & static_cast<uint64_t>(-static_cast<int64_t>(currU & 1));
+                            uint64_t carry = add_uint64(currU, masked_modulus, 0, &currU);
+                            *U++ = (currU >> 1) | (carry << (bits_per_uint64 - 1));
+
+                            uint64_t Q;
+                            multiply_uint64_hw64(Wprime, T, &Q);
+                            // effectively, the next two multiply perform multiply modulo beta = 2**wordsize. 
+                            *V++ = W * T - Q * modulus;
+                        }
+                        j1 += (t << 1);
+                    }
+                    t <<= 1;
+                }
+            }
+
+#ifdef SEAL_ENABLE_AVX_NTT
+            // The AVX2 and AVX-512 kernels compute the same butterflies as the scalar ones on 4 or 8 coefficients at once,
+            // with the same arithmetic modulo 2^64, so that they give bit-identical results. Values go up to 4q, which reaches
+            // 2^63 for moduli of 61 and 62 bits, so AVX2 compares them without sign by flipping their sign bit first (AVX-512
+            // has unsigned comparisons). AVX2 has no 64-bit multiplication, which is made of 32-bit ones.
+
+            // High 64 bits of the products of the lanes of a and b
+            __attribute__((target("avx2"))) inline __m256i multiply_uint64_hw64_avx2(__m256i a, __m256i b)
+            {
+                const __m256i low_mask = _mm256_set1_epi64x(0xFFFFFFFF);
+                __m256i a_high = _mm256_srli_epi64(a, 32);
+                __m256i b_high = _mm256_srli_epi64(b, 32);
+
+                __m256i low_low = _mm256_mul_epu32(a, b);
+                __m256i high_low = _mm256_mul_epu32(a_high, b);
+                __m256i low_high = _mm256_mul_epu32(a, b_high);
+                __m256i high_high = _mm256_mul_epu32(a_high, b_high);
+
+                // None of these sums can overflow
+                __m256i middle = _mm256_add_epi64(high_low, _mm256_srli_epi64(low_low, 32));
+                __m256i middle_carry = _mm256_add_epi64(low_high, _mm256_and_si256(middle, low_mask));
+                return _mm256_add_epi64(_mm256_add_epi64(high_high, _mm256_srli_epi64(middle, 32)), _mm256_srli_epi64(middle_carry, 32));
+            }
+
+            // Low 64 bits of the products of the lanes of a and b
+            __attribute__((target("avx2"))) inline __m256i multiply_uint64_lw64_avx2(__m256i a, __m256i b)
+            {
+                __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+                return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+            }
+
+            // Forward Harvey butterfly, see ntt_negacyclic_harvey_lazy_scalar
+            __attribute__((target("avx2"))) inline void forward_butterfly_avx2(__m256i &X, __m256i &Y, __m256i W, __m256i Wprime,
+                __m256i modulus, __m256i two_times_modulus)
+            {
+                // X >= 2q, compared without sign for X up to 4q
+                const __m256i sign_bit = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ULL));
+                __m256i below = _mm256_cmpgt_epi64(_mm256_xor_si256(two_times_modulus, sign_bit), _mm256_xor_si256(X, sign_bit));
+                X = _mm256_sub_epi64(X, _mm256_andnot_si256(below, two_times_modulus));
+
+                __m256i Q = multiply_uint64_hw64_avx2(Wprime, Y);
+                __m256i T = _mm256_sub_epi64(multiply_uint64_lw64_avx2(W, Y), multiply_uint64_lw64_avx2(Q, modulus));
+                Y = _mm256_add_epi64(X, _mm256_sub_epi64(two_times_modulus, T));
+                X = _mm256_add_epi64(X, T);
+            }
+
+            // Inverse Harvey butterfly, see inverse_ntt_negacyclic_harvey_lazy_scalar
+            __attribute__((target("avx2"))) inline void inverse_butterfly_avx2(__m256i &U, __m256i &V, __m256i W, __m256i Wprime,
+                __m256i modulus, __m256i two_times_modulus)
+            {
+                __m256i T = _mm256_add_epi64(_mm256_sub_epi64(two_times_modulus, V), U);
+
+                // Same check as the scalar kernel, 2U >= T, compared without sign for T wrapping around when V > U + 2q
+                const __m256i sign_bit = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ULL));
+                __m256i reduce = _mm256_cmpgt_epi64(_mm256_xor_si256(T, sign_bit), _mm256_xor_si256(_mm256_slli_epi64(U, 1), sign_bit));
+                __m256i sum = _mm256_sub_epi64(_mm256_add_epi64(U, V), _mm256_andnot_si256(reduce, two_times_modulus));
+
+                // Division by two modulo q, the sum plus q never carrying out of 64 bits
+                __m256i odd = _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(sum, _mm256_set1_epi64x(1)));
+                U = _mm256_srli_epi64(_mm256_add_epi64(sum, _mm256_and_si256(odd, modulus)), 1);
+
+                __m256i Q = multiply_uint64_hw64_avx2(Wprime, T);
+                V = _mm256_sub_epi64(multiply_uint64_lw64_avx2(W, T), multiply_uint64_lw64_avx2(Q, modulus));
+            }
+
+            // One stage of butterflies between blocks of t >= 4 coefficients, block i using the root of index root_index + i
+            template<bool Inverse>
+            __attribute__((target("avx2"))) void ntt_stage_avx2(uint64_t *operand, int blocks, int t, int root_index,
+                const uint64_t *roots, const uint64_t *scaled_roots, __m256i modulus, __m256i two_times_modulus)
+            {
+                for (int i = 0; i < blocks; i++)
+                {
+                    __m256i W = _mm256_set1_epi64x(static_cast<long long>(roots[root_index + i]));
+                    __m256i Wprime = _mm256_set1_epi64x(static_cast<long long>(scaled_roots[root_index + i]));
+
+                    __m256i *X = reinterpret_cast<__m256i*>(operand + 2 * i * t);
+                    __m256i *Y = reinterpret_cast<__m256i*>(operand + 2 * i * t + t);
+                    for (int j = 0; j < t; j += 4, X++, Y++)
+                    {
+                        __m256i currX = _mm256_loadu_si256(X);
+                        __m256i currY = _mm256_loadu_si256(Y);
+                        if (Inverse)
+                        {
+                            inverse_butterfly_avx2(currX, currY, W, Wprime, modulus, two_times_modulus);
+                        }
+                        else
+                        {
+                            forward_butterfly_avx2(currX, currY, W, Wprime, modulus, two_times_modulus);
+                        }
+                        _mm256_storeu_si256(X, currX);
+                        _mm256_storeu_si256(Y, currY);
+                    }
+                }
+            }
+
+            // Stage with blocks of 2 coefficients: two blocks [x0 x1 y0 y1] [x2 x3 y2 y3] are split into X and Y lanes
+            template<bool Inverse>
+            __attribute__((target("avx2"))) void ntt_stage_t2_avx2(uint64_t *operand, int blocks, int root_index,
+                const uint64_t *roots, const uint64_t *scaled_roots, __m256i modulus, __m256i two_times_modulus)
             {
-                t >>= 1;
-                for (int i = 0; i < m; i++)
+                __m256i *block = reinterpret_cast<__m256i*>(operand);
+                for (int i = 0; i < blocks; i += 2, block += 2)
                 {
-                    int j1 = 2 * i * t;
-                    int j2 = j1 + t - 1;
-                    const uint64_t W = tables.get_from_root_powers(m + i);
-                    const uint64_t Wprime = tables.get_from_scaled_root_powers(m + i);
+                    // Roots of the two blocks, as [w0 w0 w1 w1]
+                    __m256i W = _mm256_permute4x64_epi64(_mm256_castsi128_si256(
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(roots + root_index + i))), 0x50);
+                    __m256i Wprime = _mm256_permute4x64_epi64(_mm256_castsi128_si256(
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(scaled_roots + root_index + i))), 0x50);
+
+                    __m256i first = _mm256_loadu_si256(block);
+                    __m256i second = _mm256_loadu_si256(block + 1);
+                    __m256i X = _mm256_permute2x128_si256(first, second, 0x20);
+                    __m256i Y = _mm256_permute2x128_si256(first, second, 0x31);
+                    if (Inverse)
+                    {
+                        inverse_butterfly_avx2(X, Y, W, Wprime, modulus, two_times_modulus);
+                    }
+                    else
+                    {
+                        forward_butterfly_avx2(X, Y, W, Wprime, modulus, two_times_modulus);
+                    }
+                    _mm256_storeu_si256(block, _mm256_permute2x128_si256(X, Y, 0x20));
+                    _mm256_storeu_si256(block + 1, _mm256_permute2x128_si256(X, Y, 0x31));
+                }
+            }
 
-                    uint64_t *X = operand + j1;
+            // Stage with blocks of 1 coefficient: four blocks [x0 y0 x1 y1] [x2 y2 x3 y3] are split into lanes [x0 x2 x1 x3] and [y0 y2 y1 y3]
+            template<bool Inverse>
+            __attribute__((target("avx2"))) void ntt_stage_t1_avx2(uint64_t *operand, int blocks, int root_index,
+                const uint64_t *roots, const uint64_t *scaled_roots, __m256i modulus, __m256i two_times_modulus)
+            {
+                __m256i *block = reinterpret_cast<__m256i*>(operand);
+                for (int i = 0; i < blocks; i += 4, block += 2)
+                {
+                    // Roots of the four blocks, in the order of the lanes
+                    __m256i W = _mm256_permute4x64_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(roots + root_index + i)), 0xD8);
+                    __m256i Wprime = _mm256_permute4x64_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(scaled_roots + root_index + i)), 0xD8);
+
+                    __m256i first = _mm256_loadu_si256(block);
+                    __m256i second = _mm256_loadu_si256(block + 1);
+                    __m256i X = _mm256_unpacklo_epi64(first, second);
+                    __m256i Y = _mm256_unpackhi_epi64(first, second);
+                    if (Inverse)
+                    {
+                        inverse_butterfly_avx2(X, Y, W, Wprime, modulus, two_times_modulus);
+                    }
+                    else
+                    {
+                        forward_butterfly_avx2(X, Y, W, Wprime, modulus, two_times_modulus);
+                    }
+                    _mm256_storeu_si256(block, _mm256_unpacklo_epi64(X, Y));
+                    _mm256_storeu_si256(block + 1, _mm256_unpackhi_epi64(X, Y));
+                }
+            }
+
+            __attribute__((target("avx2"))) void ntt_negacyclic_harvey_lazy_avx2(uint64_t *operand, const SmallNTTTables &tables)
+            {
+                int n = 1 << tables.coeff_count_power();
+                if (n < 8)
+                {
+                    ntt_negacyclic_harvey_lazy_scalar(operand, tables);
+                    return;
+                }
+
+                __m256i modulus = _mm256_set1_epi64x(static_cast<long long>(tables.modulus().value()));
+                __m256i two_times_modulus = _mm256_add_epi64(modulus, modulus);
+                const uint64_t *roots = tables.get_root_powers();
+                const uint64_t *scaled_roots = tables.get_scaled_root_powers();
+
+                int m = 1;
+                for (int t = n >> 1; t >= 4; t >>= 1, m <<= 1)
+                {
+                    ntt_stage_avx2<false>(operand, m, t, m, roots, scaled_roots, modulus, two_times_modulus);
+                }
+                ntt_stage_t2_avx2<false>(operand, m, m, roots, scaled_roots, modulus, two_times_modulus);
+                ntt_stage_t1_avx2<false>(operand, 2 * m, 2 * m, roots, scaled_roots, modulus, two_times_modulus);
+            }
+
+            __attribute__((target("avx2"))) void inverse_ntt_negacyclic_harvey_lazy_avx2(uint64_t *operand, const SmallNTTTables &tables)
+            {
+                int n = 1 << tables.coeff_count_power();
+                if (n < 8)
+                {
+                    inverse_ntt_negacyclic_harvey_lazy_scalar(operand, tables);
+                    return;
+                }
+
+                __m256i modulus = _mm256_set1_epi64x(static_cast<long long>(tables.modulus().value()));
+                __m256i two_times_modulus = _mm256_add_epi64(modulus, modulus);
+                const uint64_t *roots = tables.get_inv_root_powers_div_two();
+                const uint64_t *scaled_roots = tables.get_scaled_inv_root_powers_div_two();
+
+                ntt_stage_t1_avx2<true>(operand, n >> 1, n >> 1, roots, scaled_roots, modulus, two_times_modulus);
+                ntt_stage_t2_avx2<true>(operand, n >> 2, n >> 2, roots, scaled_roots, modulus, two_times_modulus);
+                for (int t = 4, h = n >> 3; h >= 1; t <<= 1, h >>= 1)
+                {
+                    ntt_stage_avx2<true>(operand, h, t, h, roots, scaled_roots, modulus, two_times_modulus);
+                }
+            }
+
+            // AVX-512 has a 64-bit multiplication for the low bits, the high bits being made of 32-bit ones. Shifts and 32-bit
+            // multiplications use their zero-masked forms over all the lanes: they are the same instructions, without the
+            // undefined source operand GCC reports as maybe uninitialized once inlined.
+            __attribute__((target("avx512f,avx512dq"))) inline __m512i multiply_uint64_hw64_avx512(__m512i a, __m512i b)
+            {
+                const __mmask8 all_lanes = 0xFF;
+                const __m512i low_mask = _mm512_set1_epi64(0xFFFFFFFF);
+                __m512i a_high = _mm512_maskz_srli_epi64(all_lanes, a, 32);
+                __m512i b_high = _mm512_maskz_srli_epi64(all_lanes, b, 32);
+
+                __m512i low_low = _mm512_maskz_mul_epu32(all_lanes, a, b);
+                __m512i high_low = _mm512_maskz_mul_epu32(all_lanes, a_high, b);
+                __m512i low_high = _mm512_maskz_mul_epu32(all_lanes, a, b_high);
+                __m512i high_high = _mm512_maskz_mul_epu32(all_lanes, a_high, b_high);
+
+                __m512i middle = _mm512_add_epi64(high_low, _mm512_maskz_srli_epi64(all_lanes, low_low, 32));
+                __m512i middle_carry = _mm512_add_epi64(low_high, _mm512_and_si512(middle, low_mask));
+                return _mm512_add_epi64(_mm512_add_epi64(high_high, _mm512_maskz_srli_epi64(all_lanes, middle, 32)),
+                    _mm512_maskz_srli_epi64(all_lanes, middle_carry, 32));
+            }
+
+            // One stage of butterflies between blocks of t >= 8 coefficients, see ntt_stage_avx2
+            template<bool Inverse>
+            __attribute__((target("avx512f,avx512dq"))) void ntt_stage_avx512(uint64_t *operand, int blocks, int t, int root_index,
+                const uint64_t *roots, const uint64_t *scaled_roots, uint64_t modulus_value)
+            {
+                const __mmask8 all_lanes = 0xFF;
+                __m512i modulus = _mm512_set1_epi64(static_cast<long long>(modulus_value));
+                __m512i two_times_modulus = _mm512_add_epi64(modulus, modulus);
+
+                for (int i = 0; i < blocks; i++)
+                {
+                    __m512i W = _mm512_set1_epi64(static_cast<long long>(roots[root_index + i]));
+                    __m512i Wprime = _mm512_set1_epi64(static_cast<long long>(scaled_roots[root_index + i]));
+
+                    uint64_t *X = operand + 2 * i * t;
                     uint64_t *Y = X + t;
-                    for (int j = j1; j <= j2; j++)
+                    for (int j = 0; j < t; j += 8, X += 8, Y += 8)
                     {
-                        uint64_t currX = *X, currY = *Y;
-                        // The Harvey butterfly: assume X, Y in [0, 2p), and return X', Y' in [0, 2p).
-                        // X', Y' = X + WY, X - WY (mod p).
-                        currX -= two_times_modulus & static_cast<uint64_t>(-static_cast<int64_t>(currX >= two_times_modulus));
-
-                        uint64_t Q;
-                        multiply_uint64_hw64(Wprime, currY, &Q);
-                        uint64_t T = W * currY - Q * modulus;
-                        *Y++ = currX + two_times_modulus - T;
-                        *X++ = currX + T;
+                        __m512i currX = _mm512_loadu_si512(X);
+                        __m512i currY = _mm512_loadu_si512(Y);
+                        if (Inverse)
+                        {
+                            __m512i T = _mm512_add_epi64(_mm512_sub_epi64(two_times_modulus, currY), currX);
+
+                            __m512i sum = _mm512_add_epi64(currX, currY);
+                            sum = _mm512_mask_sub_epi64(sum, _mm512_cmpge_epu64_mask(_mm512_maskz_slli_epi64(all_lanes, currX, 1), T), sum, two_times_modulus);
+                            sum = _mm512_mask_add_epi64(sum, _mm512_test_epi64_mask(sum, _mm512_set1_epi64(1)), sum, modulus);
+                            currX = _mm512_maskz_srli_epi64(all_lanes, sum, 1);
+
+                            __m512i Q = multiply_uint64_hw64_avx512(Wprime, T);
+                            currY = _mm512_sub_epi64(_mm512_mullo_epi64(W, T), _mm512_mullo_epi64(Q, modulus));
+                        }
+                        else
+                        {
+                            currX = _mm512_mask_sub_epi64(currX, _mm512_cmpge_epu64_mask(currX, two_times_modulus), currX, two_times_modulus);
+
+                            __m512i Q = multiply_uint64_hw64_avx512(Wprime, currY);
+                            __m512i T = _mm512_sub_epi64(_mm512_mullo_epi64(W, currY), _mm512_mullo_epi64(Q, modulus));
+                            currY = _mm512_add_epi64(currX, _mm512_sub_epi64(two_times_modulus, T));
+                            currX = _mm512_add_epi64(currX, T);
+                        }
+                        _mm512_storeu_si512(X, currX);
+                        _mm512_storeu_si512(Y, currY);
                     }
                 }
             }
-        }
 
-        // Inverse negacyclic NTT using Harvey's butterfly. (See Patrick Longa and Michael Naehrig). 
-        void inverse_ntt_negacyclic_harvey_lazy(uint64_t *operand, const SmallNTTTables &tables)
-        {
-            uint64_t modulus = tables.modulus().value();
-            uint64_t two_times_modulus = modulus * 2;
+            // Stages with blocks of 8 coefficients or more use AVX-512, the last ones (first ones for the inverse) using AVX2
+            __attribute__((target("avx512f,avx512dq"))) void ntt_negacyclic_harvey_lazy_avx512(uint64_t *operand, const SmallNTTTables &tables)
+            {
+                int n = 1 << tables.coeff_count_power();
+                if (n < 16)
+                {
+                    ntt_negacyclic_harvey_lazy_avx2(operand, tables);
+                    return;
+                }
+
+                uint64_t modulus_value = tables.modulus().value();
+                __m256i modulus = _mm256_set1_epi64x(static_cast<long long>(modulus_value));
+                __m256i two_times_modulus = _mm256_add_epi64(modulus, modulus);
+                const uint64_t *roots = tables.get_root_powers();
+                const uint64_t *scaled_roots = tables.get_scaled_root_powers();
+
+                int m = 1;
+                for (int t = n >> 1; t >= 8; t >>= 1, m <<= 1)
+                {
+                    ntt_stage_avx512<false>(operand, m, t, m, roots, scaled_roots, modulus_value);
+                }
+                ntt_stage_avx2<false>(operand, m, 4, m, roots, scaled_roots, modulus, two_times_modulus);
+                ntt_stage_t2_avx2<false>(operand, 2 * m, 2 * m, roots, scaled_roots, modulus, two_times_modulus);
+                ntt_stage_t1_avx2<false>(operand, 4 * m, 4 * m, roots, scaled_roots, modulus, two_times_modulus);
+            }
+
+            __attribute__((target("avx512f,avx512dq"))) void inverse_ntt_negacyclic_harvey_lazy_avx512(uint64_t *operand, const SmallNTTTables &tables)
+            {
+                int n = 1 << tables.coeff_count_power();
+                if (n < 16)
+                {
+                    inverse_ntt_negacyclic_harvey_lazy_avx2(operand, tables);
+                    return;
+                }
+
+                uint64_t modulus_value = tables.modulus().value();
+                __m256i modulus = _mm256_set1_epi64x(static_cast<long long>(modulus_value));
+                __m256i two_times_modulus = _mm256_add_epi64(modulus, modulus);
+                const uint64_t *roots = tables.get_inv_root_powers_div_two();
+                const uint64_t *scaled_roots = tables.get_scaled_inv_root_powers_div_two();
+
+                ntt_stage_t1_avx2<true>(operand, n >> 1, n >> 1, roots, scaled_roots, modulus, two_times_modulus);
+                ntt_stage_t2_avx2<true>(operand, n >> 2, n >> 2, roots, scaled_roots, modulus, two_times_modulus);
+                ntt_stage_avx2<true>(operand, n >> 3, 4, n >> 3, roots, scaled_roots, modulus, two_times_modulus);
+                for (int t = 8, h = n >> 4; h >= 1; t <<= 1, h >>= 1)
+                {
+                    ntt_stage_avx512<true>(operand, h, t, h, roots, scaled_roots, modulus_value);
+                }
+            }
+
+            SmallNTTKernel detect_small_ntt_kernel()
+            {
+                unsigned int eax, ebx, ecx, edx;
+                if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || __get_cpuid_max(0, nullptr) < 7)
+                {
+                    return SmallNTTKernel::scalar;
+                }
+
+                // The operating system must save the YMM registers, and the opmask and ZMM registers for AVX-512
+                uint32_t xcr0_low, xcr0_high;
+                __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+
+                __cpuid_count(7, 0, eax, ebx, ecx, edx);
+                if ((ebx & bit_AVX512F) && (ebx & bit_AVX512DQ) && (xcr0_low & 0xE6) == 0xE6)
+                {
+                    return SmallNTTKernel::avx512;
+                }
+                if ((ebx & bit_AVX2) && (xcr0_low & 0x6) == 0x6)
+                {
+                    return SmallNTTKernel::avx2;
+                }
+                return SmallNTTKernel::scalar;
+            }
+#endif
+
+            // Kernel used by the transforms, the best supported one unless set_small_ntt_kernel chose another
+            atomic<int> &small_ntt_kernel()
+            {
+                static atomic<int> kernel(static_cast<int>(get_supported_small_ntt_kernel()));
+                return kernel;
+            }
+
+            typedef void (*small_ntt_function)(uint64_t *operand, const SmallNTTTables &tables);
+
+            small_ntt_function select_forward_kernel()
+            {
+#ifdef SEAL_ENABLE_AVX_NTT
+                switch (static_cast<SmallNTTKernel>(small_ntt_kernel().load()))
+                {
+                case SmallNTTKernel::avx512:
+                    return ntt_negacyclic_harvey_lazy_avx512;
+
+                case SmallNTTKernel::avx2:
+                    return ntt_negacyclic_harvey_lazy_avx2;
+
+                default:
+                    break;
+                }
+#endif
+                return ntt_negacyclic_harvey_lazy_scalar;
+            }
+
+            small_ntt_function select_inverse_kernel()
+            {
+#ifdef SEAL_ENABLE_AVX_NTT
+                switch (static_cast<SmallNTTKernel>(small_ntt_kernel().load()))
+                {
+                case SmallNTTKernel::avx512:
+                    return inverse_ntt_negacyclic_harvey_lazy_avx512;
+
+                case SmallNTTKernel::avx2:
+                    return inverse_ntt_negacyclic_harvey_lazy_avx2;
+
+                default:
+                    break;
+                }
+#endif
+                return inverse_ntt_negacyclic_harvey_lazy_scalar;
+            }
+
+            // Reduces the output of ntt_negacyclic_harvey_lazy from [0, 4q) to [0, q), as ntt_negacyclic_harvey does
+            void reduce_ntt_output(uint64_t *operand, const SmallNTTTables &tables)
+            {
+                int n = 1 << tables.coeff_count_power();
+                uint64_t modulus = tables.modulus().value();
+                uint64_t two_times_modulus = modulus * 2;
+                for (int i = 0; i < n; i++, operand++)
+                {
+                    if (*operand >= two_times_modulus)
+                    {
+                        *operand -= two_times_modulus;
+                    }
+                    if (*operand >= modulus)
+                    {
+                        *operand -= modulus;
+                    }
+                }
+            }
 
-            // return the bit-reversed order of NTT. 
-            int n = 1 << tables.coeff_count_power();
-            int t = 1;
-            for (int m = n; m > 1; m >>= 1)
+            // Reduces the output of inverse_ntt_negacyclic_harvey_lazy from [0, 2q) to [0, q)
+            void reduce_inverse_ntt_output(uint64_t *operand, const SmallNTTTables &tables)
             {
-                int j1 = 0;
-                int h = m >> 1;
-                for (int i = 0; i < h; i++)
+                int n = 1 << tables.coeff_count_power();
+                uint64_t modulus = tables.modulus().value();
+                for (int i = 0; i < n; i++, operand++)
                 {
-                    int j2 = j1 + t - 1;
-                    // Need the powers of  phi^{-1} in bit-reversed order
-                    const uint64_t W = tables.get_from_inv_root_powers_div_two(h + i);
-                    const uint64_t Wprime = tables.get_from_scaled_inv_root_powers_div_two(h + i);
-                    uint64_t *U = operand + j1;
-                    uint64_t *V = U + t;
-                    for (int j = j1; j <= j2; j++)
+                    if (*operand >= modulus)
                     {
-                        uint64_t currV = *V;
-                        uint64_t currU = *U;
-                        // U = x[i], V = x[i+m]
-
-                        // Compute U - V + 2q
-                        uint64_t T = two_times_modulus - currV + currU;
-
-                        // Cleverly check whether currU + currV >= two_times_modulus
-                        currU += currV - (two_times_modulus & static_cast<uint64_t>(-static_cast<int64_t>((currU << 1) >= T)));
-
-                        // Need to make it so that div2_uint_mod takes values that are > q. 
-                        //div2_uint_mod(U, modulusptr, coeff_uint64_count, U); 
-                        uint64_t masked_modulus = modulus & static_cast<uint64_t>(-static_cast<int64_t>(currU & 1));
-                        uint64_t carry = add_uint64(currU, masked_modulus, 0, &currU);
-                        *U++ = (currU >> 1) | (carry << (bits_per_uint64 - 1));
-
-                        uint64_t Q;
-                        multiply_uint64_hw64(Wprime, T, &Q);
-                        // effectively, the next two multiply perform multiply modulo beta = 2**wordsize. 
-                        *V++ = W * T - Q * modulus;
+                        *operand -= modulus;
                     }
-                    j1 += (t << 1);
                 }
-                t <<= 1;
             }
+
+            // Smallest residue polynomial worth transforming on another thread
+            const int min_parallel_ntt_coeff_count = 1 << 11;
+
+            /*
+            Calls transform on the coeff_mod_count residue polynomials of operand. Each residue has its own twiddle factors,
+            so nothing is shared between the residues but the choice of the kernel, and every residue is transformed whole
+            while it is in the cache. The residues are split between the threads of thread_pool if one is given.
+            */
+            template<typename Transform>
+            void transform_residues(uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+                ThreadPool *thread_pool, Transform transform)
+            {
+                if (thread_pool && coeff_mod_count > 1 && coeff_count >= min_parallel_ntt_coeff_count)
+                {
+                    thread_pool->parallel_for(coeff_mod_count, [&](int i) {
+                        transform(operand + i * coeff_count, tables[i]);
+                    });
+                    return;
+                }
+                for (int i = 0; i < coeff_mod_count; i++)
+                {
+                    transform(operand + i * coeff_count, tables[i]);
+                }
+            }
+        }
+
+        SmallNTTKernel get_supported_small_ntt_kernel()
+        {
+#ifdef SEAL_ENABLE_AVX_NTT
+            static const SmallNTTKernel supported = detect_small_ntt_kernel();
+            return supported;
+#else
+            return SmallNTTKernel::scalar;
+#endif
+        }
+
+        SmallNTTKernel get_small_ntt_kernel()
+        {
+            return static_cast<SmallNTTKernel>(small_ntt_kernel().load());
+        }
+
+        void set_small_ntt_kernel(SmallNTTKernel kernel)
+        {
+            if (static_cast<int>(kernel) > static_cast<int>(get_supported_small_ntt_kernel()))
+            {
+                throw invalid_argument("kernel is not supported by this processor");
+            }
+            small_ntt_kernel().store(static_cast<int>(kernel));
+        }
+
+        /**
+        This function computes in-place the negacyclic NTT. The input is a polynomial a of degree n in R_q,
+        where n is assumed to be a power of 2 and q is a prime such that q = 1 (mod 2n).
+
+        The output is a vector A such that the following hold:
+        A[j] =  a(psi**(2*bit_reverse(j) + 1)), 0 <= j < n.
+
+        For details, see Michael Naehrig and Patrick Longa.
+        */
+        void ntt_negacyclic_harvey_lazy(uint64_t *operand, const SmallNTTTables &tables)
+        {
+            select_forward_kernel()(operand, tables);
+        }
+
+        // Inverse negacyclic NTT using Harvey's butterfly. (See Patrick Longa and Michael Naehrig). 
+        void inverse_ntt_negacyclic_harvey_lazy(uint64_t *operand, const SmallNTTTables &tables)
+        {
+            select_inverse_kernel()(operand, tables);
+        }
+
+        void ntt_negacyclic_harvey_lazy(uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool)
+        {
+            small_ntt_function kernel = select_forward_kernel();
+            transform_residues(operand, coeff_count, coeff_mod_count, tables, thread_pool, [kernel](uint64_t *residue, const SmallNTTTables &residue_tables) {
+                kernel(residue, residue_tables);
+            });
+        }
+
+        void ntt_negacyclic_harvey(uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool)
+        {
+            small_ntt_function kernel = select_forward_kernel();
+            transform_residues(operand, coeff_count, coeff_mod_count, tables, thread_pool, [kernel](uint64_t *residue, const SmallNTTTables &residue_tables) {
+                kernel(residue, residue_tables);
+                reduce_ntt_output(residue, residue_tables);
+            });
+        }
+
+        void inverse_ntt_negacyclic_harvey_lazy(uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool)
+        {
+            small_ntt_function kernel = select_inverse_kernel();
+            transform_residues(operand, coeff_count, coeff_mod_count, tables, thread_pool, [kernel](uint64_t *residue, const SmallNTTTables &residue_tables) {
+                kernel(residue, residue_tables);
+            });
+        }
+
+        void inverse_ntt_negacyclic_harvey(uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool)
+        {
+            small_ntt_function kernel = select_inverse_kernel();
+            transform_residues(operand, coeff_count, coeff_mod_count, tables, thread_pool, [kernel](uint64_t *residue, const SmallNTTTables &residue_tables) {
+                kernel(residue, residue_tables);
+                reduce_inverse_ntt_output(residue, residue_tables);
+            });
         }
     }
 }
\ No newline at end of file
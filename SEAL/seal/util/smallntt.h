@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include "seal/memorypoolhandle.h"
 #include "seal/smallmodulus.h"
+#include "seal/util/threadpool.h"
 
 namespace seal
 {
@@ -133,6 +134,50 @@ namespace seal
                 return scaled_inv_root_powers_div_two_[index];
             }
 
+            inline const std::uint64_t *get_root_powers() const
+            {
+#ifdef SEAL_DEBUG
+                if (!generated_)
+                {
+                    throw std::logic_error("tables are not generated");
+                }
+#endif
+                return root_powers_.get();
+            }
+
+            inline const std::uint64_t *get_scaled_root_powers() const
+            {
+#ifdef SEAL_DEBUG
+                if (!generated_)
+                {
+                    throw std::logic_error("tables are not generated");
+                }
+#endif
+                return scaled_root_powers_.get();
+            }
+
+            inline const std::uint64_t *get_inv_root_powers_div_two() const
+            {
+#ifdef SEAL_DEBUG
+                if (!generated_)
+                {
+                    throw std::logic_error("tables are not generated");
+                }
+#endif
+                return inv_root_powers_div_two_.get();
+            }
+
+            inline const std::uint64_t *get_scaled_inv_root_powers_div_two() const
+            {
+#ifdef SEAL_DEBUG
+                if (!generated_)
+                {
+                    throw std::logic_error("tables are not generated");
+                }
+#endif
+                return scaled_inv_root_powers_div_two_.get();
+            }
+
             inline const std::uint64_t *get_inv_degree_modulo() const
             {
 #ifdef SEAL_DEBUG
@@ -200,6 +245,23 @@ namespace seal
 
         };
 
+        // Instruction sets the negacyclic NTT can be computed with, every one giving bit-identical results
+        enum class SmallNTTKernel
+        {
+            scalar = 0,
+            avx2 = 1,
+            avx512 = 2
+        };
+
+        // Returns the fastest kernel supported by the processor and the operating system, checked with CPUID
+        SmallNTTKernel get_supported_small_ntt_kernel();
+
+        // Returns the kernel used by the NTT functions below, the supported one unless set_small_ntt_kernel was called
+        SmallNTTKernel get_small_ntt_kernel();
+
+        // Sets the kernel used by the NTT functions below, throws std::invalid_argument if it is not supported
+        void set_small_ntt_kernel(SmallNTTKernel kernel);
+
         void ntt_negacyclic_harvey_lazy(std::uint64_t *operand, const SmallNTTTables &tables);
 
         inline void ntt_negacyclic_harvey(std::uint64_t *operand, const SmallNTTTables &tables)
@@ -246,5 +308,23 @@ namespace seal
                 operand++;
             }
         }
+
+        /*
+        The functions below transform in place the coeff_mod_count residue polynomials of an RNS representation, laid one
+        after the other every coeff_count values, residue i being transformed with tables[i]. The kernel is chosen once for
+        all of the residues, which are split between the threads of thread_pool if one is given. Each residue is transformed
+        exactly as by the functions above.
+        */
+        void ntt_negacyclic_harvey_lazy(std::uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool = nullptr);
+
+        void ntt_negacyclic_harvey(std::uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool = nullptr);
+
+        void inverse_ntt_negacyclic_harvey_lazy(std::uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool = nullptr);
+
+        void inverse_ntt_negacyclic_harvey(std::uint64_t *operand, int coeff_count, int coeff_mod_count, const SmallNTTTables *tables,
+            ThreadPool *thread_pool = nullptr);
     }
 }
@@ -0,0 +1,142 @@
+#include "seal/util/threadpool.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace seal
+{
+    namespace util
+    {
+        ThreadPool::ThreadPool(int thread_count)
+        {
+            if (thread_count < 1)
+            {
+                throw invalid_argument("thread_count must be at least 1");
+            }
+            try
+            {
+                for (int i = 1; i < thread_count; i++)
+                {
+                    workers_.emplace_back(&ThreadPool::work, this);
+                }
+            }
+            catch (...)
+            {
+                {
+                    lock_guard<mutex> lock(mutex_);
+                    stopping_ = true;
+                }
+                wake_.notify_all();
+                for (auto &worker : workers_)
+                {
+                    worker.join();
+                }
+                throw;
+            }
+        }
+
+        ThreadPool::~ThreadPool()
+        {
+            {
+                lock_guard<mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_all();
+            for (auto &worker : workers_)
+            {
+                worker.join();
+            }
+        }
+
+        void ThreadPool::parallel_for(int count, const function<void(int)> &task)
+        {
+            if (count <= 0)
+            {
+                return;
+            }
+            if (count == 1 || workers_.empty())
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    task(i);
+                }
+                return;
+            }
+
+            // The calling thread takes an iteration too, so count - 1 workers at most are useful
+            auto loop = make_shared<Loop>(count, task);
+            int helper_count = min(count - 1, static_cast<int>(workers_.size()));
+            {
+                lock_guard<mutex> lock(mutex_);
+                for (int i = 0; i < helper_count; i++)
+                {
+                    loops_.push_back(loop);
+                }
+            }
+            if (helper_count == 1)
+            {
+                wake_.notify_one();
+            }
+            else
+            {
+                wake_.notify_all();
+            }
+
+            run(*loop);
+
+            unique_lock<mutex> lock(loop->mutex);
+            loop->done.wait(lock, [&loop]() { return loop->finished == loop->count; });
+            if (loop->exception)
+            {
+                rethrow_exception(loop->exception);
+            }
+        }
+
+        void ThreadPool::run(Loop &loop)
+        {
+            // Once every iteration has been started, the loop (and its task) may not exist anymore but for the shared pointer
+            for (int i = loop.next++; i < loop.count; i = loop.next++)
+            {
+                exception_ptr exception;
+                try
+                {
+                    loop.task(i);
+                }
+                catch (...)
+                {
+                    exception = current_exception();
+                }
+
+                lock_guard<mutex> lock(loop.mutex);
+                if (exception && !loop.exception)
+                {
+                    loop.exception = exception;
+                }
+                if (++loop.finished == loop.count)
+                {
+                    loop.done.notify_all();
+                }
+            }
+        }
+
+        void ThreadPool::work()
+        {
+            while (true)
+            {
+                shared_ptr<Loop> loop;
+                {
+                    unique_lock<mutex> lock(mutex_);
+                    wake_.wait(lock, [this]() { return stopping_ || !loops_.empty(); });
+                    if (loops_.empty())
+                    {
+                        return;
+                    }
+                    loop = move(loops_.front());
+                    loops_.pop_front();
+                }
+                run(*loop);
+            }
+        }
+    }
+}
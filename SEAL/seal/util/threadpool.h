@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace seal
+{
+    namespace util
+    {
+        /**
+        A fixed set of worker threads running the iterations of parallel loops. The thread calling parallel_for
+        runs iterations too, and takes every iteration no worker has started, so a loop never waits for workers
+        busy with other loops. Loops can thus be run from several threads at once, and from inside other loops.
+        */
+        class ThreadPool
+        {
+        public:
+            /**
+            Starts thread_count - 1 workers, the thread calling parallel_for being the last one.
+
+            @throws std::invalid_argument if thread_count is less than 1
+            */
+            explicit ThreadPool(int thread_count);
+
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool &copy) = delete;
+
+            ThreadPool &operator =(const ThreadPool &assign) = delete;
+
+            /**
+            Returns the number of threads running the iterations of a loop, counting the calling thread.
+            */
+            inline int thread_count() const
+            {
+                return static_cast<int>(workers_.size()) + 1;
+            }
+
+            /**
+            Calls task(i) for every i in [0, count), on the workers and on the calling thread, and returns once
+            every call has returned. The calls must not depend on each other. If calls throw, the first exception
+            is thrown again here once every call has returned.
+            */
+            void parallel_for(int count, const std::function<void(int)> &task);
+
+        private:
+            struct Loop
+            {
+                Loop(int count, const std::function<void(int)> &task) : count(count), task(task)
+                {
+                }
+
+                const int count;
+
+                const std::function<void(int)> &task;
+
+                std::atomic<int> next{ 0 };
+
+                int finished = 0;
+
+                std::exception_ptr exception;
+
+                std::mutex mutex;
+
+                std::condition_variable done;
+            };
+
+            // Runs the iterations of loop until none is left to start
+            static void run(Loop &loop);
+
+            void work();
+
+            std::vector<std::thread> workers_;
+
+            // Loops waiting for a worker, once for each worker they can use
+            std::deque<std::shared_ptr<Loop>> loops_;
+
+            std::mutex mutex_;
+
+            std::condition_variable wake_;
+
+            bool stopping_ = false;
+        };
+    }
+}
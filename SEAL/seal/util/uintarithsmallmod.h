@@ -409,6 +409,161 @@ namespace seal
                 result[i] = barrett_reduce_128(z, modulus);
             }
         }
+        // Returns floor(operand * 2^64 / modulus), the precomputed (Shoup) form of a fixed multiplier operand < modulus.
+        // Multiplying any 64-bit value by operand then takes two word products and no division; see the functions below.
+        inline std::uint64_t shoup_precompute_uint_mod(std::uint64_t operand, const SmallModulus &modulus)
+        {
+#ifdef SEAL_DEBUG
+            if (modulus.value() == 0)
+            {
+                throw std::invalid_argument("modulus");
+            }
+            if (operand >= modulus.value())
+            {
+                throw std::out_of_range("operand");
+            }
+#endif
+            std::uint64_t wide_quotient[2]{ 0 };
+            std::uint64_t wide_coeff[2]{ 0, operand };
+            divide_uint128_uint64_inplace(wide_coeff, modulus.value(), wide_quotient);
+            return wide_quotient[0];
+        }
+
+        // Returns operand1 * operand2 modulo modulus in the lazy range [0, 2 * modulus), where operand2 < modulus
+        // and operand2_shoup = shoup_precompute_uint_mod(operand2, modulus). operand1 can be any 64-bit value.
+        inline std::uint64_t multiply_uint_uint_mod_lazy(std::uint64_t operand1, std::uint64_t operand2, std::uint64_t operand2_shoup, const SmallModulus &modulus)
+        {
+#ifdef SEAL_DEBUG
+            if (modulus.value() == 0)
+            {
+                throw std::invalid_argument("modulus");
+            }
+            if (operand2 >= modulus.value())
+            {
+                throw std::out_of_range("operand2");
+            }
+#endif
+            // The quotient estimate is at most one below the true quotient, so the low words give the remainder plus 
+            // at most one modulus
+            std::uint64_t quotient;
+            multiply_uint64_hw64(operand1, operand2_shoup, &quotient);
+            return operand1 * operand2 - quotient * modulus.value();
+        }
+
+        // Returns operand1 * operand2 modulo modulus, with operand2 and operand2_shoup as in multiply_uint_uint_mod_lazy
+        inline std::uint64_t multiply_uint_uint_mod(std::uint64_t operand1, std::uint64_t operand2, std::uint64_t operand2_shoup, const SmallModulus &modulus)
+        {
+            std::uint64_t tmp = multiply_uint_uint_mod_lazy(operand1, operand2, operand2_shoup, modulus);
+            return tmp - (modulus.value() & static_cast<std::uint64_t>(-static_cast<std::int64_t>(tmp >= modulus.value())));
+        }
+
+        // Returns operand1 * operand2 + addend modulo modulus in the lazy range [0, 2 * modulus), with operand2 and 
+        // operand2_shoup as in multiply_uint_uint_mod_lazy and addend in [0, 2 * modulus)
+        inline std::uint64_t multiply_add_uint_mod_lazy(std::uint64_t operand1, std::uint64_t operand2, std::uint64_t operand2_shoup, 
+            std::uint64_t addend, const SmallModulus &modulus)
+        {
+#ifdef SEAL_DEBUG
+            if (addend >= (modulus.value() << 1))
+            {
+                throw std::out_of_range("addend");
+            }
+#endif
+            // The sum is below 4 * modulus, which fits in a word since modulus has at most 62 bits
+            std::uint64_t two_times_modulus = modulus.value() << 1;
+            std::uint64_t tmp = multiply_uint_uint_mod_lazy(operand1, operand2, operand2_shoup, modulus) + addend;
+            return tmp - (two_times_modulus & static_cast<std::uint64_t>(-static_cast<std::int64_t>(tmp >= two_times_modulus)));
+        }
+
+        // Returns operand1 * operand2 + addend modulo modulus, with operand2 and operand2_shoup as in 
+        // multiply_uint_uint_mod_lazy and addend < modulus
+        inline std::uint64_t multiply_add_uint_mod(std::uint64_t operand1, std::uint64_t operand2, std::uint64_t operand2_shoup, 
+            std::uint64_t addend, const SmallModulus &modulus)
+        {
+#ifdef SEAL_DEBUG
+            if (addend >= modulus.value())
+            {
+                throw std::out_of_range("addend");
+            }
+#endif
+            std::uint64_t tmp = multiply_add_uint_mod_lazy(operand1, operand2, operand2_shoup, addend, modulus);
+            return tmp - (modulus.value() & static_cast<std::uint64_t>(-static_cast<std::int64_t>(tmp >= modulus.value())));
+        }
+
+        // Sets result[i] = operand[i] * scalar modulo modulus in the lazy range [0, 2 * modulus), where scalar < modulus 
+        // and scalar_shoup = shoup_precompute_uint_mod(scalar, modulus). operand and result may be the same.
+        inline void multiply_uint_scalar_mod_vector_lazy(const std::uint64_t *operand, int count, std::uint64_t scalar, std::uint64_t scalar_shoup, 
+            const SmallModulus &modulus, std::uint64_t *result)
+        {
+#ifdef SEAL_DEBUG
+            if (modulus.value() == 0)
+            {
+                throw std::invalid_argument("modulus");
+            }
+            if (scalar >= modulus.value())
+            {
+                throw std::out_of_range("scalar");
+            }
+#endif
+            std::uint64_t modulus_value = modulus.value();
+            for (int i = 0; i < count; i++)
+            {
+                std::uint64_t quotient;
+                multiply_uint64_hw64(operand[i], scalar_shoup, &quotient);
+                result[i] = operand[i] * scalar - quotient * modulus_value;
+            }
+        }
+
+        // Sets result[i] = operand[i] * scalar modulo modulus, with scalar and scalar_shoup as in 
+        // multiply_uint_scalar_mod_vector_lazy
+        inline void multiply_uint_scalar_mod_vector(const std::uint64_t *operand, int count, std::uint64_t scalar, std::uint64_t scalar_shoup, 
+            const SmallModulus &modulus, std::uint64_t *result)
+        {
+#ifdef SEAL_DEBUG
+            if (modulus.value() == 0)
+            {
+                throw std::invalid_argument("modulus");
+            }
+            if (scalar >= modulus.value())
+            {
+                throw std::out_of_range("scalar");
+            }
+#endif
+            std::uint64_t modulus_value = modulus.value();
+            for (int i = 0; i < count; i++)
+            {
+                std::uint64_t quotient;
+                multiply_uint64_hw64(operand[i], scalar_shoup, &quotient);
+                std::uint64_t tmp = operand[i] * scalar - quotient * modulus_value;
+                result[i] = tmp - (modulus_value & static_cast<std::uint64_t>(-static_cast<std::int64_t>(tmp >= modulus_value)));
+            }
+        }
+
+        // Sets result[i] = result[i] + operand[i] * scalar modulo modulus, with scalar and scalar_shoup as in 
+        // multiply_uint_scalar_mod_vector_lazy and every result[i] < modulus
+        inline void multiply_add_uint_scalar_mod_vector(const std::uint64_t *operand, int count, std::uint64_t scalar, std::uint64_t scalar_shoup, 
+            const SmallModulus &modulus, std::uint64_t *result)
+        {
+#ifdef SEAL_DEBUG
+            if (modulus.value() == 0)
+            {
+                throw std::invalid_argument("modulus");
+            }
+            if (scalar >= modulus.value())
+            {
+                throw std::out_of_range("scalar");
+            }
+#endif
+            std::uint64_t modulus_value = modulus.value();
+            std::uint64_t two_times_modulus = modulus_value << 1;
+            for (int i = 0; i < count; i++)
+            {
+                std::uint64_t quotient;
+                multiply_uint64_hw64(operand[i], scalar_shoup, &quotient);
+                std::uint64_t tmp = operand[i] * scalar - quotient * modulus_value + result[i];
+                tmp -= two_times_modulus & static_cast<std::uint64_t>(-static_cast<std::int64_t>(tmp >= two_times_modulus));
+                result[i] = tmp - (modulus_value & static_cast<std::uint64_t>(-static_cast<std::int64_t>(tmp >= modulus_value)));
+            }
+        }
 
         inline void modulo_uint_inplace(std::uint64_t *value, int value_uint64_count, const SmallModulus &modulus)
         {
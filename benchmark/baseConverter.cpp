@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "seal/defaultparams.h"
+#include "seal/memorypoolhandle.h"
+#include "seal/util/baseconverter.h"
+#include "seal/util/globals.h"
+#include "seal/util/uintarith.h"
+#include "seal/util/uintarithsmallmod.h"
+#include "seal/util/uintcore.h"
+
+using namespace std;
+using namespace seal;
+using namespace seal::util;
+
+/*
+Reference BaseConverter : the per-coefficient scalar loops of fastbconv, fastbconv_mtilde, mont_rq,
+fast_floor and fastbconv_sk as they were before they were blocked and fused. The new kernels are timed
+against it and must give the same output.
+*/
+class ReferenceBaseConverter {
+public:
+	ReferenceBaseConverter(const vector<SmallModulus>& coeff_base, int coeff_count, int aux_base_mod_count);
+
+	void fastbconv(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const;
+	void fastbconv_mtilde(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const;
+	void mont_rq(const uint64_t* input, uint64_t* destination) const;
+	void fast_floor(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const;
+	void fastbconv_sk(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const;
+
+private:
+	int coeff_count_;
+	int coeff_base_mod_count_;
+	int aux_base_mod_count_;
+	int bsk_base_mod_count_;
+	SmallModulus m_tilde_;
+	SmallModulus m_sk_;
+	vector<SmallModulus> coeff_base_array_;
+	vector<SmallModulus> aux_base_array_;
+	vector<SmallModulus> bsk_base_array_;
+	vector<uint64_t> inv_coeff_base_products_mod_coeff_array_;
+	vector<uint64_t> mtilde_inv_coeff_base_products_mod_coeff_array_;
+	vector<vector<uint64_t>> coeff_base_products_mod_aux_bsk_array_;
+	vector<uint64_t> coeff_base_products_mod_mtilde_array_;
+	vector<uint64_t> inv_coeff_products_all_mod_aux_bsk_array_;
+	vector<uint64_t> coeff_products_all_mod_bsk_array_;
+	vector<uint64_t> inv_mtilde_mod_bsk_array_;
+	uint64_t inv_coeff_products_mod_mtilde_;
+	vector<uint64_t> inv_aux_base_products_mod_aux_array_;
+	vector<vector<uint64_t>> aux_base_products_mod_coeff_array_;
+	vector<uint64_t> aux_base_products_mod_msk_array_;
+	vector<uint64_t> aux_products_all_mod_coeff_array_;
+	uint64_t inv_aux_products_mod_msk_;
+};
+
+void benchmark(ofstream&, int, int, int);
+double average(function<void()>, int);
+uint64_t product_mod(const vector<SmallModulus>&, int, const SmallModulus&);
+uint64_t invert_mod(uint64_t, const SmallModulus&);
+vector<uint64_t> random_residues(const vector<SmallModulus>&, int, mt19937_64&);
+
+int main() {
+
+	const vector<int> poly_modulus_degree_list { 2048, 4096, 8192, 16384, 32768 };
+	const int plain_modulus = 65537;
+	const int count = 20;
+
+	ofstream file;
+	file.open("baseConverterResults.txt", ios::app);
+
+	/* BaseConverter benchmark Programme */
+	cout << "/=====================================\\" << endl;
+	cout << "*  BASECONVERTER BENCHMARK PROGRAMME  *" << endl;
+	cout << "\\=====================================/" << endl;
+	cout << endl;
+
+	for (size_t i = 0; i < poly_modulus_degree_list.size(); ++i) {
+		benchmark(file, poly_modulus_degree_list[i], plain_modulus, count);
+	}
+
+	file.close();
+	return 0;
+}
+
+/* Average time of count calls to kernel in microseconds, after a first call warming the caches */
+double average(function<void()> kernel, int count) {
+	kernel();
+
+	auto time_start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < count; ++i) {
+		kernel();
+	}
+	auto time_end = chrono::high_resolution_clock::now();
+
+	return chrono::duration<double, micro>(time_end - time_start).count() / count;
+}
+
+/* Product of the moduli of base, except base[skip], reduced modulo modulus */
+uint64_t product_mod(const vector<SmallModulus>& base, int skip, const SmallModulus& modulus) {
+	uint64_t product = 1;
+	for (int i = 0; i < (int) base.size(); ++i) {
+		if (i != skip) {
+			product = multiply_uint_uint_mod(product, base[i].value() % modulus.value(), modulus);
+		}
+	}
+	return product;
+}
+
+uint64_t invert_mod(uint64_t value, const SmallModulus& modulus) {
+	uint64_t result = 0;
+	if (!try_invert_uint_mod(value, modulus, result)) {
+		throw logic_error("value is not invertible");
+	}
+	return result;
+}
+
+/* One random residue modulo base[i] for each of the coeff_count coefficients of each modulus */
+vector<uint64_t> random_residues(const vector<SmallModulus>& base, int coeff_count, mt19937_64& random) {
+	vector<uint64_t> residues(base.size() * coeff_count);
+	for (size_t i = 0; i < base.size(); ++i) {
+		for (int k = 0; k < coeff_count; ++k) {
+			residues[k + i * coeff_count] = random() % base[i].value();
+		}
+	}
+	return residues;
+}
+
+ReferenceBaseConverter::ReferenceBaseConverter(const vector<SmallModulus>& coeff_base, int coeff_count, int aux_base_mod_count) :
+	coeff_count_(coeff_count), coeff_base_mod_count_(coeff_base.size()), aux_base_mod_count_(aux_base_mod_count),
+	bsk_base_mod_count_(aux_base_mod_count + 1), m_tilde_(global_variables::internal_mods::m_tilde),
+	m_sk_(global_variables::internal_mods::m_sk), coeff_base_array_(coeff_base) {
+
+	aux_base_array_.assign(global_variables::internal_mods::aux_small_mods.begin(),
+		global_variables::internal_mods::aux_small_mods.begin() + aux_base_mod_count_);
+	bsk_base_array_ = aux_base_array_;
+	bsk_base_array_.push_back(m_sk_);
+
+	/* Constants of the conversions from q */
+	inv_coeff_base_products_mod_coeff_array_.resize(coeff_base_mod_count_);
+	mtilde_inv_coeff_base_products_mod_coeff_array_.resize(coeff_base_mod_count_);
+	coeff_base_products_mod_mtilde_array_.resize(coeff_base_mod_count_);
+	coeff_base_products_mod_aux_bsk_array_.assign(coeff_base_mod_count_, vector<uint64_t>(bsk_base_mod_count_));
+	for (int i = 0; i < coeff_base_mod_count_; ++i) {
+		inv_coeff_base_products_mod_coeff_array_[i] = invert_mod(product_mod(coeff_base_array_, i, coeff_base_array_[i]), coeff_base_array_[i]);
+		mtilde_inv_coeff_base_products_mod_coeff_array_[i] = multiply_uint_uint_mod(inv_coeff_base_products_mod_coeff_array_[i],
+			m_tilde_.value(), coeff_base_array_[i]);
+		coeff_base_products_mod_mtilde_array_[i] = product_mod(coeff_base_array_, i, m_tilde_);
+		for (int j = 0; j < bsk_base_mod_count_; ++j) {
+			coeff_base_products_mod_aux_bsk_array_[i][j] = product_mod(coeff_base_array_, i, bsk_base_array_[j]);
+		}
+	}
+
+	/* Constants of the Montgomery reduction and of the floor in Bsk */
+	inv_coeff_products_all_mod_aux_bsk_array_.resize(bsk_base_mod_count_);
+	coeff_products_all_mod_bsk_array_.resize(bsk_base_mod_count_);
+	inv_mtilde_mod_bsk_array_.resize(bsk_base_mod_count_);
+	for (int j = 0; j < bsk_base_mod_count_; ++j) {
+		coeff_products_all_mod_bsk_array_[j] = product_mod(coeff_base_array_, -1, bsk_base_array_[j]);
+		inv_coeff_products_all_mod_aux_bsk_array_[j] = invert_mod(coeff_products_all_mod_bsk_array_[j], bsk_base_array_[j]);
+		inv_mtilde_mod_bsk_array_[j] = invert_mod(m_tilde_.value() % bsk_base_array_[j].value(), bsk_base_array_[j]);
+	}
+	inv_coeff_products_mod_mtilde_ = invert_mod(product_mod(coeff_base_array_, -1, m_tilde_), m_tilde_);
+
+	/* Constants of the conversion from Bsk back to q */
+	inv_aux_base_products_mod_aux_array_.resize(aux_base_mod_count_);
+	aux_base_products_mod_msk_array_.resize(aux_base_mod_count_);
+	aux_base_products_mod_coeff_array_.assign(coeff_base_mod_count_, vector<uint64_t>(aux_base_mod_count_));
+	for (int i = 0; i < aux_base_mod_count_; ++i) {
+		inv_aux_base_products_mod_aux_array_[i] = invert_mod(product_mod(aux_base_array_, i, aux_base_array_[i]), aux_base_array_[i]);
+		aux_base_products_mod_msk_array_[i] = product_mod(aux_base_array_, i, m_sk_);
+		for (int j = 0; j < coeff_base_mod_count_; ++j) {
+			aux_base_products_mod_coeff_array_[j][i] = product_mod(aux_base_array_, i, coeff_base_array_[j]);
+		}
+	}
+	aux_products_all_mod_coeff_array_.resize(coeff_base_mod_count_);
+	for (int j = 0; j < coeff_base_mod_count_; ++j) {
+		aux_products_all_mod_coeff_array_[j] = product_mod(aux_base_array_, -1, coeff_base_array_[j]);
+	}
+	inv_aux_products_mod_msk_ = invert_mod(product_mod(aux_base_array_, -1, m_sk_), m_sk_);
+}
+
+void ReferenceBaseConverter::fastbconv(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const {
+	Pointer temp_coeff_transition(allocate_uint(coeff_count_ * coeff_base_mod_count_, pool));
+	for (int i = 0; i < coeff_base_mod_count_; i++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			temp_coeff_transition[k + (i * coeff_count_)] = multiply_uint_uint_mod(input[k + (i * coeff_count_)],
+				inv_coeff_base_products_mod_coeff_array_[i], coeff_base_array_[i]);
+		}
+	}
+
+	for (int j = 0; j < bsk_base_mod_count_; j++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			uint64_t aux_transition[2] { 0 };
+			for (int i = 0; i < coeff_base_mod_count_; i++) {
+				uint64_t temp[2];
+				multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], coeff_base_products_mod_aux_bsk_array_[i][j], temp);
+				unsigned char carry = add_uint64(aux_transition[0], temp[0], 0, aux_transition);
+				aux_transition[1] += temp[1] + carry;
+			}
+			destination[k + (j * coeff_count_)] = barrett_reduce_128(aux_transition, bsk_base_array_[j]);
+		}
+	}
+}
+
+void ReferenceBaseConverter::fastbconv_mtilde(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const {
+	Pointer temp_coeff_transition(allocate_uint(coeff_count_ * coeff_base_mod_count_, pool));
+	for (int i = 0; i < coeff_base_mod_count_; i++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			temp_coeff_transition[k + (i * coeff_count_)] = multiply_uint_uint_mod(input[k + (i * coeff_count_)],
+				mtilde_inv_coeff_base_products_mod_coeff_array_[i], coeff_base_array_[i]);
+		}
+	}
+
+	for (int j = 0; j < bsk_base_mod_count_; j++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			uint64_t aux_transition[2] { 0 };
+			for (int i = 0; i < coeff_base_mod_count_; i++) {
+				uint64_t temp[2];
+				multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], coeff_base_products_mod_aux_bsk_array_[i][j], temp);
+				unsigned char carry = add_uint64(aux_transition[0], temp[0], 0, aux_transition);
+				aux_transition[1] += temp[1] + carry;
+			}
+			destination[k + (j * coeff_count_)] = barrett_reduce_128(aux_transition, bsk_base_array_[j]);
+		}
+	}
+
+	int index_mtilde = bsk_base_mod_count_ * coeff_count_;
+	for (int k = 0; k < coeff_count_; k++) {
+		uint64_t wide_result[2] { 0 };
+		for (int i = 0; i < coeff_base_mod_count_; i++) {
+			uint64_t aux_transition[2];
+			multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], coeff_base_products_mod_mtilde_array_[i], aux_transition);
+			unsigned char carry = add_uint64(aux_transition[0], wide_result[0], 0, wide_result);
+			wide_result[1] += aux_transition[1] + carry;
+		}
+		destination[index_mtilde + k] = barrett_reduce_128(wide_result, m_tilde_);
+	}
+}
+
+void ReferenceBaseConverter::mont_rq(const uint64_t* input, uint64_t* destination) const {
+	for (int i = 0; i < coeff_count_; i++) {
+		uint64_t r_mtilde = multiply_uint_uint_mod(input[i + (coeff_count_ * bsk_base_mod_count_)], inv_coeff_products_mod_mtilde_, m_tilde_);
+		r_mtilde = negate_uint_mod(r_mtilde, m_tilde_);
+
+		for (int k = 0; k < bsk_base_mod_count_; k++) {
+			uint64_t tmp[2];
+			multiply_uint64(coeff_products_all_mod_bsk_array_[k], r_mtilde, tmp);
+			tmp[1] += add_uint64(tmp[0], input[i + (k * coeff_count_)], 0, tmp);
+			uint64_t tmp2 = barrett_reduce_128(tmp, bsk_base_array_[k]);
+			destination[i + (k * coeff_count_)] = multiply_uint_uint_mod(tmp2, inv_mtilde_mod_bsk_array_[k], bsk_base_array_[k]);
+		}
+	}
+}
+
+void ReferenceBaseConverter::fast_floor(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const {
+	fastbconv(input, destination, pool);
+
+	int index_msk = coeff_base_mod_count_ * coeff_count_;
+	for (int i = 0; i < bsk_base_mod_count_; i++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			uint64_t negated_base_convert_Bsk = bsk_base_array_[i].value() - destination[k + (i * coeff_count_)];
+			uint64_t bsk_transition = input[index_msk + k + (i * coeff_count_)] + negated_base_convert_Bsk;
+			destination[k + (i * coeff_count_)] = multiply_uint_uint_mod(bsk_transition, inv_coeff_products_all_mod_aux_bsk_array_[i], bsk_base_array_[i]);
+		}
+	}
+}
+
+void ReferenceBaseConverter::fastbconv_sk(const uint64_t* input, uint64_t* destination, const MemoryPoolHandle& pool) const {
+	Pointer temp_coeff_transition(allocate_uint(coeff_count_ * aux_base_mod_count_, pool));
+	for (int i = 0; i < aux_base_mod_count_; i++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			temp_coeff_transition[k + (i * coeff_count_)] = multiply_uint_uint_mod(input[k + (i * coeff_count_)],
+				inv_aux_base_products_mod_aux_array_[i], aux_base_array_[i]);
+		}
+	}
+
+	for (int j = 0; j < coeff_base_mod_count_; j++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			uint64_t aux_transition[2] { 0 };
+			for (int i = 0; i < aux_base_mod_count_; i++) {
+				uint64_t temp[2];
+				multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], aux_base_products_mod_coeff_array_[j][i], temp);
+				unsigned char carry = add_uint64(aux_transition[0], temp[0], 0, aux_transition);
+				aux_transition[1] += temp[1] + carry;
+			}
+			destination[k + (j * coeff_count_)] = barrett_reduce_128(aux_transition, coeff_base_array_[j]);
+		}
+	}
+
+	/* alpha_sk, from the conversion of the auxiliary residues to m_sk */
+	Pointer tmp(allocate_uint(coeff_count_, pool));
+	for (int k = 0; k < coeff_count_; k++) {
+		uint64_t msk_transition[2] { 0 };
+		for (int i = 0; i < aux_base_mod_count_; i++) {
+			uint64_t temp[2];
+			multiply_uint64(temp_coeff_transition[k + (i * coeff_count_)], aux_base_products_mod_msk_array_[i], temp);
+			unsigned char carry = add_uint64(msk_transition[0], temp[0], 0, msk_transition);
+			msk_transition[1] += temp[1] + carry;
+		}
+		tmp[k] = barrett_reduce_128(msk_transition, m_sk_);
+	}
+
+	Pointer alpha_sk(allocate_uint(coeff_count_, pool));
+	for (int i = 0; i < coeff_count_; i++) {
+		uint64_t negated_input = m_sk_.value() - input[i + (aux_base_mod_count_ * coeff_count_)];
+		tmp[i] += negated_input;
+		alpha_sk[i] = multiply_uint_uint_mod(tmp[i], inv_aux_products_mod_msk_, m_sk_);
+	}
+
+	uint64_t m_sk_div_2 = m_sk_.value() >> 1;
+	for (int i = 0; i < coeff_base_mod_count_; i++) {
+		for (int k = 0; k < coeff_count_; k++) {
+			uint64_t m_alpha_sk[2];
+
+			/* alpha_sk is a centered residue */
+			if (alpha_sk[k] > m_sk_div_2) {
+				uint64_t alpha_sk_corrected = m_sk_.value() - alpha_sk[k];
+				multiply_uint64(aux_products_all_mod_coeff_array_[i], alpha_sk_corrected, m_alpha_sk);
+				m_alpha_sk[1] += add_uint64(m_alpha_sk[0], destination[k + (i * coeff_count_)], 0, m_alpha_sk);
+				destination[k + (i * coeff_count_)] = barrett_reduce_128(m_alpha_sk, coeff_base_array_[i]);
+			}
+			else {
+				uint64_t negated_input = coeff_base_array_[i].value() - aux_products_all_mod_coeff_array_[i];
+				multiply_uint64(negated_input, alpha_sk[k], m_alpha_sk);
+				m_alpha_sk[1] += add_uint64(destination[k + (i * coeff_count_)], m_alpha_sk[0], 0, m_alpha_sk);
+				destination[k + (i * coeff_count_)] = barrett_reduce_128(m_alpha_sk, coeff_base_array_[i]);
+			}
+		}
+	}
+}
+
+void benchmark(ofstream& file, int poly_modulus_degree, int plain_modulus, int count) {
+	/* Benchmark START */
+	file << "============== BASECONVERTER N=" << poly_modulus_degree << " ==============" << endl;
+	file << endl;
+
+	/* Base converter of the default coeff_modulus */
+	vector<SmallModulus> coeff_modulus = coeff_modulus_128(poly_modulus_degree);
+	int coeff_count_power = 0;
+	while ((1 << coeff_count_power) < poly_modulus_degree) {
+		++coeff_count_power;
+	}
+	BaseConverter base_converter(coeff_modulus, poly_modulus_degree, coeff_count_power, SmallModulus(plain_modulus));
+	if (!base_converter.is_generated()) {
+		cout << "BaseConverter N=" << poly_modulus_degree << " not generated" << endl;
+		file << "Not generated" << endl;
+		file << endl;
+		return;
+	}
+	ReferenceBaseConverter reference(coeff_modulus, poly_modulus_degree, base_converter.aux_base_mod_count());
+
+	/* Write parameters in file */
+	int coeff_mod_count = coeff_modulus.size();
+	int bsk_base_mod_count = base_converter.bsk_base_mod_count();
+	file << "Parameters loaded : " << endl;
+	file << "{ Poly Modulus Degree     : " << poly_modulus_degree << endl;
+	file << "{ Coeff Modulus Count     : " << coeff_mod_count << endl;
+	file << "{ Bsk Base Count          : " << bsk_base_mod_count << endl;
+	file << "{ Plain Modulus           : " << plain_modulus << endl;
+	file << endl;
+
+	/* Random residues in the input base of each kernel */
+	const vector<SmallModulus>& bsk_modulus = base_converter.get_bsk_mod_array();
+	vector<SmallModulus> bsk_mtilde_modulus(bsk_modulus);
+	bsk_mtilde_modulus.push_back(global_variables::internal_mods::m_tilde);
+	vector<SmallModulus> coeff_bsk_modulus(coeff_modulus);
+	coeff_bsk_modulus.insert(coeff_bsk_modulus.end(), bsk_modulus.begin(), bsk_modulus.end());
+
+	mt19937_64 random(1);
+	vector<uint64_t> input_q = random_residues(coeff_modulus, poly_modulus_degree, random);
+	vector<uint64_t> input_bsk = random_residues(bsk_modulus, poly_modulus_degree, random);
+	vector<uint64_t> input_bsk_mtilde = random_residues(bsk_mtilde_modulus, poly_modulus_degree, random);
+	vector<uint64_t> input_q_bsk = random_residues(coeff_bsk_modulus, poly_modulus_degree, random);
+	vector<uint64_t> output_old((bsk_base_mod_count + 1) * poly_modulus_degree);
+	vector<uint64_t> output_new((bsk_base_mod_count + 1) * poly_modulus_degree);
+	MemoryPoolHandle pool = MemoryPoolHandle::Global();
+
+	cout << "Running BaseConverter N=" << poly_modulus_degree << " | ";
+	cout.flush();
+
+	const vector<string> names { "fastbconv", "fastbconv_mtilde", "mont_rq", "fast_floor", "fastbconv_sk" };
+	const vector<function<void(uint64_t*)>> old_kernels {
+		[&](uint64_t* output) { reference.fastbconv(input_q.data(), output, pool); },
+		[&](uint64_t* output) { reference.fastbconv_mtilde(input_q.data(), output, pool); },
+		[&](uint64_t* output) { reference.mont_rq(input_bsk_mtilde.data(), output); },
+		[&](uint64_t* output) { reference.fast_floor(input_q_bsk.data(), output, pool); },
+		[&](uint64_t* output) { reference.fastbconv_sk(input_bsk.data(), output, pool); }
+	};
+	const vector<function<void(uint64_t*)>> new_kernels {
+		[&](uint64_t* output) { base_converter.fastbconv(input_q.data(), output, pool); },
+		[&](uint64_t* output) { base_converter.fastbconv_mtilde(input_q.data(), output, pool); },
+		[&](uint64_t* output) { base_converter.mont_rq(input_bsk_mtilde.data(), output); },
+		[&](uint64_t* output) { base_converter.fast_floor(input_q_bsk.data(), output, pool); },
+		[&](uint64_t* output) { base_converter.fastbconv_sk(input_bsk.data(), output, pool); }
+	};
+
+	/* Save results in file : old and new times in microseconds, and the speedup old / new */
+	file << "Kernel              Old (us)    New (us)    Old / New    Output" << endl;
+	for (size_t i = 0; i < names.size(); ++i) {
+		fill(output_old.begin(), output_old.end(), 0);
+		fill(output_new.begin(), output_new.end(), 0);
+		double avg_old = average([&] { old_kernels[i](output_old.data()); }, count);
+		double avg_new = average([&] { new_kernels[i](output_new.data()); }, count);
+		bool identical = output_old == output_new;
+		if (!identical) {
+			cout << names[i] << " output differs | ";
+		}
+
+		file << names[i] << string(20 - names[i].size(), ' ');
+		file << avg_old << "\t" << avg_new << "\t" << avg_old / avg_new << "\t" << (identical ? "identical" : "DIFFERENT") << endl;
+	}
+	file << endl;
+
+	/* End of process */
+	cout << " done." << endl;
+	cout.flush();
+
+	/* Benchmark END */
+	file << "============================================" << endl;
+}
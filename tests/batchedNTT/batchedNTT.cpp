@@ -0,0 +1,143 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "seal/defaultparams.h"
+#include "seal/memorypoolhandle.h"
+#include "seal/util/smallntt.h"
+#include "seal/util/threadpool.h"
+
+using namespace std;
+using namespace seal;
+using namespace seal::util;
+
+const int threadCount = 3;
+
+const char *transformNames[] = { "ntt_negacyclic_harvey_lazy", "ntt_negacyclic_harvey",
+	"inverse_ntt_negacyclic_harvey_lazy", "inverse_ntt_negacyclic_harvey" };
+
+/**
+	transforms every residue of operand with its own call to the single-residue function
+*/
+void perResidue(int transform, uint64_t *operand, int coeffCount, const vector<SmallNTTTables> &tables)
+{
+	for(size_t i = 0; i < tables.size(); i++)
+	{
+		uint64_t *residue = operand + i * coeffCount;
+		switch(transform)
+		{
+		case 0:
+			ntt_negacyclic_harvey_lazy(residue, tables[i]);
+			break;
+
+		case 1:
+			ntt_negacyclic_harvey(residue, tables[i]);
+			break;
+
+		case 2:
+			inverse_ntt_negacyclic_harvey_lazy(residue, tables[i]);
+			break;
+
+		default:
+			inverse_ntt_negacyclic_harvey(residue, tables[i]);
+			break;
+		}
+	}
+}
+
+/**
+	transforms every residue of operand in one call to the batched function
+*/
+void batched(int transform, uint64_t *operand, int coeffCount, const vector<SmallNTTTables> &tables, ThreadPool *threadPool)
+{
+	int coeffModCount = tables.size();
+	switch(transform)
+	{
+	case 0:
+		ntt_negacyclic_harvey_lazy(operand, coeffCount, coeffModCount, tables.data(), threadPool);
+		break;
+
+	case 1:
+		ntt_negacyclic_harvey(operand, coeffCount, coeffModCount, tables.data(), threadPool);
+		break;
+
+	case 2:
+		inverse_ntt_negacyclic_harvey_lazy(operand, coeffCount, coeffModCount, tables.data(), threadPool);
+		break;
+
+	default:
+		inverse_ntt_negacyclic_harvey(operand, coeffCount, coeffModCount, tables.data(), threadPool);
+		break;
+	}
+}
+
+/**
+	compares the batched transforms with the per-residue ones for the default coefficient modulus of degree 2^power,
+	with every supported kernel, without and with a thread pool
+	@return the number of failed comparisons
+*/
+int checkDegree(int power, ThreadPool &threadPool, mt19937_64 &random)
+{
+	int coeffCount = 1 << power;
+	vector<SmallModulus> coeffModulus = coeff_modulus_128(coeffCount);
+	vector<SmallNTTTables> tables;
+	for(size_t i = 0; i < coeffModulus.size(); i++)
+	{
+		tables.emplace_back(power, coeffModulus[i], MemoryPoolHandle::Global());
+	}
+
+	vector<uint64_t> input(coeffCount * coeffModulus.size());
+	for(size_t i = 0; i < coeffModulus.size(); i++)
+	{
+		uniform_int_distribution<uint64_t> coefficient(0, coeffModulus[i].value() - 1);
+		for(int j = 0; j < coeffCount; j++)
+		{
+			input[i * coeffCount + j] = coefficient(random);
+		}
+	}
+
+	int failures = 0;
+	int supported = static_cast<int>(get_supported_small_ntt_kernel());
+	for(int kernel = 0; kernel <= supported; kernel++)
+	{
+		set_small_ntt_kernel(static_cast<SmallNTTKernel>(kernel));
+		for(int transform = 0; transform < 4; transform++)
+		{
+			vector<uint64_t> expected(input);
+			perResidue(transform, expected.data(), coeffCount, tables);
+
+			for(int pooled = 0; pooled < 2; pooled++)
+			{
+				vector<uint64_t> result(input);
+				batched(transform, result.data(), coeffCount, tables, pooled ? &threadPool : nullptr);
+				if(result != expected)
+				{
+					cout << "FAIL N = " << coeffCount << " kernel " << kernel << " " << transformNames[transform]
+						<< (pooled ? " with a thread pool" : "") << ": differs from the per-residue calls" << endl;
+					failures++;
+				}
+			}
+		}
+	}
+	set_small_ntt_kernel(get_supported_small_ntt_kernel());
+
+	return failures;
+}
+
+int main()
+{
+	ThreadPool threadPool(threadCount);
+	mt19937_64 random(1);
+
+	int failures = 0;
+	for(int power = 10; power <= 15; power++)
+	{
+		int degreeFailures = checkDegree(power, threadPool, random);
+		cout << (degreeFailures ? "FAIL " : "OK   ") << "N = " << (1 << power) << ", " << coeff_modulus_128(1 << power).size() << " residues" << endl;
+		failures += degreeFailures;
+	}
+
+	cout << (failures ? "FAILED" : "PASSED") << endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "seal/seal.h"
+
+using namespace std;
+using namespace seal;
+
+const int threadCount = 3;
+
+/**
+	keys and ciphertexts every evaluation is run on
+*/
+struct Inputs
+{
+	SecretKey secretKey;
+	EvaluationKeys evaluationKeys;
+	GaloisKeys galoisKeys;
+	Ciphertext first;
+	Ciphertext second;
+
+	void save(ostream &stream) const
+	{
+		secretKey.save(stream);
+		evaluationKeys.save(stream);
+		galoisKeys.save(stream);
+		first.save(stream);
+		second.save(stream);
+	}
+
+	void load(istream &stream)
+	{
+		secretKey.load(stream);
+		evaluationKeys.load(stream);
+		galoisKeys.load(stream);
+		first.load(stream);
+		second.load(stream);
+	}
+};
+
+EncryptionParameters parameters(int polyModulusDegree)
+{
+	EncryptionParameters parms;
+	parms.set_poly_modulus("1x^" + to_string(polyModulusDegree) + " + 1");
+	parms.set_coeff_modulus(coeff_modulus_128(polyModulusDegree));
+	parms.set_plain_modulus(65537);
+	return parms;
+}
+
+Inputs generateInputs(const SEALContext &context)
+{
+	Inputs inputs;
+	KeyGenerator generator(context);
+	inputs.secretKey = generator.secret_key();
+	generator.generate_evaluation_keys(30, 1, inputs.evaluationKeys);
+	generator.generate_galois_keys(30, inputs.galoisKeys);
+
+	Encryptor encryptor(context, generator.public_key());
+	encryptor.encrypt(Plaintext("7x^5 + 3x^1 + 1"), inputs.first);
+	encryptor.encrypt(Plaintext("5x^3 + 2"), inputs.second);
+	return inputs;
+}
+
+/**
+	runs every operation the thread pool splits, using pool for the allocations
+	@return the serialized results, one after the other
+	@param[out] product the relinearized product of the two ciphertexts
+*/
+string evaluate(Evaluator &evaluator, const Inputs &inputs, const MemoryPoolHandle &pool, Ciphertext &product)
+{
+	ostringstream stream;
+	Ciphertext result;
+
+	evaluator.multiply(inputs.first, inputs.second, product, pool);
+	product.save(stream);
+	evaluator.square(inputs.first, result, pool);
+	result.save(stream);
+	evaluator.relinearize(product, inputs.evaluationKeys, pool);
+	product.save(stream);
+
+	result = inputs.first;
+	evaluator.rotate_rows(result, 3, inputs.galoisKeys, pool);
+	result.save(stream);
+	evaluator.rotate_columns(result, inputs.galoisKeys, pool);
+	result.save(stream);
+
+	evaluator.multiply_plain(inputs.second, Plaintext("3x^2 + 9"), result, pool);
+	result.save(stream);
+
+	result = inputs.first;
+	evaluator.transform_to_ntt(result);
+	result.save(stream);
+	evaluator.transform_from_ntt(result);
+	result.save(stream);
+
+	return stream.str();
+}
+
+/**
+	compares the results without a pool, with a pool of threadCount threads and with a pool and a thread-unsafe memory pool
+	the results without a pool are also compared with the baseline file if it exists, and saved in it otherwise
+	@return the number of failed comparisons
+*/
+int check(int polyModulusDegree, const string &baselineFile)
+{
+	SEALContext context(parameters(polyModulusDegree));
+
+	Inputs inputs;
+	string baseline;
+	ifstream baselineInput;
+	if(!baselineFile.empty())
+	{
+		baselineInput.open(baselineFile.c_str(), ios::in | ios::binary);
+	}
+	if(baselineInput.is_open())
+	{
+		inputs.load(baselineInput);
+		baseline.assign(istreambuf_iterator<char>(baselineInput), istreambuf_iterator<char>());
+	}
+	else
+	{
+		inputs = generateInputs(context);
+	}
+
+	Evaluator evaluator(context);
+	Ciphertext product;
+	string withoutPool = evaluate(evaluator, inputs, MemoryPoolHandle::Global(), product);
+
+	evaluator.set_thread_pool(ThreadPoolHandle::New(threadCount));
+	Ciphertext pooledProduct;
+	string withPool = evaluate(evaluator, inputs, MemoryPoolHandle::Global(), pooledProduct);
+	string withUnsafeMemoryPool = evaluate(evaluator, inputs, MemoryPoolHandle::New(false), pooledProduct);
+
+	int failures = 0;
+	if(withPool != withoutPool)
+	{
+		cout << "FAIL N = " << polyModulusDegree << ": results with " << threadCount << " threads differ" << endl;
+		failures++;
+	}
+	if(withUnsafeMemoryPool != withoutPool)
+	{
+		cout << "FAIL N = " << polyModulusDegree << ": results with a thread-unsafe memory pool differ" << endl;
+		failures++;
+	}
+
+	Decryptor decryptor(context, inputs.secretKey);
+	Plaintext decrypted;
+	decryptor.decrypt(product, decrypted);
+	if(decrypted.to_string() != "23x^8 + Ex^5 + Fx^4 + 5x^3 + 6x^1 + 2")
+	{
+		cout << "FAIL N = " << polyModulusDegree << ": product decrypts to " << decrypted.to_string() << endl;
+		failures++;
+	}
+
+	if(baselineInput.is_open())
+	{
+		if(baseline != withoutPool)
+		{
+			cout << "FAIL N = " << polyModulusDegree << ": results differ from " << baselineFile << endl;
+			failures++;
+		}
+	}
+	else if(!baselineFile.empty())
+	{
+		ofstream baselineOutput(baselineFile.c_str(), ios::out | ios::binary);
+		inputs.save(baselineOutput);
+		baselineOutput << withoutPool;
+		cout << "baseline saved in " << baselineFile << endl;
+	}
+
+	return failures;
+}
+
+/**
+	usage : evaluatorThreadPool [baseline directory]
+	with a directory, the results are compared with the ones saved there by an earlier run, from another build for instance
+*/
+int main(int argc, char* argv[])
+{
+	string baselineDirectory = argc > 1 ? string(argv[1]) + "/" : "";
+
+	int failures = 0;
+	for(int polyModulusDegree = 4096; polyModulusDegree <= 16384; polyModulusDegree *= 2)
+	{
+		string baselineFile = argc > 1 ? baselineDirectory + "evaluator" + to_string(polyModulusDegree) + ".bin" : "";
+		int degreeFailures = check(polyModulusDegree, baselineFile);
+		cout << (degreeFailures ? "FAIL " : "OK   ") << "N = " << polyModulusDegree << endl;
+		failures += degreeFailures;
+	}
+
+	cout << (failures ? "FAILED" : "PASSED") << endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "seal/smallmodulus.h"
+#include "seal/util/globals.h"
+#include "seal/util/uintarithsmallmod.h"
+
+using namespace std;
+using namespace seal;
+using namespace seal::util;
+using namespace seal::util::global_variables;
+
+int failures = 0;
+
+void expect(bool condition, const char *what, uint64_t q, uint64_t operand, uint64_t multiplier, uint64_t addend = 0)
+{
+	if(!condition)
+	{
+		cout << "FAIL " << what << ": q = " << q << ", operand = " << operand << ", multiplier = " << multiplier
+			<< ", addend = " << addend << endl;
+		failures++;
+	}
+}
+
+/**
+	values of a 64-bit operand around 0, q, 2q, 4q, 2^63 and 2^64, and random ones
+*/
+vector<uint64_t> operands(uint64_t q, mt19937_64 &random)
+{
+	vector<uint64_t> values;
+	uint64_t anchors[] = { 0, q, 2 * q, 4 * q, uint64_t(1) << 63, 0 };
+	for(size_t i = 0; i < sizeof(anchors) / sizeof(anchors[0]); i++)
+	{
+		for(uint64_t offset = 0; offset < 3; offset++)
+		{
+			values.push_back(anchors[i] + offset);
+			values.push_back(anchors[i] - 1 - offset);
+		}
+	}
+	for(int i = 0; i < 64; i++)
+	{
+		values.push_back(random());
+		values.push_back(random() % q);
+	}
+	return values;
+}
+
+/**
+	multipliers below q: the smallest, the largest, around q / 2 and random ones
+*/
+vector<uint64_t> multipliers(uint64_t q, mt19937_64 &random)
+{
+	vector<uint64_t> values;
+	uint64_t candidates[] = { 0, 1, 2, q / 2 - 1, q / 2, q / 2 + 1, q - 2, q - 1 };
+	for(size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++)
+	{
+		if(candidates[i] < q)
+		{
+			values.push_back(candidates[i]);
+		}
+	}
+	for(int i = 0; i < 16; i++)
+	{
+		values.push_back(random() % q);
+	}
+	return values;
+}
+
+/**
+	checks the scalar and vector Shoup multiplications by every multiplier against multiply_uint_uint_mod
+	the lazy results must be congruent and in [0, 2q), the others equal to the reference
+*/
+void checkModulus(const SmallModulus &modulus, mt19937_64 &random)
+{
+	uint64_t q = modulus.value();
+	vector<uint64_t> operand = operands(q, random);
+	vector<uint64_t> multiplier = multipliers(q, random);
+
+	// Addends of the lazy multiply-add are in [0, 2q), the others in [0, q)
+	vector<uint64_t> addends;
+	uint64_t addendCandidates[] = { 0, 1, q - 1, q, q + 1, 2 * q - 2, 2 * q - 1 };
+	addends.assign(addendCandidates, addendCandidates + sizeof(addendCandidates) / sizeof(addendCandidates[0]));
+	addends.push_back(random() % (2 * q));
+
+	for(size_t m = 0; m < multiplier.size(); m++)
+	{
+		uint64_t w = multiplier[m];
+		uint64_t wShoup = shoup_precompute_uint_mod(w, modulus);
+
+		vector<uint64_t> expected(operand.size());
+		for(size_t i = 0; i < operand.size(); i++)
+		{
+			uint64_t x = operand[i];
+			expected[i] = multiply_uint_uint_mod(x % q, w, modulus);
+
+			uint64_t lazy = multiply_uint_uint_mod_lazy(x, w, wShoup, modulus);
+			expect(lazy < 2 * q && lazy % q == expected[i], "multiply_uint_uint_mod_lazy", q, x, w);
+			expect(multiply_uint_uint_mod(x, w, wShoup, modulus) == expected[i], "multiply_uint_uint_mod", q, x, w);
+
+			for(size_t a = 0; a < addends.size(); a++)
+			{
+				uint64_t addend = addends[a] % (2 * q);
+				uint64_t sum = (expected[i] + addend % q) % q;
+				uint64_t lazySum = multiply_add_uint_mod_lazy(x, w, wShoup, addend, modulus);
+				expect(lazySum < 2 * q && lazySum % q == sum, "multiply_add_uint_mod_lazy", q, x, w, addend);
+				if(addend < q)
+				{
+					expect(multiply_add_uint_mod(x, w, wShoup, addend, modulus) == sum, "multiply_add_uint_mod", q, x, w, addend);
+				}
+			}
+		}
+
+		int count = operand.size();
+		vector<uint64_t> result(count);
+		multiply_uint_scalar_mod_vector_lazy(operand.data(), count, w, wShoup, modulus, result.data());
+		for(int i = 0; i < count; i++)
+		{
+			expect(result[i] < 2 * q && result[i] % q == expected[i], "multiply_uint_scalar_mod_vector_lazy", q, operand[i], w);
+		}
+
+		multiply_uint_scalar_mod_vector(operand.data(), count, w, wShoup, modulus, result.data());
+		expect(result == expected, "multiply_uint_scalar_mod_vector", q, 0, w);
+
+		// In place, as the evaluator calls it
+		result = operand;
+		multiply_uint_scalar_mod_vector(result.data(), count, w, wShoup, modulus, result.data());
+		expect(result == expected, "multiply_uint_scalar_mod_vector in place", q, 0, w);
+
+		vector<uint64_t> accumulator(count);
+		vector<uint64_t> accumulated(count);
+		for(int i = 0; i < count; i++)
+		{
+			accumulator[i] = (i & 1) ? q - 1 - (i % q) : operand[i] % q;
+			accumulated[i] = (expected[i] + accumulator[i]) % q;
+		}
+		multiply_add_uint_scalar_mod_vector(operand.data(), count, w, wShoup, modulus, accumulator.data());
+		expect(accumulator == accumulated, "multiply_add_uint_scalar_mod_vector", q, 0, w);
+	}
+}
+
+int main()
+{
+	vector<SmallModulus> moduli;
+	moduli.push_back(SmallModulus(2));
+	moduli.push_back(SmallModulus(3));
+	moduli.push_back(SmallModulus(65537));
+	moduli.push_back(small_mods_30bit[0]);
+	moduli.push_back(small_mods_40bit[0]);
+	moduli.push_back(small_mods_50bit[0]);
+	moduli.push_back(small_mods_60bit[0]);
+	moduli.push_back(internal_mods::aux_small_mods[0]);
+	moduli.push_back(SmallModulus(0x3fffffffffe80001ULL));
+	moduli.push_back(SmallModulus(0x3fffffffffffffffULL));
+
+	mt19937_64 random(1);
+	for(size_t i = 0; i < moduli.size(); i++)
+	{
+		int previousFailures = failures;
+		checkModulus(moduli[i], random);
+		cout << (failures > previousFailures ? "FAIL " : "OK   ") << moduli[i].bit_count() << " bits, q = " << moduli[i].value() << endl;
+	}
+
+	cout << (failures ? "FAILED" : "PASSED") << endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "seal/memorypoolhandle.h"
+#include "seal/smallmodulus.h"
+#include "seal/util/globals.h"
+#include "seal/util/smallntt.h"
+
+using namespace std;
+using namespace seal;
+using namespace seal::util;
+using namespace seal::util::global_variables;
+
+// Largest 62-bit prime congruent to 1 mod 2^18, values up to 4q go past 2^63
+const uint64_t modulus_62bit = 0x3fffffffffe80001ULL;
+
+const char *kernelName(SmallNTTKernel kernel)
+{
+	switch(kernel)
+	{
+	case SmallNTTKernel::avx512:
+		return "avx512";
+
+	case SmallNTTKernel::avx2:
+		return "avx2";
+
+	default:
+		return "scalar";
+	}
+}
+
+/**
+	runs the lazy and reduced transforms of data with the current kernel, and the inverse of the reduced one
+	@return the lazy forward, reduced forward and inverse outputs, one after the other
+*/
+vector<uint64_t> transforms(const vector<uint64_t> &data, const SmallNTTTables &tables)
+{
+	size_t n = data.size();
+	vector<uint64_t> outputs(3 * n);
+
+	vector<uint64_t> values(data);
+	ntt_negacyclic_harvey_lazy(values.data(), tables);
+	copy(values.begin(), values.end(), outputs.begin());
+
+	values = data;
+	ntt_negacyclic_harvey(values.data(), tables);
+	copy(values.begin(), values.end(), outputs.begin() + n);
+
+	inverse_ntt_negacyclic_harvey(values.data(), tables);
+	copy(values.begin(), values.end(), outputs.begin() + 2 * n);
+
+	return outputs;
+}
+
+/**
+	compares every supported kernel with the scalar one on random data and on the values nearest to q
+	the scalar kernel must also give the data back after a round trip
+	@return the number of failed comparisons
+*/
+int checkModulus(const SmallModulus &modulus, int maxPower, mt19937_64 &random)
+{
+	uint64_t q = modulus.value();
+	int supported = static_cast<int>(get_supported_small_ntt_kernel());
+	int failures = 0;
+
+	for(int power = 1; power <= maxPower; power++)
+	{
+		if((q - 1) % (uint64_t(2) << power) != 0)
+		{
+			break;
+		}
+
+		SmallNTTTables tables(power, modulus, MemoryPoolHandle::Global());
+		if(!tables.is_generated())
+		{
+			cout << "FAIL q = 0x" << hex << q << dec << " n = " << (1 << power) << ": tables not generated" << endl;
+			failures++;
+			continue;
+		}
+
+		int n = 1 << power;
+		vector<vector<uint64_t> > inputs(3, vector<uint64_t>(n));
+		uniform_int_distribution<uint64_t> coefficient(0, q - 1);
+		for(int i = 0; i < n; i++)
+		{
+			inputs[0][i] = coefficient(random);
+			inputs[1][i] = q - 1;
+			inputs[2][i] = (i & 1) ? q - 1 - (i & 7) : (i & 7);
+		}
+
+		for(size_t k = 0; k < inputs.size(); k++)
+		{
+			set_small_ntt_kernel(SmallNTTKernel::scalar);
+			vector<uint64_t> expected = transforms(inputs[k], tables);
+			if(!equal(inputs[k].begin(), inputs[k].end(), expected.begin() + 2 * n))
+			{
+				cout << "FAIL q = 0x" << hex << q << dec << " n = " << n << " input " << k << ": scalar round trip" << endl;
+				failures++;
+			}
+
+			for(int kernel = 1; kernel <= supported; kernel++)
+			{
+				set_small_ntt_kernel(static_cast<SmallNTTKernel>(kernel));
+				if(transforms(inputs[k], tables) != expected)
+				{
+					cout << "FAIL q = 0x" << hex << q << dec << " n = " << n << " input " << k << ": "
+						<< kernelName(static_cast<SmallNTTKernel>(kernel)) << " differs from scalar" << endl;
+					failures++;
+				}
+			}
+		}
+	}
+
+	return failures;
+}
+
+int main()
+{
+	SmallNTTKernel supported = get_supported_small_ntt_kernel();
+	cout << "supported kernel: " << kernelName(supported) << endl;
+	if(supported == SmallNTTKernel::scalar)
+	{
+		cout << "no vector kernel to compare on this processor" << endl;
+	}
+
+	vector<SmallModulus> moduli;
+	moduli.push_back(small_mods_30bit[0]);
+	moduli.push_back(small_mods_40bit[0]);
+	moduli.push_back(small_mods_50bit[0]);
+	moduli.push_back(small_mods_60bit[0]);
+	moduli.push_back(small_mods_60bit[small_mods_60bit.size() - 1]);
+	moduli.push_back(internal_mods::m_sk);
+	moduli.push_back(internal_mods::aux_small_mods[0]);
+	moduli.push_back(SmallModulus(modulus_62bit));
+
+	mt19937_64 random(1);
+	int failures = 0;
+	for(size_t i = 0; i < moduli.size(); i++)
+	{
+		int modulusFailures = checkModulus(moduli[i], 15, random);
+		cout << (modulusFailures ? "FAIL " : "OK   ") << moduli[i].bit_count() << " bits, q = 0x" << hex << moduli[i].value() << dec << endl;
+		failures += modulusFailures;
+	}
+
+	set_small_ntt_kernel(supported);
+
+	cout << (failures ? "FAILED" : "PASSED") << endl;
+	return failures ? 1 : 0;
+}
@@ -4,77 +4,80 @@
 ImageCiphertext::ImageCiphertext(ImageCiphertext& autre)
 {
 	this->imageParameters = autre.imageParameters;
+	this->session = autre.session;
 	this->pKey = autre.pKey;
+	this->keys = autre.keys;
 	this->gKey = autre.gKey;
 	this->imageWidth = autre.imageWidth;
 	this->imageHeight = autre.imageHeight;
 	this->normalisation = autre.normalisation;
+	this->layout = autre.layout;
 	this->encryptedImageData = autre.encryptedImageData;
 	this->wrongSKey = autre.wrongSKey;
-	this->row_pointers = autre.row_pointers;
+	this->previewOperations = autre.previewOperations;
+	this->previewRowStep = autre.previewRowStep;
 }
 
 ImageCiphertext& ImageCiphertext::operator=(const ImageCiphertext& assign)
 {
 	this->imageParameters = assign.imageParameters;
+	this->session = assign.session;
 	this->imageHeight = assign.imageHeight;
 	this->imageWidth = assign.imageWidth;
 	this->normalisation = assign.normalisation;
+	this->layout = assign.layout;
 	this->pKey = assign.pKey;
+	this->keys = assign.keys;
 	this->gKey = assign.gKey;
 	this->encryptedImageData = assign.encryptedImageData;
 	this->wrongSKey = assign.wrongSKey;
-	this->row_pointers = assign.row_pointers;
+	this->previewOperations = assign.previewOperations;
+	this->previewRowStep = assign.previewRowStep;
+
+	return *this;
 }
 
 
-ImageCiphertext::ImageCiphertext(EncryptionParameters parameters, int height, int width, PublicKey pKey, GaloisKeys gKey, vector<Ciphertext> encryptedData)
+ImageCiphertext::ImageCiphertext(EncryptionParameters parameters, ImageLayout layout, shared_ptr<KeyStore> keys, vector<Ciphertext> encryptedData)
 {
 	this->imageParameters = parameters;
-	this->imageHeight = height;
-	this->imageWidth = width;
-	this->pKey = pKey;
-	this->gKey = gKey;
-	this->encryptedImageData = encryptedData;
-
-	initNorm();
+	this->session = ImageSession::get(parameters);
+	this->layout = layout;
+	this->imageHeight = layout.getHeight();
+	this->imageWidth = layout.getWidth();
+	this->pKey = keys->getPublicKey();
+	this->keys = keys;
+	this->encryptedImageData = move(encryptedData);
 
-	row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * imageHeight);
-	for(int y = 0; y < imageHeight; y++) 
-	{
-		row_pointers[y] = (png_byte*)malloc(sizeof(png_bytep) * imageWidth);
-	}
+	normalisation = Normalisation(imageHeight, imageWidth);
 
-	SEALContext context(imageParameters);
-	KeyGenerator keygen(context);
+	KeyGenerator keygen(session->getContext());
 	this->wrongSKey = keygen.secret_key();
 }
 
 void ImageCiphertext::negate()
 {
-	if(verifyNormOver(1.0))
+	if(normalisation.isOver(1.0))
 	{
-		wrongDecryption("../images/beforeNegationEncrypted.png");
+		preview(PREVIEW_NEGATE, "../images/beforeNegationEncrypted.png");
 
-		SEALContext imageContext(imageParameters);
-
-		Evaluator evaluator(imageContext);
+		Evaluator &evaluator = session->getEvaluator();
 
 		cout << "beggining negate" << endl;
 
 		auto timeStart = chrono::high_resolution_clock::now();
 
-		for(uint64_t i = 0; i < encryptedImageData.size(); i++)
+		ThreadPool::get().run(encryptedImageData.size(), [&](int i, int)
 		{
 			//works as it is because values of pixels are centered inside plain modulus, so zero will end up to be 255 (after offset is removed), and vice-versa
 			evaluator.negate(encryptedImageData.at(i));
-		}
+		});
 
 		auto timeStop = chrono::high_resolution_clock::now();
 
 		cout << "--> end of negate: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
 
-		wrongDecryption("../images/afterNegationEncrypted.png");
+		preview(PREVIEW_NEGATE, "../images/afterNegationEncrypted.png");
 	}
 	else
 	{
@@ -85,13 +88,11 @@ void ImageCiphertext::negate()
 
 void ImageCiphertext::grey()
 {
-	SEALContext imageContext(imageParameters);
-	Evaluator evaluator(imageContext);
-	PolyCRTBuilder crtbuilder(imageContext);
+	Evaluator &evaluator = session->getEvaluator();
+	PolyCRTBuilder &crtbuilder = session->getCRTBuilder();
 
-	//calculating offset value
-	uint64_t plainModulus = *imageContext.plain_modulus().pointer();
-	int offset = (int)(plainModulus - 255) / 2;
+	int offset = session->getOffset();
+	uint64_t plainModulus = session->getPlainModulus();
 
 	if(offset < 25500)
 	{
@@ -99,186 +100,307 @@ void ImageCiphertext::grey()
 		return;
 	}
 
-	wrongDecryption("../images/beforeGreyingEncrypted.png");
+	if(layout.getChannels() == 1)
+	{
+		cout << "image already grey" << endl;
+		return;
+	}
+
+	preview(PREVIEW_GREY, "../images/beforeGreyingEncrypted.png");
 
 	//the values contained here are the percentage values of each color to be taken to make the grey
 	//those are multiplied by 100 to be integers, and have to be normalised afterward
 	//this is done automaticaly with the help of the normalisation matrix
-	vector<uint64_t> redCoeff(crtbuilder.slot_count(), 21);
-	vector<uint64_t> greenCoeff(crtbuilder.slot_count(), 72);
-	vector<uint64_t> blueCoeff(crtbuilder.slot_count(), 7);
-	vector<uint64_t> offsetVec(crtbuilder.slot_count(), offset);
+	uint64_t percentages[3] = {21, 72, 7};
 
-	Plaintext redCoeffCRT, greenCoeffCRT, blueCoeffCRT, offsetPlain;
-	Ciphertext weightedRed, weightedGreen, weightedBlue, tampon;
+	//every pixel value holds an offset, multiplied with the pixel by its percentage, so the sum holds 100*offset instead of offset
+	//the difference is added once to the grey value, instead of removing the offset of each color before multiplying it
+	int64_t correctionValue = ((int64_t)offset * (1 - 100)) % (int64_t)plainModulus;
+	if(correctionValue < 0) correctionValue += plainModulus;
 
-	crtbuilder.compose(redCoeff, redCoeffCRT);
-	crtbuilder.compose(greenCoeff, greenCoeffCRT);
-	crtbuilder.compose(blueCoeff, blueCoeffCRT);
-	crtbuilder.compose(offsetVec, offsetPlain);
+	Plaintext correction;
+	session->composeConstant(correctionValue, correction);
+
+	//the grey image only keeps one color layer, read for the three colors when decoding
+	ImageLayout greyLayout = layout.getGreyLayout();
+	vector<Ciphertext> greyData(greyLayout.getCipherCount(), Ciphertext());
 
 	cout << "beggining greying" << endl;
 
 	auto timeStart = chrono::high_resolution_clock::now();
 
-	for(uint64_t i = 0; i < encryptedImageData.size(); i += 3)
+	ThreadPool &threadPool = ThreadPool::get();
+
+	if(layout.getChannelsPerCipher() == 1)
 	{
-		//removing offset to multiply only pixel value
-		evaluator.sub_plain(encryptedImageData.at(i), offsetPlain, tampon);
-		evaluator.multiply_plain(tampon, redCoeffCRT, weightedRed);
+		//the red, green and blue ciphertexts of a row hold the same lines in the same slots, so each color is multiplied with a constant
+		Plaintext weights[3];
+		for(int k = 0; k < 3; k++)
+		{
+			session->composeConstant(percentages[k], weights[k]);
+		}
+
+		//each task calculates the grey value of a row of ciphertexts
+		threadPool.run(layout.getRowCount(), [&](int row, int worker)
+		{
+			const MemoryPoolHandle &pool = threadPool.getMemoryPool(worker);
+			Ciphertext weighted(pool);
+			Ciphertext &result = greyData[row];
 
-		evaluator.sub_plain(encryptedImageData.at(i+1), offsetPlain, tampon);
-		evaluator.multiply_plain(tampon, greenCoeffCRT, weightedGreen);
+			evaluator.multiply_plain(encryptedImageData[row*3], weights[0], result, pool);
+			for(int k = 1; k < 3; k++)
+			{
+				evaluator.multiply_plain(encryptedImageData[row*3 + k], weights[k], weighted, pool);
+				evaluator.add(result, weighted);
+			}
+			evaluator.add_plain(result, correction);
+		});
+	}
+	else
+	{
+		//the color layers of a line are in the same ciphertext, each color being weighted in its own segments
+		vector<uint64_t> coeff(crtbuilder.slot_count(), 0);
+		for(int segment = 0; segment < layout.getSegmentCount(); segment++)
+		{
+			int slot = layout.getSegmentSlot(segment);
+			fill(coeff.begin() + slot, coeff.begin() + slot + imageWidth, percentages[layout.getChannel(0, segment)]);
+		}
+
+		Plaintext weightsNTT;
+		crtbuilder.compose(coeff, weightsNTT);
+		evaluator.transform_to_ntt(weightsNTT);
+
+		//the weighted colors of three rows are then brought to the three sub-bands of a grey row
+		vector<SegmentMove> greyMoves[3];
+		set<int> steps;
+		bool columnRotation = false;
+		for(int k = 0; k < 3; k++)
+		{
+			layout.planGrey(k, greyMoves[k]);
+			for(auto &move : greyMoves[k])
+			{
+				if(move.steps != 0) steps.insert(move.steps);
+				columnRotation |= move.swap;
+			}
+		}
+		loadGaloisKeys(steps, columnRotation);
+
+		//the ciphertexts are weighted in place, as they are replaced by the grey ones
+		threadPool.run(layout.getCipherCount(), [&](int i, int)
+		{
+			evaluator.transform_to_ntt(encryptedImageData[i]);
+			evaluator.multiply_plain_ntt(encryptedImageData[i], weightsNTT);
+			evaluator.transform_from_ntt(encryptedImageData[i]);
+		});
 
-		evaluator.sub_plain(encryptedImageData.at(i+2), offsetPlain, tampon);
-		evaluator.multiply_plain(tampon, blueCoeffCRT, weightedBlue);
+		int rowCount = layout.getRowCount();
+		int greyRowCount = greyLayout.getRowCount();
 
+		threadPool.run(greyLayout.getCipherCount(), [&](int row, int worker)
+		{
+			const MemoryPoolHandle &pool = threadPool.getMemoryPool(worker);
+			Ciphertext moved(pool);
+			Ciphertext &result = greyData[row];
 
-		//adding every value to one ciphertext, then putting back offset
-		evaluator.add(weightedRed, weightedGreen);
-		evaluator.add(weightedRed, weightedBlue);
-		evaluator.add_plain(weightedRed, offsetPlain);
+			//sub-bands under the last line of the bands are left with meaningless values
+			auto source = [&](int subBand) -> const Ciphertext&
+			{
+				int sourceRow = subBand*greyRowCount + row;
+				return encryptedImageData[(sourceRow < rowCount) ? sourceRow : row];
+			};
 
-		//replacing old values to new ones
-		encryptedImageData.at(i) = weightedRed;
-		encryptedImageData.at(i+1) = weightedRed;
-		encryptedImageData.at(i+2) = weightedRed;
+			moveSegments(greyMoves[0], source, result, pool);
+			for(int k = 1; k < 3; k++)
+			{
+				moveSegments(greyMoves[k], source, moved, pool);
+				evaluator.add(result, moved);
+			}
+			evaluator.add_plain(result, correction);
+		});
 	}
 
+	//replacing old values to new ones
+	encryptedImageData = move(greyData);
+	layout = greyLayout;
+
 	//every value was multiplied by 100, so multiplying values by 0.01 at decoding is necessary
-	updateNorm(0.01);
+	normalisation.scale(0.01);
 
 	auto timeStop = chrono::high_resolution_clock::now();
 
 	cout << "--> end of greying: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
 
-	wrongDecryption("../images/afterGreyingEncrypted.png");
+	preview(PREVIEW_GREY, "../images/afterGreyingEncrypted.png");
 }
 
 
-void ImageCiphertext::applyFilter(Filter filter, int numThreads)
+void ImageCiphertext::applyFilter(Filter filter, int numThreads, ConvolutionMode mode)
 {
 	if(filter.validate())
 	{
-		SEALContext imageContext(imageParameters);
-		PolyCRTBuilder crtbuilder(imageContext);
-		Evaluator evaluator(imageContext);
-		vector<Ciphertext> newEncryptedData(imageHeight*3, Ciphertext());
-		string progressBar = string(9*numThreads, ' ');
-
-		//internal function to call for each thread
-		auto calculatePart = [&crtbuilder, &evaluator, &newEncryptedData, &progressBar, this](int threadIndex, Filter filter, mutex &rmtx, mutex &wmtx, int xBegin, int xEnd, const MemoryPoolHandle &pool)
+		if(mode == PACKED && filter.getWidth()/2 > layout.getGuard())
 		{
-			SEALContext imageContext(imageParameters);
-			vector<Ciphertext> pixelResults;
-			Ciphertext tampon(pool);
+			//shifted lines must not take values from the next segment or from the other end of the row, as rotations are cyclic in a row of the batching matrix
+			cout << "guards of the image too narrow to shift its lines, using hoisted convolution" << endl;
+			mode = HOISTED;
+		}
 
-			int instantProgress = 0;
-			int progressPercentage = -1;
+		//every plaintext used by the convolution is built once for the whole image (and kept for the next images of the same layout)
+		shared_ptr<CompiledFilter> compiled = CompiledFilter::get(filter, session, layout, mode);
 
-			while(!wmtx.try_lock());
-			// cout << "thread n°" << threadIndex << " beginning calculations from line " << xBegin << " to line " << xEnd << endl;
-			wmtx.unlock();
+		//only the keys of the rotations made by the filter are needed, each rotation taking a single key switch
+		loadGaloisKeys(compiled->getRotationSteps(), compiled->hasColumnRotation());
 
-			for(int x = xBegin; x <= xEnd; x++)	//works on each assigned line of the picture
-			{
-				for(int colorLayer = 0; colorLayer < 3; colorLayer++) //works on each color layer
-				{
-					pixelResults.clear();
+		Evaluator &evaluator = session->getEvaluator();
+		ThreadPool &threadPool = ThreadPool::get();
+		int channelGroups = layout.getChannelGroups();
+		vector<Ciphertext> newEncryptedData(layout.getCipherCount(), Ciphertext());
 
-					for(int y = 0; y < imageWidth; y++)	//works on each pixel of the current line
-					{
-						//calculation of the new value of the pixel at (x,y) on layer colorLayer
-						pixelResults.push_back(convolute(imageContext, x, y, colorLayer, filter, ref(rmtx), pool));
-
-						//progress bar printing part
-						instantProgress++;
-						int currentProgressPercentage = (int)(((float)instantProgress/(imageWidth*(xEnd-xBegin+1)*3))*100);
-						if(currentProgressPercentage != progressPercentage)
-						{
-							progressPercentage = currentProgressPercentage;
-
-							string insert;
-							insert.append(" [ ");
-							insert.append(to_string(progressPercentage));
-							insert.append("% ] ");
-
-							while(!wmtx.try_lock());
-							progressBar.replace((threadIndex-1)*9, insert.length(), insert);
-							cout << "\r" << progressBar;
-							cout.flush();
-							wmtx.unlock();
-						}
-					}
-					evaluator.add_many(pixelResults, tampon);
+		//data kept by each worker between its tasks
+		struct WorkerData
+		{
+			vector<Ciphertext> surroundingLines;
+			vector<Ciphertext> pixelResults;
 
-					if(filter.getNorm() == 0)	//additionnal pixel normalisation if sum of factors in filter is zero (plain pixels normalisation process)
-					{
-						vector<uint64_t> additionnalOffset(crtbuilder.slot_count(), 128);
-						Plaintext addOffsetPlain;
-						crtbuilder.compose(additionnalOffset, addOffsetPlain);
-						evaluator.add_plain(tampon, addOffsetPlain);
-					}
-					else if(filter.getNorm() < 0)	//additionnal pixel normalisation if sum of factors in filters is less than zero (plain pixels normalisation process)
-					{
-						vector<uint64_t> additionnalOffset(crtbuilder.slot_count(), 255);
-						Plaintext addOffsetPlain;
-						crtbuilder.compose(additionnalOffset, addOffsetPlain);
-						evaluator.add_plain(tampon, addOffsetPlain);
-					}
+			//shifted copies of the lines surrounding the current ones, for each ciphertext of a row (only used by PACKED)
+			map<int, vector<Ciphertext> > shiftedLines[3];
 
-					while(!wmtx.try_lock());	
-					newEncryptedData[x*3+colorLayer] = tampon;	//writing new encrypted line to global array of data
-					wmtx.unlock();
-				}
-			}
+			//horizontal passes of the lines surrounding the current ones, for each ciphertext of a row (only used by separable filters)
+			map<int, Ciphertext> filteredRows[3];
 		};
-		
-		mutex readMutex, writeMutex;	//mutex to synchronize prints to stdout between threads, and reads from data 
-		vector<thread> threads;
 
-		wrongDecryption("../images/beforeFilteringEncrypted.png");
+		//the input data is only read by the tasks, each task writing its ciphertext and the normalisation factors of its lines in their own slots
+		vector<float> lineNorms(imageHeight*3, 1.0);
+
+		preview(PREVIEW_FILTER, "../images/beforeFilteringEncrypted.png");
 
 		cout << "applying filter :" << endl;
 		filter.print();
-
-		unsigned int numThreadsAdvised = thread::hardware_concurrency();	//checking number of available threads
-		cout << "possible number of threads : " << numThreadsAdvised << endl;
-		if(numThreads > numThreadsAdvised && numThreadsAdvised != 0)
+		if(compiled->isSeparable())
 		{
-			cout << "number of threads asked for is too high, getting down to " << numThreadsAdvised << " threads" << endl;
-			numThreads = numThreadsAdvised;
+			cout << "separable filter, applying its rows then its columns" << endl;
 		}
 
-		if(numThreads > imageHeight)
+		cout << "possible number of threads : " << threadPool.getWorkerCount() << endl;
+		if(numThreads > threadPool.getWorkerCount())
 		{
-			cout << "too much threads for the height of the image, getting down to " << imageHeight << " threads" << endl;
-			numThreads = imageHeight;
+			cout << "number of threads asked for is too high, getting down to " << threadPool.getWorkerCount() << " threads" << endl;
 		}
+		numThreads = threadPool.getWorkerCount(numThreads);
 
 		cout << "begginning calculations on " << numThreads << " threads" << endl;
 
-		vector<int> linesPerThread(numThreads, 0);
+		//a filter applied from a task of the thread pool (see ThreadPool::run) is executed by the worker of the task
+		vector<WorkerData> workerData(threadPool.getWorkerCount());
+		ProgressReporter progress(imageWidth*imageHeight*3);
 
-		for(int i = 0; i < imageHeight; i++)	//assigning a number of lines to process for each thread (quite simple method)
+		//each task calculates a ciphertext, tasks being given by row so that a worker shares the surrounding lines between its tasks
+		auto calculateLine = [&](int task, int worker)
 		{
-			linesPerThread[i%numThreads]++;
-		}
+			int row = task / channelGroups;
+			int group = task % channelGroups;
+
+			const MemoryPoolHandle &pool = threadPool.getMemoryPool(worker);
+			WorkerData &data = workerData[worker];
+			Ciphertext tampon(pool);
+
+			//color lines of the image held by the ciphertext (the last band may leave segments empty)
+			int lineCount = 0;
+			for(int segment = 0; segment < layout.getSegmentCount(); segment++)
+			{
+				lineCount += (layout.getLine(row, segment) < (int) imageHeight);
+			}
+
+			if(compiled->isSeparable())
+			{
+				//every pixel of the ciphertext is calculated at once, from horizontal passes shared with the next rows of the worker
+				tampon = convoluteSeparable(row, group, *compiled, data.filteredRows[group], pool);
+				progress.add(imageWidth*lineCount);
+			}
+			else if(mode == PACKED)
+			{
+				//every pixel of the ciphertext is calculated at once, from shifted lines shared with the next rows of the worker
+				tampon = convolutePacked(row, group, *compiled, data.shiftedLines[group], pool);
+				progress.add(imageWidth*lineCount);
+			}
+			else if(mode == HOISTED)
+			{
+				//every pixel of the ciphertext is calculated at once, sharing the rotations of the surrounding lines
+				tampon = convoluteLine(row, group, *compiled, pool);
+				progress.add(imageWidth*lineCount);
+			}
+			else
+			{
+				//the surrounding lines are gathered once for every pixel, without their offset and in NTT form
+				int verticalOffset = filter.getHeight()/2;
+				data.surroundingLines.resize(filter.getHeight());
+				for(int xOffset = -verticalOffset; xOffset <= verticalOffset; xOffset++)
+				{
+					Ciphertext &line = data.surroundingLines[verticalOffset + xOffset];
+					gatherLine(row + xOffset, group, *compiled, line, pool);
+					evaluator.sub_plain(line, session->getOffsetPlain());
+					evaluator.transform_to_ntt(line);
+				}
+
+				data.pixelResults.clear();
+
+				for(uint32_t y = 0; y < imageWidth; y++)	//works on each pixel of the current lines
+				{
+					//calculation of the new value of the pixels at position y of every segment
+					data.pixelResults.push_back(convolute(data.surroundingLines, y, *compiled, pool));
+					progress.add(lineCount);
+				}
+				evaluator.add_many(data.pixelResults, tampon);
+			}
+
+			if(compiled->hasNormOffset())	//additionnal pixel normalisation if sum of factors in filter is zero or less (plain pixels normalisation process)
+			{
+				evaluator.add_plain(tampon, compiled->getNormOffset());
+			}
+
+			newEncryptedData[task] = tampon;	//writing new encrypted lines to global array of data
+			if(filter.getNorm() != 0)
+			{
+				for(int segment = 0; segment < layout.getSegmentCount(); segment++)
+				{
+					int x = layout.getLine(row, segment);
+					if(x >= (int) imageHeight) continue;
+
+					//the single color layer of a grey image is read for the three colors
+					int colorLayer = layout.getChannel(group, segment);
+					int lastLayer = (layout.getChannels() == 1) ? 2 : colorLayer;
+					for(int k = colorLayer; k <= lastLayer; k++)
+					{
+						lineNorms[x*3 + k] = compiled->getNormFactor();
+					}
+				}
+			}
+		};
 
 		auto timeStart = chrono::high_resolution_clock::now();
 
-		int sum = 0;
-		for(int i = 0; i < numThreads; i++)
-		{
-			//launching each thread 
-			threads.emplace_back(calculatePart, i+1, filter, ref(readMutex), ref(writeMutex), sum, (sum)+linesPerThread[i]-1, MemoryPoolHandle::New(false));
-			sum += linesPerThread[i];
-		}
-		
-		for(int j = 0; j < threads.size(); j++)
+		threadPool.run(layout.getCipherCount(), calculateLine, numThreads);
+		progress.finish();
+
+		//merging the normalisation factors of every line, factors being kept uniform if every line of a color layer has the same
+		for(int colorLayer = 0; colorLayer < 3; colorLayer++)
 		{
-			//waiting for each thread to finish 
-			threads[j].join();
+			bool uniform = true;
+			for(uint32_t x = 1; x < imageHeight; x++)
+			{
+				uniform &= (lineNorms[x*3+colorLayer] == lineNorms[colorLayer]);
+			}
+
+			if(uniform)
+			{
+				normalisation.scale(lineNorms[colorLayer], colorLayer);
+				continue;
+			}
+
+			for(uint32_t x = 0; x < imageHeight; x++)
+			{
+				normalisation.scaleLine(lineNorms[x*3+colorLayer], x, colorLayer);
+			}
 		}
 
 		//replacing old array of data to new one
@@ -289,49 +411,360 @@ void ImageCiphertext::applyFilter(Filter filter, int numThreads)
 
 		cout << "\nfiltering finished: " << chrono::duration_cast<chrono::seconds>(timeStop - timeStart).count() << " seconds" << endl << endl;
 
-		wrongDecryption("../images/afterFilteringEncrypted.png");
+		preview(PREVIEW_FILTER, "../images/afterFilteringEncrypted.png");
 	}
 }
 
-void ImageCiphertext::save(string fileName)
+void ImageCiphertext::applyPixelOperation(const PixelOperation &operation)
 {
+	if(operation.isEmpty()) return;
 
-	cout << "saving crypted file '" << fileName << "'" << endl << endl;
+	CompiledPixelOperation compiled(operation, session, layout, normalisation);
+
+	preview(PREVIEW_PIXELS, "../images/beforePixelOperationEncrypted.png");
+
+	//the keys are taken before the tasks, as every task uses them
+	if(!compiled.getRotationSteps().empty() || compiled.hasColumnRotation())
+	{
+		loadGaloisKeys(compiled.getRotationSteps(), compiled.hasColumnRotation());
+	}
+	shared_ptr<const EvaluationKeys> eKey;
+	if(compiled.needsRelinearization())
+	{
+		if(!keys)
+			throw logic_error("image has no keys to relinearize its ciphertexts, see setKeys");
+		eKey = keys->getEvaluationKeys();
+	}
+
+	cout << "beggining pixel operation: " << compiled.getSteps().size() << " steps, taking about " << compiled.getNoiseCost() << " bits of noise budget";
+	if(compiled.getPrecision() > 0)
+	{
+		cout << ", pixels off by up to " << compiled.getPrecision() << " levels";
+	}
+	cout << endl;
+
+	auto timeStart = chrono::high_resolution_clock::now();
+
+	ThreadPool &threadPool = ThreadPool::get();
+	int channelGroups = layout.getChannelGroups();
+
+	//each task takes a row of ciphertexts through every step, the color layers of a pixel being all in the row
+	threadPool.run(layout.getRowCount(), [&](int row, int worker)
+	{
+		const MemoryPoolHandle &pool = threadPool.getMemoryPool(worker);
+		Ciphertext *ciphers = &encryptedImageData[row*channelGroups];
+
+		for(const PixelStep &step : compiled.getSteps())
+		{
+			if(step.type != POLYNOMIAL_STAGE)
+			{
+				applyLinearStep(ciphers, step, pool);
+				continue;
+			}
+
+			for(int group = 0; group < channelGroups; group++)
+			{
+				applyPolynomialStep(ciphers[group], group, step, *eKey, pool);
+			}
+		}
+	});
+
+	for(int colorLayer = 0; colorLayer < 3; colorLayer++)
+	{
+		normalisation.scale(compiled.getFactorScale(colorLayer), colorLayer);
+	}
+
+	auto timeStop = chrono::high_resolution_clock::now();
 
-	ofstream fileBin;
-	fileBin.open(fileName, ios::out | ios::binary);
+	cout << "--> end of pixel operation: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
 
-	imageParameters.save(fileBin);
-	pKey.save(fileBin);
+	preview(PREVIEW_PIXELS, "../images/afterPixelOperationEncrypted.png");
+}
+
+void ImageCiphertext::blend(const ImageCiphertext &other, float alpha)
+{
+	if(!(imageParameters.hash_block() == other.imageParameters.hash_block()) || layout.getKey() != other.layout.getKey())
+		throw invalid_argument("blended images must have the same encryption parameters and layout");
+	if(!normalisation.isUniform() || !other.normalisation.isUniform())
+		throw invalid_argument("blended images need the same normalisation factor for every pixel of a color layer");
+
+	preview(PREVIEW_BLEND, "../images/beforeBlendingEncrypted.png");
+
+	Evaluator &evaluator = session->getEvaluator();
+	uint64_t plainModulus = session->getPlainModulus();
+	int64_t offset = session->getOffset();
+	int channels = layout.getChannels();
+
+	//the weights are about as fine as half of the range of the plain modulus allows, the other half being left to the next operations
+	array<float, 3> factors;
+	array<uint64_t, 3> weights, otherWeights, constants;
+	for(int c = 0; c < 3; c++)
+	{
+		int layer = min(c, channels - 1);
+		vector<double> pixelWeights = {alpha * normalisation.get(0, 0, layer), (1 - alpha) * other.normalisation.get(0, 0, layer)};
+		vector<double> magnitudes = {255 / normalisation.get(0, 0, layer), 255 / other.normalisation.get(0, 0, layer)};
+		float factor = factors[c] = 1 / CompiledPixelOperation::chooseScale(pixelWeights, magnitudes, (offset / 2.0) / (255*(fabs(alpha) + fabs(1 - alpha)) + 1));
+
+		int64_t weight = llround(pixelWeights[0] / factor);
+		int64_t otherWeight = llround(pixelWeights[1] / factor);
+
+		//half a pixel level is added for the truncation of decoding, and the offset is put back once after the sum
+		int64_t constant = ((int64_t)floor(0.5 / factor) + offset*(1 - weight - otherWeight)) % (int64_t)plainModulus;
+		weights[c] = (weight < 0) ? weight + plainModulus : weight;
+		otherWeights[c] = (otherWeight < 0) ? otherWeight + plainModulus : otherWeight;
+		constants[c] = (constant < 0) ? constant + plainModulus : constant;
+	}
 
-	for(uint64_t i=0; i<encryptedImageData.size(); i++)
+	int channelGroups = layout.getChannelGroups();
+	vector<ChannelPlain> weightPlains(channelGroups), otherWeightPlains(channelGroups), constantPlains(channelGroups);
+	for(int group = 0; group < channelGroups; group++)
 	{
-		encryptedImageData.at(i).save(fileBin);
+		CompiledPixelOperation::composeChannels(session, layout, group, weights, true, weightPlains[group]);
+		CompiledPixelOperation::composeChannels(session, layout, group, otherWeights, true, otherWeightPlains[group]);
+		CompiledPixelOperation::composeChannels(session, layout, group, constants, false, constantPlains[group]);
 	}
-	fileBin.close();
+
+	//noise taken from fresh ciphertexts, the weights of concatenated color layers being batched plaintexts
+	SimulationEvaluator simulator;
+	uint64_t largestValue = (plainModulus - 1) / 2;
+	int weightCount = weightPlains[0].ntt ? session->getSlotCount() : 1;
+	Simulation fresh = simulator.get_fresh(imageParameters, session->getSlotCount(), largestValue);
+	auto largestWeight = [&](const array<uint64_t, 3> &values)
+	{
+		uint64_t largest = 1;
+		for(uint64_t value : values)
+		{
+			largest = max(largest, min(value, plainModulus - value));
+		}
+		return weightPlains[0].ntt ? largestValue : largest;
+	};
+	Simulation weighted = simulator.add(simulator.multiply_plain(fresh, weightCount, largestWeight(weights)), simulator.multiply_plain(fresh, weightCount, largestWeight(otherWeights)));
+	Simulation blended = simulator.add_plain(weighted, constantPlains[0].ntt ? session->getSlotCount() : 1, largestValue);
+
+	cout << "beggining blending, taking about " << fresh.invariant_noise_budget() - blended.invariant_noise_budget() << " bits of noise budget" << endl;
+
+	auto timeStart = chrono::high_resolution_clock::now();
+
+	ThreadPool &threadPool = ThreadPool::get();
+	threadPool.run(encryptedImageData.size(), [&](int i, int worker)
+	{
+		const MemoryPoolHandle &pool = threadPool.getMemoryPool(worker);
+		int group = i % channelGroups;
+		Ciphertext weighted = other.encryptedImageData[i];
+
+		multiplyChannels(encryptedImageData[i], weightPlains[group], pool);
+		multiplyChannels(weighted, otherWeightPlains[group], pool);
+		evaluator.add(encryptedImageData[i], weighted);
+		evaluator.add_plain(encryptedImageData[i], constantPlains[group].plain);
+	});
+
+	for(int c = 0; c < 3; c++)
+	{
+		normalisation.scale(factors[c] / normalisation.get(0, 0, c), c);
+	}
+
+	auto timeStop = chrono::high_resolution_clock::now();
+
+	cout << "--> end of blending: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
+
+	preview(PREVIEW_BLEND, "../images/afterBlendingEncrypted.png");
 }
 
-void ImageCiphertext::load(string fileName)
+void ImageCiphertext::downscale(int guard)
 {
-	cout << "loading crypted file '" << fileName << "'" << endl << endl;
+	ImageLayout downscaledLayout = layout.getDownscaledLayout(guard);
+
+	vector<int> sourceLines(downscaledLayout.getHeight());
+	for(int x = 0; x < downscaledLayout.getHeight(); x++)
+	{
+		sourceLines[x] = layout.getDownscaledLine(x);
+	}
+	Normalisation downscaledNorm = normalisation.getDownscaled(sourceLines);
+
+	Evaluator &evaluator = session->getEvaluator();
+	uint64_t plainModulus = session->getPlainModulus();
+	int64_t offset = session->getOffset();
 
-	ifstream fileBin;
-	fileBin.open(fileName, ios::in | ios::binary);
+	//the sum of four pixels must stay in the range of the plain modulus
+	if(!downscaledNorm.isOver(255.0 / offset))
+		throw invalid_argument("plain modulus too small to add the pixels of the image together");
 
-	imageParameters.load(fileBin);
-	pKey.load(fileBin);
+	//the sums hold four offsets instead of one, the pixels being kept as exact sums so that successive downscalings add the same pixels as a single one
+	int64_t correctionValue = (-3*offset) % (int64_t)plainModulus;
+	if(correctionValue < 0) correctionValue += plainModulus;
 
-	for(uint64_t i=0; i<encryptedImageData.size(); i++)
+	Plaintext correction;
+	session->composeConstant(correctionValue, correction);
+
+	int channelGroups = downscaledLayout.getChannelGroups();
+
+	//the rotations of both passes are planned before the tasks, as every task uses the keys
+	ColumnPairPlan pairPlan;
+	layout.planColumnPairs(pairPlan);
+
+	set<int> steps;
+	bool columnRotation = false;
+	for(int baby = 1; baby < pairPlan.babySteps; baby++)
+	{
+		steps.insert(baby);
+	}
+	for(int giantSteps : pairPlan.giantSteps)
+	{
+		if(giantSteps != 0) steps.insert(giantSteps);
+	}
+
+	int cipherCount = downscaledLayout.getCipherCount();
+	vector<vector<SegmentMove> > upperMoves(cipherCount), lowerMoves(cipherCount);
+	for(int i = 0; i < cipherCount; i++)
 	{
-		encryptedImageData.at(i).load(fileBin);
+		downscaledLayout.planDownscale(layout, i / channelGroups, i % channelGroups, false, upperMoves[i]);
+		downscaledLayout.planDownscale(layout, i / channelGroups, i % channelGroups, true, lowerMoves[i]);
+		for(auto moves : {&upperMoves[i], &lowerMoves[i]})
+		{
+			for(auto &move : *moves)
+			{
+				if(move.steps != 0) steps.insert(move.steps);
+				columnRotation |= move.swap;
+			}
+		}
 	}
-	fileBin.close();
+	loadGaloisKeys(steps, columnRotation);
+
+	preview(PREVIEW_DOWNSCALE, "../images/beforeDownscalingEncrypted.png");
+
+	cout << "beggining downscaling" << endl;
+
+	auto timeStart = chrono::high_resolution_clock::now();
+
+	//when the two lines of the pairs are moved the same way from their rows for every downscaled ciphertext,
+	//the rows are added before their column pairs, which halves the ciphertexts to pack and to move
+	map<int, int> rowPairs;
+	bool paired = true;
+	for(int i = 0; paired && i < cipherCount; i++)
+	{
+		const vector<SegmentMove> &upper = upperMoves[i];
+		const vector<SegmentMove> &lower = lowerMoves[i];
+
+		paired = (upper.size() == lower.size());
+		for(uint64_t m = 0; paired && m < upper.size(); m++)
+		{
+			paired = upper[m].steps == lower[m].steps && upper[m].swap == lower[m].swap && upper[m].segments == lower[m].segments
+				&& rowPairs.emplace(upper[m].sourceRow, lower[m].sourceRow).first->second == lower[m].sourceRow;
+		}
+	}
+
+	ThreadPool &threadPool = ThreadPool::get();
+
+	//the sources are packed in place, every one of them being read by several downscaled ciphertexts afterwards
+	map<int, Ciphertext> rowSums;
+	if(paired)
+	{
+		vector<pair<int, int> > pairList(rowPairs.begin(), rowPairs.end());
+		for(auto &rowPair : pairList)
+		{
+			rowSums[rowPair.first];
+		}
+
+		threadPool.run(pairList.size(), [&](int i, int worker)
+		{
+			Ciphertext &sum = rowSums.at(pairList[i].first);
+			sum = encryptedImageData[pairList[i].first];
+			evaluator.add(sum, encryptedImageData[pairList[i].second]);
+			addColumnPairs(sum, pairPlan, threadPool.getMemoryPool(worker));
+		});
+	}
+	else
+	{
+		threadPool.run(encryptedImageData.size(), [&](int i, int worker)
+		{
+			addColumnPairs(encryptedImageData[i], pairPlan, threadPool.getMemoryPool(worker));
+		});
+	}
+
+	vector<Ciphertext> downscaledData(cipherCount, Ciphertext());
+	threadPool.run(cipherCount, [&](int i, int worker)
+	{
+		const MemoryPoolHandle &pool = threadPool.getMemoryPool(worker);
+		Ciphertext &result = downscaledData[i];
+
+		if(paired)
+		{
+			moveSegments(upperMoves[i], [&](int sourceRow) -> const Ciphertext& { return rowSums.at(sourceRow); }, result, pool);
+		}
+		else
+		{
+			auto source = [&](int sourceRow) -> const Ciphertext& { return encryptedImageData[sourceRow]; };
+			Ciphertext moved(pool);
+
+			moveSegments(upperMoves[i], source, result, pool);
+			moveSegments(lowerMoves[i], source, moved, pool);
+			evaluator.add(result, moved);
+		}
+		evaluator.add_plain(result, correction);
+	});
+
+	//replacing old values to new ones
+	encryptedImageData = move(downscaledData);
+	layout = downscaledLayout;
+	normalisation = downscaledNorm;
+	imageHeight = layout.getHeight();
+	imageWidth = layout.getWidth();
+
+	auto timeStop = chrono::high_resolution_clock::now();
+
+	cout << "--> end of downscaling: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
+
+	preview(PREVIEW_DOWNSCALE, "../images/afterDownscalingEncrypted.png");
+}
+
+void ImageCiphertext::save(string fileName)
+{
+
+	cout << "saving crypted file '" << fileName << "'" << endl << endl;
+
+	ImageFile::write(fileName, imageParameters, pKey, layout, normalisation, encryptedImageData);
+}
+
+void ImageCiphertext::load(string fileName, bool mapped)
+{
+	cout << "loading crypted file '" << fileName << "'" << endl << endl;
+
+	ImageFile file(fileName, mapped);
+
+	imageParameters = file.getParameters();
+	session = ImageSession::get(imageParameters);
+	pKey = file.getPublicKey();
+	keys.reset();
+	gKey.reset();
+	layout = file.getLayout();
+	normalisation = file.getNormalisation();
+	imageHeight = layout.getHeight();
+	imageWidth = layout.getWidth();
+
+	KeyGenerator keygen(session->getContext());
+	wrongSKey = keygen.secret_key();
+
+	//a mapped file is read by every worker at once
+	encryptedImageData.assign(file.getCipherCount(), Ciphertext());
+	ThreadPool::get().run(file.getCipherCount(), [&](int i, int)
+	{
+		file.readCipher(i, encryptedImageData[i]);
+	}, mapped ? 0 : 1);
+}
+
+void ImageCiphertext::setKeys(shared_ptr<KeyStore> keys)
+{
+	if(keys->getParameters().hash_block() != imageParameters.hash_block())
+		throw invalid_argument("keys made for other encryption parameters");
+
+	this->keys = keys;
+	gKey.reset();
 }
 
 
 void ImageCiphertext::printParameters()
 {
-	SEALContext imageContext(imageParameters);
+	SEALContext &imageContext = session->getContext();
     cout << endl << "/ Encryption parameters:" << endl;
     cout << "| poly_modulus: " << imageContext.poly_modulus().to_string() << endl;
 
@@ -345,74 +778,30 @@ void ImageCiphertext::printParameters()
     cout << "\\ noise_standard_deviation: " << imageContext.noise_standard_deviation() << endl;
     cout << "/ image height: " << imageHeight << endl;
     cout << "| image width: " << imageWidth << endl;
-    cout << "\\ offset applied to values: " << (int)(imageContext.plain_modulus().value() - 255) / 2 << endl;
+    cout << "| ciphertexts: " << layout.getCipherCount() << ", holding " << layout.getSegmentCount() << " color lines each" << endl;
+    cout << "\\ offset applied to values: " << session->getOffset() << endl;
 
     cout << endl;
 }
 
 
-void ImageCiphertext::wrongDecryption(string fileName)
+void ImageCiphertext::enablePreviews(int operations, int rowStep)
 {
-	SEALContext imageContext(imageParameters);
-	Decryptor decryptor(imageContext, this->wrongSKey);
-	PolyCRTBuilder crtbuilder(imageContext);
-
-
-	Plaintext tampon;
-	vector<Plaintext> decryptedData;
-
-	for(uint i = 0; i < encryptedImageData.size(); i++)
-	{
-		decryptor.decrypt(encryptedImageData.at(i), tampon);
-		decryptedData.push_back(tampon);
-	}
-
-	//calculating offset to be removed
-	uint64_t plainModulus = *imageContext.plain_modulus().pointer();
-	int offset = (int)(plainModulus - 255) / 2;
-
-	vector<uint64_t> reds(crtbuilder.slot_count(), 0);
-	vector<uint64_t> greens(crtbuilder.slot_count(), 0);
-	vector<uint64_t> blues(crtbuilder.slot_count(), 0);
+	previewOperations = operations;
+	previewRowStep = (rowStep < 1) ? 1 : rowStep;
+}
 
-	for(int i = 0; i < imageHeight; i++)
+void ImageCiphertext::wrongDecryption(string fileName)
+{
+	vector<int> rows;
+	for(uint32_t i = 0; i < imageHeight; i++)
 	{
-		png_bytep row = row_pointers[i];
-
-		crtbuilder.decompose(decryptedData.at(i * 3), reds);
-		crtbuilder.decompose(decryptedData.at(i * 3 + 1), greens);
-		crtbuilder.decompose(decryptedData.at(i * 3 + 2), blues);
-
-		for(int j = 0; j < imageWidth; j++)
-		{
-			png_bytep px = &(row[j * 4]);
-
-			//for each value, the offset is removed (thus, the value can be negative), then normalisation is applied
-			int pix0 = (int)((reds[j]-offset)*normalisation[i][j][0]);
-			//makes sure that the value is taken back to pixel dynamics
-			(pix0 < 0) ? (pix0 = 0) : (pix0 = pix0);
-			(pix0 > 255) ? (pix0 = 255) : (pix0 = pix0);
-			px[0] = pix0;
-			// cout << "(" << reds[j] << " - " << offset << ")*" << normalisation[i][j][0] << ", px[" << i << "][" << j << "][0] = " << (int)px[0] << endl;	//DEBUG
-
-			int pix1 = (int)((greens[j]-offset)*normalisation[i][j][1]);
-			(pix1 < 0) ? (pix1 = 0) : (pix1 = pix1);
-			(pix1 > 255) ? (pix1 = 255) : (pix1 = pix1);
-			px[1] = pix1;
-			// cout << "(" << greens[j] << " - " << offset << ")*" << normalisation[i][j][1] << ", px[" << i << "][" << j << "][1] = " << (int)px[1] << endl;	//DEBUG
-
-			int pix2 = (int)((blues[j]-offset)*normalisation[i][j][2]);
-			(pix2 < 0) ? (pix2 = 0) : (pix2 = pix2);
-			(pix2 > 255) ? (pix2 = 255) : (pix2 = pix2);
-			px[2] = pix2;
-			// cout << "(" << blues[j] << " - " << offset << ")*" << normalisation[i][j][2] << ", px[" << i << "][" << j << "][2] = " << (int)px[2] << endl;	//DEBUG
-
-			//writting default 255 alpha channel
-			px[3] = 255;	
-		}
+		rows.push_back(i);
 	}
 
-	write_png_file(&fileName[0u]);
+	PreviewWriter &writer = PreviewWriter::get();
+	writer.add(fileName, session, wrongSKey, normalisation, layout, rows, encryptedImageData);
+	writer.wait();
 }
 
 
@@ -420,214 +809,602 @@ void ImageCiphertext::wrongDecryption(string fileName)
 //####################################### private classes ###################################################
 //###########################################################################################################
 
-Ciphertext ImageCiphertext::addColumns(SEALContext context, Ciphertext cipher, int position, int min, int max, const MemoryPoolHandle &pool)
+Ciphertext ImageCiphertext::addColumns(Ciphertext cipher, int position, int min, int max, CompiledFilter &compiled, const MemoryPoolHandle &pool)
 {
 	// cout << "		addRows from " << min << " to " << max << " on position " << position << endl;	//DEBUG
-    Evaluator evaluator(context);
-    PolyCRTBuilder crtbuilder(context);
+    Evaluator &evaluator = session->getEvaluator();
+
+    Ciphertext cipherNTT(pool), tampon(pool);
 
-    vector<uint64_t> selector(crtbuilder.slot_count(), 0);
-    Ciphertext tampon(pool);
-    Plaintext selectorPlain(pool);
+    int polyLength = session->getPolyLength();
 
-    int polyLength = context.poly_modulus().significant_coeff_count() - 1;
+    //the ciphertext is transformed only once, every coefficient being selected with the NTT selectors of the compiled filter
+    evaluator.transform_to_ntt(cipher, cipherNTT);
 
     for(int coeff = min; coeff <= max; coeff++)
     {
         if(coeff == position) continue;		//prevent pixel that has to take new value to be added with itself
 
         //selecting coefficient
-        selector[coeff] = 1;
-        crtbuilder.compose(selector, selectorPlain);
-        evaluator.multiply_plain(cipher, selectorPlain, tampon, pool);	//tampon olds all zeros except for the pixel selected at index 'coeff'
+        evaluator.multiply_plain_ntt(cipherNTT, compiled.getSelector(coeff), tampon);	//tampon olds all zeros except for the pixel selected at index 'coeff'
+        evaluator.transform_from_ntt(tampon);
 
         //shifting the value of the pixel to the position 'position'
         //second argument is number of shifts, positive is rotating left, negative shifts right
-        evaluator.rotate_rows(tampon, (coeff-position), gKey, pool);    
+        evaluator.rotate_rows(tampon, (coeff-position), *gKey, pool);    
 
         //rotation works on ciphertext represented as a 2 by (polyLength/2), so if the position is in first line 
         //and the pixel to move is in second line (example : pos = 511 and pixel = 513, with polyLength = 1024), program also has to 
         //rotate the lines for the pixel to be in the good one (see SEAL documentation)
+        //(positions are the slots of the first segment, which starts at slot 0 and is the only one able to go on in the second line)
         if(((position < polyLength/2) && (coeff >= polyLength/2)) || ((position >= polyLength/2) && (coeff < polyLength/2)))
         {
-        	evaluator.rotate_columns(tampon, gKey, pool);
+        	evaluator.rotate_columns(tampon, *gKey, pool);
         }
 
         //adding new cipher with original one, now the value at position is the old one added with the value at coeff
         evaluator.add(cipher, tampon);
-
-        selector[coeff] = 0;
     }
 
     return cipher;
 }
 
 
-Ciphertext ImageCiphertext::convolute(SEALContext context, int x, int y, int colorLayer, Filter filter, mutex &rmtx, const MemoryPoolHandle &pool)
+Ciphertext ImageCiphertext::convolute(const vector<Ciphertext> &lines, int y, CompiledFilter &compiled, const MemoryPoolHandle &pool)
 {
-	int sum = 0;
-
-	Evaluator evaluator(context);
-	PolyCRTBuilder crtbuilder(context);
-
-	Plaintext multiplierPlain(pool);
-	vector<Ciphertext> tampons;
+	Evaluator &evaluator = session->getEvaluator();
+	Filter &filter = compiled.getFilter();
 
 	int verticalOffset = (int) filter.getHeight()/2;
 	int horizontalOffset = (int) filter.getWidth()/2;
 
-	//preparing offset value to process multiplications
-	uint64_t plainModulus = *context.plain_modulus().pointer();
-	int offsetVal = (int)(plainModulus - 255) / 2;
+	//offset value removed to process multiplications
+	const Plaintext &offset = session->getOffsetPlain();
 
-	vector<uint64_t> offsetVec(crtbuilder.slot_count(), offsetVal);
-	Plaintext offset(pool);
-	crtbuilder.compose(offsetVec, offset);
+	Ciphertext partialResult(pool), tampon(pool);
+	bool empty = true;
 
 	for(int xOffset = -verticalOffset; xOffset <= verticalOffset; xOffset++)		//working on each line of the filter
 	{
-		vector<Ciphertext> pixelsLine;
-		Ciphertext line(context.parms(), pool), data(context.parms(), pool);
-		int currentX;
-
-		((x + xOffset) < 0) ? (currentX = 0) : (((x+xOffset) > imageHeight - 1) ? (currentX = imageHeight - 1) : (currentX = x + xOffset));
-
-		while(!rmtx.try_lock());
-		data = encryptedImageData[(currentX)*3 + colorLayer];
-		rmtx.unlock();
+		//the line is already without offset (don't want to multiply the offset) and in NTT form, for every value of the line of the filter
+		const Ciphertext &data = lines[verticalOffset + xOffset];
 
 		for(int yOffset = -horizontalOffset; yOffset <= horizontalOffset; yOffset++)	//working on each value of the line of the filter
 		{
-			vector<uint64_t> multiplier(crtbuilder.slot_count(), 0);
 			int currentY;
-			Ciphertext tampon(data);
 
-			((y + yOffset) < 0) ? (currentY = 0) : (((y+yOffset) > imageWidth - 1) ? (currentY = imageWidth - 1) : (currentY = y + yOffset));
+			((y + yOffset) < 0) ? (currentY = 0) : (((y+yOffset) > (int) imageWidth - 1) ? (currentY = imageWidth - 1) : (currentY = y + yOffset));
 
 			//getting value of filter at relative position
-			int mult = filter.getValue(verticalOffset + xOffset, horizontalOffset + yOffset);
+			if(filter.getValue(verticalOffset + xOffset, horizontalOffset + yOffset) == 0) continue;
 
-			sum += mult;
+			//keeping only the pixel at current position, then multiplying it with the value in filter
+			//(negative values are taken modulo the plain modulus, which negates the pixel)
+			evaluator.multiply_plain_ntt(data, compiled.getSelector(currentY), tampon);
+			evaluator.multiply_plain(tampon, compiled.getWeight(verticalOffset + xOffset, horizontalOffset + yOffset), pool);
 
-			//making sure the multiplier selector contains only positive values (negation is taken care of after)
-			(mult < 0) ? (multiplier[currentY] = -mult) : (multiplier[currentY] = mult);
-
-			crtbuilder.compose(multiplier, multiplierPlain);
-			if(mult != 0)
+			//adding every ciphertext into only one, to put every value in different positions and different ciphertexts into only one ciphertext
+			//the resulting ciphertext has the result of the convolution operation in the sum of it's values (X values, rest is null)
+			if(empty)
 			{
-				//offset removed to process multiplication (don't want to multiply the offset)
-				evaluator.sub_plain(tampon, offset);	
-
-				if(mult < 0)
-				{
-					//negating value in case filter value at position is negative
-					//(every value of the cipher is negated, but we only use the one at current position)
-					evaluator.negate(tampon);	
-				}
-
-				//multiplying values of ciphertext with the value in filter
-				//to successfuly change the pixel value at corresponding position and deleting every other value
-				evaluator.multiply_plain(tampon, multiplierPlain, pool);
-
-				//adding every ciphertext to a list of vectors
-				pixelsLine.push_back(tampon);
+				partialResult = tampon;
+				empty = false;
+			}
+			else
+			{
+				evaluator.add(partialResult, tampon);
 			}
-			
 		}
-		//adding each ciphertext to one, to put every value in different positions and different ciphertexts into only one ciphertext
-		//thus, the line ciphertext contains X contiguous values (X being the dimmension of the filtering matrix)
-		evaluator.add_many(pixelsLine, line);
-
-		tampons.push_back(line);
 	}
-
-	Ciphertext partialResult(pool), result(pool);
-	//adding every ciphertext containing X non-null values into one, to add pixel values multiplied in only one line
-	//the resulting ciphertext has the result of the convolution operation in the sum of it's values (X values, rest is null)
-	evaluator.add_many(tampons, partialResult);	
+	evaluator.transform_from_ntt(partialResult);
 
 	int YBegin, YEnd;
 	(y < horizontalOffset) ? (YBegin = -y) : (YBegin = -horizontalOffset);
-	(y < (imageWidth - horizontalOffset)) ? (YEnd = horizontalOffset) : (YEnd = (imageWidth - 1 - y));
+	(y < ((int) imageWidth - horizontalOffset)) ? (YEnd = horizontalOffset) : (YEnd = (imageWidth - 1 - y));
 
 	//finally, adds every value in the partialResult ciphertext in a single position, 
-	//corresponding to the resulting value of pixel at position y in line x
-	result = addColumns(context, partialResult, y, y+YBegin, y+YEnd, pool);	
+	//corresponding to the resulting value of pixel at position y in every line
+	Ciphertext result = addColumns(partialResult, y, y+YBegin, y+YEnd, compiled, pool);	
 
 	evaluator.add_plain(result, offset);	//setting back the offset before deleting every value except the one on position y
 
-	vector<uint64_t> selectorNew(crtbuilder.slot_count(), 0);	
-	selectorNew[y] = 1;	
-	crtbuilder.compose(selectorNew, multiplierPlain);
-	//multiplying the result with a vector with value 1 at position y, zero everywhere else, to keep only the result of convolution on position y
-	evaluator.multiply_plain(result, multiplierPlain, pool);	
+	//multiplying the result with a vector with value 1 at position y of every segment, zero everywhere else, to keep only the result of convolution on position y
+	evaluator.transform_to_ntt(result);
+	evaluator.multiply_plain_ntt(result, compiled.getSelector(y));
+	evaluator.transform_from_ntt(result);
+
+	return result;
+}
+
+Ciphertext ImageCiphertext::convoluteLine(int row, int group, CompiledFilter &compiled, const MemoryPoolHandle &pool)
+{
+	Evaluator &evaluator = session->getEvaluator();
+	Filter &filter = compiled.getFilter();
+
+	int verticalOffset = (int) filter.getHeight()/2;
+	int horizontalOffset = (int) filter.getWidth()/2;
+
+	//lines of the filter applied to each source line (several lines of the filter take the same source line on the borders)
+	map<int, vector<int> > filterLines;
+	for(int xOffset = -verticalOffset; xOffset <= verticalOffset; xOffset++)		//working on each line of the filter
+	{
+		filterLines[compiled.getLineKey(row + xOffset)].push_back(verticalOffset + xOffset);
+	}
+
+	Ciphertext result(pool), data(pool), rotated(pool), rotatedNTT(pool), weighted(pool);
+	bool empty = true;
+
+	//multiplies the NTT form of a rotation with the weights of every line of the filter using it, the result being kept in NTT form
+	auto accumulate = [&](const vector<int> &lines, int shift, bool swapped)
+	{
+		evaluator.transform_to_ntt(rotated, rotatedNTT);
+		for(int i : lines)
+		{
+			if(!compiled.hasLineWeights(i, shift, swapped)) continue;
+
+			evaluator.multiply_plain_ntt(rotatedNTT, compiled.getLineWeights(i, shift, swapped), weighted);
+			if(empty)
+			{
+				result = weighted;
+				empty = false;
+			}
+			else
+			{
+				evaluator.add(result, weighted);
+			}
+		}
+	};
 
-	if(sum != 0)
+	for(auto &line : filterLines)
 	{
-		if(sum < 0)	sum = -sum;
-		while(!rmtx.try_lock());
-		normalisation[x][y][colorLayer] *= (float)1/sum;	//modifying normalisation for this pixel 
-		rmtx.unlock();
+		bool gathered = false;
+
+		for(int shift = -horizontalOffset; shift <= horizontalOffset; shift++)
+		{
+			bool useDirect = false, useSwapped = false;
+			for(int i : line.second)
+			{
+				useDirect |= compiled.hasLineWeights(i, shift, false);
+				useSwapped |= compiled.hasLineWeights(i, shift, true);
+			}
+
+			if(!useDirect && !useSwapped) continue;
+
+			if(!gathered)
+			{
+				gatherLine(line.first, group, compiled, data, pool);
+				gathered = true;
+			}
+
+			//each source line is rotated only once for every shift, the rotation being used by every pixel of the line
+			rotated = data;
+			if(shift != 0)
+			{
+				evaluator.rotate_rows(rotated, shift, *gKey, pool);
+			}
+
+			if(useDirect)
+			{
+				accumulate(line.second, shift, false);
+			}
+			if(useSwapped)
+			{
+				evaluator.rotate_columns(rotated, *gKey, pool);
+				accumulate(line.second, shift, true);
+			}
+		}
 	}
+	evaluator.transform_from_ntt(result);
+
+	//every pixel value was multiplied with its offset, so the result holds sum*offset instead of offset
+	//the difference is removed for every pixel of the lines, the guards being left to zero
+	evaluator.add_plain(result, compiled.getCorrection());
 
 	return result;
 }
 
-void ImageCiphertext::initNorm()
+void ImageCiphertext::gatherLine(int row, int group, CompiledFilter &compiled, Ciphertext &destination, const MemoryPoolHandle &pool)
+{
+	int channelGroups = layout.getChannelGroups();
+
+	moveSegments(compiled.getLineMoves(row), [&](int sourceRow) -> const Ciphertext& { return encryptedImageData[sourceRow*channelGroups + group]; }, destination, pool);
+}
+
+void ImageCiphertext::moveSegments(const vector<SegmentMove> &moves, const function<const Ciphertext&(int)> &source, Ciphertext &destination, const MemoryPoolHandle &pool)
 {
-	normalisation = (float***) malloc(imageHeight*sizeof(*normalisation));
+	Evaluator &evaluator = session->getEvaluator();
 
-	for(int i = 0; i < imageHeight; i++)
+	if(moves.size() == 1)
 	{
-		normalisation[i] = (float**) malloc(imageWidth*sizeof(**normalisation));
+		//a single move brings every segment at once (usually a plain copy), the other slots being left with meaningless values
+		destination = source(moves[0].sourceRow);
+		if(moves[0].steps != 0)
+		{
+			evaluator.rotate_rows(destination, moves[0].steps, *gKey, pool);
+		}
+		if(moves[0].swap)
+		{
+			evaluator.rotate_columns(destination, *gKey, pool);
+		}
+		return;
+	}
 
-		for(int j = 0; j < imageWidth; j++)
+	Ciphertext moved(pool);
+	for(uint64_t i = 0; i < moves.size(); i++)
+	{
+		moved = source(moves[i].sourceRow);
+		if(moves[i].steps != 0)
 		{
-			normalisation[i][j] = (float*) malloc(3*sizeof(***normalisation));
+			evaluator.rotate_rows(moved, moves[i].steps, *gKey, pool);
+		}
+		if(moves[i].swap)
+		{
+			evaluator.rotate_columns(moved, *gKey, pool);
+		}
+
+		//keeping only the segments brought by this move, the moves being added in NTT form
+		evaluator.transform_to_ntt(moved);
+		evaluator.multiply_plain_ntt(moved, moves[i].mask);
+		if(i == 0)
+		{
+			destination = moved;
+		}
+		else
+		{
+			evaluator.add(destination, moved);
 		}
 	}
+	evaluator.transform_from_ntt(destination);
+}
+
+void ImageCiphertext::addColumnPairs(Ciphertext &cipher, const ColumnPairPlan &plan, const MemoryPoolHandle &pool)
+{
+	Evaluator &evaluator = session->getEvaluator();
 
+	//every baby step is rotated and transformed once, each giant step adding its masked baby steps before rotating the sum
+	vector<Ciphertext> rotated(plan.babySteps, Ciphertext(pool));
+	for(int baby = 0; baby < plan.babySteps; baby++)
+	{
+		rotated[baby] = cipher;
+		if(baby != 0)
+		{
+			evaluator.rotate_rows(rotated[baby], baby, *gKey, pool);
+		}
+		evaluator.transform_to_ntt(rotated[baby]);
+	}
 
-	for(int i = 0; i < imageHeight; i++)
+	Ciphertext sum(pool), masked(pool);
+	for(uint64_t giant = 0; giant < plan.giantSteps.size(); giant++)
 	{
-		for(int j = 0; j < imageWidth; j++)
+		const vector<Plaintext> &masks = plan.masks[giant];
+
+		evaluator.multiply_plain_ntt(rotated[0], masks[0], sum);
+		for(uint64_t baby = 1; baby < masks.size(); baby++)
 		{
-			for(int k = 0; k < 3; k++)
+			evaluator.multiply_plain_ntt(rotated[baby], masks[baby], masked);
+			evaluator.add(sum, masked);
+		}
+		evaluator.transform_from_ntt(sum);
+
+		if(plan.giantSteps[giant] != 0)
+		{
+			evaluator.rotate_rows(sum, plan.giantSteps[giant], *gKey, pool);
+		}
+
+		if(giant == 0)
+		{
+			cipher = sum;
+		}
+		else
+		{
+			evaluator.add(cipher, sum);
+		}
+	}
+}
+
+void ImageCiphertext::multiplyChannels(Ciphertext &cipher, const ChannelPlain &weight, const MemoryPoolHandle &pool)
+{
+	Evaluator &evaluator = session->getEvaluator();
+
+	if(weight.one) return;
+
+	if(weight.ntt)
+	{
+		evaluator.transform_to_ntt(cipher);
+		evaluator.multiply_plain_ntt(cipher, weight.plain);
+		evaluator.transform_from_ntt(cipher);
+	}
+	else
+	{
+		evaluator.multiply_plain(cipher, weight.plain, pool);
+	}
+}
+
+void ImageCiphertext::applyLinearStep(Ciphertext *ciphers, const PixelStep &step, const MemoryPoolHandle &pool)
+{
+	Evaluator &evaluator = session->getEvaluator();
+	int channelGroups = step.terms.size();
+
+	//every ciphertext of the row can be a term of the others, so the results are only written once all of them are calculated
+	vector<Ciphertext> results(channelGroups, Ciphertext(pool));
+	Ciphertext moved(pool);
+	for(int group = 0; group < channelGroups; group++)
+	{
+		Ciphertext &result = results[group];
+		bool empty = true;
+		for(const PixelTerm &term : step.terms[group])
+		{
+			moved = ciphers[term.group];
+			if(term.steps != 0)
+			{
+				evaluator.rotate_rows(moved, term.steps, *gKey, pool);
+			}
+			if(term.swap)
+			{
+				evaluator.rotate_columns(moved, *gKey, pool);
+			}
+			multiplyChannels(moved, term.weight, pool);
+
+			if(empty)
+			{
+				result = moved;
+				empty = false;
+			}
+			else
 			{
-				normalisation[i][j][k] = 1.0;		
+				evaluator.add(result, moved);
 			}
 		}
+
+		//without any term, the color layers only take the constant
+		if(empty)
+		{
+			result = ciphers[group];
+			evaluator.sub(result, ciphers[group]);
+		}
+		evaluator.add_plain(result, step.constants[group].plain);
+	}
+
+	for(int group = 0; group < channelGroups; group++)
+	{
+		ciphers[group] = move(results[group]);
+	}
+}
+
+void ImageCiphertext::applyPolynomialStep(Ciphertext &cipher, int group, const PixelStep &step, const EvaluationKeys &eKey, const MemoryPoolHandle &pool)
+{
+	Evaluator &evaluator = session->getEvaluator();
+
+	//the powers are taken from the values without their offset, each product being relinearized back to two polynomials
+	vector<Ciphertext> powers(step.degree + 1, Ciphertext(pool));
+	evaluator.sub_plain(cipher, session->getOffsetPlain());
+	if(step.degree > 0)
+	{
+		powers[1] = cipher;
+	}
+	for(int i = 2; i <= step.degree; i++)
+	{
+		if(i % 2 == 0)
+		{
+			evaluator.square(powers[i / 2], powers[i], pool);
+		}
+		else
+		{
+			evaluator.multiply(powers[i - 1], powers[1], powers[i], pool);
+		}
+		evaluator.relinearize(powers[i], eKey, pool);
+	}
+
+	Ciphertext weighted(pool);
+	bool empty = true;
+	for(int i = 1; i <= step.degree; i++)
+	{
+		const ChannelPlain &weight = step.powers[group][i - 1];
+		if(!weight.ntt && weight.plain.is_zero()) continue;
+
+		weighted = powers[i];
+		multiplyChannels(weighted, weight, pool);
+		if(empty)
+		{
+			cipher = weighted;
+			empty = false;
+		}
+		else
+		{
+			evaluator.add(cipher, weighted);
+		}
+	}
+
+	if(empty)
+	{
+		evaluator.sub(cipher, Ciphertext(cipher));
+	}
+	evaluator.add_plain(cipher, step.constants[group].plain);
+}
+
+void ImageCiphertext::shiftLine(Ciphertext data, bool masked, CompiledFilter &compiled, vector<Ciphertext> &destination, const MemoryPoolHandle &pool)
+{
+	Evaluator &evaluator = session->getEvaluator();
+
+	int firstShift = compiled.getFirstShift();
+	int lastShift = compiled.getLastShift();
+
+	Ciphertext border(pool);
+
+	//keeping only the pixels of the lines, as values in the guards can be left over by a previous operation
+	if(!masked)
+	{
+		evaluator.transform_to_ntt(data);
+		evaluator.multiply_plain_ntt(data, compiled.getLineMask());
+		evaluator.transform_from_ntt(data);
+	}
+
+	//rotating the lines once for each shift, shifted values coming from outside the line being zeros (taken from the guards)
+	//the shifted lines are then kept in NTT form, as they are only multiplied and added together
+	destination.assign(lastShift - firstShift + 1, data);
+	for(int shift = firstShift; shift <= lastShift; shift++)
+	{
+		if(shift != 0)
+		{
+			evaluator.rotate_rows(destination[shift - firstShift], shift, *gKey, pool);
+		}
+		evaluator.transform_to_ntt(destination[shift - firstShift]);
+	}
+
+	//pixels shifted from outside the line take the closest value inside the image (extension technique)
+	//for a shift to the right, the zeros at slots y < -shift of each segment are replaced with the first pixel, 
+	//which is found at slot y of the line shifted by -y (a smaller shift)
+	//the last pixel is brought the same way to the slots y > imageWidth - 1 - shift for a shift to the left
+	//the largest shifts are completed first, so that the pixels are taken from lines not completed yet: every border value
+	//then goes through a single selector multiplication, instead of one for each smaller shift completed before
+	//(the width is signed, as it is compared with the shifts)
+	int width = imageWidth;
+	for(int shift = firstShift; shift <= -1; shift++)
+	{
+		for(int y = 0; (y < -shift) && (y < width); y++)
+		{
+			evaluator.multiply_plain_ntt(destination[-y - firstShift], compiled.getSelector(y), border);
+			evaluator.add(destination[shift - firstShift], border);
+		}
+	}
+	for(int shift = lastShift; shift >= 1; shift--)
+	{
+		for(int y = width - 1; (y > width - 1 - shift) && (y >= 0); y--)
+		{
+			evaluator.multiply_plain_ntt(destination[width - 1 - y - firstShift], compiled.getSelector(y), border);
+			evaluator.add(destination[shift - firstShift], border);
+		}
 	}
 }
 
-void ImageCiphertext::updateNorm(float value)
+Ciphertext ImageCiphertext::convolutePacked(int row, int group, CompiledFilter &compiled, map<int, vector<Ciphertext> > &shiftedLines, const MemoryPoolHandle &pool)
 {
-	for(int i = 0; i < imageHeight; i++)
+	Evaluator &evaluator = session->getEvaluator();
+	Filter &filter = compiled.getFilter();
+
+	int verticalOffset = (int) filter.getHeight()/2;
+	int horizontalOffset = (int) filter.getWidth()/2;
+
+	set<int> keys;
+	for(int xOffset = -verticalOffset; xOffset <= verticalOffset; xOffset++)
+	{
+		keys.insert(compiled.getLineKey(row + xOffset));
+	}
+
+	//lines above the filter won't be used by the next rows of the worker anymore
+	//(nor lines under it, left over if the worker went back to rows taken from another worker)
+	for(auto line = shiftedLines.begin(); line != shiftedLines.end(); )
+	{
+		(keys.count(line->first) == 0) ? (line = shiftedLines.erase(line)) : (++line);
+	}
+
+	Ciphertext data(pool);
+	for(int key : keys)
 	{
-		for(int j = 0; j < imageWidth; j++)
+		if(shiftedLines.find(key) == shiftedLines.end())
 		{
-			for(int k = 0; k < 3; k++)
+			gatherLine(key, group, compiled, data, pool);
+			shiftLine(data, compiled.getLineMoves(key).size() > 1, compiled, shiftedLines[key], pool);
+		}
+	}
+
+	Ciphertext result(pool), weighted(pool);
+	bool empty = true;
+
+	for(int xOffset = -verticalOffset; xOffset <= verticalOffset; xOffset++)		//working on each line of the filter
+	{
+		vector<Ciphertext> &shifted = shiftedLines[compiled.getLineKey(row + xOffset)];
+
+		for(int yOffset = -horizontalOffset; yOffset <= horizontalOffset; yOffset++)	//working on each value of the line of the filter
+		{
+			if(filter.getValue(verticalOffset + xOffset, horizontalOffset + yOffset) == 0) continue;
+
+			//the filter value is the same for every pixel, so it is multiplied as a constant (much faster, and adds far less noise)
+			//a constant multiplies the NTT form of the shifted line the same way
+			evaluator.multiply_plain(shifted[yOffset - compiled.getFirstShift()], compiled.getWeight(verticalOffset + xOffset, horizontalOffset + yOffset), weighted, pool);
+
+			if(empty)
 			{
-				normalisation[i][j][k] *= value;
+				result = weighted;
+				empty = false;
+			}
+			else
+			{
+				evaluator.add(result, weighted);
 			}
 		}
 	}
+	evaluator.transform_from_ntt(result);
+
+	//every pixel value was multiplied with its offset, so the result holds sum*offset instead of offset
+	evaluator.add_plain(result, compiled.getCorrection());
+
+	return result;
 }
 
-bool ImageCiphertext::verifyNormOver(float value)
+Ciphertext ImageCiphertext::convoluteRow(const Ciphertext &line, bool masked, CompiledFilter &row, const MemoryPoolHandle &pool)
 {
-	bool result = true;
+	Evaluator &evaluator = session->getEvaluator();
+	Filter &filter = row.getFilter();
+
+	int horizontalOffset = (int) filter.getWidth()/2;
+
+	Ciphertext result(pool), weighted(pool);
+	bool empty = true;
+
+	auto accumulate = [&]()
+	{
+		if(empty)
+		{
+			result = weighted;
+			empty = false;
+		}
+		else
+		{
+			evaluator.add(result, weighted);
+		}
+	};
 
-	for(int i =0; i < imageHeight; i++)
+	if(row.getMode() == PACKED)
 	{
-		for(int j = 0; j > imageWidth; j++)
+		vector<Ciphertext> shifted;
+		shiftLine(line, masked, row, shifted, pool);
+
+		for(int yOffset = -horizontalOffset; yOffset <= horizontalOffset; yOffset++)	//working on each row factor
 		{
-			for(int k = 0; k < 3; k++)
+			if(filter.getValue(0, horizontalOffset + yOffset) == 0) continue;
+
+			evaluator.multiply_plain(shifted[yOffset - row.getFirstShift()], row.getWeight(0, horizontalOffset + yOffset), weighted, pool);
+			accumulate();
+		}
+	}
+	else
+	{
+		Ciphertext rotated(pool);
+
+		for(int shift = -horizontalOffset; shift <= horizontalOffset; shift++)
+		{
+			bool useDirect = row.hasLineWeights(0, shift, false), useSwapped = row.hasLineWeights(0, shift, true);
+			if(!useDirect && !useSwapped) continue;
+
+			rotated = line;
+			if(shift != 0)
 			{
-				if(normalisation[i][j][k] < value)
-				{
-					result = false;
-				}
+				evaluator.rotate_rows(rotated, shift, *gKey, pool);
+			}
+
+			if(useDirect)
+			{
+				evaluator.transform_to_ntt(rotated, weighted);
+				evaluator.multiply_plain_ntt(weighted, row.getLineWeights(0, shift, false));
+				accumulate();
+			}
+			if(useSwapped)
+			{
+				evaluator.rotate_columns(rotated, *gKey, pool);
+				evaluator.transform_to_ntt(rotated, weighted);
+				evaluator.multiply_plain_ntt(weighted, row.getLineWeights(0, shift, true));
+				accumulate();
 			}
 		}
 	}
@@ -635,40 +1412,95 @@ bool ImageCiphertext::verifyNormOver(float value)
 	return result;
 }
 
-void ImageCiphertext::write_png_file(char *filename)
+Ciphertext ImageCiphertext::convoluteSeparable(int row, int group, CompiledFilter &compiled, map<int, Ciphertext> &filteredRows, const MemoryPoolHandle &pool)
 {
-	FILE *fp = fopen(filename, "wb");
-	if(!fp) abort();
+	Evaluator &evaluator = session->getEvaluator();
+	Filter &filter = compiled.getFilter();
 
-	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-	if (!png) abort();
+	int verticalOffset = (int) filter.getHeight()/2;
 
-	png_infop info = png_create_info_struct(png);
-	if (!info) abort();
+	set<int> keys;
+	for(int xOffset = -verticalOffset; xOffset <= verticalOffset; xOffset++)
+	{
+		keys.insert(compiled.getLineKey(row + xOffset));
+	}
 
-	if (setjmp(png_jmpbuf(png))) abort();
+	//lines above the filter won't be used by the next rows of the worker anymore
+	//(nor lines under it, left over if the worker went back to rows taken from another worker)
+	for(auto line = filteredRows.begin(); line != filteredRows.end(); )
+	{
+		(keys.count(line->first) == 0) ? (line = filteredRows.erase(line)) : (++line);
+	}
 
-	png_init_io(png, fp);
+	Ciphertext data(pool);
+	for(int key : keys)
+	{
+		if(filteredRows.find(key) == filteredRows.end())
+		{
+			gatherLine(key, group, compiled, data, pool);
+			filteredRows[key] = convoluteRow(data, compiled.getLineMoves(key).size() > 1, compiled.getRowPass(), pool);
+		}
+	}
+
+	Ciphertext result(pool), weighted(pool);
+	bool empty = true;
+
+	for(int xOffset = -verticalOffset; xOffset <= verticalOffset; xOffset++)		//working on each column factor
+	{
+		if(filter.getColumnValue(verticalOffset + xOffset) == 0) continue;
+
+		//the vertical pass needs no rotation, the horizontal passes being aligned with the lines
+		evaluator.multiply_plain(filteredRows[compiled.getLineKey(row + xOffset)], compiled.getColumnWeight(verticalOffset + xOffset), weighted, pool);
+
+		if(empty)
+		{
+			result = weighted;
+			empty = false;
+		}
+		else
+		{
+			evaluator.add(result, weighted);
+		}
+	}
+	evaluator.transform_from_ntt(result);
+
+	//every pixel value was multiplied with its offset by both passes, so the result holds sum*offset instead of offset
+	evaluator.add_plain(result, compiled.getCorrection());
 
-	// Output is 8bit depth, RGBA format.
-	png_set_IHDR(
-	png,
-	info,
-	imageWidth, imageHeight,
-	8,
-	PNG_COLOR_TYPE_RGBA,
-	PNG_INTERLACE_NONE,
-	PNG_COMPRESSION_TYPE_DEFAULT,
-	PNG_FILTER_TYPE_DEFAULT
-	);
-	png_write_info(png, info);
+	return result;
+}
+
+void ImageCiphertext::loadGaloisKeys(const set<int> &steps, bool columnRotation)
+{
+	if(!keys)
+		throw logic_error("image has no keys to rotate its ciphertexts, see setKeys");
 
-	// To remove the alpha channel for PNG_COLOR_TYPE_RGB format,
-	// Use png_set_filler().
-	//png_set_filler(png, 0, PNG_FILLER_AFTER);
+	if(gKey && keys->hasGaloisKeys(*gKey, steps, columnRotation)) return;
 
-	png_write_image(png, row_pointers);
-	png_write_end(png, NULL);
+	gKey = keys->getGaloisKeys(steps, columnRotation);
+}
+
+void ImageCiphertext::preview(PreviewOperation operation, string fileName)
+{
+	if(!(previewOperations & operation)) return;
 
-	fclose(fp);
-}
\ No newline at end of file
+	//only the ciphertexts holding the sampled lines are copied, the decryption being made by the preview writer
+	vector<int> rows;
+	vector<Ciphertext> ciphers(encryptedImageData.size());
+	vector<bool> copied(encryptedImageData.size(), false);
+	for(uint32_t i = 0; i < imageHeight; i += previewRowStep)
+	{
+		rows.push_back(i);
+		for(int k = 0; k < 3; k++)
+		{
+			int index = layout.getCipherIndex(i, k);
+			if(!copied[index])
+			{
+				ciphers[index] = encryptedImageData[index];
+				copied[index] = true;
+			}
+		}
+	}
+
+	PreviewWriter::get().add(fileName, session, wrongSKey, normalisation, layout, rows, ciphers);
+}
@@ -6,49 +6,113 @@
 //#######################################################################################################
 
 
-ImagePlaintext::ImagePlaintext(const EncryptionParameters &parameters, char* fileName)
+ImagePlaintext::ImagePlaintext(const EncryptionParameters &parameters, char* fileName, bool packed, int guard) :
+	ImagePlaintext(make_shared<KeyStore>(parameters), fileName, packed, guard)
 {
-	this->imageParameters = parameters;
+}
 
-	toPlaintext(fileName);
+ImagePlaintext::ImagePlaintext(shared_ptr<KeyStore> keys, char* fileName, bool packed, int guard)
+{
+	this->keys = keys;
+	this->imageParameters = keys->getParameters();
+	this->session = ImageSession::get(imageParameters);
 
-	initNorm();
+	toPlaintext(fileName, packed, guard);
 
-	generateKeys();
+	normalisation = Normalisation(imageHeight, imageWidth);
 }
 
-ImagePlaintext::ImagePlaintext(const EncryptionParameters &parameters, SecretKey sKey)
+ImagePlaintext::ImagePlaintext(const EncryptionParameters &parameters, const vector<string> &fileNames, int guard) :
+	ImagePlaintext(make_shared<KeyStore>(parameters), fileNames, guard)
 {
-	imageParameters = parameters;
-	this->sKey = sKey;
 }
 
-void ImagePlaintext::encrypt(ImageCiphertext &destination)
+ImagePlaintext::ImagePlaintext(shared_ptr<KeyStore> keys, const vector<string> &fileNames, int guard)
 {
-	SEALContext imageContext(imageParameters);
+	this->keys = keys;
+	imageParameters = keys->getParameters();
+	session = ImageSession::get(imageParameters);
+
+	if(fileNames.empty())
+		throw invalid_argument("a batch needs at least one image");
+
+	//the images are stacked on top of each other, each one being a band of the batch
+	vector<png_bytep> batchRows;
+	uint32_t height = 0, width = 0;
+	for(uint64_t i = 0; i < fileNames.size(); i++)
+	{
+		read_png_file((char*)fileNames[i].c_str());
+		if(i == 0)
+		{
+			height = imageHeight;
+			width = imageWidth;
+		}
+		else if(imageHeight != height || imageWidth != width)
+		{
+			throw invalid_argument("the images of a batch must have the same size");
+		}
+
+		batchRows.insert(batchRows.end(), row_pointers, row_pointers + imageHeight);
+		free(row_pointers);
+	}
 
-	Encryptor encryptor(imageContext, pKey);
-	Decryptor decryptor(imageContext, sKey);
-	Ciphertext cipherTampon;
+	layout = ImageLayout::getBatchLayout(session, fileNames.size(), height, width, guard);
 
-	vector<Ciphertext> encryptedImageData;
+	imageHeight = batchRows.size();
+	row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * imageHeight);
+	copy(batchRows.begin(), batchRows.end(), row_pointers);
+
+	encode();
+
+	normalisation = Normalisation(imageHeight, imageWidth);
+}
+
+ImagePlaintext::ImagePlaintext(const EncryptionParameters &parameters, SecretKey sKey) :
+	ImagePlaintext(make_shared<KeyStore>(parameters, sKey))
+{
+}
+
+ImagePlaintext::ImagePlaintext(const EncryptionParameters &parameters) :
+	ImagePlaintext(make_shared<KeyStore>(parameters))
+{
+}
+
+ImagePlaintext::ImagePlaintext(shared_ptr<KeyStore> keys)
+{
+	this->keys = keys;
+	imageParameters = keys->getParameters();
+	session = ImageSession::get(imageParameters);
+	imageHeight = 0;
+	imageWidth = 0;
+}
+
+void ImagePlaintext::encrypt(ImageCiphertext &destination)
+{
+	Encryptor encryptor(session->getContext(), keys->getPublicKey());
+
+	//every ciphertext is encrypted in its own place, so that the workers never wait for each other
+	vector<Ciphertext> encryptedImageData(imageData.size());
 
 	cout << "beginning image encryption" << endl;
 
 	auto timeStart = chrono::high_resolution_clock::now();
 
-	for(uint64_t i = 0; i < imageData.size(); i++)
+	ThreadPool &threadPool = ThreadPool::get();
+	threadPool.run(imageData.size(), [&](int i, int worker)
 	{
-		encryptor.encrypt(imageData.at(i), cipherTampon);
-		encryptedImageData.push_back(cipherTampon);
-	}
+		encryptor.encrypt(imageData[i], encryptedImageData[i], threadPool.getMemoryPool(worker));
+	});
 
 	auto timeStop = chrono::high_resolution_clock::now();
 
 	cout << "--> encryption finished: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl;
-	cout << "available noise budget: " << decryptor.invariant_noise_budget(encryptedImageData.at(1)) << " bits" << endl << endl;
+	if(keys->hasSecretKey())
+	{
+		Decryptor decryptor(session->getContext(), keys->getSecretKey());
+		cout << "available noise budget: " << decryptor.invariant_noise_budget(encryptedImageData.at(0)) << " bits" << endl << endl;
+	}
 
-	destination = ImageCiphertext(imageParameters, imageHeight, imageWidth, pKey, gKey, encryptedImageData); 
+	destination = ImageCiphertext(imageParameters, layout, keys, move(encryptedImageData));
 }
 
 void ImagePlaintext::decrypt(ImageCiphertext &source)
@@ -56,143 +120,382 @@ void ImagePlaintext::decrypt(ImageCiphertext &source)
 	this->imageHeight = source.getHeight();
 	this->imageWidth = source.getWidth();
 	this->normalisation = source.getNorm();
+	this->layout = source.getLayout();
 
-	SEALContext imageContext(imageParameters);
-	Decryptor decryptor(imageContext, sKey);
-	vector<Ciphertext> encryptedData = source.getAllData();
-	Plaintext plainTampon = Plaintext();
-	this->imageData.clear();
+	Decryptor decryptor(session->getContext(), keys->getSecretKey());
+	const vector<Ciphertext> &encryptedData = source.getAllData();
+	this->imageData.assign(encryptedData.size(), Plaintext());
 
-	cout << "remaining noise budget: " << decryptor.invariant_noise_budget(encryptedData.at(1)) << " bits" << endl;
+	cout << "remaining noise budget: " << decryptor.invariant_noise_budget(encryptedData.at(0)) << " bits" << endl;
 	cout << "beginning decryption" << endl;
 
 	auto timeStart = chrono::high_resolution_clock::now();
 
-	for(uint64_t i = 0; i < encryptedData.size(); i++)
+	ThreadPool &threadPool = ThreadPool::get();
+	threadPool.run(encryptedData.size(), [&](int i, int worker)
 	{
-		decryptor.decrypt(encryptedData.at(i), plainTampon);
-		this->imageData.push_back(plainTampon);
-	}
+		decryptor.decrypt(encryptedData[i], imageData[i], threadPool.getMemoryPool(worker));
+	});
 
 	auto timeStop = chrono::high_resolution_clock::now();
 
 	cout << "--> end of decryption: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
 }
 
-void ImagePlaintext::toPlaintext(char* fileName)
+void ImagePlaintext::encryptStream(char* fileName, string cipherFileName, int batchLines)
 {
-	SEALContext imageContext(imageParameters);
-	PolyCRTBuilder crtbuilder(imageContext);
-	read_png_file(fileName);
+	if(batchLines < 1)
+		throw invalid_argument("batchLines must be positive");
+
+	FILE *fp = fopen(fileName, "rb");
+	if(!fp)
+		throw invalid_argument("can't open PNG file");
+
+	png_structp png;
+	png_infop info;
+	open_png_file(fp, png, info);
 
-	if(imageWidth > imageContext.poly_modulus().significant_coeff_count() - 1)
+	if(png_get_interlace_type(png, info) != PNG_INTERLACE_NONE)
+	{
+		png_destroy_read_struct(&png, &info, NULL);
+		fclose(fp);
+		throw invalid_argument("interlaced PNG images can't be streamed");
+	}
+
+	if(imageWidth > (uint32_t) session->getPolyLength())
+	{
+		png_destroy_read_struct(&png, &info, NULL);
+		fclose(fp);
 		throw invalid_argument("poly_modulus must be over image width");
+	}
+
+	//each line gives its red, green and blue ciphertexts as soon as it is read
+	layout = ImageLayout(session, imageHeight, imageWidth, false);
+	normalisation = Normalisation(imageHeight, imageWidth);
+	imageData.clear();
+
+	cout << "beginning streamed encryption to '" << cipherFileName << "'" << endl;
+
+	auto timeStart = chrono::high_resolution_clock::now();
+
+	//same file as ImageCiphertext::save, the ciphertexts being written in the order of the layout
+	unique_ptr<ImageFileWriter> fileWriter;
+	try
+	{
+		fileWriter.reset(new ImageFileWriter(cipherFileName, imageParameters, keys->getPublicKey(), layout, normalisation));
+	}
+	catch(...)
+	{
+		png_destroy_read_struct(&png, &info, NULL);
+		fclose(fp);
+		throw;
+	}
+
+	PolyCRTBuilder &crtbuilder = session->getCRTBuilder();
+	Encryptor encryptor(session->getContext(), keys->getPublicKey());
+	ThreadPool &threadPool = ThreadPool::get();
+	int offset = session->getOffset();
+	png_size_t rowBytes = png_get_rowbytes(png, info);
+
+	//two batches waiting between each stage, in addition to the ones being read, encrypted and written
+	BoundedQueue<vector<vector<png_byte> > > readLines(2);
+	BoundedQueue<vector<Ciphertext> > encryptedLines(2);
+	ProgressReporter progress(imageHeight);
+
+	thread reader([&]()
+	{
+		if(setjmp(png_jmpbuf(png))) abort();
+
+		for(int x = 0; x < (int)imageHeight; x += batchLines)
+		{
+			vector<vector<png_byte> > batch(min(batchLines, (int)imageHeight - x), vector<png_byte>(rowBytes));
+			for(auto &line : batch)
+			{
+				png_read_row(png, line.data(), NULL);
+			}
+
+			if(!readLines.push(move(batch))) break;
+		}
+		readLines.close();
+	});
+
+	thread writer([&]()
+	{
+		vector<Ciphertext> batch;
+		while(encryptedLines.pop(batch))
+		{
+			for(auto &cipher : batch)
+			{
+				fileWriter->add(cipher);
+			}
+			progress.add(batch.size() / 3);
+		}
+	});
+
+	vector<vector<uint64_t> > workerValues(threadPool.getWorkerCount(), vector<uint64_t>(crtbuilder.slot_count(), 0));
+	vector<vector<png_byte> > lines;
+	Ciphertext firstCipher;
+	bool firstBatch = true;
+
+	try
+	{
+		while(readLines.pop(lines))
+		{
+			vector<Ciphertext> batch(lines.size()*3);
+
+			//a task encodes and encrypts a color layer of a line, in the slots of the unpacked layout
+			threadPool.run(batch.size(), [&](int i, int worker)
+			{
+				const MemoryPoolHandle &pool = threadPool.getMemoryPool(worker);
+				png_bytep line = lines[i / 3].data();
+				int colorLayer = i % 3;
+
+				vector<uint64_t> &values = workerValues[worker];
+				for(uint32_t j = 0; j < imageWidth; j++)
+				{
+					values[j] = line[j * 4 + colorLayer] + offset;
+				}
+
+				Plaintext plain(pool);
+				crtbuilder.compose(values, plain);
+				encryptor.encrypt(plain, batch[i], pool);
+			});
+
+			if(firstBatch)
+			{
+				firstCipher = batch[0];
+				firstBatch = false;
+			}
+			if(!encryptedLines.push(move(batch))) break;
+		}
+	}
+	catch(...)
+	{
+		readLines.close();
+		encryptedLines.close();
+		reader.join();
+		writer.join();
+		png_destroy_read_struct(&png, &info, NULL);
+		fclose(fp);
+
+		//the partial file is closed with a zeroed header, then removed
+		fileWriter.reset();
+		remove(cipherFileName.c_str());
+		throw;
+	}
+
+	encryptedLines.close();
+	reader.join();
+	writer.join();
+	progress.finish();
+
+	png_destroy_read_struct(&png, &info, NULL);
+	fclose(fp);
+
+	try
+	{
+		fileWriter->close();
+	}
+	catch(...)
+	{
+		remove(cipherFileName.c_str());
+		throw;
+	}
+
+	auto timeStop = chrono::high_resolution_clock::now();
+
+	cout << "--> streamed encryption finished: " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl;
+	if(!firstBatch && keys->hasSecretKey())
+	{
+		Decryptor decryptor(session->getContext(), keys->getSecretKey());
+		cout << "available noise budget: " << decryptor.invariant_noise_budget(firstCipher) << " bits" << endl << endl;
+	}
+}
+
+void ImagePlaintext::toPlaintext(char* fileName, bool packed, int guard)
+{
+	read_png_file(fileName);
+
+	if(imageWidth > (uint32_t) session->getPolyLength())
+		throw invalid_argument("poly_modulus must be over image width, or the image must be tiled (see TiledImagePlaintext)");
+
+	layout = ImageLayout(session, imageHeight, imageWidth, packed, guard);
+	encode();
+}
+
+void ImagePlaintext::toImages(const vector<string> &fileNames)
+{
+	if(!layout.isBatch())
+		throw logic_error("image is not a batch");
+	if((int)fileNames.size() != layout.getBandCount())
+		throw invalid_argument("a file name is needed for each image of the batch");
+
+	decode();
+
+	//each image is written from its own lines of the batch
+	png_bytep *batchRows = row_pointers;
+	uint32_t batchHeight = imageHeight;
+	imageHeight = layout.getBandHeight();
+
+	for(uint64_t i = 0; i < fileNames.size(); i++)
+	{
+		row_pointers = batchRows + i*imageHeight;
+		cout << "writing to PNG file '" << fileNames[i] << "'" << endl;
+		write_png_file((char*)fileNames[i].c_str());
+	}
+
+	row_pointers = batchRows;
+	imageHeight = batchHeight;
+	cout << "finished" << endl;
+}
+
+void ImagePlaintext::toImage(string fileName)
+{
+	decode();
+
+	cout << "writing to PNG file '" << fileName << "'" << endl;
+	write_png_file(&fileName[0u]);
+	cout << "finished" << endl;
+}
+
+ImagePlaintext ImagePlaintext::getColumns(int firstColumn, int width) const
+{
+	ImagePlaintext columns;
+	columns.imageParameters = imageParameters;
+	columns.session = session;
+	columns.keys = keys;
+	columns.color_type = color_type;
+	columns.bit_depth = bit_depth;
+	columns.imageHeight = imageHeight;
+	columns.imageWidth = width;
+	columns.normalisation = Normalisation(imageHeight, width);
+
+	columns.row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * imageHeight);
+	for(uint32_t y = 0; y < imageHeight; y++)
+	{
+		columns.row_pointers[y] = (png_byte*)malloc(width * 4);
+		memcpy(columns.row_pointers[y], row_pointers[y] + firstColumn * 4, width * 4);
+	}
+
+	return columns;
+}
+
+void ImagePlaintext::encode()
+{
+	PolyCRTBuilder &crtbuilder = session->getCRTBuilder();
 
 	cout << "beginning encoding" << endl;
 
-	//calculating offset to apply to values to put them at the center of the plain modulus
-	uint64_t plainModulus = *imageContext.plain_modulus().pointer();
-	int offset = (int)(plainModulus - 255) / 2;
+	//offset to apply to values to put them at the center of the plain modulus
+	int offset = session->getOffset();
 
 	cout << "offset applied : " << offset << endl;
+	cout << "layout : " << layout.getCipherCount() << " plaintexts, holding " << layout.getSegmentCount() << " color lines each" << endl;
 
-	vector<uint64_t> reds(crtbuilder.slot_count(), 0);
-	vector<uint64_t> greens(crtbuilder.slot_count(), 0);
-	vector<uint64_t> blues(crtbuilder.slot_count(), 0);
+	ThreadPool &threadPool = ThreadPool::get();
 
-	Plaintext redsPoly;
-	Plaintext greensPoly;
-	Plaintext bluesPoly;
+	//slot values being built by each worker
+	vector<vector<uint64_t> > workerValues(threadPool.getWorkerCount(), vector<uint64_t>(crtbuilder.slot_count(), 0));
+	imageData.assign(layout.getCipherCount(), Plaintext());
 
-	for(int i = 0; i < imageHeight; i++)
+	//every value of a line of the image is stored in a ciphertext using CRT batching (see SEAL documentation)
+	//the slots of each color of each line are given by the layout: with the unpacked layout, the data is stored as
+	//a ciphertext for red values of line, then for green values, and then for blue values, then next line of the image
+	//(thus imageHeight*3 ciphertexts), while a packed layout puts several lines and colors in each ciphertext
+	threadPool.run(layout.getCipherCount(), [&](int i, int worker)
 	{
-		png_bytep row = row_pointers[i];
-		for(int j = 0; j < imageWidth; j++)
+		int row = i / layout.getChannelGroups();
+		int group = i % layout.getChannelGroups();
+
+		vector<uint64_t> &values = workerValues[worker];
+		fill(values.begin(), values.end(), 0);
+		for(int segment = 0; segment < layout.getSegmentCount(); segment++)
 		{
-			png_bytep px = &(row[j * 4]);
+			int x = layout.getLine(row, segment);
+			if(x >= (int) imageHeight) continue;	//the last band can be shorter than the others
+
+			int colorLayer = layout.getChannel(group, segment);
+			int slot = layout.getSegmentSlot(segment);
+			png_bytep line = row_pointers[x];
 
-			//taking pixel color value, and adding offset
-			reds[j] = px[0] + offset;
-			greens[j] = px[1] + offset;
-			blues[j] = px[2] + offset;
+			for(uint32_t j = 0; j < imageWidth; j++)
+			{
+				//taking pixel color value, and adding offset
+				values[slot + j] = line[j * 4 + colorLayer] + offset;
+			}
 		}
 
-		//every value of a line of the image is stored in a ciphertext using CRT batching (see SEAL documentation)
-		//the data is always sotred as such : a ciphertext for red values of line, then for green values, and then for blue values
-		//then next line of the image
-		//as such, there is imageHeight*3 ciphertexts in data
-		crtbuilder.compose(reds, redsPoly);
-		crtbuilder.compose(greens, greensPoly);
-		crtbuilder.compose(blues, bluesPoly);
-		imageData.push_back(redsPoly);
-		imageData.push_back(greensPoly);
-		imageData.push_back(bluesPoly);
-	}
+		crtbuilder.compose(values, imageData[i]);
+	});
 
 	cout << "end of encoding" << endl;
 }
 
-void ImagePlaintext::toImage(string fileName)
+void ImagePlaintext::decode()
 {
-	SEALContext imageContext(imageParameters);
-	PolyCRTBuilder crtbuilder(imageContext);
+	PolyCRTBuilder &crtbuilder = session->getCRTBuilder();
 
 	cout << "beginning decoding" << endl;
 
-	//calculating offset to be removed
-	uint64_t plainModulus = *imageContext.plain_modulus().pointer();
-	int offset = (int)(plainModulus - 255) / 2;
+	//an image decrypted without being read from a PNG file (see ImagePlaintext(parameters)) has no lines yet
+	if(row_pointers == nullptr)
+	{
+		row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * imageHeight);
+		for(uint32_t y = 0; y < imageHeight; y++)
+		{
+			row_pointers[y] = (png_byte*)malloc(imageWidth * 4);
+			memset(row_pointers[y], 0xFF, imageWidth * 4);
+		}
+	}
+
+	//offset to be removed
+	int offset = session->getOffset();
 
-	vector<uint64_t> reds(crtbuilder.slot_count(), 0);
-	vector<uint64_t> greens(crtbuilder.slot_count(), 0);
-	vector<uint64_t> blues(crtbuilder.slot_count(), 0);
+	ThreadPool &threadPool = ThreadPool::get();
+	vector<vector<uint64_t> > workerValues(threadPool.getWorkerCount(), vector<uint64_t>(crtbuilder.slot_count(), 0));
 
-	for(int i = 0; i < imageHeight; i++)
+	//every ciphertext holds its own pixels, so the plaintexts are decoded in parallel
+	threadPool.run(layout.getCipherCount(), [&](int i, int worker)
 	{
-		png_bytep row = row_pointers[i];
+		int row = i / layout.getChannelGroups();
+		int group = i % layout.getChannelGroups();
 
-		crtbuilder.decompose(imageData.at(i * 3), reds);
-		crtbuilder.decompose(imageData.at(i * 3 + 1), greens);
-		crtbuilder.decompose(imageData.at(i * 3 + 2), blues);
+		vector<uint64_t> &values = workerValues[worker];
+		crtbuilder.decompose(imageData.at(i), values, threadPool.getMemoryPool(worker));
 
-		for(int j = 0; j < imageWidth; j++)
+		for(int segment = 0; segment < layout.getSegmentCount(); segment++)
 		{
-			png_bytep px = &(row[j * 4]);
-
-			//for each value, the offset is removed (thus, the value can be negative), then normalisation is applied
-			int pix0 = (int)((reds[j]-offset)*normalisation[i][j][0]);
-			//makes sure that the value is taken back to pixel dynamics
-			(pix0 < 0) ? (pix0 = 0) : (pix0 = pix0);
-			(pix0 > 255) ? (pix0 = 255) : (pix0 = pix0);
-			px[0] = pix0;
-			// cout << "(" << reds[j] << " - " << offset << ")*" << normalisation[i][j][0] << ", px[" << i << "][" << j << "][0] = " << (int)px[0] << endl;	//DEBUG
-
-			int pix1 = (int)((greens[j]-offset)*normalisation[i][j][1]);
-			(pix1 < 0) ? (pix1 = 0) : (pix1 = pix1);
-			(pix1 > 255) ? (pix1 = 255) : (pix1 = pix1);
-			px[1] = pix1;
-			// cout << "(" << greens[j] << " - " << offset << ")*" << normalisation[i][j][1] << ", px[" << i << "][" << j << "][1] = " << (int)px[1] << endl;	//DEBUG
-
-			int pix2 = (int)((blues[j]-offset)*normalisation[i][j][2]);
-			(pix2 < 0) ? (pix2 = 0) : (pix2 = pix2);
-			(pix2 > 255) ? (pix2 = 255) : (pix2 = pix2);
-			px[2] = pix2;
-			// cout << "(" << blues[j] << " - " << offset << ")*" << normalisation[i][j][2] << ", px[" << i << "][" << j << "][2] = " << (int)px[2] << endl;	//DEBUG
+			int x = layout.getLine(row, segment);
+			if(x >= (int) imageHeight) continue;
+
+			//the single color layer of a grey image is written to the three colors
+			int colorLayer = layout.getChannel(group, segment);
+			int lastLayer = (layout.getChannels() == 1) ? 2 : colorLayer;
+			int slot = layout.getSegmentSlot(segment);
+			png_bytep line = row_pointers[x];
 
+			for(int k = colorLayer; k <= lastLayer; k++)
+			{
+				for(uint32_t j = 0; j < imageWidth; j++)
+				{
+					//for each value, the offset is removed (thus, the value can be negative), then normalisation is applied
+					int pix = (int)(((int64_t)values[slot + j] - offset)*normalisation.get(x, j, k));
+					//makes sure that the value is taken back to pixel dynamics
+					(pix < 0) ? (pix = 0) : (pix = pix);
+					(pix > 255) ? (pix = 255) : (pix = pix);
+					line[j * 4 + k] = pix;
+				}
+			}
 		}
-	}
+	});
 
 	cout << "end of decoding" << endl;
-
-	cout << "writing to PNG file '" << fileName << "'" << endl;
-	write_png_file(&fileName[0u]);
-	cout << "finished" << endl;
 }
 
 
 void ImagePlaintext::printParameters()
 {
-	SEALContext imageContext(imageParameters);
+	SEALContext &imageContext = session->getContext();
     cout << endl << "/ Encryption parameters:" << endl;
     cout << "| poly_modulus: " << imageContext.poly_modulus().to_string() << endl;
 
@@ -206,7 +509,7 @@ void ImagePlaintext::printParameters()
     cout << "\\ noise_standard_deviation: " << imageContext.noise_standard_deviation() << endl;
     cout << "/ image height: " << imageHeight << endl;
     cout << "| image width: " << imageWidth << endl;
-    cout << "\\ offset applied to values: " << (int)(imageContext.plain_modulus().value() - 255) / 2 << endl;
+    cout << "\\ offset applied to values: " << session->getOffset() << endl;
     cout << endl;
 }
 
@@ -215,77 +518,33 @@ void ImagePlaintext::printParameters()
 //############################################ private methods ######################################################
 //###################################################################################################################
 
-void ImagePlaintext::generateKeys()
+void ImagePlaintext::read_png_file(char *filename) 
 {
-	cout << "generating keys" << endl;
-	auto timeStart = chrono::high_resolution_clock::now();
-
-	SEALContext context(imageParameters);
-
-	KeyGenerator generator(context);
-    sKey = generator.secret_key();
-    pKey = generator.public_key();
-
-    //this key is used during ciphertext values rotation (used during matric filtering)
-    //current Galois key is generated with a Decomposition Bit Count of 30
-    //this value is purely subjective, and was simply taken as the mean of possible values
-    //taking a lower DBC will slow the rotation process, but will lower the noise generated by it
-    //inversely, taking a higher value will result in more noise but will process faster
-    generator.generate_galois_keys(30, gKey);
-
-    auto timeStop = chrono::high_resolution_clock::now();
-    cout << "--> keys generated successfully in " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
-}
+	FILE *fp = fopen(filename, "rb");
 
-void ImagePlaintext::initNorm()
-{
-	normalisation = (float***) malloc(imageHeight*sizeof(*normalisation));
+	png_structp png;
+	png_infop info;
+	open_png_file(fp, png, info);
 
-	for(int i = 0; i < imageHeight; i++)
-	{
-		normalisation[i] = (float**) malloc(imageWidth*sizeof(**normalisation));
+	if(setjmp(png_jmpbuf(png))) abort();
 
-		for(int j = 0; j < imageWidth; j++)
-		{
-			normalisation[i][j] = (float*) malloc(3*sizeof(***normalisation));
-		}
+	row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * imageHeight);
+	for(uint32_t y = 0; y < imageHeight; y++) {
+	row_pointers[y] = (png_byte*)malloc(png_get_rowbytes(png,info));
 	}
 
+	png_read_image(png, row_pointers);
 
-	for(int i = 0; i < imageHeight; i++)
-	{
-		for(int j = 0; j < imageWidth; j++)
-		{
-			for(int k = 0; k < 3; k++)
-			{
-				normalisation[i][j][k] = 1.0;		
-			}
-		}
-	}
-}
-
-void ImagePlaintext::copyNorm(float ***norm)
-{
-	for(int i = 0; i < imageHeight; i++)
-	{
-		for(int j = 0; j < imageWidth; j++)
-		{
-			for(int k = 0; k < 3; k++)
-			{
-				normalisation[i][j][k] = norm[i][j][k];
-			}
-		}
-	}
+	png_destroy_read_struct(&png, &info, NULL);
+	fclose(fp);
 }
 
-void ImagePlaintext::read_png_file(char *filename) 
+void ImagePlaintext::open_png_file(FILE *fp, png_structp &png, png_infop &info)
 {
-	FILE *fp = fopen(filename, "rb");
-
-	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	if(!png) abort();
 
-	png_infop info = png_create_info_struct(png);
+	info = png_create_info_struct(png);
 	if(!info) abort();
 
 	if(setjmp(png_jmpbuf(png))) abort();
@@ -326,15 +585,6 @@ void ImagePlaintext::read_png_file(char *filename)
 	png_set_gray_to_rgb(png);
 
 	png_read_update_info(png, info);
-
-	row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * imageHeight);
-	for(int y = 0; y < imageHeight; y++) {
-	row_pointers[y] = (png_byte*)malloc(png_get_rowbytes(png,info));
-	}
-
-	png_read_image(png, row_pointers);
-
-	fclose(fp);
 }
 
 void ImagePlaintext::write_png_file(char *filename) 
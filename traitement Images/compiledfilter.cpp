@@ -0,0 +1,270 @@
+#include "compiledfilter.h"
+
+map<CompiledFilter::CacheKey, shared_ptr<CompiledFilter> > CompiledFilter::cache;
+mutex CompiledFilter::cacheMutex;
+
+
+CompiledFilter::CompiledFilter(Filter filter, shared_ptr<ImageSession> session, const ImageLayout &layout, ConvolutionMode mode, int lineRadius) :
+	filter(filter), session(session), layout(layout), imageWidth(layout.getWidth()), mode(mode), lineRadius(lineRadius)
+{
+	int slotCount = session->getSlotCount();
+	int segmentCount = layout.getSegmentCount();
+	int rowSize = slotCount / 2;
+	uint64_t plainModulus = session->getPlainModulus();
+
+	verticalOffset = (int) filter.getHeight()/2;
+	horizontalOffset = (int) filter.getWidth()/2;
+
+	//filter values, negative values being taken modulo the plain modulus
+	firstShift = 0;
+	lastShift = 0;
+	bool empty = true;
+	weights.resize(filter.getHeight()*filter.getWidth());
+	for(int i = 0; i < filter.getHeight(); i++)
+	{
+		for(int j = 0; j < filter.getWidth(); j++)
+		{
+			int mult = filter.getValue(i, j);
+			session->composeConstant((mult < 0) ? plainModulus - (uint64_t)(-mult) : (uint64_t)mult, weights[i*filter.getWidth() + j]);
+
+			if(mult != 0)
+			{
+				firstShift = min(firstShift, j - horizontalOffset);
+				lastShift = max(lastShift, j - horizontalOffset);
+				empty = false;
+			}
+		}
+	}
+
+	if(empty)
+		throw invalid_argument("filter must contain at least one non-zero value");
+
+	//every pixel value is multiplied with its offset, so the sum holds sum*offset instead of offset
+	int sum = filter.getNorm();
+	int64_t correctionValue = ((int64_t)session->getOffset() * (1 - sum)) % (int64_t)plainModulus;
+	if(correctionValue < 0) correctionValue += plainModulus;
+
+	if(mode == HOISTED)
+	{
+		//the guards are left to zero
+		vector<uint64_t> values(slotCount, 0);
+		for(int segment = 0; segment < segmentCount; segment++)
+		{
+			fill(values.begin() + layout.getSegmentSlot(segment), values.begin() + layout.getSegmentSlot(segment) + imageWidth, correctionValue);
+		}
+		session->getCRTBuilder().compose(values, correction);
+	}
+	else
+	{
+		session->composeConstant(correctionValue, correction);
+	}
+
+	session->composeConstant((sum == 0) ? 128 : 255, normOffset);
+	normFactor = (sum == 0) ? 1 : (float)1/((sum < 0) ? -sum : sum);
+
+	//the surrounding lines of every row, planned once for the rows giving the same lines (on the borders of the image)
+	map<vector<pair<int, int> >, int> plannedLines;
+	for(int row = -lineRadius; row < layout.getRowCount() + lineRadius; row++)
+	{
+		int key = plannedLines.insert(make_pair(layout.getLineSources(row), row)).first->second;
+
+		lineKeys.push_back(key);
+		lineMoves.push_back(vector<SegmentMove>());
+		if(key == row)
+		{
+			layout.planLine(row, lineMoves.back());
+		}
+		else
+		{
+			lineMoves.back() = lineMoves[key + lineRadius];
+		}
+	}
+
+	//sets the slots of pixel y of every segment to value
+	auto setPixel = [&](vector<uint64_t> &values, int y, uint64_t value)
+	{
+		for(int segment = 0; segment < segmentCount; segment++)
+		{
+			values[layout.getSegmentSlot(segment) + y] = value;
+		}
+	};
+
+	vector<uint64_t> values(slotCount, 0);
+	if(mode != PIXELWISE && filter.isSeparable() && filter.getHeight() > 1)
+	{
+		//the filter is executed as a horizontal pass of its row factors, which needs the plaintexts of its own mode,
+		//followed by a vertical pass of its column factors, only made of constant multiplications
+		rowPass.reset(new CompiledFilter(filter.getRowFilter(), session, layout, mode, lineRadius));
+
+		columnWeights.resize(filter.getHeight());
+		for(int i = 0; i < filter.getHeight(); i++)
+		{
+			int mult = filter.getColumnValue(i);
+			session->composeConstant((mult < 0) ? plainModulus - (uint64_t)(-mult) : (uint64_t)mult, columnWeights[i]);
+		}
+	}
+	else if(mode == PIXELWISE)
+	{
+		//one selector for each pixel of a line
+		selectors.resize(imageWidth);
+		for(int y = 0; y < imageWidth; y++)
+		{
+			setPixel(values, y, 1);
+			composeNTT(values, selectors[y]);
+			setPixel(values, y, 0);
+		}
+	}
+	else if(mode == PACKED)
+	{
+		for(int y = 0; y < imageWidth; y++)
+		{
+			setPixel(values, y, 1);
+		}
+		composeNTT(values, lineMask);
+
+		//selectors are only needed on the borders, where the shifted lines take the first or last pixel
+		selectors.resize(imageWidth);
+		values.assign(slotCount, 0);
+		for(int y = 0; y < imageWidth; y++)
+		{
+			if(y < -firstShift || y > imageWidth - 1 - lastShift)
+			{
+				setPixel(values, y, 1);
+				composeNTT(values, selectors[y]);
+				setPixel(values, y, 0);
+			}
+		}
+	}
+	else
+	{
+		//the weights depend on the slot, so that pixels on the borders take the closest value inside the image (extension technique)
+		//rotate_rows only moves values inside a row of the 2 by (N/2) matrix, so values that have to go from one row to the other
+		//are put in the swapped weights, applied on the rotation with swapped rows
+		int shiftCount = 2*horizontalOffset + 1;
+		for(int swapped = 0; swapped < 2; swapped++)
+		{
+			lineWeights[swapped].assign(filter.getHeight(), vector<Plaintext>(shiftCount));
+		}
+
+		for(int i = 0; i < filter.getHeight(); i++)	//working on each line of the filter
+		{
+			vector<vector<uint64_t> > direct(shiftCount, vector<uint64_t>(slotCount, 0));
+			vector<vector<uint64_t> > swapped(shiftCount, vector<uint64_t>(slotCount, 0));
+
+			for(int yOffset = -horizontalOffset; yOffset <= horizontalOffset; yOffset++)	//working on each value of the line of the filter
+			{
+				int mult = filter.getValue(i, horizontalOffset + yOffset);
+				if(mult == 0) continue;
+
+				uint64_t weight = (mult < 0) ? plainModulus - (uint64_t)(-mult) : (uint64_t)mult;
+
+				for(int segment = 0; segment < segmentCount; segment++)
+				{
+					int first = layout.getSegmentSlot(segment);
+
+					for(int y = 0; y < imageWidth; y++)
+					{
+						int currentY;
+						((y + yOffset) < 0) ? (currentY = 0) : (((y+yOffset) > imageWidth - 1) ? (currentY = imageWidth - 1) : (currentY = y + yOffset));
+
+						//the value at currentY is brought to y by a rotation of (currentY - y), which is always in the range of the filter
+						//(only the segment of an unpacked layout can go on in the other row)
+						int shift = currentY - y + horizontalOffset;
+						vector<uint64_t> &shiftWeights = (((first + currentY) / rowSize) == ((first + y) / rowSize)) ? direct[shift] : swapped[shift];
+						shiftWeights[first + y] = (shiftWeights[first + y] + weight) % plainModulus;
+					}
+				}
+			}
+
+			//weights left empty are skipped by the convolution (the filter values may also add up to zero)
+			for(int shift = 0; shift < shiftCount; shift++)
+			{
+				if(any_of(direct[shift].begin(), direct[shift].end(), [](uint64_t w){ return w != 0; }))
+				{
+					composeNTT(direct[shift], lineWeights[0][i][shift]);
+				}
+				if(any_of(swapped[shift].begin(), swapped[shift].end(), [](uint64_t w){ return w != 0; }))
+				{
+					composeNTT(swapped[shift], lineWeights[1][i][shift]);
+				}
+			}
+		}
+	}
+
+	//rotations of the surrounding lines, then of the algorithm (the horizontal pass only for a separable filter)
+	columnRotation = false;
+	for(auto &moves : lineMoves)
+	{
+		for(auto &move : moves)
+		{
+			if(move.steps != 0) rotationSteps.insert(move.steps);
+			columnRotation |= move.swap;
+		}
+	}
+
+	if(rowPass)
+	{
+		rotationSteps.insert(rowPass->rotationSteps.begin(), rowPass->rotationSteps.end());
+		columnRotation |= rowPass->columnRotation;
+	}
+	else if(mode == PIXELWISE)
+	{
+		//the neighbours of a pixel are brought to its slot of the first segment, which is the only one able to go on in the second row
+		for(int shift = -min(horizontalOffset, imageWidth - 1); shift <= min(horizontalOffset, imageWidth - 1); shift++)
+		{
+			if(shift != 0) rotationSteps.insert(shift);
+		}
+		columnRotation |= (imageWidth > rowSize);
+	}
+	else if(mode == PACKED)
+	{
+		for(int shift = firstShift; shift <= lastShift; shift++)
+		{
+			if(shift != 0) rotationSteps.insert(shift);
+		}
+	}
+	else
+	{
+		for(int i = 0; i < filter.getHeight(); i++)
+		{
+			for(int shift = -horizontalOffset; shift <= horizontalOffset; shift++)
+			{
+				bool swapped = hasLineWeights(i, shift, true);
+				if(shift != 0 && (swapped || hasLineWeights(i, shift, false))) rotationSteps.insert(shift);
+				columnRotation |= swapped;
+			}
+		}
+	}
+}
+
+shared_ptr<CompiledFilter> CompiledFilter::get(Filter filter, shared_ptr<ImageSession> session, const ImageLayout &layout, ConvolutionMode mode)
+{
+	vector<int> values;
+	for(int i = 0; i < filter.getHeight(); i++)
+	{
+		for(int j = 0; j < filter.getWidth(); j++)
+		{
+			values.push_back(filter.getValue(i, j));
+		}
+	}
+	CacheKey key(session->getParameters().hash_block(), layout.getKey(), (int)mode, filter.getHeight(), filter.getWidth(), values);
+
+	lock_guard<mutex> lock(cacheMutex);
+
+	auto found = cache.find(key);
+	if(found != cache.end())
+	{
+		return found->second;
+	}
+
+	shared_ptr<CompiledFilter> compiled(new CompiledFilter(filter, session, layout, mode, filter.getHeight()/2));
+	cache[key] = compiled;
+
+	return compiled;
+}
+
+void CompiledFilter::composeNTT(const vector<uint64_t> &values, Plaintext &destination)
+{
+	session->getCRTBuilder().compose(values, destination);
+	session->getEvaluator().transform_to_ntt(destination);
+}
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <seal/seal.h>
+#include "filter.h"
+#include "session.h"
+#include "layout.h"
+
+using namespace std;
+using namespace seal;
+
+#ifndef COMPILEDFILTER_H
+#define COMPILEDFILTER_H
+
+/**
+ * @brief algorithm used by applyFilter to execute the convolution matrix
+ */
+enum ConvolutionMode
+{
+	PIXELWISE,	//each pixel is calculated in its own ciphertext, every neighbour being selected and rotated one by one (one rotation per neighbour and per pixel)
+	HOISTED,	//each surrounding line is rotated once per column of the filter, and every pixel of the line is calculated from those rotations
+	PACKED		//each line is rotated once per column of the filter, the rotations being shared by every line using them, and multiplied by constants
+};
+
+/**
+ * @brief plaintexts needed to execute a filter on images of a given layout, with given encryption parameters
+ * @details every plaintext used by a convolution only depends on the filter, the layout of the image and the encryption parameters,
+ * so they are all built once, when the filter is compiled, instead of being composed again for every line or pixel
+ * the plaintexts work on every segment of a ciphertext at once (see ImageLayout), as do the moves bringing the surrounding lines
+ * plaintexts multiplied with non-constant values are stored in NTT form, to be used with Evaluator::multiply_plain_ntt,
+ * filter values being stored as constant plaintexts (see ImageSession::composeConstant)
+ * compiled filters are kept in a cache, so that they can be used again by every image with the same layout and parameters
+ * a compiled filter is never modified once built, and can thus be shared between threads
+ */
+class CompiledFilter
+{
+	public :
+
+		/**
+		 * @brief returns the compiled filter corresponding to the given filter, image layout, encryption parameters and mode
+		 * @details looks for the filter in the cache, and compiles it if it is not found
+		 *
+		 * @param filter the filter to compile
+		 * @param session the session of the encryption parameters of the image
+		 * @param layout the layout of the image
+		 * @param mode the algorithm the filter is compiled for (only the plaintexts used by this algorithm are built)
+		 * @return a shared pointer to the compiled filter
+		 */
+		static shared_ptr<CompiledFilter> get(Filter filter, shared_ptr<ImageSession> session, const ImageLayout &layout, ConvolutionMode mode);
+
+		Filter& getFilter()		{ return filter;	}
+		ConvolutionMode getMode()	{ return mode;		}
+
+		/**
+		 * @brief returns the filter value at given position, as a constant plaintext (negative values are taken modulo the plain modulus)
+		 */
+		const Plaintext& getWeight(int x, int y)	{ return weights[x*filter.getWidth() + y]; }
+
+		/**
+		 * @brief returns the NTT form of a plaintext with 1 at pixel y of every segment, and 0 everywhere else
+		 * @details every slot of the image is available for PIXELWISE,
+		 * only the slots on the borders of the image being available for PACKED (see ImageCiphertext::shiftLine)
+		 */
+		const Plaintext& getSelector(int y)	{ return selectors[y]; }
+
+		/**
+		 * @brief returns the NTT form of a plaintext with 1 at every pixel of every segment, and 0 in the guards (PACKED only)
+		 */
+		const Plaintext& getLineMask()	{ return lineMask; }
+
+		/**
+		 * @brief returns the NTT form of the weights of a shift of a line, for a line of the filter (HOISTED only)
+		 * @details the weights hold the filter value for every pixel taking its neighbour at this shift,
+		 * pixels on the borders taking the closest value inside the image (extension technique)
+		 *
+		 * @param x the line of the filter
+		 * @param shift the rotation of the line, from -width/2 to width/2
+		 * @param swapped true to get the weights of the values taken from the other row of the batching matrix
+		 */
+		const Plaintext& getLineWeights(int x, int shift, bool swapped)	{ return lineWeights[swapped][x][shift + horizontalOffset]; }
+
+		/**
+		 * @brief returns true if the weights of getLineWeights are not all zeros
+		 */
+		bool hasLineWeights(int x, int shift, bool swapped)	{ return lineWeights[swapped][x][shift + horizontalOffset].coeff_count() != 0; }
+
+		/**
+		 * @brief returns the plaintext to add to a convoluted line to remove the offsets multiplied by the filter
+		 * @details every pixel value holds an offset, multiplied with the pixel by the filter,
+		 * so the sum of weighted pixels holds sum*offset instead of offset, this plaintext adds the difference
+		 * the difference is added to every slot and is a constant plaintext, except for HOISTED where the guards are left to zero
+		 */
+		const Plaintext& getCorrection()	{ return correction; }
+
+		/**
+		 * @brief returns true if pixel values have to be moved by getNormOffset after the convolution (sum of values of the filter not over zero)
+		 */
+		bool hasNormOffset()	{ return filter.getNorm() <= 0; }
+
+		/**
+		 * @brief returns the constant plaintext added to pixel values to bring them back to pixel dynamics when the sum of values of the filter is not over zero
+		 */
+		const Plaintext& getNormOffset()	{ return normOffset; }
+
+		/**
+		 * @brief returns the value to multiply the normalisation with after the convolution, 1 if the sum of values of the filter is zero
+		 */
+		float getNormFactor()	{ return normFactor; }
+
+		/**
+		 * @brief returns true if the filter is executed in two passes (see Filter::isSeparable), which is never the case for PIXELWISE or filters of height 1
+		 */
+		bool isSeparable()	{ return rowPass != nullptr; }
+
+		/**
+		 * @brief returns the row factors of a separable filter, compiled for the same mode (horizontal pass)
+		 */
+		CompiledFilter& getRowPass()	{ return *rowPass; }
+
+		/**
+		 * @brief returns the column factor of line x of a separable filter, as a constant plaintext (vertical pass)
+		 */
+		const Plaintext& getColumnWeight(int x)	{ return columnWeights[x]; }
+
+		/**
+		 * @brief returns the moves bringing line x + offset in the segments holding line x, for the lines x of a row (see ImageLayout::planLine)
+		 * @details available for offsets from -height/2 to height/2 of the filter, and for every row of the image
+		 */
+		const vector<SegmentMove>& getLineMoves(int row)	{ return lineMoves[row + lineRadius]; }
+
+		/**
+		 * @brief returns the first row (from -height/2) whose moves give the same lines as the given row, the lines of both rows being identical
+		 */
+		int getLineKey(int row)	{ return lineKeys[row + lineRadius]; }
+
+		ImageLayout& getLayout()	{ return layout; }
+
+		int getFirstShift()	{ return firstShift;	}
+		int getLastShift()	{ return lastShift;		}
+
+		/**
+		 * @brief returns the steps of every rotation of the rows of the batching matrix made by the convolution, giving the galois keys it needs (see KeyStore)
+		 */
+		const set<int>& getRotationSteps()	{ return rotationSteps; }
+
+		/**
+		 * @brief returns true if the convolution swaps the rows of the batching matrix (see Evaluator::rotate_columns)
+		 */
+		bool hasColumnRotation()	{ return columnRotation; }
+
+	private :
+		/**
+		 * @param lineRadius the moves are planned for rows from -lineRadius to rowCount - 1 + lineRadius
+		 */
+		CompiledFilter(Filter filter, shared_ptr<ImageSession> session, const ImageLayout &layout, ConvolutionMode mode, int lineRadius);
+
+		/**
+		 * @brief composes the given slot values, then transforms the plaintext to NTT form
+		 */
+		void composeNTT(const vector<uint64_t> &values, Plaintext &destination);
+
+		Filter filter;
+		shared_ptr<ImageSession> session;
+		ImageLayout layout;
+		int imageWidth;
+		ConvolutionMode mode;
+
+		int verticalOffset, horizontalOffset;
+		int firstShift, lastShift;	//first and last shifts with a non-zero filter value
+		float normFactor;
+
+		vector<Plaintext> weights;
+		vector<Plaintext> selectors;
+		Plaintext lineMask;
+		vector<vector<Plaintext> > lineWeights[2];	//direct and swapped weights, for each line of the filter and each shift
+		Plaintext correction;
+		Plaintext normOffset;
+
+		shared_ptr<CompiledFilter> rowPass;
+		vector<Plaintext> columnWeights;
+
+		int lineRadius;
+		vector<vector<SegmentMove> > lineMoves;
+		vector<int> lineKeys;
+
+		set<int> rotationSteps;
+		bool columnRotation;
+
+		typedef tuple<EncryptionParameters::hash_block_type, vector<int>, int, int, int, vector<int> > CacheKey;
+		static map<CacheKey, shared_ptr<CompiledFilter> > cache;
+		static mutex cacheMutex;
+};
+#endif	//COMPILEDFILTER_H
@@ -1,3 +1,6 @@
+#include <cstdlib>
+#include <stdexcept>
+
 #include "filter.h"
 
 Filter::Filter(string name, int height, int width, vector<int> values)
@@ -6,6 +9,27 @@ Filter::Filter(string name, int height, int width, vector<int> values)
 	filterHeight = height;
 	filterWidth = width;
 	filterValues = values;
+
+	factorise();
+}
+
+Filter::Filter(string name, vector<int> columnValues, vector<int> rowValues)
+{
+	filterName = name;
+	filterHeight = columnValues.size();
+	filterWidth = rowValues.size();
+
+	for(int i=0; i<filterHeight; i++)
+	{
+		for(int j=0; j<filterWidth; j++)
+		{
+			filterValues.push_back(columnValues[i]*rowValues[j]);
+		}
+	}
+
+	this->columnValues = columnValues;
+	this->rowValues = rowValues;
+	separable = true;
 }
 
 
@@ -37,10 +61,84 @@ int Filter::getNorm()
 {
 	int sum = 0;
 
-	for(int i=0; i<filterValues.size(); i++)
+	for(size_t i=0; i<filterValues.size(); i++)
 	{
 		sum += filterValues[i];
 	}
 
 	return sum;
-}
\ No newline at end of file
+}
+
+
+Filter Filter::getRowFilter()
+{
+	if(!separable)
+		throw logic_error("filter is not separable");
+
+	return Filter(filterName + " (rows)", 1, filterWidth, rowValues);
+}
+
+int Filter::getColumnValue(int x)
+{
+	if(!separable)
+		throw logic_error("filter is not separable");
+	if(x > filterHeight - 1)
+		throw invalid_argument("x over height of filter matrix");
+
+	return columnValues[x];
+}
+
+void Filter::factorise()
+{
+	separable = false;
+	columnValues.clear();
+	rowValues.clear();
+
+	//the first non-zero line gives the row factors, once divided by their greatest common divisor
+	int first = -1;
+	for(int i=0; i<filterHeight*filterWidth; i++)
+	{
+		if(filterValues[i] != 0)
+		{
+			first = i;
+			break;
+		}
+	}
+	if(first == -1) return;
+
+	int firstLine = first/filterWidth, firstColumn = first%filterWidth;
+
+	int divisor = 0;
+	for(int j=0; j<filterWidth; j++)
+	{
+		int a = divisor, b = abs(filterValues[firstLine*filterWidth+j]);
+		while(b != 0)
+		{
+			int remainder = a%b;
+			a = b;
+			b = remainder;
+		}
+		divisor = a;
+	}
+	if(filterValues[first] < 0) divisor = -divisor;
+
+	vector<int> row(filterWidth), column(filterHeight);
+	for(int j=0; j<filterWidth; j++)
+	{
+		row[j] = filterValues[firstLine*filterWidth+j]/divisor;
+	}
+
+	//every line must then be a multiple of the row factors (an integer one, as the row factors have no common divisor)
+	for(int i=0; i<filterHeight; i++)
+	{
+		column[i] = filterValues[i*filterWidth+firstColumn]/row[firstColumn];
+		for(int j=0; j<filterWidth; j++)
+		{
+			if(filterValues[i*filterWidth+j] != column[i]*row[j]) return;
+		}
+	}
+
+	columnValues = column;
+	rowValues = row;
+	separable = true;
+}
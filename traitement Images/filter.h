@@ -11,12 +11,40 @@ class Filter
 	public :
 
 		Filter(string name, int height, int width, vector<int> values);
+
+		/**
+		 * @brief creates a separable filter from a column vector and a row vector
+		 * @details the values of the filter are the products columnValues[x]*rowValues[y], 
+		 * so the filter can be executed as a horizontal pass of rowValues followed by a vertical pass of columnValues
+		 * 
+		 * @param name the name of the filter
+		 * @param columnValues the vertical factors of the filter (height of the filter)
+		 * @param rowValues the horizontal factors of the filter (width of the filter)
+		 */
+		Filter(string name, vector<int> columnValues, vector<int> rowValues);
 		
 		void print();
 		
 		int getValue(int x, int y);
 		int getNorm();
 
+		/**
+		 * @brief returns true if the filter is the product of a column vector and a row vector (rank 1 matrix)
+		 * @details given factors are kept as is, other filters are factorised when they are created,
+		 * with the row factors divided by their greatest common divisor and the first non-zero one positive
+		 */
+		bool isSeparable()	{ return separable; }
+
+		/**
+		 * @brief returns the horizontal factors of a separable filter, as a filter of height 1
+		 */
+		Filter getRowFilter();
+
+		/**
+		 * @brief returns the vertical factor of line x of a separable filter
+		 */
+		int getColumnValue(int x);
+
 		int getHeight()	{ return filterHeight;	}
 		int getWidth()	{ return filterWidth;	}
 		bool validate() { return (filterHeight%2 == 1) && (filterWidth%2 == 1); }
@@ -27,5 +55,14 @@ class Filter
 		int filterHeight;
 		int filterWidth;
 		vector<int> filterValues;
+
+		bool separable;
+		vector<int> columnValues;
+		vector<int> rowValues;
+
+		/**
+		 * @brief looks for a column vector and a row vector whose product gives the values of the filter
+		 */
+		void factorise();
 };
 #endif	//FILTER_H
\ No newline at end of file
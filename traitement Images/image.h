@@ -2,19 +2,34 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <cstring>
+#include <functional>
 #include <png.h>
 
 
 #include <seal/seal.h>
 #include "filter.h"
+#include "session.h"
+#include "compiledfilter.h"
+#include "threadpool.h"
+#include "normalisation.h"
+#include "layout.h"
+#include "preview.h"
+#include "imagefile.h"
+#include "keystore.h"
+#include "pixeloperation.h"
 
 
 using namespace std;
 using namespace seal;
 
+#ifndef IMAGE_H
+#define IMAGE_H
 
 class ImageCiphertext;
 class ImagePlaintext;
@@ -50,19 +65,34 @@ class ImageCiphertext
 		 */
 		ImageCiphertext& operator=(const ImageCiphertext& assign);
 
+		/**
+		 * @brief move constructor
+		 * @details takes the encrypted data and the normalisation of autre without copying them
+		 * 
+		 * @param autre ImageCiphertext to move, left empty
+		 */
+		ImageCiphertext(ImageCiphertext&& autre) = default;
+
+		/**
+		 * @brief ImageCiphertext move assignment
+		 * @details takes the encrypted data and the normalisation of the rvalue ImageCiphertext without copying them
+		 * (used when ImagePlaintext encrypts an image)
+		 * 
+		 * @param assign rvalue ImageCiphertext, left empty
+		 */
+		ImageCiphertext& operator=(ImageCiphertext&& assign) = default;
+
 		/**
 		 * @brief creates an ImageCiphertext with given parameters
 		 * @details creates an ImageCiphertext and assign to it given parameters
 		 * this constructor is called by ImagePlaintext when encrypting data
 		 * 
 		 * @param parameters encryption parameters of the ciphertexts contained in data
-		 * @param height height of the image contained
-		 * @param width width of the image contained
-		 * @param pKey public key of the ciphertexts in data
-		 * @param gKey galois key corresponding to ciphertexts (this key is needed for rotations)
+		 * @param layout layout of the image contained, giving its height and width (see ImageLayout)
+		 * @param keys keys of the ciphertexts in data, giving the public key and the galois keys (needed for rotations) of the image
 		 * @param encryptedData vector containing encrypted lines of the image
 		 */
-		ImageCiphertext(EncryptionParameters parameters, int height, int width, PublicKey pKey, GaloisKeys gKey, vector<Ciphertext> encryptedData);
+		ImageCiphertext(EncryptionParameters parameters, ImageLayout layout, shared_ptr<KeyStore> keys, vector<Ciphertext> encryptedData);
 
 		/**
 		 * @brief method to negate the image
@@ -75,6 +105,8 @@ class ImageCiphertext
 		 * @brief method to convert image to greyscale
 		 * @details this method converts pixels values to greyscale, applying a percentage to calculate common value
 		 * the percentages taken are 21% red, 72% green and 7% blue
+		 * the offsets of the three colors are corrected at once after the weighted sum, and the grey image only keeps
+		 * a single color layer, taking three times fewer ciphertexts (see ImageLayout::getGreyLayout)
 		 */
 		void grey();
 
@@ -85,13 +117,57 @@ class ImageCiphertext
 		 * for user's comfort, the percentage of completion of each thread is printed to stdout
 		 * 
 		 * @param filter Class containing it's height, width (both must be odd) and values for each position
-		 * @param numThread number of threads to lauch for calculations, will make sure values entered are coherent, default value is 1
+		 * @param numThread number of workers of the thread pool to use for calculations (see ThreadPool), will make sure values entered are coherent, default value is 1
+		 * @param mode algorithm used to execute the convolution, every one gives the same result, PACKED being the fastest
+		 * (PACKED and HOISTED take about the same noise budget, within two bits for 3 and 5 wide filters)
+		 * (PACKED falls back to HOISTED if the guards of the layout are narrower than half the width of the filter, see ImageLayout)
+		 * separable filters (see Filter::isSeparable) are executed as a horizontal pass followed by a vertical pass, except with PIXELWISE
+		 */
+		void applyFilter(Filter filter, int numThread = 1, ConvolutionMode mode = PACKED);
+
+		/**
+		 * @brief applies a chain of pixel operations (brightness, contrast, channel mixing, gamma...) to every pixel of the image
+		 * @details the operation is planned for the plain modulus and the normalisation of the image (see CompiledPixelOperation),
+		 * which prints the noise budget it takes, then every row of ciphertexts goes through all its steps in a single task of the thread pool
+		 * channel mixing rotates the ciphertexts of packed color images, and polynomial stages multiply ciphertexts together,
+		 * which takes the galois or evaluation keys of the key store of the image
+		 * throws an invalid_argument error if the operation can't be planned for the image
+		 *
+		 * @param operation the operation to apply
+		 */
+		void applyPixelOperation(const PixelOperation &operation);
+
+		/**
+		 * @brief blends another image into this one, every pixel p becoming alpha*p + (1 - alpha)*q, q being the pixel of the other image
+		 * @details both images are multiplied with integer weights as fine as the plain modulus allows, then added, in a single pass
+		 * throws an invalid_argument error if the images don't have the same encryption parameters and layout,
+		 * or if their normalisation factors aren't uniform (see Normalisation::isUniform)
+		 *
+		 * @param other the image to blend, encrypted with the same keys
+		 * @param alpha the weight of this image, from 0 to 1
 		 */
-		void applyFilter(Filter filter, int numThread = 1);
+		void blend(const ImageCiphertext &other, float alpha);
+
+		/**
+		 * @brief halves the height and the width of the image, every pixel becoming the mean of a square of 2 by 2 pixels
+		 * @details the pixels of every line are added by pairs with rotations, and packed at the beginning of their segments,
+		 * then the two lines of every pair are added and moved to the segments of the downscaled layout (see ImageLayout::getDownscaledLayout),
+		 * which holds the image in about half as many ciphertexts for an unpacked image, and a quarter for a packed one
+		 * when both lines of every pair are held in the same segments of two rows (even rows of an unpacked image), the rows are added first,
+		 * so that only half of the ciphertexts are rotated
+		 * the pixels hold the sums of the four pixels, divided at decoding (see Normalisation::getDownscaled), which keeps successive
+		 * downscalings exact, and the last line and column of an odd image are dropped
+		 * throws an invalid_argument error if the image can't be downscaled, or if the pixels added together don't have the same normalisation factor
+		 *
+		 * @param guard the minimum number of empty slots after a segment of the downscaled layout, for a packed layout
+		 */
+		void downscale(int guard = 2);
 
 		/**
 		 * @brief saves data and parameters to a binary file
-		 * @details saves every parameter and data of the image to a binary file. 
+		 * @details saves every parameter and data of the image to a binary file: the encryption parameters, the public key,
+		 * the layout, the normalisation, then the ciphertexts with their index (see ImageFile, which can also read and write back
+		 * some of the ciphertexts only, and ImagePlaintext::encryptStream, writing the same file from a PNG image)
 		 * Be careful though, as the weight of such a file can be quite large (more than 10 MB)
 		 * 
 		 * @param fileName the name to give the file
@@ -100,11 +176,13 @@ class ImageCiphertext
 
 		/**
 		 * @brief loads the parameters and data from an existing file
-		 * @details loads all data and parameters previously saved from the 'save' method
+		 * @details loads all data and parameters previously saved from the 'save' method, the galois keys excepted
+		 * the keys of the image have to be given by setKeys before greying or filtering it
 		 * 
 		 * @param fileName the name of the file to load
+		 * @param mapped true to map the file to memory, its ciphertexts then being read in parallel (see ImageFile)
 		 */
-		void load(string fileName);
+		void load(string fileName, bool mapped = true);
 
 		/**
 		 * @brief returns the number of ciphertexts in encrypted data
@@ -120,10 +198,10 @@ class ImageCiphertext
 		/**
 		 * @brief returns the ciphertext at index given
 		 * @details returns the ciphertext contained in data at position 'index' if it exists, throw an out_of_range error otherwise
-		 * remember data is stored as red line, green line, blue line, red line, green line...
+		 * the lines and color layers held by a ciphertext are given by the layout of the image (see getLayout)
 		 * 
 		 * @param index position of the ciphertext to get
-		 * @return a Ciphertext containing values of one color of a line of the image
+		 * @return a Ciphertext containing values of one or several colors of one or several lines of the image
 		 */
 		Ciphertext getDataAt(uint32_t index)
 		{
@@ -137,7 +215,7 @@ class ImageCiphertext
 		 * @details returns the reference of the vector to the encrypted data of the image
 		 * @return a vector of Ciphertext
 		 */
-		vector<Ciphertext> getAllData()
+		const vector<Ciphertext>& getAllData() const
 		{
 			return encryptedImageData;
 		}
@@ -191,35 +269,64 @@ class ImageCiphertext
 		 * if poly_modulus is X^N + 1, then ciphertexts are represented as matrices of 2 lines and N/2 columns : 
 		 * [[0, 1, 2, ..., 511], [512, 513, ..., 1023]] for N = 1024
 		 * this key is used to swap lines and rotate columns (see SEAL documentation)
-		 * @return a GaloisKey instance (see SEAL documentation)
+		 * the keys are taken from the key store of the image by the operations rotating the ciphertexts, for the rotations they make,
+		 * so an image never greyed or filtered holds no galois keys (see KeyStore::getGaloisKeys(steps, columnRotation))
+		 * @return a GaloisKey instance (see SEAL documentation), null if no operation rotated the ciphertexts
 		 */
-		GaloisKeys getGaloisKeys()
+		shared_ptr<const GaloisKeys> getGaloisKeys()
 		{
 			return gKey;
 		}
 
 		/**
-		 * @brief returns the reference pointing to the first value of the normalisation matrix
-		 * @details returns a pointer to the normalisation table
-		 * this table is a 3-dimensional matrix keeping history of multiplications for each pixel
+		 * @brief gives the keys of the image, used by the rotations of its operations
+		 * @details an image loaded from a file (see load) holds no galois keys, and must be given the key store of its owner
+		 * throws an invalid_argument error if the keys are made for other encryption parameters
+		 *
+		 * @param keys the key store of the image, the secret key being unused
+		 */
+		void setKeys(shared_ptr<KeyStore> keys);
+
+		/**
+		 * @brief returns the normalisation of the image
+		 * @details the normalisation keeps history of multiplications for each pixel (see Normalisation)
 		 * when decoding, the values recovered are multiplied by the corresponding values in normalisation to get the pixel values
-		 * @return a triple pointer to float
+		 * @return a reference to the normalisation
 		 */
-		float*** getNorm()
+		const Normalisation& getNorm()
 		{
 			return normalisation;
 		}
 
+		/**
+		 * @brief returns the layout of the image, giving the slots of each line and color layer in the ciphertexts
+		 */
+		const ImageLayout& getLayout()
+		{
+			return layout;
+		}
+
 		/**
 		 * @brief prints the parameters of data and image
 		 * @details prints to stdout the encryption parameters, as well as the image height, width and the offset applied to values while encoding
 		 */
 		void printParameters();
 
+		/**
+		 * @brief enables debug previews of the image before and after the given operations
+		 * @details previews are disabled by default, as decrypting and writing the whole image twice for each operation
+		 * takes longer than most operations, when enabled they are written by a background thread (see PreviewWriter),
+		 * the operation only copying the lines kept in the preview
+		 * 
+		 * @param operations the operations to preview, as a combination of PreviewOperation values (PREVIEW_NONE disables every preview)
+		 * @param rowStep only one line out of rowStep is kept in the previews (1 to keep every line)
+		 */
+		void enablePreviews(int operations, int rowStep = 1);
+
 		/**
 		 * @brief method for demonstration, creates an image with same dimensions and tries to decrypt data in it
 		 * @details this method decrypts the encrypted data contained with a wrong secret key created at construction 
-		 * then decode decrypted data to write it in a PNG file by calling write_png_file
+		 * then decode decrypted data to write it in a PNG file, and waits until the file is written (see PreviewWriter)
 		 * good to know : alpha value is set manually for each pixel to 255 (no transparency)
 		 * 
 		 * @param fileName the name of the resulting PNG file
@@ -230,72 +337,200 @@ class ImageCiphertext
 		/**
 		 * @brief adds the values from index 'min' to index 'max' to index position in a Ciphertext
 		 * @details uses Ciphertext rotation to get every value in a range around a specific position in ciphertext added to this position
-		 * this method is used to get multiplied values of pixels in a line to a single pixel position
+		 * this method is used to get multiplied values of pixels in a line to a single pixel position, in every segment at once
 		 * 
-		 * @param imageContext the context created from the encryption parameters kept by the instance
-		 * @param cipher the ciphertext (corresponding to a color of a line of the image)
-		 * @param position the position where values around have to be added
+		 * @param cipher the ciphertext (corresponding to the lines of a row of ciphertexts)
+		 * @param position the position in the segments where values around have to be added
 		 * @param min the position of the first value to take
 		 * @param max the position of the last value to take
+		 * @param compiled the compiled filter, holding the NTT selectors of every position
 		 * @param pool pool used and generated by applyFilter, used to manage more efficiently multi-threading
 		 * @return returns a Ciphertext containing the new value at index 'position' and old values everywhere else
 		 */
-		Ciphertext addColumns(SEALContext imageContext, Ciphertext cipher, int position, int min, int max, const MemoryPoolHandle &pool);
+		Ciphertext addColumns(Ciphertext cipher, int position, int min, int max, CompiledFilter &compiled, const MemoryPoolHandle &pool);
 
 		/**
-		 * @brief uses the convolution matrix contained in filter to execute the convolution at the pixel in position (x, y), in a specific color layer
-		 * @details executes the convolution using the matrix contained in filter on the given pixel in coordinates x, y on color layer
+		 * @brief uses the convolution matrix contained in filter to execute the convolution at the pixels in position y of every line of a ciphertext
+		 * @details executes the convolution using the matrix contained in filter on pixel y of every segment of the ciphertext (see ImageLayout)
 		 * if the convolution has to take pixels outside of the image, the algorithm takes the closest value (extension technique)
 		 * this method takes a SEAL pool to make the calculations, as it can be threaded
-		 * the ciphertext returned contains zeros, except at the y position given, where it contains the value 
+		 * the ciphertext returned contains zeros, except at the y position of every segment, where it contains the value 
 		 * resulting from the sum of all surrounding values multiplied by the convolution matrix' values
+		 * the image data is only read, and the normalisation is left unchanged (like every convolution method), 
+		 * applyFilter updating it once every line is calculated (see CompiledFilter::getNormFactor)
 		 * 
-		 * @param context the context created from the encryption parameters 
-		 * @param x the height position of the pixel value to evaluate
-		 * @param y the width position of the pixel to evaluate
-		 * @param colorLayer the color layer of the pixel to evaluate
-		 * @param filter the filter to execute on the pixel
-		 * @param rmtx the read mutex used to prevent data corruption during readings of data
+		 * @param lines the lines surrounding the lines of the ciphertext (see gatherLine), from -height/2 to height/2 of the filter, without their offset and in NTT form
+		 * @param y the width position of the pixels to evaluate
+		 * @param compiled the filter to execute on the pixel, compiled for PIXELWISE
 		 * @param pool the SEAL pool used for convolution (see SEAL documentation)
 		 * @return return a Ciphertext instance
 		 */
-		Ciphertext convolute(SEALContext context, int x, int y, int colorLayer, Filter filter, mutex &rmtx, const MemoryPoolHandle &pool);
+		Ciphertext convolute(const vector<Ciphertext> &lines, int y, CompiledFilter &compiled, const MemoryPoolHandle &pool);
 
 		/**
-		 * @brief initializes every value of the 'normalisation' matrix
-		 * @details initializes every value of the 3-Dimensional matrix 'normalisation' to 1
+		 * @brief uses the convolution matrix contained in filter to execute the convolution on every pixel of a ciphertext
+		 * @details gives the same result as convolute for every pixel of the lines, but calculates them all in a single ciphertext
+		 * each surrounding line is rotated once for each column of the filter, so the number of rotations only depends on the size of the filter
+		 * each rotation is then multiplied with a plaintext holding the filter value for every pixel, 
+		 * pixels on the borders taking the closest value inside the image (extension technique)
+		 * 
+		 * @param row the row of the ciphertext to evaluate
+		 * @param group the index of the ciphertext in its row
+		 * @param compiled the filter to execute on the lines, compiled for HOISTED
+		 * @param pool the SEAL pool used for convolution (see SEAL documentation)
+		 * @return a Ciphertext holding the new values of the lines, and zeros in the guards
 		 */
-		void initNorm();
+		Ciphertext convoluteLine(int row, int group, CompiledFilter &compiled, const MemoryPoolHandle &pool);
 
 		/**
-		 * @brief updates every value of 'normalisation' by the value given in parameter
-		 * @details multiply each value of the 'normalisation' matrix with the given value
-		 * thus, the new value is the old one, multiplied by the given one
+		 * @brief gathers the lines surrounding the lines of a row of ciphertexts in a single ciphertext
+		 * @details applies the moves planned by the compiled filter for this row (see ImageLayout::planLine),
+		 * a single move being a copy of a ciphertext of the image, rotated if needed
 		 * 
-		 * @param value a float with which multiply every value of 'normalisation'
+		 * @param row the row of the lines to gather, from -height/2 to rowCount - 1 + height/2 of the filter
+		 * @param group the index of the ciphertexts in their row
+		 * @param compiled the filter compiled for the layout of the image
+		 * @param destination the ciphertext overwritten with the lines, only the pixels of the segments being meaningful
+		 * @param pool the SEAL pool used for rotations (see SEAL documentation)
 		 */
-		void updateNorm(float value);
+		void gatherLine(int row, int group, CompiledFilter &compiled, Ciphertext &destination, const MemoryPoolHandle &pool);
 
 		/**
-		 * @brief verify if every value of 'normalisation' is over the value given
-		 * @details checks if every value of the 'normalisation' matrix is over or equal to the value given
+		 * @brief applies moves of segments (see SegmentMove) and adds the moved ciphertexts together
 		 * 
-		 * @param value the value with which compare every one from 'nomrmalisation'
-		 * @return returns true if every value is indeed over of equal to the given value, false otherwise
+		 * @param moves the moves to apply
+		 * @param source function giving the ciphertext of the source row of a move
+		 * @param destination the ciphertext overwritten with the sum of the moved ciphertexts
+		 * @param pool the SEAL pool used for rotations (see SEAL documentation)
 		 */
-		bool verifyNormOver(float value);
+		void moveSegments(const vector<SegmentMove> &moves, const function<const Ciphertext&(int)> &source, Ciphertext &destination, const MemoryPoolHandle &pool);
 
-		void write_png_file(char *filename);
+		/**
+		 * @brief adds the pixels of every segment of a ciphertext by pairs, at the beginning of the segment (see ColumnPairPlan)
+		 *
+		 * @param cipher the ciphertext, overwritten with the sums
+		 * @param plan the rotations of the layout of the image (see ImageLayout::planColumnPairs)
+		 * @param pool the SEAL pool used for rotations (see SEAL documentation)
+		 */
+		void addColumnPairs(Ciphertext &cipher, const ColumnPairPlan &plan, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief multiplies a ciphertext with the values of its color layers (see ChannelPlain)
+		 */
+		void multiplyChannels(Ciphertext &cipher, const ChannelPlain &weight, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief replaces the ciphertexts of a row with the sums of their terms, plus their constants (see PixelStep)
+		 *
+		 * @param ciphers the ciphertexts of the row
+		 * @param step the linear step to apply
+		 * @param pool the SEAL pool used for rotations (see SEAL documentation)
+		 */
+		void applyLinearStep(Ciphertext *ciphers, const PixelStep &step, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief replaces a ciphertext with a polynomial of its values without their offset, plus its constant (see PixelStep)
+		 *
+		 * @param cipher the ciphertext
+		 * @param group the index of the ciphertext in its row
+		 * @param step the polynomial step to apply
+		 * @param eKey the evaluation keys relinearizing the powers of the values
+		 * @param pool the SEAL pool used for the products (see SEAL documentation)
+		 */
+		void applyPolynomialStep(Ciphertext &cipher, int group, const PixelStep &step, const EvaluationKeys &eKey, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief rotates the lines of a ciphertext for every shift needed by a filter, pixels shifted from outside the line taking the closest value inside the image
+		 * @details the lines are rotated once for each shift, then the slots that took values from outside the line 
+		 * are given the first or last pixel of the line, taken from the smaller shifts (extension technique)
+		 * the guards of the layout must thus be at least as wide as the largest shift
+		 * 
+		 * @param line the lines to shift, as gathered by gatherLine
+		 * @param masked true if the guards of the lines are already zeros (gathered by several moves)
+		 * @param compiled the filter compiled for PACKED, giving the shifts to calculate (from its first to its last shift)
+		 * @param destination vector overwritten with the NTT form of the lines shifted by every shift
+		 * @param pool the SEAL pool used for rotations (see SEAL documentation)
+		 */
+		void shiftLine(Ciphertext line, bool masked, CompiledFilter &compiled, vector<Ciphertext> &destination, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief uses the convolution matrix contained in filter to execute the convolution on every pixel of a ciphertext
+		 * @details gives the same result as convolute for every pixel of the lines, calculated in a single ciphertext 
+		 * as a sum of shifted lines multiplied by the constant values of the filter
+		 * the shifted lines are kept in 'shiftedLines' to be used by the next rows, only the ones still needed being kept,
+		 * so rows should be given in increasing order for each 'shiftedLines' (other lines are calculated again)
+		 * 
+		 * @param row the row of the ciphertext to evaluate
+		 * @param group the index of the ciphertext in its row
+		 * @param compiled the filter to execute on the lines, compiled for PACKED
+		 * @param shiftedLines the shifted lines (see shiftLine) surrounding the previous row evaluated, by line key (see CompiledFilter::getLineKey), updated for this row
+		 * @param pool the SEAL pool used for convolution (see SEAL documentation)
+		 * @return a Ciphertext holding the new values of the lines, values in the guards being meaningless
+		 */
+		Ciphertext convolutePacked(int row, int group, CompiledFilter &compiled, map<int, vector<Ciphertext> > &shiftedLines, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief executes the horizontal pass of a separable filter on the lines of a ciphertext
+		 * @details the lines are shifted (PACKED, see shiftLine) or rotated (HOISTED) once for each column of the row factors,
+		 * and the shifts are multiplied by the row factors and added together
+		 * 
+		 * @param line the lines to evaluate, as gathered by gatherLine
+		 * @param masked true if the guards of the lines are already zeros (gathered by several moves)
+		 * @param row the row factors of the filter, compiled for PACKED or HOISTED (see CompiledFilter::getRowPass)
+		 * @param pool the SEAL pool used for convolution (see SEAL documentation)
+		 * @return the NTT form of a Ciphertext holding the weighted sums, without any offset correction
+		 */
+		Ciphertext convoluteRow(const Ciphertext &line, bool masked, CompiledFilter &row, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief uses a separable filter to execute the convolution on every pixel of a ciphertext
+		 * @details gives the same result as convolutePacked or convoluteLine, as a vertical pass of the column factors 
+		 * on the horizontal passes of the surrounding lines (see convoluteRow)
+		 * the vertical pass only multiplies ciphertexts with constants, so the rotations only depend on the width of the filter
+		 * (and on the moves bringing the lines surrounding the borders of the bands)
+		 * the horizontal passes are kept in 'filteredRows' to be used by the next rows, only the ones still needed being kept,
+		 * so rows should be given in increasing order for each 'filteredRows' (other lines are calculated again)
+		 * 
+		 * @param row the row of the ciphertext to evaluate
+		 * @param group the index of the ciphertext in its row
+		 * @param compiled the separable filter to execute on the lines
+		 * @param filteredRows the horizontal passes of the lines surrounding the previous row evaluated, by line key (see CompiledFilter::getLineKey), updated for this row
+		 * @param pool the SEAL pool used for convolution (see SEAL documentation)
+		 * @return a Ciphertext holding the new values of the lines
+		 */
+		Ciphertext convoluteSeparable(int row, int group, CompiledFilter &compiled, map<int, Ciphertext> &filteredRows, const MemoryPoolHandle &pool);
+
+		/**
+		 * @brief queues a preview of the image if previews are enabled for the given operation (see enablePreviews)
+		 * 
+		 * @param operation the operation being executed
+		 * @param fileName the name of the PNG file to write
+		 */
+		void preview(PreviewOperation operation, string fileName);
+
+		/**
+		 * @brief takes galois keys for the given rotations from the key store of the image if the keys held don't have them,
+		 * before an operation rotating the ciphertexts
+		 * @details throws a logic_error if the image has no key store
+		 *
+		 * @param steps the steps of the rotations of the rows of the batching matrix
+		 * @param columnRotation true if the rows of the batching matrix are swapped too
+		 */
+		void loadGaloisKeys(const set<int> &steps, bool columnRotation);
 
 		EncryptionParameters imageParameters;
+		shared_ptr<ImageSession> session;	//SEAL tools shared by every image using the same encryption parameters
 		PublicKey pKey;
-		GaloisKeys gKey;
+		shared_ptr<KeyStore> keys;
+		shared_ptr<const GaloisKeys> gKey;	//null until an operation rotates the ciphertexts
 		SecretKey wrongSKey;	//this key is for demonstration only, doesn't represent the real secret key of the encrypted data
 		vector<Ciphertext> encryptedImageData;
-		float ***normalisation;
+		Normalisation normalisation;
+		ImageLayout layout;
 
 		uint32_t imageHeight, imageWidth;
-		png_bytep *row_pointers;	//used to write PNG pictures
+		int previewOperations = PREVIEW_NONE;
+		int previewRowStep = 1;
 };
 
 class ImagePlaintext
@@ -318,8 +553,22 @@ class ImagePlaintext
 		 * 
 		 * @param parameters encryption parameters to use during all encryption/calculus/decryption process
 		 * @param fileName the file name of the image to read (image must be PNG)
+		 * @param packed true to pack the color layers and bands of lines in shared ciphertexts (see ImageLayout), taking fewer ciphertexts,
+		 * but making grey() rotate them, which takes much more noise budget than the unpacked layout (the default)
+		 * @param guard the minimum number of empty slots after each packed line, PACKED filters needing half their width (see ImageCiphertext::applyFilter)
+		 */
+		ImagePlaintext(const EncryptionParameters &parameters, char* fileName, bool packed = false, int guard = 2);
+
+		/**
+		 * @brief reads and encodes an image with the keys of a key store, shared with the other images using it
+		 * @details the encryption parameters are the ones of the key store, no key being generated for the image (see KeyStore)
+		 *
+		 * @param keys the key store of the image
+		 * @param fileName the file name of the image to read (image must be PNG)
+		 * @param packed true to use the packed layout
+		 * @param guard the minimum number of empty slots after each packed line
 		 */
-		ImagePlaintext(const EncryptionParameters &parameters, char* fileName);
+		ImagePlaintext(shared_ptr<KeyStore> keys, char* fileName, bool packed = false, int guard = 2);
 
 		/**
 		 * @brief creates a new ImagePlaintext with specific encryption parameters and secret key
@@ -330,10 +579,46 @@ class ImagePlaintext
 		 */
 		ImagePlaintext(const EncryptionParameters &parameters, SecretKey sKey);
 
+		/**
+		 * @brief creates an ImagePlaintext holding a batch of images of the same size, sharing its ciphertexts and keys
+		 * @details the images are stacked on top of each other as the bands of a single image (see ImageLayout::getBatchLayout),
+		 * so that every line of the ciphertexts holds the same line of each image, side by side with guards between them,
+		 * and every operation of ImageCiphertext processes the whole batch with the rotations of a single image
+		 * line x of image i is line i*height + x of the batch, which is written back to its own image by toImages
+		 * throws an invalid_argument error if the images don't have the same size or are too many (see ImageLayout::getBatchCapacity)
+		 *
+		 * @param parameters encryption parameters to use
+		 * @param fileNames the names of the PNG images
+		 * @param guard the minimum number of empty slots after each line, filters needing half their width (see ImageCiphertext::applyFilter)
+		 */
+		ImagePlaintext(const EncryptionParameters &parameters, const vector<string> &fileNames, int guard = 2);
+
+		/**
+		 * @brief creates a batch of images with the keys of a key store (see ImagePlaintext(parameters, fileNames))
+		 */
+		ImagePlaintext(shared_ptr<KeyStore> keys, const vector<string> &fileNames, int guard = 2);
+
+		/**
+		 * @brief creates a new ImagePlaintext without image, generating its keys
+		 * @details used to encrypt images streamed from their files (see encryptStream), the secret key being kept to decrypt them afterward
+		 *
+		 * @param parameters encryption parameters to use
+		 */
+		ImagePlaintext(const EncryptionParameters &parameters);
+
+		/**
+		 * @brief creates a new ImagePlaintext without image, using the keys of a key store
+		 * @details used to encrypt (with the public key) or decrypt (with the secret key) images with the keys of the store
+		 *
+		 * @param keys the key store to use
+		 */
+		ImagePlaintext(shared_ptr<KeyStore> keys);
+
 		/**
 		 * @brief encrypts the data contained in the ImagePlaintext, and gives the encrypted data and parameters to the given ImageCiphertext
 		 * @details this method encrypts every Plaintext contained in data, then creates a new ImageCiphertext with same parameters 
 		 * (encryption parameters, image heigth, width, public key, galois key) and all encrypted data
+		 * the plaintexts are encrypted in parallel on the thread pool (see ThreadPool)
 		 * also prints available noise budget
 		 * 
 		 * @param destination the ImageCiphertext to be given the encrypted data, it can be uninitialized, as all parameters will be given by this method
@@ -343,24 +628,44 @@ class ImagePlaintext
 		/**
 		 * @brief decrypts all data from the ImageCiphertext to store the resulting Plaintexts in its data
 		 * @details takes image height, width and normalisation matrix, then decrypts every Ciphertext contained in ImageCiphertext data
-		 * every Plaintext obtained is stored in order to its data
+		 * every Plaintext obtained is stored in order to its data, the ciphertexts being decrypted in parallel on the thread pool
 		 * 
 		 * @param source ImageCiphertext to take encrypted data from
 		 */
 		void decrypt(ImageCiphertext &source);
 
+		/**
+		 * @brief encrypts a PNG image directly to a ciphertext file, without loading the whole image
+		 * @details the lines of the image are read by batches, encoded and encrypted on the thread pool, then written to the file,
+		 * each stage running on its own thread and passing the batches to the next one through a bounded queue (see BoundedQueue),
+		 * so that at most a few batches are in memory at once, the slowest stage setting the pace of the others
+		 * the lines of the bands of a packed layout can't be put in their ciphertexts before the whole image is read,
+		 * so the image is encrypted with the unpacked layout
+		 * the file is the one written by ImageCiphertext::save, which can load it
+		 * interlaced images can't be read line by line, and throw an invalid_argument error
+		 * if the encryption or the writing of the file fails, the partial file is removed before the error is thrown
+		 *
+		 * @param fileName the name of the PNG image to encrypt
+		 * @param cipherFileName the name of the ciphertext file to write
+		 * @param batchLines the number of lines in a batch
+		 */
+		void encryptStream(char* fileName, string cipherFileName, int batchLines = 16);
+
 		/**
 		 * @brief reads a PNG image to get data 
 		 * @details every value of every color of every pixel is taken to be put into a coefficient of a SEAL Plaintext 
 		 * this plaintext is a polynomial with a certain number of coefficients, represented by the poly_modulus
 		 * for encoding and simplicity, the poly_modulus must be larger than the image width, to be able to put every value of a color line into a plaintext
 		 * for calculation purposes, an offset is added to the values to put them at the center of the plain_modulus of the coefficients (see SEAL documentation)
-		 * every Plaintext created is then added to a vector containing all of the data
-		 * the data is thus represented of plaintexts containing values of a specific color for every pixels of a line, with the order of the colors being red, green and blue
+		 * every Plaintext created is then added to a vector containing all of the data, the plaintexts being encoded in parallel
+		 * the lines and color layers held by each plaintext are given by the layout of the image, created from its size (see ImageLayout),
+		 * the unpacked layout giving a plaintext for each color of each line, with the order of the colors being red, green and blue
 		 * 
 		 * @param fileName the name of the image file to read
+		 * @param packed true to use the packed layout
+		 * @param guard the minimum number of empty slots after each packed line
 		 */
-		void toPlaintext(char* fileName);
+		void toPlaintext(char* fileName, bool packed = false, int guard = 2);
 
 		/**
 		 * @brief creates a new image from the data containted in the instance
@@ -371,10 +676,17 @@ class ImagePlaintext
 		 */
 		void toImage(string fileName);
 
+		/**
+		 * @brief creates the images of a batch from the data contained in the instance (see ImagePlaintext(parameters, fileNames))
+		 *
+		 * @param fileNames the names of the images to create, one for each image of the batch, in the order of the batch
+		 */
+		void toImages(const vector<string> &fileNames);
+
 		/**
 		 * @brief returns the size of the data contained in the instance
-		 * @details returns the number of lines contained in the instance
-		 * this number corresponds to three times the number of lines in the image, as a Plaintext contains color values red, green or blue of a line
+		 * @details returns the number of plaintexts contained in the instance
+		 * with the unpacked layout, this number corresponds to three times the number of lines in the image, as a Plaintext contains color values red, green or blue of a line
 		 * 
 		 * @return an unsigned int representing the number of Plaintext
 		 */
@@ -387,7 +699,7 @@ class ImagePlaintext
 		/**
 		 * @brief returns the Plaintext at given index
 		 * @details returns the Plaintext at given index if exists, throw an out_of_range error otherwise
-		 * the general way to get a line is : lineOfImage*3 + colorLayer
+		 * the plaintext holding a color layer of a line is given by ImageLayout::getCipherIndex (lineOfImage*3 + colorLayer for the unpacked layout)
 		 * 
 		 * @param index the index of the Plaintext needed
 		 * @return a Plaintext instance
@@ -431,45 +743,69 @@ class ImagePlaintext
 			return imageParameters;
 		}
 
+		/**
+		 * @brief returns the layout of the image, giving the slots of each line and color layer in the plaintexts
+		 */
+		const ImageLayout& getLayout()
+		{
+			return layout;
+		}
+
 		/**
 		 * @brief prints the parameters of data and image
 		 * @details prints to stdout the encryption parameters, as well as the image height, width and the offset applied to values while encoding
 		 */
 		void printParameters();
 
+		/**
+		 * @brief returns the key store of the image, which can be given to other images or saved (see KeyStore)
+		 */
+		shared_ptr<KeyStore> getKeys()
+		{
+			return keys;
+		}
+
 	private : 
+		friend class TiledImagePlaintext;
+
 		/**
-		 * @brief generates keys from encryption parameters for data encryption/calculus/decryption
-		 * @details generates a public key, a secret key and a galois key
-		 * the role of the public key is to encrypt data
-		 * the role of the secret key is to decrypt data
-		 * the role of the galois key is to perform rotations in ciphertexts (see ImageCiphertext's addColumns method)
-		 * the galois key is generated with a median Decomposition Bit Count, allowing a trade-off between speed and noise production 
+		 * @brief returns an image holding some columns of this image, with the same keys, its data being left empty (see encode)
+		 *
+		 * @param firstColumn the first column to take
+		 * @param width the number of columns to take
 		 */
-		void generateKeys();
+		ImagePlaintext getColumns(int firstColumn, int width) const;
 
-		void initNorm();
+		/**
+		 * @brief encodes the pixels of the image to its plaintexts, in the slots given by its layout (see toPlaintext)
+		 */
+		void encode();
 
 		/**
-		 * @brief copy values of another normalisation matrix to the one owned by the instance
-		 * 
-		 * @param norm the triple pointer to float representing the 3-Dimensional matrix 
+		 * @brief decodes the plaintexts of the image to its pixels (see toImage)
 		 */
-		void copyNorm(float ***norm);
+		void decode();
 
 		void read_png_file(char *filename);
 
+		/**
+		 * @brief opens a PNG file and reads its header, setting the image size and the transformations to 8 bits RGBA
+		 * @details the lines are then read with png_read_image or png_read_row
+		 */
+		void open_png_file(FILE *fp, png_structp &png, png_infop &info);
+
 		void write_png_file(char *filename);
 
 		EncryptionParameters imageParameters;
-		SecretKey sKey;
-		PublicKey pKey;
-		GaloisKeys gKey;
+		shared_ptr<ImageSession> session;
+		shared_ptr<KeyStore> keys;	//public key to encrypt, secret key to decrypt, galois keys given to the ciphertexts for their rotations
 		vector<Plaintext> imageData;
-		float ***normalisation;
+		Normalisation normalisation;
+		ImageLayout layout;
 
 		uint32_t imageHeight, imageWidth;
 		png_byte color_type;
 		png_byte bit_depth;
-		png_bytep *row_pointers;
-};
\ No newline at end of file
+		png_bytep *row_pointers = nullptr;
+};
+#endif	//IMAGE_H
@@ -0,0 +1,349 @@
+#include <set>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "imagefile.h"
+
+//fixed header: magic, version, reserved, cipher count, index offset, normalisation offset and size
+static const char IMAGE_FILE_MAGIC[8] = {'S', 'E', 'A', 'L', 'I', 'M', 'G', 0};
+static const uint64_t HEADER_SIZE = 48;
+static const uint64_t NORMALISATION_ENTRY = 32;	//place of the normalisation offset and size in the header
+
+/**
+ * @brief read-only stream buffer over a part of a mapped file, used to load SEAL objects without copying them
+ */
+class MappedBuffer : public streambuf
+{
+	public :
+		MappedBuffer(const char *data, uint64_t size)
+		{
+			char *begin = const_cast<char*>(data);
+			setg(begin, begin, begin + size);
+		}
+
+	protected :
+		pos_type seekoff(off_type offset, ios_base::seekdir direction, ios_base::openmode which) override
+		{
+			char *position = (direction == ios_base::beg) ? eback() : ((direction == ios_base::cur) ? gptr() : egptr());
+			position += offset;
+			if(!(which & ios_base::in) || position < eback() || position > egptr())
+				return pos_type(off_type(-1));
+
+			setg(eback(), position, egptr());
+			return pos_type(position - eback());
+		}
+
+		pos_type seekpos(pos_type position, ios_base::openmode which) override
+		{
+			return seekoff(off_type(position), ios_base::beg, which);
+		}
+};
+
+template<typename T>
+static void writeValue(ostream &stream, T value)
+{
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static T readValue(istream &stream)
+{
+	T value = T();
+	stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+	return value;
+}
+
+ImageFile::ImageFile(string fileName, bool mapped) :
+	fileName(fileName), indexOffset(0), mapping(nullptr), mappingSize(0)
+{
+	uint64_t fileSize = 0;
+	unique_ptr<MappedBuffer> buffer;
+	unique_ptr<istream> mappedStream;
+
+	if(mapped)
+	{
+		int descriptor = open(fileName.c_str(), O_RDONLY);
+		struct stat status;
+		if(descriptor < 0 || fstat(descriptor, &status) != 0)
+		{
+			if(descriptor >= 0) ::close(descriptor);
+			throw invalid_argument("can't open image file");
+		}
+
+		fileSize = status.st_size;
+		void *address = (fileSize > 0) ? mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, descriptor, 0) : MAP_FAILED;
+		::close(descriptor);
+		if(address == MAP_FAILED)
+			throw invalid_argument("can't map image file");
+
+		mapping = static_cast<const char*>(address);
+		mappingSize = fileSize;
+		buffer.reset(new MappedBuffer(mapping, mappingSize));
+		mappedStream.reset(new istream(buffer.get()));
+	}
+	else
+	{
+		//the file is opened for writing too if it can be, so that processed ciphertexts can be written back
+		file.open(fileName, ios::in | ios::out | ios::binary);
+		if(!file.is_open())
+		{
+			file.clear();
+			file.open(fileName, ios::in | ios::binary);
+		}
+		if(!file.is_open())
+			throw invalid_argument("can't open image file");
+
+		file.seekg(0, ios::end);
+		fileSize = file.tellg();
+		file.seekg(0, ios::beg);
+	}
+
+	istream &stream = mapped ? *mappedStream : static_cast<istream&>(file);
+
+	try
+	{
+		char magic[8];
+		stream.read(magic, 8);
+		if(!stream || !equal(magic, magic + 8, IMAGE_FILE_MAGIC))
+			throw invalid_argument("not an image file");
+
+		uint32_t version = readValue<uint32_t>(stream);
+		if(version != VERSION)
+			throw invalid_argument("unsupported image file version");
+
+		readValue<uint32_t>(stream);
+		uint64_t cipherCount = readValue<uint64_t>(stream);
+		indexOffset = readValue<uint64_t>(stream);
+		normalisationEntry.offset = readValue<uint64_t>(stream);
+		normalisationEntry.size = readValue<uint64_t>(stream);
+		if(!stream || indexOffset > fileSize || cipherCount > (fileSize - indexOffset) / sizeof(IndexEntry)
+			|| normalisationEntry.offset > fileSize || normalisationEntry.size > fileSize - normalisationEntry.offset)
+			throw invalid_argument("invalid image file header");
+
+		parameters.load(stream);
+		shared_ptr<ImageSession> session = ImageSession::get(parameters);
+		pKey.load(stream);
+		layout.load(stream, session);
+		if(!stream || cipherCount != (uint64_t)layout.getCipherCount())
+			throw invalid_argument("invalid image file header");
+
+		stream.seekg(normalisationEntry.offset);
+		normalisation.load(stream);
+
+		stream.seekg(indexOffset);
+		index.resize(cipherCount);
+		for(uint64_t i = 0; i < cipherCount; i++)
+		{
+			index[i].offset = readValue<uint64_t>(stream);
+			index[i].size = readValue<uint64_t>(stream);
+			if(index[i].offset < HEADER_SIZE || index[i].size == 0
+				|| index[i].offset > fileSize || index[i].size > fileSize - index[i].offset)
+				throw invalid_argument("invalid image file index");
+		}
+		if(!stream)
+			throw invalid_argument("invalid image file index");
+	}
+	catch(...)
+	{
+		if(mapping != nullptr)
+			munmap(const_cast<char*>(mapping), mappingSize);
+		throw;
+	}
+}
+
+ImageFile::~ImageFile()
+{
+	if(mapping != nullptr)
+	{
+		munmap(const_cast<char*>(mapping), mappingSize);
+	}
+}
+
+void ImageFile::write(string fileName, const EncryptionParameters &parameters, const PublicKey &pKey, const ImageLayout &layout,
+	const Normalisation &normalisation, const vector<Ciphertext> &ciphers)
+{
+	ImageFileWriter writer(fileName, parameters, pKey, layout, normalisation);
+	for(const Ciphertext &cipher : ciphers)
+	{
+		writer.add(cipher);
+	}
+	writer.close();
+}
+
+vector<int> ImageFile::getCiphers(int firstLine, int lineCount, int colorLayer) const
+{
+	int lastLine = min(firstLine + lineCount, layout.getHeight());
+	int firstLayer = (colorLayer < 0) ? 0 : colorLayer;
+	int lastLayer = (colorLayer < 0) ? 2 : colorLayer;
+
+	set<int> ciphers;
+	for(int x = max(0, firstLine); x < lastLine; x++)
+	{
+		for(int k = firstLayer; k <= lastLayer; k++)
+		{
+			ciphers.insert(layout.getCipherIndex(x, k));
+		}
+	}
+
+	return vector<int>(ciphers.begin(), ciphers.end());
+}
+
+void ImageFile::readCipher(int cipherIndex, Ciphertext &destination) const
+{
+	if(cipherIndex < 0 || cipherIndex >= (int)index.size())
+		throw out_of_range("cipherIndex must be less than the cipher count");
+
+	if(mapping != nullptr)
+	{
+		MappedBuffer buffer(mapping + index[cipherIndex].offset, index[cipherIndex].size);
+		istream stream(&buffer);
+		destination.load(stream);
+		if(!stream)
+			throw runtime_error("can't read ciphertext");
+		return;
+	}
+
+	lock_guard<mutex> lock(fileMutex);
+	file.clear();
+	file.seekg(index[cipherIndex].offset);
+	destination.load(file);
+	if(!file)
+		throw runtime_error("can't read ciphertext");
+}
+
+void ImageFile::writeCipher(int cipherIndex, const Ciphertext &cipher)
+{
+	if(mapping != nullptr)
+		throw logic_error("image file is mapped read-only");
+	if(cipherIndex < 0 || cipherIndex >= (int)index.size())
+		throw out_of_range("cipherIndex must be less than the cipher count");
+
+	ostringstream block;
+	cipher.save(block);
+
+	lock_guard<mutex> lock(fileMutex);
+	writeBlock(block.str(), index[cipherIndex]);
+	writeEntry(cipherIndex, index[cipherIndex]);
+}
+
+void ImageFile::writeNormalisation(const Normalisation &normalisation)
+{
+	if(mapping != nullptr)
+		throw logic_error("image file is mapped read-only");
+
+	ostringstream block;
+	normalisation.save(block);
+
+	lock_guard<mutex> lock(fileMutex);
+	writeBlock(block.str(), normalisationEntry);
+	writeEntry(-1, normalisationEntry);
+	this->normalisation = normalisation;
+}
+
+void ImageFile::writeBlock(const string &block, IndexEntry &entry)
+{
+	file.clear();
+	if(block.size() == entry.size)
+	{
+		file.seekp(entry.offset);
+	}
+	else
+	{
+		file.seekp(0, ios::end);
+		entry.offset = file.tellp();
+		entry.size = block.size();
+	}
+
+	file.write(block.data(), block.size());
+	file.flush();
+	if(!file)
+		throw runtime_error("can't write image file");
+}
+
+void ImageFile::writeEntry(int cipherIndex, const IndexEntry &entry)
+{
+	file.seekp((cipherIndex < 0) ? NORMALISATION_ENTRY : indexOffset + cipherIndex*sizeof(IndexEntry));
+	writeValue<uint64_t>(file, entry.offset);
+	writeValue<uint64_t>(file, entry.size);
+	file.flush();
+	if(!file)
+		throw runtime_error("can't write image file");
+}
+
+
+ImageFileWriter::ImageFileWriter(string fileName, const EncryptionParameters &parameters, const PublicKey &pKey, const ImageLayout &layout, const Normalisation &normalisation) :
+	file(fileName, ios::out | ios::binary | ios::trunc), cipherCount(layout.getCipherCount()), closed(false)
+{
+	if(!file.is_open())
+		throw invalid_argument("can't create image file");
+
+	//the offsets of the header are written by close
+	file.write(string(HEADER_SIZE, 0).data(), HEADER_SIZE);
+
+	parameters.save(file);
+	pKey.save(file);
+	layout.save(file);
+
+	normalisationOffset = file.tellp();
+	normalisation.save(file);
+	normalisationSize = (uint64_t)file.tellp() - normalisationOffset;
+
+	indexOffset = file.tellp();
+	file.write(string((uint64_t)cipherCount*2*sizeof(uint64_t), 0).data(), (uint64_t)cipherCount*2*sizeof(uint64_t));
+}
+
+ImageFileWriter::~ImageFileWriter()
+{
+	if(!closed)
+	{
+		try
+		{
+			close();
+		}
+		catch(...)
+		{
+		}
+	}
+}
+
+void ImageFileWriter::add(const Ciphertext &cipher)
+{
+	uint64_t offset = file.tellp();
+	cipher.save(file);
+	index.push_back(offset);
+	index.push_back((uint64_t)file.tellp() - offset);
+}
+
+void ImageFileWriter::close()
+{
+	if(closed) return;
+	closed = true;
+
+	//without every ciphertext, the header stays zeroed so that ImageFile rejects the file
+	if(index.size()/2 != (uint64_t)cipherCount)
+	{
+		file.close();
+		throw logic_error("the number of ciphertexts written doesn't match the layout");
+	}
+
+	file.seekp(indexOffset);
+	file.write(reinterpret_cast<const char*>(index.data()), index.size()*sizeof(uint64_t));
+	file.flush();
+
+	//the magic is written last, once the index is complete
+	file.seekp(0);
+	file.write(IMAGE_FILE_MAGIC, 8);
+	writeValue<uint32_t>(file, ImageFile::VERSION);
+	writeValue<uint32_t>(file, 0);
+	writeValue<uint64_t>(file, cipherCount);
+	writeValue<uint64_t>(file, indexOffset);
+	writeValue<uint64_t>(file, normalisationOffset);
+	writeValue<uint64_t>(file, normalisationSize);
+	file.close();
+
+	if(!file)
+		throw runtime_error("can't write image file");
+}
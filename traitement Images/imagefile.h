@@ -0,0 +1,169 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <seal/seal.h>
+#include "session.h"
+#include "normalisation.h"
+#include "layout.h"
+
+using namespace std;
+using namespace seal;
+
+#ifndef IMAGEFILE_H
+#define IMAGEFILE_H
+
+/**
+ * @brief encrypted image file, giving access to each of its ciphertexts without reading the others
+ * @details an image file starts with a fixed header (magic, version, number of ciphertexts, offsets of the index and of the normalisation),
+ * followed by the encryption parameters, the public key and the layout of the image, its normalisation,
+ * then an index giving the offset and size of every ciphertext, and finally the ciphertexts themselves
+ * the lines and color layers held by a ciphertext are given by the layout (see getCiphers), so that a band of lines
+ * or a single color layer can be read, processed and written back without touching the rest of the image
+ * a ciphertext (or the normalisation) written back with a different size than before is appended at the end of the file,
+ * its index entry being updated, the old one being left unused
+ * a file opened as mapped is mapped to memory read-only, its ciphertexts being read straight from the mapping,
+ * which lets several threads read at once without any lock
+ * integers are written in the byte order of the machine, like the SEAL objects
+ */
+class ImageFile
+{
+	public :
+
+		/**
+		 * @brief version of the format written, files of other versions are refused
+		 */
+		static const uint32_t VERSION = 1;
+
+		/**
+		 * @brief opens an image file and reads its header and index
+		 * @details throws an invalid_argument error if the file can't be opened or isn't an image file of this version
+		 *
+		 * @param fileName the name of the file
+		 * @param mapped true to map the file to memory, read-only
+		 */
+		ImageFile(string fileName, bool mapped = false);
+
+		~ImageFile();
+
+		ImageFile(const ImageFile &copy) = delete;
+		ImageFile& operator=(const ImageFile &assign) = delete;
+
+		/**
+		 * @brief writes a whole image to a new file, replacing any existing one
+		 */
+		static void write(string fileName, const EncryptionParameters &parameters, const PublicKey &pKey, const ImageLayout &layout,
+			const Normalisation &normalisation, const vector<Ciphertext> &ciphers);
+
+		const EncryptionParameters& getParameters() const	{ return parameters;	}
+		const PublicKey& getPublicKey() const				{ return pKey;			}
+		const ImageLayout& getLayout() const				{ return layout;		}
+		const Normalisation& getNormalisation() const		{ return normalisation;	}
+		int getCipherCount() const							{ return index.size();	}
+		bool isMapped() const								{ return mapping != nullptr; }
+
+		/**
+		 * @brief returns the indexes of the ciphertexts holding some lines of the image, in increasing order
+		 *
+		 * @param firstLine the first line
+		 * @param lineCount the number of lines from firstLine
+		 * @param colorLayer the color layer of the lines, every color layer being taken if negative
+		 */
+		vector<int> getCiphers(int firstLine, int lineCount, int colorLayer = -1) const;
+
+		/**
+		 * @brief reads a ciphertext of the image, can be called by several threads at once
+		 */
+		void readCipher(int cipherIndex, Ciphertext &destination) const;
+
+		/**
+		 * @brief writes a ciphertext of the image back to the file
+		 * @details throws a logic_error if the file is mapped
+		 */
+		void writeCipher(int cipherIndex, const Ciphertext &cipher);
+
+		/**
+		 * @brief writes the normalisation of the image back to the file, after lines have been processed
+		 * @details throws a logic_error if the file is mapped
+		 */
+		void writeNormalisation(const Normalisation &normalisation);
+
+	private :
+		struct IndexEntry
+		{
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		/**
+		 * @brief writes a block at its place if it has the same size as before, at the end of the file otherwise, and updates its entry
+		 */
+		void writeBlock(const string &block, IndexEntry &entry);
+
+		/**
+		 * @brief writes an entry of the index, or the entry of the normalisation if cipherIndex is negative
+		 */
+		void writeEntry(int cipherIndex, const IndexEntry &entry);
+
+		string fileName;
+		EncryptionParameters parameters;
+		PublicKey pKey;
+		ImageLayout layout;
+		Normalisation normalisation;
+
+		IndexEntry normalisationEntry;
+		uint64_t indexOffset;
+		vector<IndexEntry> index;
+
+		const char *mapping;	//the file mapped to memory, nullptr if it isn't mapped
+		uint64_t mappingSize;
+		mutable mutex fileMutex;	//protects the file stream
+		mutable fstream file;
+};
+
+/**
+ * @brief writes an image file one ciphertext after the other, without holding the image (see ImageFile)
+ * @details the space of the index is reserved after the header, and filled by close once every ciphertext has been written
+ */
+class ImageFileWriter
+{
+	public :
+
+		/**
+		 * @brief creates the file and writes its header
+		 * @details throws an invalid_argument error if the file can't be created
+		 */
+		ImageFileWriter(string fileName, const EncryptionParameters &parameters, const PublicKey &pKey, const ImageLayout &layout, const Normalisation &normalisation);
+
+		/**
+		 * @brief closes the file if close hasn't been called
+		 * @details if some ciphertexts are missing, the header is left zeroed and ImageFile rejects the file
+		 */
+		~ImageFileWriter();
+
+		/**
+		 * @brief writes the next ciphertext of the image, in the order of the layout
+		 */
+		void add(const Ciphertext &cipher);
+
+		/**
+		 * @brief writes the index, then the header, and closes the file
+		 * @details throws a logic_error, leaving the header zeroed, if the number of ciphertexts written isn't the one of the layout,
+		 * and a runtime_error if the file couldn't be written
+		 */
+		void close();
+
+	private :
+		ofstream file;
+		uint64_t normalisationOffset, normalisationSize;
+		uint64_t indexOffset;
+		vector<uint64_t> index;	//offset and size of each ciphertext written
+		int cipherCount;
+		bool closed;
+};
+#endif	//IMAGEFILE_H
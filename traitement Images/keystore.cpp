@@ -0,0 +1,255 @@
+#include "keystore.h"
+
+//file: magic, version, parts held (secret, public, galois and evaluation keys), encryption parameters, then the keys held
+static const char KEY_STORE_MAGIC[8] = {'S', 'E', 'A', 'L', 'K', 'E', 'Y', 'S'};
+static const uint32_t KEY_STORE_VERSION = 1;
+
+enum KeyStorePart
+{
+	SECRET_KEY_PART = 1,
+	PUBLIC_KEY_PART = 2,
+	GALOIS_KEYS_PART = 4,
+	EVALUATION_KEYS_PART = 8
+};
+
+KeyStore::KeyStore(const EncryptionParameters &parameters) :
+	parameters(parameters), session(ImageSession::get(parameters)), secretKey(true), publicKey(true)
+{
+	cout << "generating keys" << endl;
+	auto timeStart = chrono::high_resolution_clock::now();
+
+	KeyGenerator generator(session->getContext());
+	sKey = generator.secret_key();
+	pKey = generator.public_key();
+
+	auto timeStop = chrono::high_resolution_clock::now();
+	cout << "--> keys generated successfully in " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
+}
+
+KeyStore::KeyStore(const EncryptionParameters &parameters, const SecretKey &sKey) :
+	parameters(parameters), session(ImageSession::get(parameters)), sKey(sKey), secretKey(true), publicKey(false)
+{
+}
+
+KeyStore::KeyStore(string fileName) :
+	secretKey(false), publicKey(false)
+{
+	ifstream file(fileName, ios::in | ios::binary);
+	if(!file.is_open())
+		throw invalid_argument("can't open key store");
+
+	char magic[8];
+	uint32_t version = 0, parts = 0;
+	file.read(magic, 8);
+	file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+	file.read(reinterpret_cast<char*>(&parts), sizeof(uint32_t));
+	if(!file || !equal(magic, magic + 8, KEY_STORE_MAGIC))
+		throw invalid_argument("not a key store");
+	if(version != KEY_STORE_VERSION)
+		throw invalid_argument("unsupported key store version");
+
+	parameters.load(file);
+	session = ImageSession::get(parameters);
+
+	if(parts & SECRET_KEY_PART)
+	{
+		sKey.load(file);
+		secretKey = true;
+	}
+	if(parts & PUBLIC_KEY_PART)
+	{
+		pKey.load(file);
+		publicKey = true;
+	}
+	if(parts & GALOIS_KEYS_PART)
+	{
+		shared_ptr<GaloisKeys> keys = make_shared<GaloisKeys>();
+		keys->load(file);
+		gKey = keys;
+	}
+	if(parts & EVALUATION_KEYS_PART)
+	{
+		shared_ptr<EvaluationKeys> keys = make_shared<EvaluationKeys>();
+		keys->load(file);
+		eKey = keys;
+	}
+
+	if(!file)
+		throw invalid_argument("invalid key store");
+}
+
+void KeyStore::save(string fileName, bool withSecretKey) const
+{
+	ofstream file(fileName, ios::out | ios::binary | ios::trunc);
+	if(!file.is_open())
+		throw invalid_argument("can't create key store");
+
+	uint32_t parts = ((withSecretKey && secretKey) ? SECRET_KEY_PART : 0) | (publicKey ? PUBLIC_KEY_PART : 0) | (gKey ? GALOIS_KEYS_PART : 0)
+		| (eKey ? EVALUATION_KEYS_PART : 0);
+
+	file.write(KEY_STORE_MAGIC, 8);
+	file.write(reinterpret_cast<const char*>(&KEY_STORE_VERSION), sizeof(uint32_t));
+	file.write(reinterpret_cast<const char*>(&parts), sizeof(uint32_t));
+	parameters.save(file);
+
+	if(parts & SECRET_KEY_PART) sKey.save(file);
+	if(parts & PUBLIC_KEY_PART) pKey.save(file);
+	if(parts & GALOIS_KEYS_PART) gKey->save(file);
+	if(parts & EVALUATION_KEYS_PART) eKey->save(file);
+
+	file.close();
+	if(!file)
+		throw runtime_error("can't write key store");
+}
+
+const SecretKey& KeyStore::getSecretKey() const
+{
+	if(!secretKey)
+		throw logic_error("key store has no secret key");
+
+	return sKey;
+}
+
+const PublicKey& KeyStore::getPublicKey() const
+{
+	if(!publicKey)
+		throw logic_error("key store has no public key");
+
+	return pKey;
+}
+
+shared_ptr<const GaloisKeys> KeyStore::getGaloisKeys()
+{
+	lock_guard<mutex> lock(galoisMutex);
+
+	set<uint64_t> elements = getPowerOfTwoElements();
+	if(gKey && all_of(elements.begin(), elements.end(), [&](uint64_t element) { return gKey->has_key(element); }))
+		return gKey;
+
+	generateGaloisKeys(elements);
+
+	return gKey;
+}
+
+shared_ptr<const GaloisKeys> KeyStore::getGaloisKeys(const set<int> &steps, bool columnRotation)
+{
+	lock_guard<mutex> lock(galoisMutex);
+
+	if(gKey && hasGaloisKeys(*gKey, steps, columnRotation))
+		return gKey;
+
+	//keys of every power of two can make any rotation, when the missing keys can't be generated
+	set<uint64_t> powers = getPowerOfTwoElements();
+	if(gKey && (!secretKey || !publicKey) && all_of(powers.begin(), powers.end(), [&](uint64_t element) { return gKey->has_key(element); }))
+		return gKey;
+
+	generateGaloisKeys(getGaloisElements(steps, columnRotation));
+
+	return gKey;
+}
+
+bool KeyStore::hasGaloisKeys(const GaloisKeys &keys, const set<int> &steps, bool columnRotation) const
+{
+	set<uint64_t> elements = getGaloisElements(steps, columnRotation);
+
+	return all_of(elements.begin(), elements.end(), [&](uint64_t element) { return keys.has_key(element); });
+}
+
+shared_ptr<const EvaluationKeys> KeyStore::getEvaluationKeys()
+{
+	lock_guard<mutex> lock(evaluationMutex);
+
+	if(eKey) return eKey;
+
+	if(!secretKey || !publicKey)
+		throw logic_error("evaluation keys can't be generated without the secret and public keys");
+
+	cout << "generating evaluation keys" << endl;
+	auto timeStart = chrono::high_resolution_clock::now();
+
+	//a single key relinearizes the three polynomials of a product of two ciphertexts
+	shared_ptr<EvaluationKeys> keys = make_shared<EvaluationKeys>();
+	KeyGenerator generator(session->getContext(), sKey, pKey);
+	generator.generate_evaluation_keys(EVALUATION_DBC, *keys);
+	eKey = keys;
+
+	auto timeStop = chrono::high_resolution_clock::now();
+	cout << "--> evaluation keys generated successfully in " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
+
+	return eKey;
+}
+
+set<uint64_t> KeyStore::getGaloisElements(const set<int> &steps, bool columnRotation) const
+{
+	//same elements as Evaluator::rotate_rows and rotate_columns, with the poly_modulus X^n + 1
+	uint64_t n = parameters.poly_modulus().coeff_count() - 1;
+	uint64_t m = 2*n;
+
+	set<uint64_t> elements;
+	for(int step : steps)
+	{
+		if(step == 0) continue;
+		if((uint64_t)abs(step) >= n/2)
+			throw invalid_argument("rotation steps too large");
+
+		//a rotation to the right is a rotation to the left by the rest of the row
+		uint64_t exponent = (step > 0) ? step : n/2 + step;
+		uint64_t element = 1;
+		for(uint64_t i = 0; i < exponent; i++)
+		{
+			element = (element * 3) & (m - 1);
+		}
+		elements.insert(element);
+	}
+	if(columnRotation)
+	{
+		elements.insert(m - 1);
+	}
+
+	return elements;
+}
+
+set<uint64_t> KeyStore::getPowerOfTwoElements() const
+{
+	uint64_t n = parameters.poly_modulus().coeff_count() - 1;
+	uint64_t m = 2*n;
+
+	//3^(2^i) and its inverse for every power of two of the rotations of a row, with the swap of the rows
+	set<uint64_t> elements = {m - 1};
+	uint64_t power = 3, inversePower = 1;
+	while((3*inversePower) % m != 1)
+	{
+		inversePower += 2;
+	}
+	for(uint64_t i = 1; i < n/2; i *= 2)
+	{
+		elements.insert(power);
+		elements.insert(inversePower);
+		power = (power * power) & (m - 1);
+		inversePower = (inversePower * inversePower) & (m - 1);
+	}
+
+	return elements;
+}
+
+void KeyStore::generateGaloisKeys(const set<uint64_t> &elements)
+{
+	if(!secretKey || !publicKey)
+		throw logic_error("galois keys can't be generated without the secret and public keys");
+
+	//the keys given before are left unchanged, as they may be used by other threads, the new keys being added to a copy of them
+	//(they were generated from the secret key of the store, which is the one KeyGenerator::add_galois_keys expects)
+	shared_ptr<GaloisKeys> keys = (gKey && gKey->decomposition_bit_count() == GALOIS_DBC) ? make_shared<GaloisKeys>(*gKey) : make_shared<GaloisKeys>();
+	int missing = count_if(elements.begin(), elements.end(), [&](uint64_t element) { return !keys->has_key(element); });
+
+	cout << "generating " << missing << " galois keys" << endl;
+	auto timeStart = chrono::high_resolution_clock::now();
+
+	//these keys are used during ciphertext values rotation (used during matrix filtering)
+	KeyGenerator generator(session->getContext(), sKey, pKey);
+	generator.add_galois_keys(GALOIS_DBC, vector<uint64_t>(elements.begin(), elements.end()), *keys);
+	gKey = keys;
+
+	auto timeStop = chrono::high_resolution_clock::now();
+	cout << "--> galois keys generated successfully in " << chrono::duration_cast<chrono::milliseconds>(timeStop - timeStart).count() << " milliseconds" << endl << endl;
+}
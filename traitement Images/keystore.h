@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include <seal/seal.h>
+#include "session.h"
+
+using namespace std;
+using namespace seal;
+
+#ifndef KEYSTORE_H
+#define KEYSTORE_H
+
+/**
+ * @brief keys of a set of images, shared by every image using them
+ * @details generating the keys (and the galois keys most of all) takes longer than most of the operations made on an image,
+ * so a key store is created once, then given to every ImagePlaintext encrypting or decrypting with the same keys
+ * the galois keys are only generated when first asked for, the images never rotated (negated, greyed...) never needing them,
+ * and only for the rotations the operations of the images make (see getGaloisKeys(steps, columnRotation)),
+ * the evaluation keys being generated the same way by the first operation multiplying two ciphertexts
+ * a key store can be saved to a file and loaded back, with or without the secret key: a store without secret key
+ * lets a server encrypt images and rotate ciphertexts, without being able to decrypt them
+ */
+class KeyStore
+{
+	public :
+
+		/**
+		 * @brief decomposition bit count of the galois keys
+		 * @details this value is purely subjective, and was simply taken as the mean of possible values
+		 * taking a lower DBC will slow the rotation process, but will lower the noise generated by it
+		 * inversely, taking a higher value will result in more noise but will process faster
+		 */
+		static const int GALOIS_DBC = 30;
+
+		/**
+		 * @brief decomposition bit count of the evaluation keys, relinearizing the products of two ciphertexts
+		 * @details same trade-off as GALOIS_DBC, the noise of a relinearization being small next to the noise of the product
+		 */
+		static const int EVALUATION_DBC = 30;
+
+		/**
+		 * @brief generates a secret key and a public key for the encryption parameters
+		 */
+		KeyStore(const EncryptionParameters &parameters);
+
+		/**
+		 * @brief creates a store holding a secret key only, which can only decrypt
+		 */
+		KeyStore(const EncryptionParameters &parameters, const SecretKey &sKey);
+
+		/**
+		 * @brief loads a key store written by save
+		 * @details throws an invalid_argument error if the file can't be opened or isn't a key store
+		 */
+		KeyStore(string fileName);
+
+		/**
+		 * @brief writes the keys to a file
+		 * @details the galois and evaluation keys are written if they have been generated
+		 *
+		 * @param fileName the name of the file
+		 * @param withSecretKey false to leave the secret key out of the file
+		 */
+		void save(string fileName, bool withSecretKey = true) const;
+
+		const EncryptionParameters& getParameters() const	{ return parameters; }
+
+		bool hasSecretKey() const	{ return secretKey; }
+		bool hasPublicKey() const	{ return publicKey; }
+
+		/**
+		 * @brief returns the secret key, throws a logic_error if the store doesn't hold it
+		 */
+		const SecretKey& getSecretKey() const;
+
+		/**
+		 * @brief returns the public key, throws a logic_error if the store doesn't hold it
+		 */
+		const PublicKey& getPublicKey() const;
+
+		/**
+		 * @brief returns galois keys for every rotation, generating them the first time if needed, can be called by several threads at once
+		 * @details the keys are the ones of the powers of two of the rotation steps, a rotation by other steps being made of several
+		 * rotations (one for each bit of the steps), each one adding its noise
+		 * throws a logic_error if the keys have to be generated without the secret key
+		 */
+		shared_ptr<const GaloisKeys> getGaloisKeys();
+
+		/**
+		 * @brief returns galois keys holding a key for each of the given rotations, can be called by several threads at once
+		 * @details each rotation then takes a single key switch, so the keys of a plan of filters (rotations by -2 to 2 for a 5 by 5 filter)
+		 * are fewer and faster to generate than the keys of every power of two, and rotate with less noise
+		 * only the missing keys are generated, the keys already held being kept for the operations asking for them later
+		 * keys held for every power of two (see getGaloisKeys()) are returned as they are when they can't be generated,
+		 * throws a logic_error otherwise
+		 *
+		 * @param steps the steps of the rotations of the rows of the batching matrix (see Evaluator::rotate_rows)
+		 * @param columnRotation true if the rows of the batching matrix are swapped too (see Evaluator::rotate_columns)
+		 */
+		shared_ptr<const GaloisKeys> getGaloisKeys(const set<int> &steps, bool columnRotation);
+
+		/**
+		 * @brief returns true if the given keys hold a key for each of the given rotations (see getGaloisKeys(steps, columnRotation))
+		 */
+		bool hasGaloisKeys(const GaloisKeys &keys, const set<int> &steps, bool columnRotation) const;
+
+		/**
+		 * @brief returns the evaluation keys relinearizing a product of two ciphertexts back to two polynomials,
+		 * generating them the first time if needed, can be called by several threads at once
+		 * @details only the operations multiplying ciphertexts together need them (see PixelOperation::polynomial)
+		 * throws a logic_error if the keys have to be generated without the secret key
+		 */
+		shared_ptr<const EvaluationKeys> getEvaluationKeys();
+
+	private :
+		/**
+		 * @brief returns the galois elements of the given rotations
+		 */
+		set<uint64_t> getGaloisElements(const set<int> &steps, bool columnRotation) const;
+
+		/**
+		 * @brief returns the galois elements of the keys of every power of two (see KeyGenerator::generate_galois_keys)
+		 */
+		set<uint64_t> getPowerOfTwoElements() const;
+
+		/**
+		 * @brief adds the keys of the given galois elements to the keys held
+		 */
+		void generateGaloisKeys(const set<uint64_t> &elements);
+
+		EncryptionParameters parameters;
+		shared_ptr<ImageSession> session;
+		SecretKey sKey;
+		PublicKey pKey;
+		shared_ptr<const GaloisKeys> gKey;	//null until generated or loaded
+		shared_ptr<const EvaluationKeys> eKey;	//null until generated or loaded
+		bool secretKey, publicKey;
+		mutex galoisMutex;
+		mutex evaluationMutex;
+};
+#endif	//KEYSTORE_H
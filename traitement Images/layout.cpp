@@ -0,0 +1,327 @@
+#include "layout.h"
+
+
+ImageLayout::ImageLayout() :
+	height(0), width(0), channels(3), rowSize(1), channelsPerCipher(1), channelGroups(3), blocks(1), bands(1), bandHeight(0), rowCount(0), segmentsPerHalf(1), stride(1), batch(false)
+{
+}
+
+ImageLayout::ImageLayout(shared_ptr<ImageSession> session, int height, int width, bool packed, int guard) :
+	session(session), height(height), width(width), channels(3), batch(false)
+{
+	if(width > session->getSlotCount())
+		throw invalid_argument("poly_modulus must be over image width");
+
+	rowSize = session->getSlotCount() / 2;
+
+	//unpacked layout: a single segment at the beginning of the slots, which may go on in the second row of the batching matrix
+	channelsPerCipher = 1;
+	bands = 1;
+	segmentsPerHalf = 1;
+	stride = rowSize;
+
+	if(packed && guard >= 0 && width + guard <= rowSize)
+	{
+		segmentsPerHalf = rowSize / (width + guard);
+		stride = rowSize / segmentsPerHalf;
+
+		int segments = 2*segmentsPerHalf;
+		if(segments >= 3)
+		{
+			channelsPerCipher = 3;
+		}
+		bands = max(1, min(segments / channelsPerCipher, height));
+	}
+
+	//the last band is the only one which may be shorter, no band being left empty
+	bandHeight = max(1, (height + bands - 1) / bands);
+	bands = max(1, (height + bandHeight - 1) / bandHeight);
+	rowCount = bandHeight;
+	blocks = channelsPerCipher;
+	channelGroups = 3 / channelsPerCipher;
+}
+
+ImageLayout ImageLayout::getBatchLayout(shared_ptr<ImageSession> session, int imageCount, int height, int width, int guard)
+{
+	if(imageCount < 1 || height < 1)
+		throw invalid_argument("a batch needs at least one image");
+	if(imageCount > getBatchCapacity(session, width, guard))
+		throw invalid_argument("too many images for a batch");
+
+	ImageLayout layout(session, imageCount*height, width, true, guard);
+	layout.bands = imageCount;
+	layout.bandHeight = height;
+	layout.rowCount = height;
+	layout.batch = true;
+
+	return layout;
+}
+
+int ImageLayout::getBatchCapacity(shared_ptr<ImageSession> session, int width, int guard)
+{
+	//segments of a single line, every image of the batch having one segment per color layer
+	ImageLayout line(session, 1, width, true, guard);
+	if(guard < 0 || line.getGuard() < guard) return 0;	//too wide to be packed
+
+	return 2*line.segmentsPerHalf / line.channelsPerCipher;
+}
+
+vector<pair<int, int> > ImageLayout::getLineSources(int row) const
+{
+	vector<pair<int, int> > sources;
+	for(int segment = 0; segment < getSegmentCount(); segment++)
+	{
+		int block = segment / bands;
+		int band = segment % bands;
+
+		int x = band*bandHeight + (block / channelsPerCipher)*rowCount + row;
+		if(batch)
+		{
+			//the lines out of an image are taken in the image itself
+			x = band*bandHeight + max(0, min(bandHeight - 1, x - band*bandHeight));
+		}
+		(x < 0) ? (x = 0) : ((x > height - 1) ? (x = height - 1) : (x = x));
+
+		//same color layer, in the band and sub-band of line x
+		int sourceBlock = ((x % bandHeight) / rowCount)*channelsPerCipher + block % channelsPerCipher;
+		sources.push_back(make_pair((x % bandHeight) % rowCount, sourceBlock*bands + x / bandHeight));
+	}
+
+	return sources;
+}
+
+void ImageLayout::planLine(int row, vector<SegmentMove> &destination) const
+{
+	planMoves(getLineSources(row), destination);
+}
+
+ImageLayout ImageLayout::getGreyLayout() const
+{
+	if(channels == 1)
+		throw logic_error("image is already grey");
+
+	ImageLayout grey(*this);
+	grey.channels = 1;
+	grey.channelGroups = 1;
+
+	if(channelsPerCipher == 3)
+	{
+		//the segments of the three color layers hold three sub-bands
+		grey.channelsPerCipher = 1;
+		grey.rowCount = (bandHeight + 2) / 3;
+	}
+
+	return grey;
+}
+
+void ImageLayout::planGrey(int colorLayer, vector<SegmentMove> &destination) const
+{
+	if(channelsPerCipher != 3 || channels != 3)
+		throw logic_error("color layers are not concatenated");
+
+	vector<pair<int, int> > sources;
+	for(int segment = 0; segment < getSegmentCount(); segment++)
+	{
+		int subBand = segment / bands;
+		int band = segment % bands;
+
+		sources.push_back(make_pair(subBand, colorLayer*bands + band));
+	}
+
+	planMoves(sources, destination);
+}
+
+void ImageLayout::planChannel(int shift, vector<SegmentMove> &destination) const
+{
+	if(channelsPerCipher != 3 || channels != 3)
+		throw logic_error("color layers are not concatenated");
+
+	vector<pair<int, int> > sources;
+	for(int segment = 0; segment < getSegmentCount(); segment++)
+	{
+		int colorLayer = getChannel(0, segment);
+		sources.push_back(make_pair(0, getChannelSegment(segment, (colorLayer + shift) % 3)));
+	}
+
+	planMoves(sources, destination);
+}
+
+ImageLayout ImageLayout::getDownscaledLayout(int guard) const
+{
+	//the two lines of a pair may be in different bands of the same rows, but each image of a batch must have two lines
+	if((batch ? bandHeight : height) < 2 || width < 2)
+		throw invalid_argument("image too small to be downscaled");
+	if(width > rowSize)
+		throw invalid_argument("lines over half the slot count can't be downscaled");
+
+	ImageLayout downscaled = batch ? getBatchLayout(session, bands, bandHeight/2, width/2, guard)
+		: ImageLayout(session, height/2, width/2, isPacked(), guard);
+
+	return (channels == 1) ? downscaled.getGreyLayout() : downscaled;
+}
+
+void ImageLayout::planColumnPairs(ColumnPairPlan &destination) const
+{
+	if(width > rowSize)
+		throw logic_error("lines go on in the second row of the batching matrix");
+
+	//pixels 2y and 2y + 1 are brought to y by rotations of y and y + 1 slots, from 0 to pairs slots
+	int pairs = width/2;
+	int rotations = pairs + 1;
+	int babySteps = (int)ceil(sqrt((double)rotations));
+
+	destination.babySteps = babySteps;
+	destination.giantSteps.clear();
+	destination.masks.clear();
+
+	vector<uint64_t> values(session->getSlotCount(), 0);
+	for(int giantSteps = 0; giantSteps < rotations; giantSteps += babySteps)
+	{
+		destination.giantSteps.push_back(giantSteps);
+		destination.masks.emplace_back();
+
+		for(int baby = 0; baby < babySteps && giantSteps + baby < rotations; baby++)
+		{
+			int steps = giantSteps + baby;
+
+			//after the baby step, pixel 2y (rotated by y = steps) and pixel 2y - 1 (rotated by y, from pair y - 1) are baby slots before their place
+			fill(values.begin(), values.end(), 0);
+			for(int segment = 0; segment < getSegmentCount(); segment++)
+			{
+				int slot = getSegmentSlot(segment) - baby;
+				if(steps < pairs) values[slot + 2*steps] = 1;
+				if(steps > 0) values[slot + 2*steps - 1] = 1;
+			}
+
+			Plaintext mask;
+			session->getCRTBuilder().compose(values, mask);
+			session->getEvaluator().transform_to_ntt(mask);
+			destination.masks.back().push_back(mask);
+		}
+	}
+}
+
+void ImageLayout::planDownscale(const ImageLayout &source, int row, int group, bool lower, vector<SegmentMove> &destination) const
+{
+	vector<pair<int, int> > sources;
+	for(int segment = 0; segment < getSegmentCount(); segment++)
+	{
+		int x = getLine(row, segment);
+		if(x >= height)
+		{
+			sources.push_back(make_pair(0, -1));
+			continue;
+		}
+
+		int colorLayer = getChannel(group, segment);
+		int sourceLine = source.getDownscaledLine(x) + (lower ? 1 : 0);
+		sources.push_back(make_pair(source.getCipherIndex(sourceLine, colorLayer), source.getSegment(sourceLine, colorLayer)));
+	}
+
+	planMoves(sources, destination, &source);
+}
+
+vector<int> ImageLayout::getKey() const
+{
+	return {height, width, channels, rowSize, channelsPerCipher, blocks, bands, bandHeight, rowCount, segmentsPerHalf, stride, batch};
+}
+
+void ImageLayout::save(ostream &stream) const
+{
+	vector<int> key = getKey();
+	int32_t size = key.size();
+
+	stream.write(reinterpret_cast<const char*>(&size), sizeof(int32_t));
+	for(int value : key)
+	{
+		int32_t value32 = value;
+		stream.write(reinterpret_cast<const char*>(&value32), sizeof(int32_t));
+	}
+}
+
+void ImageLayout::load(istream &stream, shared_ptr<ImageSession> session)
+{
+	int32_t size = 0;
+	stream.read(reinterpret_cast<char*>(&size), sizeof(int32_t));
+	if(!stream || size != (int32_t)getKey().size())
+		throw invalid_argument("invalid layout");
+
+	vector<int> key;
+	for(int i = 0; i < size; i++)
+	{
+		int32_t value = 0;
+		stream.read(reinterpret_cast<char*>(&value), sizeof(int32_t));
+		key.push_back(value);
+	}
+	if(!stream)
+		throw invalid_argument("invalid layout");
+
+	ImageLayout layout;
+	layout.session = session;
+	layout.height = key[0];
+	layout.width = key[1];
+	layout.channels = key[2];
+	layout.rowSize = key[3];
+	layout.channelsPerCipher = key[4];
+	layout.blocks = key[5];
+	layout.bands = key[6];
+	layout.bandHeight = key[7];
+	layout.rowCount = key[8];
+	layout.segmentsPerHalf = key[9];
+	layout.stride = key[10];
+	layout.batch = (key[11] != 0);
+	layout.channelGroups = (layout.channels == 1) ? 1 : 3 / max(1, layout.channelsPerCipher);
+
+	//the segments must be in the slots of the session
+	if(layout.rowSize != session->getSlotCount() / 2 || layout.width < 0 || layout.height < 0 || layout.segmentsPerHalf < 1
+		|| layout.stride < 1 || layout.segmentsPerHalf*layout.stride > layout.rowSize || layout.width > ((layout.segmentsPerHalf > 1) ? layout.stride : 2*layout.rowSize)
+		|| layout.blocks < 1 || layout.bands < 1 || layout.bandHeight < 1 || layout.rowCount < 1
+		|| layout.blocks*layout.bands > 2*layout.segmentsPerHalf || (layout.channels != 1 && layout.channels != 3)
+		|| (layout.channelsPerCipher != 1 && layout.channelsPerCipher != 3))
+		throw invalid_argument("layout doesn't fit the encryption parameters");
+
+	*this = layout;
+}
+
+void ImageLayout::planMoves(const vector<pair<int, int> > &sources, vector<SegmentMove> &destination, const ImageLayout *sourceLayout) const
+{
+	if(!sourceLayout) sourceLayout = this;
+
+	//segments taken from the same row with the same rotation are brought together by a single move
+	map<tuple<int, int, bool>, vector<int> > moves;
+	for(int segment = 0; segment < (int)sources.size(); segment++)
+	{
+		if(sources[segment].second < 0) continue;
+
+		int sourceSlot = sourceLayout->getSegmentSlot(sources[segment].second);
+		int slot = getSegmentSlot(segment);
+		int steps = (sourceSlot % rowSize) - (slot % rowSize);
+		bool swap = (sourceSlot / rowSize) != (slot / rowSize);
+
+		moves[make_tuple(sources[segment].first, steps, swap)].push_back(segment);
+	}
+
+	destination.clear();
+	for(auto &move : moves)
+	{
+		SegmentMove segmentMove;
+		segmentMove.sourceRow = get<0>(move.first);
+		segmentMove.steps = get<1>(move.first);
+		segmentMove.swap = get<2>(move.first);
+		segmentMove.segments = move.second;
+
+		//a single move can bring the other slots too, as only the pixels of the segments are ever used
+		if(moves.size() > 1)
+		{
+			vector<uint64_t> values(session->getSlotCount(), 0);
+			for(int segment : move.second)
+			{
+				fill(values.begin() + getSegmentSlot(segment), values.begin() + getSegmentSlot(segment) + width, 1);
+			}
+			session->getCRTBuilder().compose(values, segmentMove.mask);
+			session->getEvaluator().transform_to_ntt(segmentMove.mask);
+		}
+
+		destination.push_back(segmentMove);
+	}
+}
@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <seal/seal.h>
+#include "session.h"
+
+using namespace std;
+using namespace seal;
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+/**
+ * @brief a rotation bringing some segments of a ciphertext to the place of other segments (see ImageLayout::planLine)
+ */
+struct SegmentMove
+{
+	int sourceRow;	//row of ciphertexts the segments are taken from
+	int steps;		//rotation of the rows of the batching matrix (see Evaluator::rotate_rows)
+	bool swap;		//true if the rows of the batching matrix are swapped after the rotation
+	Plaintext mask;	//NTT form of a plaintext with 1 at every pixel of the segments brought by the move, empty if the move is the only one
+	vector<int> segments;	//segments brought by the move
+};
+
+/**
+ * @brief rotations packing the pixel pairs of every segment of a ciphertext at the beginning of the segment (see ImageLayout::planColumnPairs)
+ * @details pixel y of a segment receives the sum of pixels 2y and 2y + 1, which are brought by rotations of y and y + 1 slots
+ * every rotation is split into a baby step and a giant step: the ciphertext is rotated by each baby step once,
+ * the rotated ciphertexts are multiplied with masks and added for each giant step, and the sums are rotated by their giant step
+ */
+struct ColumnPairPlan
+{
+	int babySteps;						//the ciphertext is rotated by 0 to babySteps - 1 slots
+	vector<int> giantSteps;				//rotation of the sum of each giant step
+	vector<vector<Plaintext> > masks;	//NTT form of the mask of each baby step, for each giant step, at the slots of the pixels before the giant step
+};
+
+/**
+ * @brief places of the lines and color layers of an image in the slots of its ciphertexts
+ * @details the slots of a ciphertext are a 2 by (N/2) matrix (see SEAL documentation), each row of the matrix being cut into segments
+ * of the same length, every segment holding one color layer of a line of the image, followed by a few empty slots (the guard)
+ * when the image is narrow enough, the three color layers of a line are put in the same ciphertext (concatenated),
+ * and the image is cut in bands of lines, each band having its own segments, so that a ciphertext holds the same line of every band
+ * a ciphertext thus holds the lines x, x + bandHeight, x + 2*bandHeight... of the image, and the lines above and under
+ * a line are found in the same segments of the previous and next ciphertexts (except on the borders of the bands),
+ * which keeps the vertical pass of the filters free of rotations
+ * ciphertexts are grouped by rows, a row holding the same lines for every color layer (the lines x, x + bandHeight...),
+ * in one ciphertext if the color layers are concatenated, in three ciphertexts (red, green and blue) otherwise
+ * the unpacked layout (one ciphertext for each color layer of each line, the line being at the beginning of the slots)
+ * is used unless the packed layout is asked for, and for images too wide to be packed: the color layers of a packed line
+ * have to be rotated to be mixed (see ImageCiphertext::grey), which takes much more noise budget
+ * a grey image only has one color layer, read for red, green and blue (see getGreyLayout): the segments of the other color layers
+ * then hold other lines of the bands, each band being cut in three sub-bands with their own segments
+ * a batch of images of the same size is laid out as a single image made of the images stacked on top of each other,
+ * each band holding one image, the lines surrounding the borders of a band being taken in the band itself (see getBatchLayout)
+ */
+class ImageLayout
+{
+	public :
+
+		/**
+		 * @brief creates the layout of an empty image
+		 */
+		ImageLayout();
+
+		/**
+		 * @brief creates the layout of an image
+		 * @details packs as many lines and color layers as possible in a ciphertext if packed is true
+		 * the guard is the minimum number of empty slots left after every segment, which lets PACKED filters
+		 * shift the lines by as many slots without mixing segments (see ImageCiphertext::applyFilter),
+		 * slots left over at the end of the rows of the batching matrix being spread between the segments
+		 *
+		 * @param session the session of the encryption parameters of the image
+		 * @param height the height of the image
+		 * @param width the width of the image, which can't be over the slot count
+		 * @param packed true to use the packed layout
+		 * @param guard the minimum number of empty slots after a segment, for a packed layout
+		 */
+		ImageLayout(shared_ptr<ImageSession> session, int height, int width, bool packed = false, int guard = 2);
+
+		/**
+		 * @brief creates the layout of a batch of images of the same size, stacked as the bands of a single image
+		 * @details every band holds a whole image, so that a ciphertext holds the same line of every image,
+		 * the lines out of an image taking the closest line of the same image (instead of the lines of the next band)
+		 * throws an invalid_argument error if the images don't fit in the segments (see getBatchCapacity)
+		 *
+		 * @param session the session of the encryption parameters of the images
+		 * @param imageCount the number of images
+		 * @param height the height of an image
+		 * @param width the width of an image
+		 * @param guard the minimum number of empty slots after a segment
+		 */
+		static ImageLayout getBatchLayout(shared_ptr<ImageSession> session, int imageCount, int height, int width, int guard = 2);
+
+		/**
+		 * @brief returns the maximum number of images of a given width in a batch (see getBatchLayout)
+		 */
+		static int getBatchCapacity(shared_ptr<ImageSession> session, int width, int guard = 2);
+
+		int getHeight() const	{ return height;	}
+		int getWidth() const	{ return width;		}
+
+		/**
+		 * @brief returns the number of color layers stored, 3 for a color image, 1 for a grey image
+		 */
+		int getChannels() const	{ return channels; }
+
+		/**
+		 * @brief returns true if a ciphertext holds more than one line or color layer
+		 */
+		bool isPacked() const	{ return getSegmentCount() > 1; }
+
+		/**
+		 * @brief returns true for the layout of a batch of images, each band holding an image (see getBatchLayout)
+		 */
+		bool isBatch() const	{ return batch; }
+
+		/**
+		 * @brief returns the number of bands, which is the number of images of a batch
+		 */
+		int getBandCount() const	{ return bands; }
+
+		/**
+		 * @brief returns the number of lines in a band, which is the height of the images of a batch
+		 */
+		int getBandHeight() const	{ return bandHeight; }
+
+		/**
+		 * @brief returns the number of ciphertexts of the image
+		 */
+		int getCipherCount() const	{ return rowCount*channelGroups; }
+
+		/**
+		 * @brief returns the number of rows of ciphertexts, which is the height of a band (of a sub-band for a packed grey image)
+		 */
+		int getRowCount() const	{ return rowCount; }
+
+		/**
+		 * @brief returns the number of ciphertexts of a row, 1 if the color layers are concatenated or for a grey image, 3 otherwise
+		 */
+		int getChannelGroups() const	{ return channelGroups; }
+
+		/**
+		 * @brief returns the number of color layers held by a ciphertext
+		 */
+		int getChannelsPerCipher() const	{ return channelsPerCipher; }
+
+		/**
+		 * @brief returns the number of segments used in a ciphertext, every color layer (or sub-band) of a ciphertext having a segment in each band
+		 */
+		int getSegmentCount() const	{ return blocks*bands; }
+
+		/**
+		 * @brief returns the number of empty slots between the last pixel of a segment and the first pixel of the next one
+		 */
+		int getGuard() const	{ return max(0, stride - width); }
+
+		/**
+		 * @brief returns the slot of the first pixel of a segment
+		 */
+		int getSegmentSlot(int segment) const	{ return (segment / segmentsPerHalf)*rowSize + (segment % segmentsPerHalf)*stride; }
+
+		/**
+		 * @brief returns the line of the image held by a segment of the ciphertexts of a row, which is over the last line for the segments left empty
+		 */
+		int getLine(int row, int segment) const
+		{
+			int line = ((segment / bands) / channelsPerCipher)*rowCount + row;	//line in the band
+			return (line < bandHeight) ? (segment % bands)*bandHeight + line : height;
+		}
+
+		/**
+		 * @brief returns the color layer held by a segment of the ciphertexts of a row (0 for a grey image)
+		 *
+		 * @param group the index of the ciphertext in its row
+		 * @param segment the segment
+		 */
+		int getChannel(int group, int segment) const	{ return group*channelsPerCipher + (segment / bands) % channelsPerCipher; }
+
+		/**
+		 * @brief returns the index of the ciphertext holding a color layer of line x (the same for every color layer of a grey image)
+		 */
+		int getCipherIndex(int x, int colorLayer) const	{ return ((x % bandHeight) % rowCount)*channelGroups + ((channels == 1) ? 0 : colorLayer) / channelsPerCipher; }
+
+		/**
+		 * @brief returns the slot of the first pixel of a color layer of line x in its ciphertext (the same for every color layer of a grey image)
+		 */
+		int getSlot(int x, int colorLayer) const	{ return getSegmentSlot(getSegment(x, colorLayer)); }
+
+		/**
+		 * @brief returns the segment holding a color layer of line x in its ciphertext (the same for every color layer of a grey image)
+		 */
+		int getSegment(int x, int colorLayer) const
+		{
+			int block = ((x % bandHeight) / rowCount)*channelsPerCipher + ((channels == 1) ? 0 : colorLayer) % channelsPerCipher;
+			return block*bands + x / bandHeight;
+		}
+
+		/**
+		 * @brief plans the moves bringing line x + offset in the segments holding line x, for every segment of a row
+		 * @details the lines surrounding the line of a segment are in the same segment of the surrounding rows,
+		 * except on the borders of the bands, where they are taken from the previous or next segment, which needs a rotation,
+		 * lines out of the image taking the closest line of the image (extension technique)
+		 * a row under the last row or over the first one (negative) gives the lines surrounding the borders of the bands
+		 *
+		 * @param row the row of the lines x, which may be outside of the rows
+		 * @param destination the moves to apply to the rows of the image, every move being added to the others
+		 */
+		void planLine(int row, vector<SegmentMove> &destination) const;
+
+		/**
+		 * @brief returns the layout of the grey image made from this image, holding a single color layer
+		 * @details the grey layout has the same segments, so that a grey line is calculated in the slots of one of its colors:
+		 * the color ciphertexts of a row are replaced with a single one, and the concatenated color layers
+		 * are replaced with three sub-bands, the grey image taking three times fewer ciphertexts in both cases
+		 */
+		ImageLayout getGreyLayout() const;
+
+		/**
+		 * @brief plans the moves bringing a color layer of this layout in the segments of the grey layout (concatenated color layers only)
+		 * @details a row r of the grey layout takes its sub-bands from the rows r, r + rowCount and r + 2*rowCount of this layout
+		 * (rowCount of the grey layout), numbered as source rows 0, 1 and 2 of the moves
+		 *
+		 * @param colorLayer the color layer to bring
+		 * @param destination the moves bringing the color layer of the three rows
+		 */
+		void planGrey(int colorLayer, vector<SegmentMove> &destination) const;
+
+		/**
+		 * @brief returns the segment holding a color layer of the line held by a segment, in the same ciphertext (concatenated color layers only)
+		 */
+		int getChannelSegment(int segment, int colorLayer) const	{ return (((segment / bands) / channelsPerCipher)*channelsPerCipher + colorLayer)*bands + segment % bands; }
+
+		/**
+		 * @brief plans the moves bringing in every segment the color layer shift places after its own (modulo 3), of the same line (concatenated color layers only)
+		 * @details the segments are taken from the same ciphertext, numbered as source row 0 of the moves
+		 *
+		 * @param shift the shift of the color layer to bring, 1 or 2
+		 * @param destination the moves bringing the color layer
+		 */
+		void planChannel(int shift, vector<SegmentMove> &destination) const;
+
+		/**
+		 * @brief returns the layout of the image made by averaging the pixels of this image by squares of 2 by 2 pixels (see ImageCiphertext::downscale)
+		 * @details the downscaled image keeps the packing, the color layers and the batch of this layout, with half its height and width,
+		 * the last line and column of an odd image being dropped (the lines of each image for a batch)
+		 * the two lines of a pair being taken from different bands when the bands are a single line high
+		 * throws an invalid_argument error if the image (each image of a batch) has less than two lines or columns,
+		 * or if its lines go on in the second row of the batching matrix (unpacked image wider than half the slot count)
+		 *
+		 * @param guard the minimum number of empty slots after a segment of the downscaled layout, for a packed layout
+		 */
+		ImageLayout getDownscaledLayout(int guard = 2) const;
+
+		/**
+		 * @brief returns the first of the two lines of this layout averaged into line x of the downscaled layout, the second one being the next line
+		 */
+		int getDownscaledLine(int x) const
+		{
+			return batch ? (x / (bandHeight/2))*bandHeight + 2*(x % (bandHeight/2)) : 2*x;
+		}
+
+		/**
+		 * @brief plans the rotations adding the pixels of every segment by pairs, at the beginning of the segment (see ColumnPairPlan)
+		 * @details the same plan applies to every ciphertext of the layout, the slots out of the first half of the segments being set to 0
+		 * throws a logic_error if the lines go on in the second row of the batching matrix
+		 *
+		 * @param destination the plan of the rotations
+		 */
+		void planColumnPairs(ColumnPairPlan &destination) const;
+
+		/**
+		 * @brief plans the moves bringing in the segments of a row of this downscaled layout one of the two lines they average,
+		 * taken from the ciphertexts of the layout it was made from (see getDownscaledLayout), once their column pairs are packed (see planColumnPairs)
+		 * @details the source rows of the moves are the indexes of the ciphertexts of the source layout, segments holding no line being left out
+		 *
+		 * @param source the layout of the image downscaled to this layout
+		 * @param row the row of ciphertexts of this layout
+		 * @param group the index of the ciphertext in its row
+		 * @param lower false to bring the first line of each pair (see getDownscaledLine), true to bring the second one
+		 * @param destination the moves bringing the lines
+		 */
+		void planDownscale(const ImageLayout &source, int row, int group, bool lower, vector<SegmentMove> &destination) const;
+
+		/**
+		 * @brief returns the segments taken by planLine for each segment, as pairs of source row and source segment
+		 * @details two rows with the same sources give the same line
+		 */
+		vector<pair<int, int> > getLineSources(int row) const;
+
+		/**
+		 * @brief returns the values identifying the layout, two layouts with the same key placing the pixels in the same slots
+		 */
+		vector<int> getKey() const;
+
+		/**
+		 * @brief writes the layout to a binary stream (see load)
+		 */
+		void save(ostream &stream) const;
+
+		/**
+		 * @brief reads a layout written by save
+		 * @details throws an invalid_argument error if the layout doesn't fit the slots of the session
+		 *
+		 * @param stream the stream to read the layout from
+		 * @param session the session of the encryption parameters of the image
+		 */
+		void load(istream &stream, shared_ptr<ImageSession> session);
+
+	private :
+		/**
+		 * @brief groups the segments taken from the same row with the same rotation into moves
+		 *
+		 * @param sources the source row and source segment of each segment, segments with a negative source segment being left out
+		 * @param destination the moves to apply
+		 * @param sourceLayout the layout of the source segments, if it isn't this layout
+		 */
+		void planMoves(const vector<pair<int, int> > &sources, vector<SegmentMove> &destination, const ImageLayout *sourceLayout = nullptr) const;
+
+		shared_ptr<ImageSession> session;
+		int height, width;
+		int channels;			//color layers stored
+		int rowSize;			//number of slots in a row of the batching matrix
+		int channelsPerCipher;	//3 if the color layers are concatenated, 1 otherwise
+		int channelGroups;		//ciphertexts in a row of ciphertexts
+		int blocks;				//groups of segments (one segment in each band), for each color layer and sub-band of a ciphertext
+		int bands;				//number of bands of lines
+		int bandHeight;			//lines in a band
+		int rowCount;			//rows of ciphertexts, a band being cut in blocks / channelsPerCipher sub-bands of rowCount lines
+		int segmentsPerHalf;	//segments in a row of the batching matrix
+		int stride;				//slots between the first pixels of two segments
+		bool batch;				//true if each band is an image of its own
+};
+#endif	//LAYOUT_H
@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include "normalisation.h"
+
+Normalisation::Normalisation() :
+	height(0), width(0)
+{
+	channelFactors.fill(1.0);
+}
+
+Normalisation::Normalisation(int height, int width) :
+	height(height), width(width)
+{
+	channelFactors.fill(1.0);
+}
+
+void Normalisation::scale(float value)
+{
+	for(int k = 0; k < 3; k++)
+	{
+		scale(value, k);
+	}
+}
+
+void Normalisation::scale(float value, int colorLayer)
+{
+	if(factors.empty())
+	{
+		channelFactors[colorLayer] *= value;
+		return;
+	}
+
+	float *layer = factors.data() + (uint64_t)colorLayer*height*width;
+	for(uint64_t i = 0; i < (uint64_t)height*width; i++)
+	{
+		layer[i] *= value;
+	}
+}
+
+void Normalisation::scaleLine(float value, int x, int colorLayer)
+{
+	if(value == 1) return;
+
+	//a single line of the image keeps the factors uniform
+	if(factors.empty() && height == 1)
+	{
+		channelFactors[colorLayer] *= value;
+		return;
+	}
+
+	expand();
+
+	float *line = factors.data() + ((uint64_t)colorLayer*height + x)*width;
+	for(int j = 0; j < width; j++)
+	{
+		line[j] *= value;
+	}
+}
+
+Normalisation Normalisation::getDownscaled(const vector<int> &sourceLines) const
+{
+	Normalisation downscaled(sourceLines.size(), width/2);
+	if(factors.empty())
+	{
+		for(int k = 0; k < 3; k++)
+		{
+			downscaled.channelFactors[k] = channelFactors[k] / 4;
+		}
+		return downscaled;
+	}
+
+	//the factors of a line are only kept by scaleLine, which needs the whole downscaled line to have the same factor
+	for(int k = 0; k < 3; k++)
+	{
+		for(int x = 0; x < (int)sourceLines.size(); x++)
+		{
+			float factor = get(sourceLines[x], 0, k);
+			for(int y = 0; y < 2*downscaled.width; y++)
+			{
+				if(get(sourceLines[x], y, k) != factor || get(sourceLines[x] + 1, y, k) != factor)
+					throw invalid_argument("pixels averaged together must have the same normalisation factor");
+			}
+			downscaled.scaleLine(factor / 4, x, k);
+		}
+	}
+
+	return downscaled;
+}
+
+bool Normalisation::isOver(float value) const
+{
+	if(factors.empty())
+	{
+		return channelFactors[0] >= value && channelFactors[1] >= value && channelFactors[2] >= value;
+	}
+
+	for(uint64_t i = 0; i < factors.size(); i++)
+	{
+		if(factors[i] < value) return false;
+	}
+
+	return true;
+}
+
+void Normalisation::expand()
+{
+	if(!factors.empty()) return;
+
+	factors.resize((uint64_t)3*height*width);
+	for(int k = 0; k < 3; k++)
+	{
+		fill(factors.begin() + (uint64_t)k*height*width, factors.begin() + (uint64_t)(k + 1)*height*width, channelFactors[k]);
+	}
+}
+
+void Normalisation::save(ostream &stream) const
+{
+	int32_t size[2] = {height, width};
+	uint8_t uniform = factors.empty() ? 1 : 0;
+
+	stream.write(reinterpret_cast<const char*>(size), sizeof(size));
+	stream.write(reinterpret_cast<const char*>(&uniform), sizeof(uint8_t));
+	stream.write(reinterpret_cast<const char*>(channelFactors.data()), 3*sizeof(float));
+	if(!uniform)
+	{
+		stream.write(reinterpret_cast<const char*>(factors.data()), factors.size()*sizeof(float));
+	}
+}
+
+void Normalisation::load(istream &stream)
+{
+	int32_t size[2] = {0, 0};
+	uint8_t uniform = 1;
+	array<float, 3> layerFactors;
+
+	stream.read(reinterpret_cast<char*>(size), sizeof(size));
+	stream.read(reinterpret_cast<char*>(&uniform), sizeof(uint8_t));
+	stream.read(reinterpret_cast<char*>(layerFactors.data()), 3*sizeof(float));
+	if(!stream || size[0] < 0 || size[1] < 0)
+		throw invalid_argument("invalid normalisation");
+
+	vector<float> pixelFactors;
+	if(!uniform)
+	{
+		pixelFactors.resize((uint64_t)3*size[0]*size[1]);
+		stream.read(reinterpret_cast<char*>(pixelFactors.data()), pixelFactors.size()*sizeof(float));
+		if(!stream)
+			throw invalid_argument("invalid normalisation");
+	}
+
+	height = size[0];
+	width = size[1];
+	channelFactors = layerFactors;
+	factors = move(pixelFactors);
+}
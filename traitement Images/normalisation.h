@@ -0,0 +1,100 @@
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+#ifndef NORMALISATION_H
+#define NORMALISATION_H
+
+/**
+ * @brief factors to multiply the decrypted values of an image with, to get back pixel values
+ * @details operations multiplying pixel values (greyscale, filters...) keep track of the multiplication here,
+ * so that decoding can divide the values back to pixel dynamics
+ * as long as every pixel of a color layer has the same factor, only one factor is kept for each color layer,
+ * the factors being expanded to one contiguous buffer of imageHeight*imageWidth values per color layer
+ * once pixels get different factors (a line of a color layer being contiguous)
+ */
+class Normalisation
+{
+	public :
+
+		/**
+		 * @brief creates an empty normalisation, for an image of size 0
+		 */
+		Normalisation();
+
+		/**
+		 * @brief creates the normalisation of an image, with a factor of 1 for every pixel
+		 */
+		Normalisation(int height, int width);
+
+		/**
+		 * @brief multiplies the factor of every pixel with value
+		 */
+		void scale(float value);
+
+		/**
+		 * @brief multiplies the factor of every pixel of a color layer with value
+		 */
+		void scale(float value, int colorLayer);
+
+		/**
+		 * @brief multiplies the factor of every pixel of line x in a color layer with value
+		 * @details expands the factors if the other lines keep a different factor
+		 */
+		void scaleLine(float value, int x, int colorLayer);
+
+		/**
+		 * @brief returns the factors of the image made by adding the pixels of this image by squares of 2 by 2 pixels, divided by 4
+		 * @details pixel (x,y) of the downscaled image is the sum of the pixels (x0,2y), (x0,2y+1), (x0+1,2y) and (x0+1,2y+1), x0 being sourceLines[x]
+		 * throws an invalid_argument error if these four pixels don't have the same factor, or if the factors of a downscaled line aren't the same
+		 *
+		 * @param sourceLines the first of the two lines added for each line of the downscaled image
+		 */
+		Normalisation getDownscaled(const vector<int> &sourceLines) const;
+
+		/**
+		 * @brief returns the factor of the pixel (x,y) in a color layer
+		 */
+		float get(int x, int y, int colorLayer) const
+		{
+			return factors.empty() ? channelFactors[colorLayer] : factors[((uint64_t)colorLayer*height + x)*width + y];
+		}
+
+		/**
+		 * @brief returns true if every pixel of a color layer has the same factor, for every color layer
+		 */
+		bool isUniform() const	{ return factors.empty(); }
+
+		/**
+		 * @brief returns true if every factor is over or equal to value
+		 */
+		bool isOver(float value) const;
+
+		int getHeight() const	{ return height;	}
+		int getWidth() const	{ return width;		}
+
+		/**
+		 * @brief writes the factors to a binary stream, a single factor by color layer being written while they are uniform
+		 */
+		void save(ostream &stream) const;
+
+		/**
+		 * @brief reads factors written by save, throws an invalid_argument error if the stream doesn't hold them
+		 */
+		void load(istream &stream);
+
+	private :
+		/**
+		 * @brief gives its own factor to every pixel
+		 */
+		void expand();
+
+		int height, width;
+		array<float, 3> channelFactors;	//factor of each color layer, while the factors are uniform
+		vector<float> factors;			//factor of each pixel, by color layer then line, empty while the factors are uniform
+};
+#endif	//NORMALISATION_H
@@ -0,0 +1,610 @@
+#include "pixeloperation.h"
+#include "keystore.h"
+
+//largest error a polynomial stage can make by rounding its coefficients, in pixel levels
+static const double MAX_POLYNOMIAL_ERROR = 2.0;
+
+//an affine stage with a factor which isn't an integer makes the factor of a color layer this many times finer
+static const double FINER_FACTOR = 8;
+
+/**
+ * @brief returns the integer value of a pixel offset, for a new factor
+ * @details decoding truncates the values multiplied with their factor, so half a pixel level is added
+ * when the factor is fine enough for the truncation to give the closest pixel value
+ */
+static int64_t quantize(double value, double factor)
+{
+	return (factor < 1) ? (int64_t)floor((value + 0.5) / factor) : llround(value / factor);
+}
+
+PixelOperation& PixelOperation::brightness(float offset)
+{
+	return affine({{1, 1, 1}}, {{offset, offset, offset}});
+}
+
+PixelOperation& PixelOperation::contrast(float factor, float center)
+{
+	float offset = center*(1 - factor);
+	return affine({{factor, factor, factor}}, {{offset, offset, offset}});
+}
+
+PixelOperation& PixelOperation::affine(const array<float, 3> &scale, const array<float, 3> &bias)
+{
+	PixelStage stage;
+	stage.type = AFFINE_STAGE;
+	stage.scale = scale;
+	stage.bias = bias;
+
+	return addStage(stage);
+}
+
+PixelOperation& PixelOperation::mixChannels(const array<array<float, 3>, 3> &matrix, const array<float, 3> &bias)
+{
+	PixelStage stage;
+	stage.type = MIX_STAGE;
+	stage.matrix = matrix;
+	stage.bias = bias;
+
+	return addStage(stage);
+}
+
+PixelOperation& PixelOperation::polynomial(const vector<float> &coefficients)
+{
+	if(coefficients.empty() || (int)coefficients.size() > MAX_DEGREE + 1)
+		throw invalid_argument("polynomial degree must be between 0 and PixelOperation::MAX_DEGREE");
+
+	PixelStage stage;
+	stage.type = POLYNOMIAL_STAGE;
+	stage.coefficients = coefficients;
+
+	return addStage(stage);
+}
+
+PixelOperation& PixelOperation::gamma(float gamma, int degree)
+{
+	if(gamma <= 0)
+		throw invalid_argument("gamma must be positive");
+
+	return polynomial(fitPolynomial([=](double p) { return 255*pow(p/255, 1/gamma); }, degree));
+}
+
+PixelOperation& PixelOperation::threshold(float level, int degree)
+{
+	if(degree > 0)
+		return polynomial(fitPolynomial([=](double p) { return (p >= level) ? 255.0 : 0.0; }, degree));
+
+	//twice the pixel range between two pixel levels, so that the rounding of the slope never brings a pixel back in the range
+	float slope = 510;
+	float offset = 382.5 - slope*level;
+	affine({{slope, slope, slope}}, {{offset, offset, offset}});
+	clamped = true;
+
+	return *this;
+}
+
+PixelOperation& PixelOperation::addStage(const PixelStage &stage)
+{
+	if(clamped)
+		throw logic_error("a threshold of degree 0 must be the last stage of a pixel operation");
+
+	stages.push_back(stage);
+	return *this;
+}
+
+vector<float> PixelOperation::fitPolynomial(const function<double(double)> &pixelFunction, int degree)
+{
+	if(degree < 0 || degree > MAX_DEGREE)
+		throw invalid_argument("polynomial degree must be between 0 and PixelOperation::MAX_DEGREE");
+
+	//normal equations of the least squares fit, in powers of p/255 to keep them well conditioned
+	int size = degree + 1;
+	vector<vector<double> > system(size, vector<double>(size + 1, 0));
+	for(int p = 0; p <= 255; p++)
+	{
+		double u = p / 255.0;
+		double value = pixelFunction(p);
+		for(int i = 0; i < size; i++)
+		{
+			for(int j = 0; j < size; j++)
+			{
+				system[i][j] += pow(u, i + j);
+			}
+			system[i][size] += pow(u, i) * value;
+		}
+	}
+
+	//gaussian elimination with partial pivoting
+	for(int i = 0; i < size; i++)
+	{
+		int pivot = i;
+		for(int j = i + 1; j < size; j++)
+		{
+			if(fabs(system[j][i]) > fabs(system[pivot][i])) pivot = j;
+		}
+		swap(system[i], system[pivot]);
+
+		for(int j = 0; j < size; j++)
+		{
+			if(j == i) continue;
+			double ratio = system[j][i] / system[i][i];
+			for(int k = i; k <= size; k++)
+			{
+				system[j][k] -= ratio * system[i][k];
+			}
+		}
+	}
+
+	vector<float> coefficients(size);
+	for(int i = 0; i < size; i++)
+	{
+		coefficients[i] = system[i][size] / system[i][i] / pow(255.0, i);
+	}
+
+	return coefficients;
+}
+
+
+CompiledPixelOperation::CompiledPixelOperation(const PixelOperation &operation, shared_ptr<ImageSession> session, const ImageLayout &layout, const Normalisation &normalisation) :
+	session(session), layout(layout), channels(layout.getChannels()), relinearization(false), columnRotation(false), noiseCost(0), precision(0)
+{
+	if(!normalisation.isUniform())
+		throw invalid_argument("pixel operations need the same normalisation factor for every pixel of a color layer");
+
+	for(int c = 0; c < 3; c++)
+	{
+		factors[c] = normalisation.get(0, 0, c);
+		if(factors[c] <= 0)
+			throw invalid_argument("pixel operations need positive normalisation factors");
+
+		//the values are assumed to decode to pixel values
+		lowest[c] = 0;
+		highest[c] = 255 / factors[c];
+	}
+	array<double, 3> initialFactors = factors;
+
+	vector<PlannedStage> planned;
+	for(const PixelStage &stage : operation.getStages())
+	{
+		planned.push_back(planStage(stage));
+	}
+
+	//the single color layer of a grey image is read for the three colors
+	for(int c = 0; c < 3; c++)
+	{
+		factorScales[c] = factors[(channels == 1) ? 0 : c] / initialFactors[c];
+	}
+
+	compile(planned);
+}
+
+CompiledPixelOperation::PlannedStage CompiledPixelOperation::planStage(const PixelStage &stage)
+{
+	//half of the range of the plain modulus is left to the next operations
+	double range = session->getOffset() / 2.0;
+
+	PlannedStage planned;
+	planned.type = stage.type;
+	for(auto &line : planned.weights)
+	{
+		line.fill(0);
+	}
+	planned.constants.fill(0);
+
+	if(channels == 1 && stage.type != POLYNOMIAL_STAGE)
+	{
+		if(stage.type == MIX_STAGE)
+			throw invalid_argument("channel mixing needs a color image");
+		if(stage.scale[1] != stage.scale[0] || stage.scale[2] != stage.scale[0] || stage.bias[1] != stage.bias[0] || stage.bias[2] != stage.bias[0])
+			throw invalid_argument("a grey image has a single color layer");
+	}
+
+	array<double, 3> newFactors = factors, newLowest = lowest, newHighest = highest;
+
+	for(int c = 0; c < channels; c++)
+	{
+		double factor = factors[c];
+		double largest = max(1.0, max(fabs(lowest[c]), fabs(highest[c])));
+
+		if(stage.type == AFFINE_STAGE)
+		{
+			//an integer factor keeps the factor of the color layer, other factors make it FINER_FACTOR times finer, if the range allows it
+			double scale = stage.scale[c];
+			int64_t weight = 0;
+			if(scale != 0)
+			{
+				int64_t largestWeight = max<int64_t>(1, (int64_t)(range / largest));
+				bool integer = fabs(scale - round(scale)) < 1e-6;
+				weight = min(largestWeight, max<int64_t>(1, integer ? llround(fabs(scale)) : (int64_t)ceil(FINER_FACTOR * fabs(scale))));
+				newFactors[c] = fabs(scale) * factor / weight;
+				if(scale < 0) weight = -weight;
+			}
+
+			planned.weights[c][c] = weight;
+			planned.constants[c] = quantize(stage.bias[c], newFactors[c]);
+			newLowest[c] = min(weight*lowest[c], weight*highest[c]) + planned.constants[c];
+			newHighest[c] = max(weight*lowest[c], weight*highest[c]) + planned.constants[c];
+		}
+		else if(stage.type == MIX_STAGE)
+		{
+			//the new factor is about as fine as the range allows, the weights being rounded to integers
+			double span = fabs(stage.bias[c]) + 1;
+			vector<double> weights, magnitudes;
+			for(int k = 0; k < 3; k++)
+			{
+				weights.push_back(stage.matrix[c][k] * factors[k]);
+				magnitudes.push_back(max(fabs(lowest[k]), fabs(highest[k])));
+				span += fabs(weights[k]) * magnitudes[k];
+			}
+			newFactors[c] = 1 / chooseScale(weights, magnitudes, range / span);
+
+			double error = 0;
+			planned.constants[c] = quantize(stage.bias[c], newFactors[c]);
+			newLowest[c] = newHighest[c] = planned.constants[c];
+			for(int k = 0; k < 3; k++)
+			{
+				int64_t weight = llround(stage.matrix[c][k] * factors[k] / newFactors[c]);
+				planned.weights[c][k] = weight;
+				newLowest[c] += min(weight*lowest[k], weight*highest[k]);
+				newHighest[c] += max(weight*lowest[k], weight*highest[k]);
+				error += fabs(weight*newFactors[c] - stage.matrix[c][k]*factors[k]) * max(fabs(lowest[k]), fabs(highest[k]));
+			}
+			precision = max(precision, (float)error);
+		}
+		else
+		{
+			const vector<float> &coefficients = stage.coefficients;
+			int degree = coefficients.size() - 1;
+
+			double span = fabs(coefficients[0]) + 1;
+			vector<double> weights, magnitudes;
+			for(int i = 1; i <= degree; i++)
+			{
+				weights.push_back(coefficients[i] * pow(factor, i));
+				magnitudes.push_back(pow(largest, i));
+				span += fabs(coefficients[i]) * pow(factor * largest, i);
+			}
+			newFactors[c] = 1 / chooseScale(weights, magnitudes, range / span);
+
+			planned.coefficients.resize(degree + 1);
+			planned.coefficients[0][c] = quantize(coefficients[0], newFactors[c]);
+			double error = 0;
+			for(int i = 1; i <= degree; i++)
+			{
+				int64_t weight = llround(coefficients[i] * pow(factor, i) / newFactors[c]);
+				planned.coefficients[i][c] = weight;
+				error += fabs(weight*newFactors[c] - coefficients[i]*pow(factor, i)) * pow(largest, i);
+				if(weight != 0 && i > 1) relinearization = true;
+			}
+			if(error > MAX_POLYNOMIAL_ERROR)
+				throw invalid_argument("plain modulus too small for the polynomial, pixels would be off by up to " + to_string(error) + " levels");
+			precision = max(precision, (float)error);
+
+			//range of the polynomial over the values of the color layer
+			double lowestValue = coefficients[0], highestValue = coefficients[0];
+			for(int sample = 0; sample <= 256; sample++)
+			{
+				double p = factor * (lowest[c] + (highest[c] - lowest[c]) * sample / 256);
+				double value = 0;
+				for(int i = degree; i >= 0; i--)
+				{
+					value = value*p + coefficients[i];
+				}
+				lowestValue = min(lowestValue, value);
+				highestValue = max(highestValue, value);
+			}
+			newLowest[c] = (lowestValue - error - 1) / newFactors[c];
+			newHighest[c] = (highestValue + error + 1) / newFactors[c];
+		}
+	}
+
+	factors = newFactors;
+	lowest = newLowest;
+	highest = newHighest;
+	for(int c = 0; c < channels; c++)
+	{
+		checkRange(c);
+	}
+
+	return planned;
+}
+
+void CompiledPixelOperation::checkRange(int colorLayer) const
+{
+	double offset = session->getOffset();
+	if(lowest[colorLayer] < -offset || highest[colorLayer] > offset)
+		throw invalid_argument("pixel operation out of the range of the plain modulus, a larger plain modulus is needed");
+}
+
+void CompiledPixelOperation::compile(const vector<PlannedStage> &planned)
+{
+	uint64_t plainModulus = session->getPlainModulus();
+	int64_t offset = session->getOffset();
+	int slotCount = session->getSlotCount();
+	int channelGroups = layout.getChannelGroups();
+	auto multiply = [&](int64_t a, int64_t b) { return (int64_t)(((__int128)a * b) % (__int128)plainModulus); };
+
+	//consecutive linear stages are merged into one, the weights being multiplied as matrices
+	vector<PlannedStage> merged;
+	for(const PlannedStage &stage : planned)
+	{
+		if(stage.type == POLYNOMIAL_STAGE || merged.empty() || merged.back().type == POLYNOMIAL_STAGE)
+		{
+			merged.push_back(stage);
+			continue;
+		}
+
+		PlannedStage &previous = merged.back();
+		PlannedStage product = stage;
+		for(int c = 0; c < 3; c++)
+		{
+			product.constants[c] = stage.constants[c];
+			for(int k = 0; k < 3; k++)
+			{
+				product.weights[c][k] = 0;
+				for(int j = 0; j < 3; j++)
+				{
+					product.weights[c][k] = (product.weights[c][k] + multiply(stage.weights[c][j], previous.weights[j][k])) % (int64_t)plainModulus;
+				}
+				product.constants[c] = (product.constants[c] + multiply(stage.weights[c][k], previous.constants[k])) % (int64_t)plainModulus;
+			}
+		}
+		product.type = (stage.type == MIX_STAGE || previous.type == MIX_STAGE) ? MIX_STAGE : AFFINE_STAGE;
+		previous = product;
+	}
+
+	SimulationEvaluator simulator;
+	uint64_t largestValue = (plainModulus - 1) / 2;
+	//simulations can't be assigned, so they are held by pointers
+	shared_ptr<Simulation> simulation = make_shared<Simulation>(simulator.get_fresh(session->getParameters(), slotCount, largestValue));
+	int freshBudget = simulation->invariant_noise_budget();
+
+	//noise of a multiplication with a channel plaintext
+	auto simulateProduct = [&](const Simulation &source, const array<uint64_t, 3> &values, const ChannelPlain &weight)
+	{
+		if(weight.one) return source;
+
+		uint64_t largestWeight = 1;
+		for(uint64_t value : values)
+		{
+			largestWeight = max(largestWeight, centered(value));
+		}
+		return weight.ntt ? simulator.multiply_plain(source, slotCount, largestValue) : simulator.multiply_plain(source, 1, largestWeight);
+	};
+
+	for(const PlannedStage &stage : merged)
+	{
+		PixelStep step;
+		step.type = stage.type;
+		step.degree = 0;
+		step.constants.resize(channelGroups);
+
+		//the noise of the step is the noise of its noisiest ciphertext
+		shared_ptr<Simulation> result;
+		auto keepNoisiest = [&](const Simulation &candidate)
+		{
+			if(!result || candidate.invariant_noise_budget() < result->invariant_noise_budget()) result = make_shared<Simulation>(candidate);
+		};
+
+		if(stage.type == POLYNOMIAL_STAGE)
+		{
+			step.powers.resize(channelGroups);
+			for(int i = 1; i < (int)stage.coefficients.size(); i++)
+			{
+				for(int c = 0; c < channels; c++)
+				{
+					if(stage.coefficients[i][c] != 0) step.degree = max(step.degree, i);
+				}
+			}
+
+			//the powers of the values without offset, each one relinearized (see ImageCiphertext::applyPixelOperation)
+			vector<shared_ptr<Simulation> > powers(max(step.degree, 1) + 1);
+			powers[1] = make_shared<Simulation>(simulator.sub_plain(*simulation, 1, offset));
+			for(int i = 2; i <= step.degree; i++)
+			{
+				Simulation product = (i % 2 == 0) ? simulator.square(*powers[i / 2]) : simulator.multiply(*powers[i - 1], *powers[1]);
+				powers[i] = make_shared<Simulation>(simulator.relinearize(product, KeyStore::EVALUATION_DBC));
+			}
+
+			for(int g = 0; g < channelGroups; g++)
+			{
+				shared_ptr<Simulation> sum;
+				for(int i = 1; i <= step.degree; i++)
+				{
+					array<uint64_t, 3> values;
+					for(int c = 0; c < 3; c++)
+					{
+						values[c] = reduce(stage.coefficients[i][min(c, channels - 1)]);
+					}
+					step.powers[g].emplace_back();
+					composeChannels(session, layout, g, values, true, step.powers[g].back());
+
+					Simulation term = simulateProduct(*powers[i], values, step.powers[g].back());
+					sum = make_shared<Simulation>(sum ? simulator.add(*sum, term) : term);
+				}
+
+				array<uint64_t, 3> constants;
+				for(int c = 0; c < 3; c++)
+				{
+					constants[c] = reduce(stage.coefficients[0][min(c, channels - 1)] + offset);
+				}
+				composeChannels(session, layout, g, constants, false, step.constants[g]);
+				keepNoisiest(simulator.add_plain(sum ? *sum : *powers[1], step.constants[g].ntt ? slotCount : 1, largestValue));
+			}
+		}
+		else
+		{
+			step.terms.resize(channelGroups);
+
+			//the offset is put back once after the weighted sum: sum(w*(v + offset)) + constant + offset*(1 - sum(w))
+			array<uint64_t, 3> constants;
+			for(int c = 0; c < 3; c++)
+			{
+				int layer = min(c, channels - 1);
+				int64_t weightSum = stage.weights[layer][0] + stage.weights[layer][1] + stage.weights[layer][2];
+				constants[c] = reduce(stage.constants[layer] + multiply(offset, (1 - weightSum) % (int64_t)plainModulus));
+			}
+
+			if(layout.getChannelsPerCipher() == 1)
+			{
+				//every ciphertext of a row holds a single color layer in the same slots, weighted by constants
+				for(int g = 0; g < channelGroups; g++)
+				{
+					int c = layout.getChannel(g, 0);
+					shared_ptr<Simulation> sum;
+					for(int k = 0; k < channels; k++)
+					{
+						if(stage.weights[c][k] == 0) continue;
+
+						PixelTerm term;
+						term.group = k;
+						term.steps = 0;
+						term.swap = false;
+						array<uint64_t, 3> values;
+						values.fill(reduce(stage.weights[c][k]));
+						composeChannels(session, layout, g, values, true, term.weight);
+						step.terms[g].push_back(term);
+
+						Simulation product = simulateProduct(*simulation, values, term.weight);
+						sum = make_shared<Simulation>(sum ? simulator.add(*sum, product) : product);
+					}
+
+					composeChannels(session, layout, g, {{constants[c], constants[c], constants[c]}}, false, step.constants[g]);
+					keepNoisiest(simulator.add_plain(sum ? *sum : *simulation, 1, largestValue));
+				}
+			}
+			else
+			{
+				//the color layers of a line are in other segments of the same ciphertext, brought by rotations (see ImageLayout::planChannel)
+				shared_ptr<Simulation> sum;
+				for(int shift = 0; shift < 3; shift++)
+				{
+					array<uint64_t, 3> values;
+					for(int c = 0; c < 3; c++)
+					{
+						values[c] = reduce(stage.weights[c][(c + shift) % 3]);
+					}
+					if(values[0] == 0 && values[1] == 0 && values[2] == 0) continue;
+
+					vector<SegmentMove> moves(1);
+					moves[0].sourceRow = 0;
+					moves[0].steps = 0;
+					moves[0].swap = false;
+					if(shift > 0)
+					{
+						layout.planChannel(shift, moves);
+					}
+
+					for(auto &move : moves)
+					{
+						PixelTerm term;
+						term.group = 0;
+						term.steps = move.steps;
+						term.swap = move.swap;
+
+						if(shift == 0)
+						{
+							composeChannels(session, layout, 0, values, true, term.weight);
+						}
+						else
+						{
+							//the weights of the segments brought by the move, which also masks the other segments
+							vector<uint64_t> coeff(slotCount, 0);
+							for(int segment : move.segments)
+							{
+								int slot = layout.getSegmentSlot(segment);
+								fill(coeff.begin() + slot, coeff.begin() + slot + layout.getWidth(), values[layout.getChannel(0, segment)]);
+							}
+							session->getCRTBuilder().compose(coeff, term.weight.plain);
+							session->getEvaluator().transform_to_ntt(term.weight.plain);
+							term.weight.ntt = true;
+							term.weight.one = false;
+
+							if(move.steps != 0) rotationSteps.insert(move.steps);
+							columnRotation |= move.swap;
+						}
+						step.terms[0].push_back(term);
+
+						Simulation product = simulateProduct(*simulation, values, term.weight);
+						sum = make_shared<Simulation>(sum ? simulator.add(*sum, product) : product);
+					}
+				}
+
+				composeChannels(session, layout, 0, constants, false, step.constants[0]);
+				keepNoisiest(simulator.add_plain(sum ? *sum : *simulation, step.constants[0].ntt ? slotCount : 1, largestValue));
+			}
+		}
+
+		simulation = result;
+		steps.push_back(move(step));
+	}
+
+	noiseCost = freshBudget - simulation->invariant_noise_budget();
+	if(!simulation->decrypts())
+		throw invalid_argument("pixel operation taking more than the noise budget of a fresh ciphertext");
+}
+
+double CompiledPixelOperation::chooseScale(const vector<double> &weights, const vector<double> &magnitudes, double largestScale)
+{
+	double bestScale = largestScale, bestError = -1;
+	for(int i = 0; i <= 1024; i++)
+	{
+		double scale = largestScale * (1 - i / 2048.0);
+		double error = 0;
+		for(uint64_t k = 0; k < weights.size(); k++)
+		{
+			error += fabs(llround(weights[k] * scale) - weights[k] * scale) / scale * magnitudes[k];
+		}
+		if(bestError < 0 || error < bestError - 1e-9)
+		{
+			bestScale = scale;
+			bestError = error;
+		}
+	}
+
+	return bestScale;
+}
+
+void CompiledPixelOperation::composeChannels(shared_ptr<ImageSession> session, const ImageLayout &layout, int group, const array<uint64_t, 3> &values, bool ntt, ChannelPlain &destination)
+{
+	//the color layers held by the ciphertext
+	set<uint64_t> groupValues;
+	for(int segment = 0; segment < layout.getSegmentCount(); segment++)
+	{
+		groupValues.insert(values[layout.getChannel(group, segment)]);
+	}
+
+	if(groupValues.size() == 1)
+	{
+		session->composeConstant(*groupValues.begin(), destination.plain);
+		destination.ntt = false;
+		destination.one = (*groupValues.begin() == 1);
+		return;
+	}
+
+	vector<uint64_t> coeff(session->getSlotCount(), 0);
+	for(int segment = 0; segment < layout.getSegmentCount(); segment++)
+	{
+		int slot = layout.getSegmentSlot(segment);
+		fill(coeff.begin() + slot, coeff.begin() + slot + layout.getWidth(), values[layout.getChannel(group, segment)]);
+	}
+	session->getCRTBuilder().compose(coeff, destination.plain);
+	destination.ntt = ntt;
+	destination.one = false;
+	if(ntt)
+	{
+		session->getEvaluator().transform_to_ntt(destination.plain);
+	}
+}
+
+uint64_t CompiledPixelOperation::reduce(int64_t value) const
+{
+	int64_t plainModulus = session->getPlainModulus();
+	value %= plainModulus;
+	return (value < 0) ? value + plainModulus : value;
+}
+
+uint64_t CompiledPixelOperation::centered(uint64_t value) const
+{
+	uint64_t plainModulus = session->getPlainModulus();
+	return (value > plainModulus / 2) ? plainModulus - value : value;
+}
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <seal/seal.h>
+#include "session.h"
+#include "layout.h"
+#include "normalisation.h"
+
+using namespace std;
+using namespace seal;
+
+#ifndef PIXELOPERATION_H
+#define PIXELOPERATION_H
+
+/**
+ * @brief kind of a stage of a PixelOperation
+ */
+enum PixelStageType
+{
+	AFFINE_STAGE,		//each color layer is multiplied with a factor, then an offset is added
+	MIX_STAGE,			//each color layer is replaced with a weighted sum of the three color layers, plus an offset
+	POLYNOMIAL_STAGE	//each pixel is replaced with a polynomial of its value, which multiplies ciphertexts together
+};
+
+/**
+ * @brief stage of a PixelOperation, in pixel values (from 0 to 255)
+ */
+struct PixelStage
+{
+	PixelStageType type;
+	array<float, 3> scale;				//AFFINE_STAGE: factor of each color layer
+	array<float, 3> bias;				//AFFINE_STAGE and MIX_STAGE: value added to each color layer
+	array<array<float, 3>, 3> matrix;	//MIX_STAGE: weight of color layer k in color layer c, as matrix[c][k]
+	vector<float> coefficients;			//POLYNOMIAL_STAGE: coefficient of each power of the pixel value, from the constant
+};
+
+/**
+ * @brief chain of operations made on every pixel of an image independently of its neighbours (brightness, contrast, gamma...)
+ * @details the stages are only described here, in pixel values, and are executed by ImageCiphertext::applyPixelOperation
+ * in a single pass over the ciphertexts, each ciphertext going through every stage before the next one is read
+ * (see CompiledPixelOperation, planning the stages for the plain modulus and the noise budget of the image)
+ * every stage works on the pixel values the previous stages would give, the values over 255 or under 0
+ * only being clamped by decoding: a stage should thus not rely on the clamping of the previous ones
+ */
+class PixelOperation
+{
+	public :
+
+		/**
+		 * @brief adds an offset to every pixel
+		 */
+		PixelOperation& brightness(float offset);
+
+		/**
+		 * @brief multiplies the distance of every pixel to a center value with a factor
+		 */
+		PixelOperation& contrast(float factor, float center = 128);
+
+		/**
+		 * @brief multiplies every color layer with its own factor, then adds its own offset
+		 * @details the three factors and offsets must be the same for a grey image
+		 */
+		PixelOperation& affine(const array<float, 3> &scale, const array<float, 3> &bias);
+
+		/**
+		 * @brief replaces every color layer with a weighted sum of the three color layers of the pixel (sepia, color balance...)
+		 * @details color images only, the color layers held by other segments of the same ciphertext being brought by rotations
+		 * (see ImageLayout::planChannel)
+		 *
+		 * @param matrix the weight of color layer k in color layer c, as matrix[c][k]
+		 * @param bias the value added to each color layer
+		 */
+		PixelOperation& mixChannels(const array<array<float, 3>, 3> &matrix, const array<float, 3> &bias = {{0, 0, 0}});
+
+		/**
+		 * @brief replaces every pixel p with the polynomial coefficients[0] + coefficients[1]*p + coefficients[2]*p^2 + ...
+		 * @details the powers of the pixels are products of ciphertexts, which need the evaluation keys of the image
+		 * and take much more noise budget than the other stages, so the degree is at most MAX_DEGREE
+		 * the coefficients are rounded to integers scaled to the plain modulus (see CompiledPixelOperation),
+		 * so a plain modulus of about 2^22 is needed to keep a polynomial of degree 2 precise to a pixel level on a fresh image,
+		 * and more after stages making the pixels finer (a contrast of 0.5 before it needing about 2^27)
+		 */
+		PixelOperation& polynomial(const vector<float> &coefficients);
+
+		/**
+		 * @brief applies a gamma correction 255*(p/255)^(1/gamma), as the least squares polynomial of the given degree (see polynomial)
+		 */
+		PixelOperation& gamma(float gamma, int degree = 2);
+
+		/**
+		 * @brief sets the pixels of value level or over to 255, and the others to 0
+		 * @details with a degree of 0, the pixels are multiplied with the steepest slope the plain modulus allows around level,
+		 * the values being clamped to 0 or 255 by decoding, so no stage can follow and the image should be decrypted next
+		 * with a higher degree, the step is approximated by the least squares polynomial of this degree (see polynomial),
+		 * which gives values in the pixel range, but only a smooth step
+		 */
+		PixelOperation& threshold(float level, int degree = 0);
+
+		/**
+		 * @brief highest degree of a polynomial stage
+		 */
+		static const int MAX_DEGREE = 4;
+
+		const vector<PixelStage>& getStages() const	{ return stages; }
+		bool isEmpty() const						{ return stages.empty(); }
+
+	private :
+		/**
+		 * @brief adds a stage, throws a logic_error if the operation ends with a threshold clamped by decoding
+		 */
+		PixelOperation& addStage(const PixelStage &stage);
+
+		/**
+		 * @brief returns the least squares polynomial of the given degree of a function over the pixel values 0 to 255
+		 */
+		static vector<float> fitPolynomial(const function<double(double)> &pixelFunction, int degree);
+
+		vector<PixelStage> stages;
+		bool clamped = false;	//true once a threshold of degree 0 was added
+};
+
+/**
+ * @brief plaintext holding a value for each color layer of a ciphertext
+ * @details a constant plaintext (see ImageSession::composeConstant) when every color layer of the ciphertext takes the same value,
+ * a batched plaintext with the value of each segment otherwise, in NTT form if it is multiplied with the ciphertexts
+ */
+struct ChannelPlain
+{
+	Plaintext plain;
+	bool ntt;		//true for the NTT form of a batched plaintext, used with Evaluator::multiply_plain_ntt
+	bool one;		//true for a constant plaintext of 1, which needs no multiplication
+};
+
+/**
+ * @brief ciphertext of a row added to a color layer by a linear step, rotated then multiplied with a weight
+ */
+struct PixelTerm
+{
+	int group;			//index of the source ciphertext in its row
+	int steps;			//rotation of the rows of the batching matrix (see Evaluator::rotate_rows)
+	bool swap;			//true if the rows of the batching matrix are swapped after the rotation
+	ChannelPlain weight;
+};
+
+/**
+ * @brief integer step executed on the ciphertexts, made of one or several stages of a PixelOperation
+ * @details a linear step (AFFINE_STAGE or MIX_STAGE) replaces each ciphertext of a row with the sum of its terms, plus a constant,
+ * consecutive linear stages (affine and mixing stages) being merged into a single step
+ * a polynomial step removes the offset of the values, computes their powers (see PixelOperation::MAX_DEGREE),
+ * then adds the powers multiplied with their weights, plus a constant (the offset of the pixel values included)
+ */
+struct PixelStep
+{
+	PixelStageType type;
+	vector<vector<PixelTerm> > terms;		//linear steps: terms of each ciphertext of a row
+	vector<vector<ChannelPlain> > powers;	//polynomial steps: weight of each power, from the first one, for each ciphertext of a row
+	vector<ChannelPlain> constants;			//value added to each ciphertext of a row (not in NTT form)
+	int degree;								//polynomial steps: highest power computed
+};
+
+/**
+ * @brief stages of a PixelOperation planned for the plain modulus, the layout and the normalisation of an image
+ * @details a pixel p of a color layer is held as the value v = p/factor + offset of the plain modulus (see Normalisation and ImageSession::getOffset),
+ * the arithmetic being exact modulo the plain modulus as long as v - offset stays between -offset and offset
+ * every stage is planned as integer weights and a new factor for each color layer, the weights being scaled
+ * to use at most half of this range (the other half being left to the operations made next, filters...),
+ * or the current factor being kept when the stage only adds values or multiplies them with integers
+ * the values of the image are assumed to decode to the pixel range (0 to 255) before the operation,
+ * and a stage taking values out of the range of the plain modulus throws an invalid_argument error
+ * the noise budget taken by the steps is simulated from a fresh ciphertext (see SimulationEvaluator),
+ * and an operation taking more than the noise budget of a fresh ciphertext throws an invalid_argument error
+ * a compiled operation is never modified once built, and can thus be shared between threads
+ */
+class CompiledPixelOperation
+{
+	public :
+
+		/**
+		 * @brief plans the stages of an operation for an image
+		 * @details throws an invalid_argument error if the normalisation factors of the image aren't uniform (see Normalisation::isUniform),
+		 * if a stage can't be planned for the plain modulus, or if the operation takes more than the noise budget of a fresh ciphertext
+		 *
+		 * @param operation the operation to plan
+		 * @param session the session of the encryption parameters of the image
+		 * @param layout the layout of the image
+		 * @param normalisation the normalisation of the image
+		 */
+		CompiledPixelOperation(const PixelOperation &operation, shared_ptr<ImageSession> session, const ImageLayout &layout, const Normalisation &normalisation);
+
+		const vector<PixelStep>& getSteps() const	{ return steps; }
+
+		/**
+		 * @brief returns the value the factor of a color layer is multiplied with (see Normalisation::scale)
+		 */
+		float getFactorScale(int colorLayer) const	{ return factorScales[colorLayer]; }
+
+		/**
+		 * @brief returns true if a step multiplies ciphertexts together, which needs evaluation keys (see KeyStore::getEvaluationKeys)
+		 */
+		bool needsRelinearization() const	{ return relinearization; }
+
+		/**
+		 * @brief returns the steps of the rotations made by the linear steps
+		 */
+		const set<int>& getRotationSteps() const	{ return rotationSteps; }
+
+		/**
+		 * @brief returns true if a linear step swaps the rows of the batching matrix
+		 */
+		bool hasColumnRotation() const	{ return columnRotation; }
+
+		/**
+		 * @brief returns the number of bits of noise budget the operation is expected to take from a fresh ciphertext
+		 */
+		int getNoiseCost() const	{ return noiseCost; }
+
+		/**
+		 * @brief returns the largest error made by rounding the polynomial coefficients, in pixel levels
+		 */
+		float getPrecision() const	{ return precision; }
+
+		/**
+		 * @brief composes the values of the color layers of a ciphertext into a plaintext (see ChannelPlain)
+		 * @details the pixels of each segment take the value of the color layer of the segment, the guards taking 0
+		 *
+		 * @param session the session of the encryption parameters of the image
+		 * @param layout the layout of the image
+		 * @param group the index of the ciphertext in its row
+		 * @param values the value of each color layer, modulo the plain modulus
+		 * @param ntt true to put a batched plaintext in NTT form, for a multiplication
+		 * @param destination the plaintext overwritten with the values
+		 */
+		static void composeChannels(shared_ptr<ImageSession> session, const ImageLayout &layout, int group, const array<uint64_t, 3> &values, bool ntt, ChannelPlain &destination);
+
+		/**
+		 * @brief returns the scale, at most largestScale, giving the smallest error when the weights multiplied with it are rounded to integers
+		 * @details the scales from half the largest one to the largest one are tried, the error of each weight
+		 * being multiplied with the largest value it is multiplied with
+		 *
+		 * @param weights the weights to scale
+		 * @param magnitudes the largest value multiplied with each weight
+		 * @param largestScale the largest scale the range of the plain modulus allows
+		 */
+		static double chooseScale(const vector<double> &weights, const vector<double> &magnitudes, double largestScale);
+
+	private :
+		/**
+		 * @brief integer weights of a stage, for each color layer (see CompiledPixelOperation)
+		 */
+		struct PlannedStage
+		{
+			PixelStageType type;
+			array<array<int64_t, 3>, 3> weights;		//linear stages: weight of color layer k in color layer c, as weights[c][k] (diagonal for affine stages)
+			vector<array<int64_t, 3> > coefficients;	//polynomial stages: weight of each power of each color layer, from the constant
+			array<int64_t, 3> constants;				//linear stages: value added to each color layer, without the offsets of the pixel values
+		};
+
+		/**
+		 * @brief plans the integer weights of a stage, and updates the factors and the ranges of the values of the color layers
+		 */
+		PlannedStage planStage(const PixelStage &stage);
+
+		/**
+		 * @brief throws an invalid_argument error if the values of a color layer are out of the range of the plain modulus
+		 */
+		void checkRange(int colorLayer) const;
+
+		/**
+		 * @brief simulates the noise taken by the steps, and builds their plaintexts
+		 */
+		void compile(const vector<PlannedStage> &planned);
+
+		/**
+		 * @brief returns a value modulo the plain modulus
+		 */
+		uint64_t reduce(int64_t value) const;
+
+		/**
+		 * @brief returns the absolute value of a value modulo the plain modulus, taken between -plainModulus/2 and plainModulus/2
+		 */
+		uint64_t centered(uint64_t value) const;
+
+		shared_ptr<ImageSession> session;
+		ImageLayout layout;
+		int channels;					//color layers of the image
+		array<double, 3> factors;		//factor of each color layer, updated by each stage planned
+		array<double, 3> lowest;		//lowest value of each color layer, without the offset, updated by each stage planned
+		array<double, 3> highest;		//highest value of each color layer, without the offset
+		array<float, 3> factorScales;
+		vector<PixelStep> steps;
+		bool relinearization;
+		set<int> rotationSteps;
+		bool columnRotation;
+		int noiseCost;
+		float precision;
+};
+#endif	//PIXELOPERATION_H
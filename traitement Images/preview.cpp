@@ -0,0 +1,161 @@
+#include "preview.h"
+
+
+PreviewWriter::PreviewWriter() :
+	pending(0), stopping(false)
+{
+	writer = thread(&PreviewWriter::work, this);
+}
+
+PreviewWriter::~PreviewWriter()
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+	writer.join();
+}
+
+PreviewWriter& PreviewWriter::get()
+{
+	static PreviewWriter writer;
+
+	return writer;
+}
+
+void PreviewWriter::add(string fileName, shared_ptr<ImageSession> session, const SecretKey &key, const Normalisation &normalisation, const ImageLayout &layout, vector<int> rows, vector<Ciphertext> ciphers)
+{
+	Preview preview;
+	preview.fileName = fileName;
+	preview.session = session;
+	preview.key = key;
+	preview.normalisation = normalisation;
+	preview.layout = layout;
+	preview.rows = move(rows);
+	preview.ciphers = move(ciphers);
+
+	{
+		lock_guard<mutex> lock(queueMutex);
+		queue.push_back(move(preview));
+		pending++;
+	}
+	queueCondition.notify_one();
+}
+
+void PreviewWriter::wait()
+{
+	unique_lock<mutex> lock(queueMutex);
+	doneCondition.wait(lock, [this]{ return pending == 0; });
+}
+
+void PreviewWriter::work()
+{
+	unique_lock<mutex> lock(queueMutex);
+
+	while(true)
+	{
+		queueCondition.wait(lock, [this]{ return stopping || !queue.empty(); });
+		if(queue.empty()) return;	//stopping, every preview being written
+
+		Preview preview = move(queue.front());
+		queue.pop_front();
+		lock.unlock();
+
+		try
+		{
+			write(preview);
+		}
+		catch(const exception &e)
+		{
+			cerr << "could not write preview '" << preview.fileName << "': " << e.what() << endl;
+		}
+
+		lock.lock();
+		if(--pending == 0)
+		{
+			doneCondition.notify_all();
+		}
+	}
+}
+
+void PreviewWriter::write(Preview &preview)
+{
+	Decryptor decryptor(preview.session->getContext(), preview.key);
+	PolyCRTBuilder &crtbuilder = preview.session->getCRTBuilder();
+
+	//offset to be removed
+	int offset = preview.session->getOffset();
+
+	ImageLayout &layout = preview.layout;
+	int width = layout.getWidth();
+
+	Plaintext tampon;
+	vector<vector<png_byte> > pixels(preview.rows.size(), vector<png_byte>(width * 4, 255));	//alpha channel set to 255 (no transparency)
+
+	//each ciphertext holding lines of the preview is decrypted once, for every line it holds
+	map<int, vector<uint64_t> > decrypted;
+
+	for(uint64_t i = 0; i < preview.rows.size(); i++)
+	{
+		for(int k = 0; k < 3; k++)
+		{
+			int index = layout.getCipherIndex(preview.rows[i], k);
+			if(decrypted.find(index) == decrypted.end())
+			{
+				decryptor.decrypt(preview.ciphers.at(index), tampon);
+				crtbuilder.decompose(tampon, decrypted[index]);
+			}
+			const vector<uint64_t> &values = decrypted[index];
+			int slot = layout.getSlot(preview.rows[i], k);
+
+			for(int j = 0; j < width; j++)
+			{
+				//for each value, the offset is removed (thus, the value can be negative), then normalisation is applied
+				int pix = (int)(((int64_t)values[slot + j] - offset)*preview.normalisation.get(preview.rows[i], j, k));
+				//makes sure that the value is taken back to pixel dynamics
+				(pix < 0) ? (pix = 0) : (pix = pix);
+				(pix > 255) ? (pix = 255) : (pix = pix);
+				pixels[i][j * 4 + k] = pix;
+			}
+		}
+	}
+
+	vector<png_bytep> rowPointers;
+	for(uint64_t i = 0; i < pixels.size(); i++)
+	{
+		rowPointers.push_back(pixels[i].data());
+	}
+
+	FILE *fp = fopen(preview.fileName.c_str(), "wb");
+	if(!fp) throw runtime_error("cannot open file");
+
+	png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (!png) abort();
+
+	png_infop info = png_create_info_struct(png);
+	if (!info) abort();
+
+	if (setjmp(png_jmpbuf(png))) abort();
+
+	png_init_io(png, fp);
+
+	// Output is 8bit depth, RGBA format.
+	png_set_IHDR(
+	png,
+	info,
+	width, preview.rows.size(),
+	8,
+	PNG_COLOR_TYPE_RGBA,
+	PNG_INTERLACE_NONE,
+	PNG_COMPRESSION_TYPE_DEFAULT,
+	PNG_FILTER_TYPE_DEFAULT
+	);
+	png_write_info(png, info);
+
+	png_write_image(png, rowPointers.data());
+	png_write_end(png, NULL);
+	png_destroy_write_struct(&png, &info);
+
+	fclose(fp);
+}
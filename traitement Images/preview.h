@@ -0,0 +1,107 @@
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <png.h>
+
+#include <seal/seal.h>
+#include "session.h"
+#include "normalisation.h"
+#include "layout.h"
+
+using namespace std;
+using namespace seal;
+
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+/**
+ * @brief operations of ImageCiphertext which can write debug previews (see ImageCiphertext::enablePreviews)
+ */
+enum PreviewOperation
+{
+	PREVIEW_NONE = 0,
+	PREVIEW_NEGATE = 1,
+	PREVIEW_GREY = 2,
+	PREVIEW_FILTER = 4,
+	PREVIEW_PIXELS = 8,
+	PREVIEW_DOWNSCALE = 16,
+	PREVIEW_BLEND = 32,
+	PREVIEW_ALL = 63
+};
+
+/**
+ * @brief writes debug previews of encrypted images on a background thread
+ * @details a preview is a copy of the ciphertexts holding some lines of an image, decrypted with a wrong secret key
+ * and decoded to a PNG picture, to show what someone without the secret key would see
+ * previews are queued by the image operations, then decrypted and written one after the other by the writer thread,
+ * so that they are kept out of the operations themselves
+ * the previews still queued are written before the program ends
+ */
+class PreviewWriter
+{
+	public :
+
+		/**
+		 * @brief returns the preview writer shared by every image
+		 */
+		static PreviewWriter& get();
+
+		~PreviewWriter();
+
+		/**
+		 * @brief queues a preview to write
+		 *
+		 * @param fileName the name of the PNG file to write
+		 * @param session the session of the encryption parameters of the lines
+		 * @param key the secret key used to decrypt the lines
+		 * @param normalisation the normalisation of the image
+		 * @param layout the layout of the image, giving the ciphertext and the slots of each line
+		 * @param rows the lines of the image kept in the preview, in increasing order
+		 * @param ciphers the ciphertexts of the image, only the ones holding the lines kept being needed (the others can be empty)
+		 */
+		void add(string fileName, shared_ptr<ImageSession> session, const SecretKey &key, const Normalisation &normalisation, const ImageLayout &layout, vector<int> rows, vector<Ciphertext> ciphers);
+
+		/**
+		 * @brief waits until every queued preview has been written
+		 */
+		void wait();
+
+	private :
+		PreviewWriter();
+
+		struct Preview
+		{
+			string fileName;
+			shared_ptr<ImageSession> session;
+			SecretKey key;
+			Normalisation normalisation;
+			ImageLayout layout;
+			vector<int> rows;
+			vector<Ciphertext> ciphers;
+		};
+
+		/**
+		 * @brief main loop of the writer thread
+		 */
+		void work();
+
+		/**
+		 * @brief decrypts and decodes a preview, then writes it to its PNG file
+		 */
+		static void write(Preview &preview);
+
+		deque<Preview> queue;
+		int pending;	//previews queued or being written
+		bool stopping;
+		mutex queueMutex;
+		condition_variable queueCondition, doneCondition;
+		thread writer;
+};
+#endif	//PREVIEW_H
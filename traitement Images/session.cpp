@@ -0,0 +1,41 @@
+#include "session.h"
+
+map<EncryptionParameters::hash_block_type, shared_ptr<ImageSession> > ImageSession::sessions;
+mutex ImageSession::sessionsMutex;
+
+
+ImageSession::ImageSession(const EncryptionParameters &parameters) :
+	parameters(parameters), context(parameters), evaluator(context), crtbuilder(context)
+{
+	slotCount = crtbuilder.slot_count();
+	polyLength = context.poly_modulus().significant_coeff_count() - 1;
+
+	//calculating offset value to put pixel values at the center of the plain modulus
+	plainModulus = *context.plain_modulus().pointer();
+	offset = (int)(plainModulus - 255) / 2;
+
+	composeConstant(offset, offsetPlain);
+}
+
+shared_ptr<ImageSession> ImageSession::get(const EncryptionParameters &parameters)
+{
+	lock_guard<mutex> lock(sessionsMutex);
+
+	auto found = sessions.find(parameters.hash_block());
+	if(found != sessions.end())
+	{
+		return found->second;
+	}
+
+	shared_ptr<ImageSession> session(new ImageSession(parameters));
+	sessions[parameters.hash_block()] = session;
+
+	return session;
+}
+
+void ImageSession::composeConstant(uint64_t value, Plaintext &destination)
+{
+	//batching the same value in every slot gives the constant polynomial equal to this value
+	destination.resize(1);
+	destination[0] = value;
+}
@@ -0,0 +1,83 @@
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <seal/seal.h>
+
+using namespace std;
+using namespace seal;
+
+#ifndef SESSION_H
+#define SESSION_H
+
+/**
+ * @brief set of SEAL tools shared by every image encrypted with the same encryption parameters
+ * @details creating a SEALContext, an Evaluator or a PolyCRTBuilder computes NTT tables, base converters
+ * and the galois generator map, which takes longer than most of the operations made on an image
+ * a session is thus built only once for each encryption parameters (identified by their hash),
+ * then shared between every ImagePlaintext and ImageCiphertext using them
+ * the tools are only read by the image operations, so a single session can be used by several threads at once,
+ * as long as each thread gives its own MemoryPoolHandle to the Evaluator (see SEAL documentation)
+ */
+class ImageSession
+{
+	public :
+
+		/**
+		 * @brief returns the session corresponding to the given encryption parameters
+		 * @details looks for an existing session built from parameters with the same hash,
+		 * and creates it if none exists yet
+		 *
+		 * @param parameters encryption parameters of the image
+		 * @return a shared pointer to the session
+		 */
+		static shared_ptr<ImageSession> get(const EncryptionParameters &parameters);
+
+		/**
+		 * @brief composes a plaintext holding the same value in every slot
+		 * @details such a plaintext is a constant polynomial, which SEAL multiplies much faster than a batched plaintext,
+		 * with a noise growth only depending on the value
+		 *
+		 * @param value the value to put in every slot (must be less than the plain modulus)
+		 * @param destination the plaintext to overwrite
+		 */
+		void composeConstant(uint64_t value, Plaintext &destination);
+
+		const EncryptionParameters& getParameters()	{ return parameters;	}
+		SEALContext& getContext()					{ return context;		}
+		Evaluator& getEvaluator()					{ return evaluator;		}
+		PolyCRTBuilder& getCRTBuilder()				{ return crtbuilder;	}
+
+		int getSlotCount()			{ return slotCount;		}
+		int getPolyLength()			{ return polyLength;	}
+		uint64_t getPlainModulus()	{ return plainModulus;	}
+
+		/**
+		 * @brief returns the offset added to every pixel value to put it at the center of the plain modulus
+		 */
+		int getOffset()	{ return offset; }
+
+		/**
+		 * @brief returns a plaintext holding the offset in every slot, used to remove or put back the offset of pixel values
+		 */
+		const Plaintext& getOffsetPlain()	{ return offsetPlain; }
+
+	private :
+		ImageSession(const EncryptionParameters &parameters);
+
+		EncryptionParameters parameters;
+		SEALContext context;
+		Evaluator evaluator;
+		PolyCRTBuilder crtbuilder;
+
+		int slotCount;
+		int polyLength;
+		uint64_t plainModulus;
+		int offset;
+		Plaintext offsetPlain;
+
+		static map<EncryptionParameters::hash_block_type, shared_ptr<ImageSession> > sessions;
+		static mutex sessionsMutex;
+};
+#endif	//SESSION_H
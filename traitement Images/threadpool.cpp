@@ -0,0 +1,226 @@
+#include "threadpool.h"
+
+thread_local int ThreadPool::currentWorker = -1;
+
+ThreadPool::ThreadPool(int workerCount) :
+	job(nullptr), jobWorkers(0), runningWorkers(0), generation(0), stopping(false)
+{
+	for(int i = 0; i < workerCount; i++)
+	{
+		queues.emplace_back(new TaskQueue());
+		memoryPools.push_back(MemoryPoolHandle::New(false));	//each pool is only used by its worker
+	}
+
+	for(int i = 0; i < workerCount; i++)
+	{
+		workers.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(jobMutex);
+		stopping = true;
+	}
+	jobStart.notify_all();
+
+	for(uint64_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+ThreadPool& ThreadPool::get()
+{
+	static ThreadPool pool((thread::hardware_concurrency() == 0) ? 1 : thread::hardware_concurrency());
+
+	return pool;
+}
+
+int ThreadPool::getWorkerCount(int workerCount)
+{
+	return (workerCount <= 0 || workerCount > (int)workers.size()) ? workers.size() : workerCount;
+}
+
+void ThreadPool::run(int taskCount, const function<void(int, int)> &task, int workerCount)
+{
+	if(taskCount <= 0) return;
+
+	//inner operation of a task, executed by its worker
+	if(currentWorker >= 0)
+	{
+		exception_ptr exception = nullptr;
+		for(int t = 0; t < taskCount; t++)
+		{
+			try
+			{
+				task(t, currentWorker);
+			}
+			catch(...)
+			{
+				if(!exception) exception = current_exception();
+			}
+		}
+
+		if(exception) rethrow_exception(exception);
+		return;
+	}
+
+	lock_guard<mutex> runLock(runMutex);
+
+	workerCount = getWorkerCount(workerCount);
+	if(workerCount > taskCount) workerCount = taskCount;
+
+	//giving a contiguous block of tasks to each worker
+	int begin = 0;
+	for(int i = 0; i < workerCount; i++)
+	{
+		int end = begin + taskCount/workerCount + ((i < taskCount%workerCount) ? 1 : 0);
+
+		lock_guard<mutex> lock(queues[i]->queueMutex);
+		for(int t = begin; t < end; t++)
+		{
+			queues[i]->tasks.push_back(t);
+		}
+		begin = end;
+	}
+
+	unique_lock<mutex> lock(jobMutex);
+	job = &task;
+	jobWorkers = workerCount;
+	runningWorkers = workerCount;
+	jobException = nullptr;
+	generation++;
+	jobStart.notify_all();
+
+	jobEnd.wait(lock, [this]{ return runningWorkers == 0; });
+	job = nullptr;
+
+	if(jobException)
+	{
+		exception_ptr exception = jobException;
+		jobException = nullptr;
+		rethrow_exception(exception);
+	}
+}
+
+void ThreadPool::work(int worker)
+{
+	uint64_t seen = 0;
+	currentWorker = worker;
+
+	while(true)
+	{
+		unique_lock<mutex> lock(jobMutex);
+		jobStart.wait(lock, [&]{ return stopping || generation != seen; });
+		if(stopping) return;
+
+		seen = generation;
+		if(worker >= jobWorkers) continue;	//worker not used by this operation
+
+		const function<void(int, int)> &task = *job;
+		lock.unlock();
+
+		int current;
+		while(takeTask(worker, current))
+		{
+			try
+			{
+				task(current, worker);
+			}
+			catch(...)
+			{
+				lock_guard<mutex> exceptionLock(jobMutex);
+				if(!jobException) jobException = current_exception();
+			}
+		}
+
+		lock.lock();
+		if(--runningWorkers == 0)
+		{
+			jobEnd.notify_all();
+		}
+	}
+}
+
+bool ThreadPool::takeTask(int worker, int &task)
+{
+	{
+		lock_guard<mutex> lock(queues[worker]->queueMutex);
+		if(!queues[worker]->tasks.empty())
+		{
+			task = queues[worker]->tasks.front();
+			queues[worker]->tasks.pop_front();
+			return true;
+		}
+	}
+
+	//taking the second half of the tasks of another worker, the first half being the ones it will execute next
+	for(int i = 1; i < jobWorkers; i++)
+	{
+		TaskQueue &victim = *queues[(worker + i) % jobWorkers];
+		vector<int> stolen;
+		{
+			lock_guard<mutex> lock(victim.queueMutex);
+			int count = (victim.tasks.size() + 1) / 2;
+			stolen.assign(victim.tasks.end() - count, victim.tasks.end());
+			victim.tasks.erase(victim.tasks.end() - count, victim.tasks.end());
+		}
+
+		if(!stolen.empty())
+		{
+			task = stolen[0];
+
+			lock_guard<mutex> lock(queues[worker]->queueMutex);
+			queues[worker]->tasks.insert(queues[worker]->tasks.end(), stolen.begin() + 1, stolen.end());
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+ProgressReporter::ProgressReporter(int64_t total, chrono::milliseconds period) :
+	total(total), period(period), progress(0), percentage(-1), stopping(false)
+{
+	reporter = thread([this]
+	{
+		unique_lock<mutex> lock(stopMutex);
+		while(!stopCondition.wait_for(lock, this->period, [this]{ return stopping; }))
+		{
+			print();
+		}
+	});
+}
+
+ProgressReporter::~ProgressReporter()
+{
+	finish();
+}
+
+void ProgressReporter::finish()
+{
+	if(!reporter.joinable()) return;
+
+	{
+		lock_guard<mutex> lock(stopMutex);
+		stopping = true;
+	}
+	stopCondition.notify_all();
+	reporter.join();
+
+	print();
+}
+
+void ProgressReporter::print()
+{
+	int currentPercentage = (total > 0) ? (int)((progress.load(memory_order_relaxed)*100)/total) : 100;
+	if(currentPercentage != percentage)
+	{
+		percentage = currentPercentage;
+		cout << "\r [ " << percentage << "% ] ";
+		cout.flush();
+	}
+}
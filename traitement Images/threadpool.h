@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <seal/seal.h>
+
+using namespace std;
+using namespace seal;
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/**
+ * @brief persistent set of worker threads executing the tasks of the image operations
+ * @details the workers are created once, with the first operation using them, and wait for tasks between operations
+ * the tasks of an operation are numbered, and given to the workers in contiguous blocks (so that a worker gets neighbouring lines),
+ * a worker that runs out of tasks takes the second half of the remaining tasks of another worker (work stealing),
+ * so that every worker stays busy until the end of the operation, even if some tasks take longer than others
+ * each worker also has its own SEAL memory pool, kept between operations
+ */
+class ThreadPool
+{
+	public :
+
+		/**
+		 * @brief returns the thread pool shared by every image, with one worker for each hardware thread
+		 */
+		static ThreadPool& get();
+
+		~ThreadPool();
+
+		/**
+		 * @brief executes every task from 0 to taskCount-1, and waits for all of them to be finished
+		 * @details the task function is called with the number of the task and the index of the worker executing it,
+		 * which can be used to keep data between the tasks of a same worker (the tasks of a worker are given in increasing order,
+		 * except when it takes the tasks of another worker)
+		 * only one operation is executed at a time: a task calling run (an operation made of independent operations,
+		 * such as the tiles of an image, see TiledImageCiphertext) executes the inner tasks itself, in order, with its own worker index
+		 * if a task throws an exception, the remaining tasks are still executed, then the first exception is thrown again by run
+		 *
+		 * @param taskCount the number of tasks to execute
+		 * @param task the function executing a task
+		 * @param workerCount the maximum number of workers to use, every worker being used if zero or more than the number of workers
+		 */
+		void run(int taskCount, const function<void(int, int)> &task, int workerCount = 0);
+
+		/**
+		 * @brief returns the number of workers used by run for the given maximum number of workers (see run)
+		 */
+		int getWorkerCount(int workerCount = 0);
+
+		/**
+		 * @brief returns the memory pool of a worker, to be used by SEAL operations executed in its tasks only
+		 */
+		const MemoryPoolHandle& getMemoryPool(int worker)	{ return memoryPools[worker]; }
+
+	private :
+		ThreadPool(int workerCount);
+
+		/**
+		 * @brief main loop of a worker, waiting for operations and executing their tasks
+		 */
+		void work(int worker);
+
+		/**
+		 * @brief takes the next task of a worker, taking tasks from the other workers if it has none left
+		 * @return false if every task of the operation has been taken
+		 */
+		bool takeTask(int worker, int &task);
+
+		struct TaskQueue
+		{
+			mutex queueMutex;
+			deque<int> tasks;
+		};
+
+		static thread_local int currentWorker;	//index of the worker running the current thread, -1 outside of the workers
+
+		vector<thread> workers;
+		vector<unique_ptr<TaskQueue> > queues;
+		vector<MemoryPoolHandle> memoryPools;
+
+		mutex runMutex;		//only one operation at a time
+		mutex jobMutex;		//protects the description of the current operation
+		condition_variable jobStart, jobEnd;
+
+		const function<void(int, int)> *job;
+		int jobWorkers;
+		int runningWorkers;
+		uint64_t generation;
+		bool stopping;
+		exception_ptr jobException;
+};
+
+/**
+ * @brief prints the progress of an operation executed by the thread pool
+ * @details the tasks only add their progress to an atomic counter, which is read and printed regularly by the reporter's own thread,
+ * so that workers never wait for each other or for the output
+ * the reporter prints the final progress and stops when finish is called, or when it is destroyed
+ */
+class ProgressReporter
+{
+	public :
+
+		/**
+		 * @brief starts the reporter thread
+		 *
+		 * @param total the progress value corresponding to the end of the operation
+		 * @param period the time between two readings of the progress
+		 */
+		ProgressReporter(int64_t total, chrono::milliseconds period = chrono::milliseconds(200));
+
+		~ProgressReporter();
+
+		/**
+		 * @brief adds done to the progress, can be called by any thread
+		 */
+		void add(int64_t done)	{ progress.fetch_add(done, memory_order_relaxed); }
+
+		/**
+		 * @brief stops the reporter thread and prints the final progress, does nothing if it is already stopped
+		 */
+		void finish();
+
+	private :
+		void print();
+
+		int64_t total;
+		chrono::milliseconds period;
+		atomic<int64_t> progress;
+		int percentage;
+
+		mutex stopMutex;
+		condition_variable stopCondition;
+		bool stopping;
+		thread reporter;
+};
+
+/**
+ * @brief queue of limited size passing values from the threads of a stage of a pipeline to the threads of the next stage
+ * @details push waits while the queue is full, so that a fast stage can't get ahead of a slower one by more than the size of the queue,
+ * which bounds the memory used by the values in flight
+ * once the queue is closed, push refuses values and pop returns the remaining values, then fails
+ */
+template<typename T>
+class BoundedQueue
+{
+	public :
+
+		/**
+		 * @brief creates an empty queue holding at most capacity values
+		 */
+		BoundedQueue(int capacity) : capacity(max(1, capacity)), closed(false) {}
+
+		/**
+		 * @brief adds a value at the end of the queue, waiting for some room if it is full
+		 * @return false if the queue has been closed, the value being dropped
+		 */
+		bool push(T value)
+		{
+			unique_lock<mutex> lock(queueMutex);
+			notFull.wait(lock, [this]() { return closed || (int)values.size() < capacity; });
+			if(closed) return false;
+
+			values.push_back(move(value));
+			notEmpty.notify_one();
+			return true;
+		}
+
+		/**
+		 * @brief takes the first value of the queue, waiting for one if it is empty
+		 * @return false if the queue is closed and empty
+		 */
+		bool pop(T &value)
+		{
+			unique_lock<mutex> lock(queueMutex);
+			notEmpty.wait(lock, [this]() { return closed || !values.empty(); });
+			if(values.empty()) return false;
+
+			value = move(values.front());
+			values.pop_front();
+			notFull.notify_one();
+			return true;
+		}
+
+		/**
+		 * @brief closes the queue, waking up every thread waiting on it
+		 */
+		void close()
+		{
+			lock_guard<mutex> lock(queueMutex);
+			closed = true;
+			notFull.notify_all();
+			notEmpty.notify_all();
+		}
+
+	private :
+		int capacity;
+		bool closed;
+		deque<T> values;
+		mutex queueMutex;
+		condition_variable notFull, notEmpty;
+};
+#endif	//THREADPOOL_H
@@ -0,0 +1,148 @@
+#include "tiling.h"
+
+
+ImageTiling::ImageTiling(int width, int tileWidth, int halo) :
+	width(width), halo(halo)
+{
+	if(halo < 0)
+		throw invalid_argument("halo must be positive");
+
+	//an image fitting in a single tile needs no halo
+	if(width <= tileWidth)
+	{
+		this->halo = 0;
+		innerWidth = max(1, width);
+		tileCount = 1;
+		return;
+	}
+
+	innerWidth = tileWidth - 2*halo;
+	if(innerWidth < 1)
+		throw invalid_argument("tiles too narrow for their halo");
+
+	tileCount = (width + innerWidth - 1) / innerWidth;
+}
+
+
+TiledImagePlaintext::TiledImagePlaintext(const EncryptionParameters &parameters, char* fileName, int halo, int tileWidth, bool packed, int guard) :
+	TiledImagePlaintext(make_shared<KeyStore>(parameters), fileName, halo, tileWidth, packed, guard)
+{
+}
+
+TiledImagePlaintext::TiledImagePlaintext(shared_ptr<KeyStore> keys, char* fileName, int halo, int tileWidth, bool packed, int guard)
+{
+	image.keys = keys;
+	image.imageParameters = keys->getParameters();
+	image.session = ImageSession::get(image.imageParameters);
+	image.read_png_file(fileName);
+
+	if(tileWidth <= 0 || tileWidth > image.session->getSlotCount())
+	{
+		tileWidth = image.session->getSlotCount();
+	}
+	tiling = ImageTiling(image.imageWidth, tileWidth, halo);
+
+	cout << "image cut into " << tiling.getTileCount() << " tiles, with a halo of " << tiling.getHalo() << " columns" << endl;
+
+	image.normalisation = Normalisation(image.imageHeight, image.imageWidth);
+
+	for(int t = 0; t < tiling.getTileCount(); t++)
+	{
+		tiles.push_back(image.getColumns(tiling.getFirstColumn(t), tiling.getWidth(t)));
+		tiles.back().layout = ImageLayout(image.session, image.imageHeight, tiling.getWidth(t), packed, guard);
+		tiles.back().encode();
+	}
+}
+
+void TiledImagePlaintext::encrypt(TiledImageCiphertext &destination)
+{
+	vector<ImageCiphertext> encryptedTiles(tiles.size());
+	for(uint64_t t = 0; t < tiles.size(); t++)
+	{
+		tiles[t].encrypt(encryptedTiles[t]);
+	}
+
+	destination = TiledImageCiphertext(tiling, move(encryptedTiles));
+}
+
+void TiledImagePlaintext::decrypt(TiledImageCiphertext &source)
+{
+	if(source.getTiling().getTileCount() != (int)tiles.size())
+		throw invalid_argument("tiled image doesn't have the tiles of this image");
+
+	for(uint64_t t = 0; t < tiles.size(); t++)
+	{
+		tiles[t].decrypt(source.getTile(t));
+	}
+}
+
+void TiledImagePlaintext::toImage(string fileName)
+{
+	for(int t = 0; t < tiling.getTileCount(); t++)
+	{
+		ImagePlaintext &tile = tiles[t];
+		tile.decode();
+
+		//only the inner columns of the tile are kept, its halo being held by its neighbours
+		int halo = tiling.getInnerColumn(t) - tiling.getFirstColumn(t);
+		for(uint32_t y = 0; y < image.imageHeight; y++)
+		{
+			memcpy(image.row_pointers[y] + tiling.getInnerColumn(t) * 4, tile.row_pointers[y] + halo * 4, tiling.getInnerWidth(t) * 4);
+		}
+	}
+
+	cout << "writing to PNG file '" << fileName << "'" << endl;
+	image.write_png_file(&fileName[0u]);
+	cout << "finished" << endl;
+}
+
+
+TiledImageCiphertext::TiledImageCiphertext(ImageTiling tiling, vector<ImageCiphertext> tiles) :
+	tiling(tiling), tiles(move(tiles)), remainingHalo(tiling.getHalo())
+{
+}
+
+void TiledImageCiphertext::negate()
+{
+	forEachTile([](ImageCiphertext &tile) { tile.negate(); });
+}
+
+void TiledImageCiphertext::grey()
+{
+	forEachTile([](ImageCiphertext &tile) { tile.grey(); });
+}
+
+void TiledImageCiphertext::applyFilter(Filter filter, ConvolutionMode mode)
+{
+	//a single tile has no neighbours to take columns from
+	if(tiling.getTileCount() > 1)
+	{
+		if(filter.getWidth()/2 > remainingHalo)
+			throw invalid_argument("filter wider than the halo left to the tiles");
+
+		remainingHalo -= filter.getWidth()/2;
+	}
+
+	forEachTile([&](ImageCiphertext &tile) { tile.applyFilter(filter, ThreadPool::get().getWorkerCount(), mode); });
+}
+
+void TiledImageCiphertext::forEachTile(const function<void(ImageCiphertext&)> &operation)
+{
+	ThreadPool &threadPool = ThreadPool::get();
+
+	//with fewer tiles than workers, the operations of each tile are spread over the workers instead
+	if((int)tiles.size() < threadPool.getWorkerCount())
+	{
+		for(auto &tile : tiles)
+		{
+			operation(tile);
+		}
+		return;
+	}
+
+	//each tile is an independent task, its own operations being executed by the worker of the task
+	threadPool.run(tiles.size(), [&](int t, int)
+	{
+		operation(tiles[t]);
+	});
+}
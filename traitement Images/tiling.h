@@ -0,0 +1,173 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <seal/seal.h>
+#include "image.h"
+
+using namespace std;
+using namespace seal;
+
+#ifndef TILING_H
+#define TILING_H
+
+/**
+ * @brief cuts the columns of an image into tiles narrow enough to be encrypted with a small poly_modulus
+ * @details every tile owns a range of columns of the image (its inner columns), and holds up to halo columns
+ * of its neighbours on each side, so that a filter whose half width is at most halo gives the same inner pixels as on the whole image
+ * the tiles on the borders of the image have no halo on their outer side, as the extension technique of the filters
+ * (see ImageCiphertext::applyFilter) gives the same pixels at the border of the tile as at the border of the image
+ */
+class ImageTiling
+{
+	public :
+
+		ImageTiling() : width(0), innerWidth(1), halo(0), tileCount(0) {}
+
+		/**
+		 * @brief cuts an image into tiles
+		 * @details throws an invalid_argument error if the tiles are too narrow for their halo
+		 *
+		 * @param width the width of the image
+		 * @param tileWidth the maximum width of a tile, halo included
+		 * @param halo the number of columns of the neighbouring tiles held by a tile on each side
+		 */
+		ImageTiling(int width, int tileWidth, int halo);
+
+		int getTileCount() const	{ return tileCount;	}
+		int getHalo() const			{ return halo;		}
+
+		/**
+		 * @brief returns the first column of the image held by a tile, halo included
+		 */
+		int getFirstColumn(int tile) const	{ return max(0, getInnerColumn(tile) - halo); }
+
+		/**
+		 * @brief returns the number of columns held by a tile, halo included
+		 */
+		int getWidth(int tile) const	{ return min(width, getInnerColumn(tile) + getInnerWidth(tile) + halo) - getFirstColumn(tile); }
+
+		/**
+		 * @brief returns the first column of the image owned by a tile
+		 */
+		int getInnerColumn(int tile) const	{ return tile*innerWidth; }
+
+		/**
+		 * @brief returns the number of columns of the image owned by a tile
+		 */
+		int getInnerWidth(int tile) const	{ return min(innerWidth, width - getInnerColumn(tile)); }
+
+	private :
+		int width;
+		int innerWidth;	//columns owned by a tile
+		int halo;
+		int tileCount;
+};
+
+class TiledImageCiphertext;
+
+/**
+ * @brief image cut into column tiles (see ImageTiling), each tile being encoded and encrypted as an image of its own
+ * @details lets images wider than the slot count be processed, and keeps the poly_modulus (and so every operation) small
+ * for wide images, the tiles sharing the same keys
+ */
+class TiledImagePlaintext
+{
+	public :
+
+		TiledImagePlaintext() {}
+
+		/**
+		 * @brief reads a PNG image and cuts it into tiles
+		 * @details generates the keys, then encodes every tile (see ImagePlaintext::toPlaintext)
+		 *
+		 * @param parameters encryption parameters of the tiles
+		 * @param fileName the name of the PNG image
+		 * @param halo the largest half width of the filters to apply, summed over every filter applied (see ImageTiling)
+		 * @param tileWidth the maximum width of a tile, halo included, the slot count if zero
+		 * @param packed true to use the packed layout for the tiles (see ImageLayout)
+		 * @param guard the minimum number of empty slots after each packed line
+		 */
+		TiledImagePlaintext(const EncryptionParameters &parameters, char* fileName, int halo, int tileWidth = 0, bool packed = false, int guard = 2);
+
+		/**
+		 * @brief reads a PNG image and cuts it into tiles, encrypted with the keys of a key store (see KeyStore)
+		 */
+		TiledImagePlaintext(shared_ptr<KeyStore> keys, char* fileName, int halo, int tileWidth = 0, bool packed = false, int guard = 2);
+
+		/**
+		 * @brief encrypts every tile
+		 */
+		void encrypt(TiledImageCiphertext &destination);
+
+		/**
+		 * @brief decrypts every tile of a tiled image encrypted with the keys of this image
+		 */
+		void decrypt(TiledImageCiphertext &source);
+
+		/**
+		 * @brief decodes every tile, then writes the inner columns of the tiles side by side to a PNG image
+		 */
+		void toImage(string fileName);
+
+		const ImageTiling& getTiling() const	{ return tiling; }
+		ImagePlaintext& getTile(int tile)		{ return tiles.at(tile); }
+
+	private :
+		ImagePlaintext image;	//whole image and keys, never encoded
+		ImageTiling tiling;
+		vector<ImagePlaintext> tiles;
+};
+
+/**
+ * @brief encrypted tiles of an image (see TiledImagePlaintext)
+ * @details the operations are applied to every tile, the tiles being independent tasks of the thread pool (see ThreadPool::run)
+ * every filter spoils as many columns on the sides of the tiles as its half width, taken from the halo left by the previous filters
+ */
+class TiledImageCiphertext
+{
+	public :
+
+		TiledImageCiphertext() : remainingHalo(0) {}
+
+		/**
+		 * @brief creates a tiled image from its encrypted tiles
+		 */
+		TiledImageCiphertext(ImageTiling tiling, vector<ImageCiphertext> tiles);
+
+		/**
+		 * @brief negates every tile (see ImageCiphertext::negate)
+		 */
+		void negate();
+
+		/**
+		 * @brief converts every tile to greyscale (see ImageCiphertext::grey)
+		 */
+		void grey();
+
+		/**
+		 * @brief applies a filter to every tile (see ImageCiphertext::applyFilter)
+		 * @details throws an invalid_argument error if half the width of the filter is over the halo left
+		 */
+		void applyFilter(Filter filter, ConvolutionMode mode = PACKED);
+
+		const ImageTiling& getTiling() const	{ return tiling; }
+		ImageCiphertext& getTile(int tile)		{ return tiles.at(tile); }
+
+		/**
+		 * @brief returns the columns of halo which are still right on each side of the tiles
+		 */
+		int getRemainingHalo() const	{ return remainingHalo; }
+
+	private :
+		/**
+		 * @brief applies an operation to every tile, each tile being a task of the thread pool
+		 */
+		void forEachTile(const function<void(ImageCiphertext&)> &operation);
+
+		ImageTiling tiling;
+		vector<ImageCiphertext> tiles;
+		int remainingHalo;
+};
+#endif	//TILING_H